@@ -47,6 +47,7 @@
 
 #include "contiki.h"
 #include "blowfish.h"
+#include "cfs/cfs.h"
 
 #include <stdint.h>
 #include <stdio.h>
@@ -324,77 +325,83 @@ static uint32_t SBOX[SBOXES][256] =
     0xb74e6132, 0xce77e25b, 0x578fdfe3, 0x3ac372e6}
 };
 
-static void swap(uint32_t* a, uint32_t* b) {
-    uint32_t tmp;
+#if defined(COFFEE_CONF_SIZE) && (COFFEE_CONF_SIZE > 0)
+#include "cfs/cfs-coffee.h"
+#define SCHEDULE_RESERVE(name, size) cfs_coffee_reserve((name), (size))
+#else
+#define SCHEDULE_RESERVE(name, size)
+#endif
 
-    tmp = *a;
-    *a = *b;
-    *b = tmp;
-}
+#define SCHEDULE_MAGIC 0x42465331 /* "BFS1" */
 
-static uint32_t blowfish_f(blowfish_t* container, uint32_t input) {
-    uint8_t a, b, c, d;
+/* Header of a persisted key schedule. The key is kept to recognize the
+ * schedule, it is no more sensitive than the schedule itself. */
+typedef struct {
+    uint32_t magic;
+    uint32_t length;
+    uint8_t  key[BLOWFISH_MAX_KEY_BYTES];
+} schedule_header_t;
 
-    a = input >> 24;
-    b = (input >> 16) & 0xff;
-    c = (input >> 8) & 0xff;
-    d = input & 0xff;
+#define F(x) (((sbox[0][(x) >> 24] + sbox[1][((x) >> 16) & 0xff]) \
+                ^ sbox[2][((x) >> 8) & 0xff]) + sbox[3][(x) & 0xff])
 
-    return ((container->sbox[0][a] + container->sbox[1][b]) ^ container->sbox[2][c]) +
-            container->sbox[3][d];
-}
+/* Two rounds, without the swaps of the textbook loop */
+#define ROUNDS(i, j) do {               \
+    xr ^= F(xl) ^ pass[i];              \
+    xl ^= F(xr) ^ pass[j];              \
+  } while(0)
 
-void blowfish_cipher(blowfish_t* container, uint32_t* xl, uint32_t* xr, uint8_t mode) {
-    int i;
-    uint32_t loc_xl, loc_xr;
+static void encrypt_block(blowfish_t* container, uint32_t* l, uint32_t* r) {
+    const uint32_t (*sbox)[256] = container->sbox;
+    const uint32_t *pass = container->pass;
+    uint32_t xl = *l ^ pass[0], xr = *r;
 
-    loc_xl = *xl;
-    loc_xr = *xr;
+    ROUNDS(1, 2);   ROUNDS(3, 4);   ROUNDS(5, 6);   ROUNDS(7, 8);
+    ROUNDS(9, 10);  ROUNDS(11, 12); ROUNDS(13, 14); ROUNDS(15, 16);
 
-    if(mode == BLOWFISH_ENCRYPT) {
-        for(i = 0; i < PASSES; i++) {
-            loc_xl = loc_xl ^ container->pass[i];
-            loc_xr = blowfish_f(container, loc_xl) ^ loc_xr;
+    *l = xr ^ pass[17];
+    *r = xl;
+}
 
-            swap(&loc_xl, &loc_xr);
-        }
-    } else if(mode == BLOWFISH_DECRYPT) {
-        for(i = PASSES+1; i > 1; i--) {
-            loc_xl = loc_xl ^ container->pass[i];
-            loc_xr = blowfish_f(container, loc_xl) ^ loc_xr;
+static void decrypt_block(blowfish_t* container, uint32_t* l, uint32_t* r) {
+    const uint32_t (*sbox)[256] = container->sbox;
+    const uint32_t *pass = container->pass;
+    uint32_t xl = *l ^ pass[17], xr = *r;
 
-            swap(&loc_xl, &loc_xr);
-        }
-    }
+    ROUNDS(16, 15); ROUNDS(14, 13); ROUNDS(12, 11); ROUNDS(10, 9);
+    ROUNDS(8, 7);   ROUNDS(6, 5);   ROUNDS(4, 3);   ROUNDS(2, 1);
 
-    swap(&loc_xl, &loc_xr);
+    *l = xr ^ pass[0];
+    *r = xl;
+}
+
+static uint32_t load_be(const uint8_t* p) {
+    return ((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16) |
+           ((uint32_t) p[2] << 8) | p[3];
+}
 
+static void store_be(uint8_t* p, uint32_t v) {
+    p[0] = v >> 24;
+    p[1] = v >> 16;
+    p[2] = v >> 8;
+    p[3] = v;
+}
+
+void blowfish_cipher(blowfish_t* container, uint32_t* xl, uint32_t* xr, uint8_t mode) {
     if(mode == BLOWFISH_ENCRYPT) {
-        loc_xr = loc_xr ^ container->pass[PASSES];
-        loc_xl = loc_xl ^ container->pass[PASSES+1];
+        encrypt_block(container, xl, xr);
     } else if(mode == BLOWFISH_DECRYPT) {
-        loc_xr = loc_xr ^ container->pass[1];
-        loc_xl = loc_xl ^ container->pass[0];
+        decrypt_block(container, xl, xr);
     }
-
-    *xl = loc_xl;
-    *xr = loc_xr;
 }
 
 uint32_t blowfish_initialize(unsigned char* key, uint32_t length, blowfish_t* container) {
     unsigned int i, ii, j = 0;
     uint32_t tmp, tmp_l = 0, tmp_r = 0;
 
-    if(length > BLOWFISH_MAX_KEY_BYTES) return 0;
-    for(i = 0; i < PASSES+2; i++) {
-        container->pass[i] = PASS[i];
-    }
-
-    for(i = 0; i < SBOXES; i++) {
-        for(ii = 0; ii < 256; ii++) {
-            container->sbox[i][ii] = SBOX[i][ii];
-        }
-    }
+    if(length == 0 || length > BLOWFISH_MAX_KEY_BYTES) return 0;
+    memcpy(container->pass, PASS, sizeof(PASS));
+    memcpy(container->sbox, SBOX, sizeof(SBOX));
 
     for(i = 0; i < PASSES+2; i++) {
         tmp = 0;
@@ -408,17 +415,111 @@ uint32_t blowfish_initialize(unsigned char* key, uint32_t length, blowfish_t* co
     }
 
     for(i = 0; i < PASSES+1; i += 2) {
-        blowfish_cipher(container, &tmp_l, &tmp_r, BLOWFISH_ENCRYPT);
+        encrypt_block(container, &tmp_l, &tmp_r);
         container->pass[i] = tmp_l;
         container->pass[i+1] = tmp_r;
     }
 
     for(i = 0; i < SBOXES; i++) {
         for(ii = 0; ii < 256; ii += 2) {
-            blowfish_cipher(container, &tmp_l, &tmp_r, BLOWFISH_ENCRYPT);
+            encrypt_block(container, &tmp_l, &tmp_r);
             container->sbox[i][ii] = tmp_l;
             container->sbox[i][ii+1] = tmp_r;
         }
     }
     return 1;
 }
+
+uint32_t blowfish_ecb(blowfish_t* container, const uint8_t* in, uint8_t* out,
+                      uint32_t len, uint8_t mode) {
+    uint32_t l, r;
+
+    if(len % BLOWFISH_BLOCK_BYTES) return 0;
+    for(; len; len -= BLOWFISH_BLOCK_BYTES, in += BLOWFISH_BLOCK_BYTES, out += BLOWFISH_BLOCK_BYTES) {
+        l = load_be(in);
+        r = load_be(in + 4);
+        if(mode == BLOWFISH_ENCRYPT) {
+            encrypt_block(container, &l, &r);
+        } else {
+            decrypt_block(container, &l, &r);
+        }
+        store_be(out, l);
+        store_be(out + 4, r);
+    }
+    return 1;
+}
+
+void blowfish_ctr(blowfish_t* container, uint8_t* counter, const uint8_t* in,
+                  uint8_t* out, uint32_t len) {
+    uint8_t stream[BLOWFISH_BLOCK_BYTES];
+    uint32_t l, r, i, n;
+
+    l = load_be(counter);
+    r = load_be(counter + 4);
+    while(len) {
+        uint32_t kl = l, kr = r;
+
+        encrypt_block(container, &kl, &kr);
+        store_be(stream, kl);
+        store_be(stream + 4, kr);
+        n = len < BLOWFISH_BLOCK_BYTES ? len : BLOWFISH_BLOCK_BYTES;
+        for(i = 0; i < n; i++) {
+            out[i] = in[i] ^ stream[i];
+        }
+        in += n;
+        out += n;
+        len -= n;
+        if(++r == 0) {
+            l++;
+        }
+    }
+    store_be(counter, l);
+    store_be(counter + 4, r);
+}
+
+uint32_t blowfish_initialize_persistent(unsigned char* key, uint32_t length,
+                                        blowfish_t* container, const char* name) {
+    schedule_header_t header;
+    uint8_t diff = 0;
+    uint32_t i;
+    int fd;
+
+    if(length == 0 || length > BLOWFISH_MAX_KEY_BYTES) return 0;
+
+    fd = cfs_open(name, CFS_READ);
+    if(fd >= 0) {
+        if(cfs_read(fd, &header, sizeof(header)) == sizeof(header)
+           && header.magic == SCHEDULE_MAGIC && header.length == length) {
+            for(i = 0; i < length; i++) {
+                diff |= header.key[i] ^ key[i];
+            }
+            if(diff == 0
+               && cfs_read(fd, container, sizeof(blowfish_t)) == sizeof(blowfish_t)) {
+                cfs_close(fd);
+                return 1;
+            }
+        }
+        cfs_close(fd);
+    }
+
+    blowfish_initialize(key, length, container);
+
+    memset(&header, 0, sizeof(header));
+    header.magic = SCHEDULE_MAGIC;
+    header.length = length;
+    memcpy(header.key, key, length);
+    cfs_remove(name);
+    SCHEDULE_RESERVE(name, sizeof(header) + sizeof(blowfish_t));
+    fd = cfs_open(name, CFS_WRITE);
+    if(fd >= 0) {
+        if(cfs_write(fd, &header, sizeof(header)) != sizeof(header)
+           || cfs_write(fd, container, sizeof(blowfish_t)) != sizeof(blowfish_t)) {
+            cfs_close(fd);
+            cfs_remove(name);
+        } else {
+            cfs_close(fd);
+        }
+    }
+    memset(&header, 0, sizeof(header));
+    return 1;
+}
@@ -57,6 +57,7 @@
 #define BLOWFISH_DECRYPT 2
 
 #define BLOWFISH_MAX_KEY_BYTES 56
+#define BLOWFISH_BLOCK_BYTES 8
 
 typedef struct {
     uint32_t pass[PASSES+2];
@@ -66,4 +67,32 @@ typedef struct {
 void blowfish_cipher(blowfish_t* container, uint32_t* xl, uint32_t* xr, uint8_t mode);
 uint32_t blowfish_initialize(unsigned char* key, uint32_t length, blowfish_t* container);
 
+/**
+ * \brief Encrypts or decrypts len bytes in ECB mode
+ *
+ * Blocks are read and written big-endian, in and out may be the same buffer.
+ * \return 1 on success, 0 if len is not a multiple of BLOWFISH_BLOCK_BYTES
+ */
+uint32_t blowfish_ecb(blowfish_t* container, const uint8_t* in, uint8_t* out,
+                      uint32_t len, uint8_t mode);
+
+/**
+ * \brief Encrypts or decrypts len bytes in CTR mode
+ *
+ * The 8-byte big-endian counter is advanced by one per block, including a
+ * trailing partial block, and is left at the next unused value.
+ */
+void blowfish_ctr(blowfish_t* container, uint8_t* counter, const uint8_t* in,
+                  uint8_t* out, uint32_t len);
+
+/**
+ * \brief Like blowfish_initialize, but keeps the key schedule in the file name
+ *
+ * The expansion takes 521 block encryptions. If the file holds the schedule
+ * of the same key, it is read back instead, otherwise the schedule is
+ * computed and written to the file for the next boot.
+ */
+uint32_t blowfish_initialize_persistent(unsigned char* key, uint32_t length,
+                                        blowfish_t* container, const char* name);
+
 #endif /* BLOWFISH_H_ */
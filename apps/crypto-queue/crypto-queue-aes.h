@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2015, Institute for Pervasive Computing, ETH Zurich.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/**
+ * \addtogroup crypto-queue
+ * @{
+ *
+ * \file
+ * Crypto queue jobs for the cc2538 AES driver
+ */
+#ifndef CRYPTO_QUEUE_AES_H_
+#define CRYPTO_QUEUE_AES_H_
+
+#include "contiki.h"
+#include "crypto-queue.h"
+#include "dev/aes.h"
+
+#include <stdint.h>
+
+/** Arguments of aes_start(), the iv is overwritten with the output iv */
+typedef struct {
+  uint8_t  *in;
+  uint8_t  *iv;
+  uint8_t  *out;
+  uint32_t len;
+  uint8_t  key_area;
+  uint8_t  encrypt;
+  AES_MODE mode;
+} crypto_queue_aes_t;
+
+/**
+ * \brief Prepares job to run op on the AES engine, the caller still sets
+ * process and priority
+ */
+void crypto_queue_aes_job(crypto_job_t *job, crypto_queue_aes_t *op);
+
+#endif /* CRYPTO_QUEUE_AES_H_ */
+
+/** @} */
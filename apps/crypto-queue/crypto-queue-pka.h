@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2015, Institute for Pervasive Computing, ETH Zurich.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/**
+ * \addtogroup crypto-queue
+ * @{
+ *
+ * \file
+ * Crypto queue jobs for the ECC operations of the PKA, on the cc2538
+ * driver or pka-sw
+ */
+#ifndef CRYPTO_QUEUE_PKA_H_
+#define CRYPTO_QUEUE_PKA_H_
+
+#include "contiki.h"
+#include "crypto-queue.h"
+#include "ecc-driver.h"
+
+#include <stdint.h>
+
+/** \name ECC operations
+ * @{
+ */
+#define CRYPTO_QUEUE_ECC_MULTIPLY 0 /**< scalar * point_a */
+#define CRYPTO_QUEUE_ECC_MULT_GEN 1 /**< scalar * generator */
+#define CRYPTO_QUEUE_ECC_ADD      2 /**< point_a + point_b */
+/** @} */
+
+/** Arguments of an ECC operation, the result goes to point_out */
+typedef struct {
+  //Input Variables
+  uint8_t          op;              //CRYPTO_QUEUE_ECC_x
+  ecc_curve_info_t *curve_info;
+  uint32_t         *scalar;         //Multiplications only
+  ec_point_t       *point_a;
+  ec_point_t       *point_b;        //Addition only
+
+  //Variables Holding intermediate data (initialized/used internally)
+  uint32_t         rv;
+
+  //Output Variables
+  ec_point_t       *point_out;
+} crypto_queue_ecc_t;
+
+/**
+ * \brief Prepares job to run op on the PKA, the caller still sets process
+ * and priority
+ * \note The PKA RAM is not kept between jobs, a result is only valid in
+ * point_out.
+ */
+void crypto_queue_ecc_job(crypto_job_t *job, crypto_queue_ecc_t *op);
+
+#endif /* CRYPTO_QUEUE_PKA_H_ */
+
+/** @} */
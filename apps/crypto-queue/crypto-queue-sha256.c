@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2015, Institute for Pervasive Computing, ETH Zurich.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/**
+ * \addtogroup crypto-queue
+ * @{
+ *
+ * \file
+ * Crypto queue jobs for the cc2538 SHA-256 driver
+ */
+#include "contiki.h"
+#include "crypto-queue-sha256.h"
+#include "dev/crypto.h"
+
+#include <stdint.h>
+/*---------------------------------------------------------------------------*/
+static uint8_t
+sha256_job_start(crypto_job_t *job, struct process *notify)
+{
+  crypto_queue_sha256_t *op = job->arg;
+  uint8_t ret;
+
+  ret = sha256_process_start(op->state, op->data, op->len, notify);
+  return ret == AES_RESOURCE_IN_USE ? CRYPTO_QUEUE_RETRY : ret;
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t
+sha256_job_check(crypto_job_t *job)
+{
+  return sha256_check_status(((crypto_queue_sha256_t *)job->arg)->state);
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t
+sha256_job_finish(crypto_job_t *job)
+{
+  return sha256_get_result(((crypto_queue_sha256_t *)job->arg)->state);
+}
+/*---------------------------------------------------------------------------*/
+void
+crypto_queue_sha256_job(crypto_job_t *job, crypto_queue_sha256_t *op)
+{
+  job->start = sha256_job_start;
+  job->check = sha256_job_check;
+  job->finish = sha256_job_finish;
+  job->arg = op;
+  job->engine = CRYPTO_QUEUE_AES;
+}
+
+/** @} */
@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2015, Institute for Pervasive Computing, ETH Zurich.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/**
+ * \addtogroup crypto-queue
+ * @{
+ *
+ * \file
+ * Implementation of the crypto job queue
+ */
+#include "contiki.h"
+#include "crypto-queue.h"
+
+#include <stdint.h>
+#include <string.h>
+
+process_event_t crypto_queue_event;
+
+//Waiting jobs per engine, sorted by priority, and the running ones
+static crypto_job_t *waiting[CRYPTO_QUEUE_ENGINES];
+static crypto_job_t *running[CRYPTO_QUEUE_ENGINES];
+static crypto_queue_stats_t stats;
+
+//Wakes the queue when a start was deferred
+static struct etimer retry_timer;
+
+PROCESS(crypto_queue_process, "Crypto queue");
+/*---------------------------------------------------------------------------*/
+static void
+complete(crypto_job_t *job)
+{
+  stats.jobs++;
+  job->done = 1;
+  if(job->process != NULL) {
+    process_post(job->process, crypto_queue_event, job);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Completes the running job of engine and starts the next ones, called by
+ * the queue process only */
+static void
+dispatch(uint8_t engine)
+{
+  crypto_job_t *job;
+  uint8_t ret;
+
+  while(1) {
+    job = running[engine];
+    if(job != NULL) {
+      if(!job->check(job)) {
+        return;
+      }
+      running[engine] = NULL;
+      job->result = job->finish(job);
+      complete(job);
+    }
+
+    job = waiting[engine];
+    if(job == NULL) {
+      return;
+    }
+
+    ret = job->start(job, &crypto_queue_process);
+    if(ret == CRYPTO_QUEUE_RETRY) {
+      stats.retries++;
+      etimer_set(&retry_timer, 1);
+      return;
+    }
+
+    waiting[engine] = job->next;
+    stats.depth--;
+    job->wait = clock_time() - job->queued;
+    stats.wait_total += job->wait;
+    if(job->wait > stats.wait_max) {
+      stats.wait_max = job->wait;
+    }
+
+    if(ret != 0) {
+      job->result = ret;
+      complete(job);
+    } else {
+      running[engine] = job;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(crypto_queue_process, ev, data)
+{
+  uint8_t engine;
+
+  PROCESS_BEGIN();
+
+  while(1) {
+    PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_POLL || ev == PROCESS_EVENT_TIMER);
+    for(engine = 0; engine < CRYPTO_QUEUE_ENGINES; engine++) {
+      dispatch(engine);
+    }
+  }
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
+void
+crypto_queue_init(void)
+{
+  if(process_is_running(&crypto_queue_process)) {
+    return;
+  }
+  crypto_queue_event = process_alloc_event();
+  memset(waiting, 0, sizeof(waiting));
+  memset(running, 0, sizeof(running));
+  memset(&stats, 0, sizeof(stats));
+  process_start(&crypto_queue_process, NULL);
+}
+/*---------------------------------------------------------------------------*/
+uint8_t
+crypto_queue_submit(crypto_job_t *job)
+{
+  crypto_job_t **p;
+
+  if(job->engine >= CRYPTO_QUEUE_ENGINES || job->start == NULL
+     || job->check == NULL || job->finish == NULL) {
+    return CRYPTO_QUEUE_INVALID;
+  }
+  if(stats.depth >= CRYPTO_QUEUE_SIZE) {
+    return CRYPTO_QUEUE_FULL;
+  }
+
+  //Behind all jobs of the same or a higher priority
+  for(p = &waiting[job->engine]; *p != NULL && (*p)->priority <= job->priority; p = &(*p)->next);
+  job->next = *p;
+  *p = job;
+
+  job->queued = clock_time();
+  job->result = 0;
+  job->done = 0;
+  stats.depth++;
+  if(stats.depth > stats.max_depth) {
+    stats.max_depth = stats.depth;
+  }
+
+  process_poll(&crypto_queue_process);
+  return CRYPTO_QUEUE_SUCCESS;
+}
+/*---------------------------------------------------------------------------*/
+uint8_t
+crypto_queue_cancel(crypto_job_t *job)
+{
+  crypto_job_t **p;
+
+  if(job->engine >= CRYPTO_QUEUE_ENGINES) {
+    return 0;
+  }
+  for(p = &waiting[job->engine]; *p != NULL; p = &(*p)->next) {
+    if(*p == job) {
+      *p = job->next;
+      stats.depth--;
+      return 1;
+    }
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+void
+crypto_queue_stats(crypto_queue_stats_t *copy)
+{
+  memcpy(copy, &stats, sizeof(crypto_queue_stats_t));
+}
+
+/** @} */
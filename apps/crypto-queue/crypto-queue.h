@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2015, Institute for Pervasive Computing, ETH Zurich.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/**
+ * \addtogroup cc2538-crypto
+ * @{
+ *
+ * \defgroup crypto-queue Crypto job queue
+ *
+ * A process that owns the AES/SHA-256 cryptoprocessor and the PKA. Jobs
+ * wait in a bounded queue per engine, ordered by priority and then by
+ * submission, and are started as soon as their engine is free. Both
+ * engines run at the same time, so symmetric and public-key work overlap.
+ * The owner of a job gets crypto_queue_event with the job as data when it
+ * completed.
+ *
+ * The queue does not know the drivers: a job brings callbacks to start the
+ * operation, to check for its completion and to fetch the result. The start
+ * callback passes the given process to the driver, e.g. aes_start() or
+ * PKABigNumMultiplyStart(), whose interrupt then polls the queue.
+ * crypto-queue-aes.h, crypto-queue-sha256.h and crypto-queue-pka.h prepare
+ * jobs for the AES, SHA-256 and ECC drivers.
+ *
+ * \note A PKA job overwrites the PKA RAM. Callers that keep vectors or
+ * intermediate results there between operations hold PKABigNumLock(),
+ * PKA jobs are retried until it is released.
+ * @{
+ *
+ * \file
+ * Header file of the crypto job queue
+ */
+#ifndef CRYPTO_QUEUE_H_
+#define CRYPTO_QUEUE_H_
+
+#include "contiki.h"
+
+#include <stdint.h>
+
+/** Jobs that may wait at the same time, running jobs are not counted */
+#ifdef CRYPTO_QUEUE_CONF_SIZE
+#define CRYPTO_QUEUE_SIZE CRYPTO_QUEUE_CONF_SIZE
+#else
+#define CRYPTO_QUEUE_SIZE 8
+#endif
+
+/** \name Engines
+ * @{
+ */
+#define CRYPTO_QUEUE_AES          0 /**< AES / SHA-256 cryptoprocessor */
+#define CRYPTO_QUEUE_PKA          1 /**< Public key accelerator */
+#define CRYPTO_QUEUE_ENGINES      2
+/** @} */
+
+/** \name Priorities, lower values run first
+ * @{
+ */
+#define CRYPTO_QUEUE_PRIO_HIGH    0
+#define CRYPTO_QUEUE_PRIO_NORMAL  1
+#define CRYPTO_QUEUE_PRIO_LOW     2
+/** @} */
+
+/** \name Return codes
+ * @{
+ */
+#define CRYPTO_QUEUE_SUCCESS      0
+#define CRYPTO_QUEUE_FULL         1    /**< No room for the job */
+#define CRYPTO_QUEUE_INVALID      2    /**< Unknown engine or missing callback */
+#define CRYPTO_QUEUE_RETRY        0xff /**< From start: engine used outside the queue */
+/** @} */
+
+struct crypto_job;
+
+/** Starts the operation, returns 0, CRYPTO_QUEUE_RETRY or an error code */
+typedef uint8_t (*crypto_job_start_t)(struct crypto_job *job, struct process *notify);
+/** Returns nonzero once the engine finished the operation */
+typedef uint8_t (*crypto_job_check_t)(struct crypto_job *job);
+/** Fetches the result, returns the result code of the driver */
+typedef uint8_t (*crypto_job_finish_t)(struct crypto_job *job);
+
+typedef struct crypto_job {
+  struct crypto_job   *next;
+
+  //Input Variables
+  crypto_job_start_t  start;
+  crypto_job_check_t  check;
+  crypto_job_finish_t finish;
+  void                *arg;         //Operation data for the callbacks
+  struct process      *process;     //Gets crypto_queue_event, or NULL
+  uint8_t             engine;       //CRYPTO_QUEUE_AES or CRYPTO_QUEUE_PKA
+  uint8_t             priority;     //CRYPTO_QUEUE_PRIO_x
+
+  //Variables Holding intermediate data (initialized/used internally)
+  clock_time_t        queued;
+
+  //Output Variables
+  clock_time_t        wait;         //Time from submission to start
+  uint8_t             result;       //0, or error code of start or finish
+  uint8_t             done;         //Set with the event, for threads that poll
+} crypto_job_t;
+
+typedef struct {
+  uint32_t     jobs;                //Completed jobs
+  uint32_t     retries;             //Starts deferred, engine used elsewhere
+  uint8_t      depth;               //Jobs waiting now
+  uint8_t      max_depth;
+  clock_time_t wait_total;          //Sum of the waits of started jobs
+  clock_time_t wait_max;
+} crypto_queue_stats_t;
+
+extern process_event_t crypto_queue_event;
+PROCESS_NAME(crypto_queue_process);
+
+/**
+ * \brief Starts the queue process
+ */
+void crypto_queue_init(void);
+
+/**
+ * \brief Queues a job, it must stay allocated until its event arrives
+ * \return CRYPTO_QUEUE_SUCCESS, CRYPTO_QUEUE_FULL or CRYPTO_QUEUE_INVALID
+ */
+uint8_t crypto_queue_submit(crypto_job_t *job);
+
+/**
+ * \brief Removes a job that did not start yet, no event is posted
+ * \return 1 if the job was removed
+ */
+uint8_t crypto_queue_cancel(crypto_job_t *job);
+
+/**
+ * \brief Copies the statistics
+ */
+void crypto_queue_stats(crypto_queue_stats_t *stats);
+
+#endif /* CRYPTO_QUEUE_H_ */
+
+/**
+ * @}
+ * @}
+ */
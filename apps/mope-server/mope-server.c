@@ -0,0 +1,482 @@
+/*
+ * Copyright (c) 2015, Institute for Pervasive Computing, ETH Zurich.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/**
+ * \addtogroup mope-server
+ * @{
+ *
+ * \file
+ * Implementation of the mOPE reference server
+ *
+ * The encoding of a key is the path to it, one 4-bit digit per level from
+ * the most significant end: 2j for the j-th child on the way and 2j+1 for
+ * the j-th key of its node, the remaining digits are 0. Keys of child j
+ * then sort below key j and keys of child j+1 above it.
+ */
+#include "contiki.h"
+#include "mope-server.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#define GAP_FOUND       0   /*value is already in the tree*/
+#define GAP_BEFORE      1   /*value goes just before successor*/
+#define GAP_LAST        2   /*value is larger than all keys*/
+
+#define DIGIT_BITS      4
+#define DIGITS          (ENCODING_LEN * 8 / DIGIT_BITS)
+/*---------------------------------------------------------------------------*/
+static int16_t
+node_alloc(mope_server_t *server, uint8_t leaf)
+{
+  mope_server_node_t *n = &server->node[server->nodes];
+
+  memset(n, 0, sizeof(*n));
+  n->parent = -1;
+  n->leaf = leaf;
+  return server->nodes++;
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t
+child_index(mope_server_t *server, int16_t parent, int16_t child)
+{
+  uint8_t i;
+
+  for(i = 0; server->node[parent].child[i] != child; i++);
+  return i;
+}
+/*---------------------------------------------------------------------------*/
+static int
+locate(mope_server_t *server, const uint32_t *cipher, int16_t *node, uint8_t *pos)
+{
+  mope_server_node_t *n;
+  int16_t i;
+  uint8_t j;
+
+  for(i = 0; i < server->nodes; i++) {
+    n = &server->node[i];
+    for(j = 0; j < n->count; j++) {
+      if(memcmp(n->key[j].cipher, cipher, CIPHER_LEN_BYTE) == 0) {
+        *node = i;
+        *pos = j;
+        return 1;
+      }
+    }
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+/* Key following the gap before key pos of a leaf, in key order */
+static uint8_t
+successor(mope_server_t *server, int16_t node, uint8_t pos, uint32_t *cipher)
+{
+  int16_t parent;
+
+  while(pos == server->node[node].count) {
+    parent = server->node[node].parent;
+    if(parent < 0) {
+      return GAP_LAST;
+    }
+    pos = child_index(server, parent, node);
+    node = parent;
+  }
+  memcpy(cipher, server->node[node].key[pos].cipher, CIPHER_LEN_BYTE);
+  return GAP_BEFORE;
+}
+/*---------------------------------------------------------------------------*/
+static void
+split(mope_server_t *server, int16_t node)
+{
+  mope_server_node_t *n, *r, *p;
+  int16_t right, parent;
+  uint8_t mid, i, ci;
+
+  n = &server->node[node];
+  mid = n->count / 2;
+  right = node_alloc(server, n->leaf);
+  r = &server->node[right];
+  r->count = n->count - mid - 1;
+  memcpy(r->key, &n->key[mid + 1], r->count * sizeof(mope_server_key_t));
+  if(!n->leaf) {
+    memcpy(r->child, &n->child[mid + 1], (r->count + 1) * sizeof(int16_t));
+    for(i = 0; i <= r->count; i++) {
+      server->node[r->child[i]].parent = right;
+    }
+  }
+  n->count = mid;
+
+  if(n->parent < 0) {
+    parent = node_alloc(server, 0);
+    server->node[parent].child[0] = node;
+    n->parent = parent;
+    server->root = parent;
+  }
+  parent = n->parent;
+  p = &server->node[parent];
+  ci = child_index(server, parent, node);
+  memmove(&p->key[ci + 1], &p->key[ci], (p->count - ci) * sizeof(mope_server_key_t));
+  memmove(&p->child[ci + 2], &p->child[ci + 1], (p->count - ci) * sizeof(int16_t));
+  p->key[ci] = n->key[mid];
+  p->child[ci + 1] = right;
+  p->count++;
+  r->parent = parent;
+}
+/*---------------------------------------------------------------------------*/
+/* Inserts cipher just before the key successor, or last if it is NULL */
+static void
+insert_before(mope_server_t *server, const uint32_t *cipher, const uint32_t *succ)
+{
+  mope_server_node_t *n;
+  int16_t node;
+  uint8_t pos;
+
+  if(server->nodes == 0) {
+    server->root = node_alloc(server, 1);
+  }
+  if(succ == NULL || !locate(server, succ, &node, &pos)) {
+    node = server->root;
+    pos = server->node[node].count;
+  }
+  /* the gap before an inner key is the end of the leaf before it */
+  while(!server->node[node].leaf) {
+    node = server->node[node].child[pos];
+    pos = server->node[node].count;
+  }
+
+  n = &server->node[node];
+  memmove(&n->key[pos + 1], &n->key[pos], (n->count - pos) * sizeof(mope_server_key_t));
+  memset(&n->key[pos], 0, sizeof(mope_server_key_t));
+  memcpy(n->key[pos].cipher, cipher, CIPHER_LEN_BYTE);
+  n->count++;
+
+  while(server->node[node].count > MOPE_SERVER_ORDER) {
+    split(server, node);
+    node = server->node[node].parent;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+set_digit(uint8_t *encoding, uint8_t level, uint8_t digit)
+{
+  encoding[level / 2] |= level & 1 ? digit : digit << DIGIT_BITS;
+}
+/*---------------------------------------------------------------------------*/
+/* Recomputes the encodings of a subtree, counts the changed old ones */
+static void
+encode(mope_server_t *server, int16_t node, const uint8_t *prefix, uint8_t level)
+{
+  mope_server_node_t *n = &server->node[node];
+  uint8_t encoding[ENCODING_LEN];
+  uint8_t i;
+
+  for(i = 0; i <= n->count; i++) {
+    if(!n->leaf) {
+      memcpy(encoding, prefix, ENCODING_LEN);
+      set_digit(encoding, level, 2 * i);
+      encode(server, n->child[i], encoding, level + 1);
+    }
+    if(i == n->count) {
+      break;
+    }
+    memcpy(encoding, prefix, ENCODING_LEN);
+    set_digit(encoding, level, 2 * i + 1);
+    if(n->key[i].encoded && memcmp(n->key[i].encoding, encoding, ENCODING_LEN)) {
+      server->stats.reencodings++;
+    }
+    memcpy(n->key[i].encoding, encoding, ENCODING_LEN);
+    n->key[i].encoded = 1;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static int
+send(mope_server_t *server, uint16_t len)
+{
+  server->stats.bytes_out += len;
+  return server->write(server, server->buf, len) < 0 ? -1 : 0;
+}
+/*---------------------------------------------------------------------------*/
+static int
+send_request(mope_server_t *server, mope_server_request_t *request)
+{
+  mope_server_node_t *n = &server->node[request->node];
+  uint16_t header, len;
+  uint8_t *element;
+
+  header = server->batch ? sizeof(packet_batch_t) : sizeof(packet_insert_t);
+  /* element 0 is not a key, the client searches from element 1 */
+  len = header + (n->count + 1) * CIPHER_LEN_BYTE;
+  memset(server->buf, 0, header + CIPHER_LEN_BYTE);
+  ((packet_insert_t *)server->buf)->len = UIP_HTONS(len);
+  if(server->batch) {
+    ((packet_batch_t *)server->buf)->type = INTERACT_FOR_LOOKUP_BATCH_S;
+    ((packet_batch_t *)server->buf)->first = request->first;
+    ((packet_batch_t *)server->buf)->count = request->count;
+  } else {
+    ((packet_insert_t *)server->buf)->type = INTERACT_FOR_LOOKUP_S;
+  }
+  element = server->buf + header + CIPHER_LEN_BYTE;
+  for(header = 0; header < n->count; header++, element += CIPHER_LEN_BYTE) {
+    memcpy(element, n->key[header].cipher, CIPHER_LEN_BYTE);
+  }
+
+  server->stats.requests++;
+  if(request->level + 1 > server->levels) {
+    server->levels = request->level + 1;
+  }
+  return send(server, len);
+}
+/*---------------------------------------------------------------------------*/
+/* Inserts the new values and sends the encodings of the whole batch */
+static int
+finish(mope_server_t *server)
+{
+  uint8_t *encoding;
+  uint16_t header, len;
+  int16_t node;
+  uint8_t pos;
+  int v;
+
+  server->busy = 0;
+  server->stats.rounds += server->levels;
+
+  /* worst case every insert splits every level and adds a root */
+  if(server->nodes + server->count * (mope_server_depth(server) + 1) > MOPE_SERVER_NODES) {
+    server->stats.failures += server->count;
+    ((packet_insert_t *)server->buf)->len = UIP_HTONS(sizeof(packet_insert_t));
+    ((packet_insert_t *)server->buf)->type = CLOSE;
+    return send(server, sizeof(packet_insert_t));
+  }
+
+  /* from the largest down, so that values of one gap precede each other */
+  for(v = server->count - 1; v >= 0; v--) {
+    if(server->gap[v] == GAP_FOUND) {
+      continue;
+    }
+    if(v + 1 < server->count && server->gap[v + 1] == server->gap[v]
+       && (server->gap[v] == GAP_LAST
+           || memcmp(server->successor[v], server->successor[v + 1], CIPHER_LEN_BYTE) == 0)) {
+      insert_before(server, server->cipher[v], server->cipher[v + 1]);
+    } else {
+      insert_before(server, server->cipher[v],
+                    server->gap[v] == GAP_LAST ? NULL : server->successor[v]);
+    }
+    server->stats.new_keys++;
+  }
+  memset(server->buf, 0, ENCODING_LEN);
+  encode(server, server->root, server->buf, 0);
+
+  header = server->batch ? sizeof(packet_batch_t) : sizeof(packet_insert_t);
+  len = header + server->count * ENCODING_LEN;
+  ((packet_insert_t *)server->buf)->len = UIP_HTONS(len);
+  if(server->batch) {
+    ((packet_batch_t *)server->buf)->type = OPE_ENCODING_BATCH;
+    ((packet_batch_t *)server->buf)->first = 0;
+    ((packet_batch_t *)server->buf)->count = server->count;
+  } else {
+    ((packet_insert_t *)server->buf)->type = OPE_ENCODING;
+  }
+  encoding = server->buf + header;
+  for(v = 0; v < server->count; v++, encoding += ENCODING_LEN) {
+    locate(server, server->cipher[v], &node, &pos);
+    memcpy(encoding, server->node[node].key[pos].encoding, ENCODING_LEN);
+  }
+  return send(server, len);
+}
+/*---------------------------------------------------------------------------*/
+/* Applies the answer for the values of a request, queues the requests for
+ * the children and finishes when none is left */
+static int
+answer(mope_server_t *server, uint8_t r, const packet_batch_entry_t *entry)
+{
+  mope_server_request_t request = server->request[r];
+  mope_server_node_t *n = &server->node[request.node];
+  mope_server_request_t *next;
+  uint8_t v, end = request.first + request.count;
+  uint8_t queued = server->requests - 1;
+
+  server->request[r] = server->request[queued];
+  server->requests = queued;
+
+  for(v = request.first; v < end; v++, entry++) {
+    if(entry->index > n->count || (entry->stop_flg && entry->index == n->count)) {
+      return -1;
+    }
+    if(entry->stop_flg) {
+      server->gap[v] = GAP_FOUND;
+    } else if(n->leaf) {
+      server->gap[v] = successor(server, request.node, entry->index, server->successor[v]);
+    } else if(v > request.first && !entry[-1].stop_flg && entry[-1].index == entry->index) {
+      server->request[server->requests - 1].count++;
+    } else {
+      next = &server->request[server->requests++];
+      next->node = n->child[entry->index];
+      next->first = v;
+      next->count = 1;
+      next->level = request.level + 1;
+    }
+  }
+
+  for(v = queued; v < server->requests; v++) {
+    if(send_request(server, &server->request[v])) {
+      return -1;
+    }
+  }
+  return server->requests ? 0 : finish(server);
+}
+/*---------------------------------------------------------------------------*/
+static int
+insert(mope_server_t *server, uint8_t *ciphers, uint8_t count, uint8_t batch)
+{
+  uint8_t v;
+
+  if(count == 0 || count > MOPE_SERVER_BATCH) {
+    return -1;
+  }
+  server->busy = 1;
+  server->batch = batch;
+  server->count = count;
+  server->levels = 0;
+  server->stats.inserts += count;
+  for(v = 0; v < count; v++) {
+    memcpy(server->cipher[v], ciphers + v * CIPHER_LEN_BYTE, CIPHER_LEN_BYTE);
+    server->gap[v] = GAP_LAST;
+  }
+  if(server->nodes == 0) {
+    return finish(server);
+  }
+
+  server->requests = 1;
+  server->request[0].node = server->root;
+  server->request[0].first = 0;
+  server->request[0].count = count;
+  server->request[0].level = 0;
+  return send_request(server, &server->request[0]);
+}
+/*---------------------------------------------------------------------------*/
+void
+mope_server_init(mope_server_t *server, mope_server_write_t write, void *session)
+{
+  memset(server, 0, sizeof(*server));
+  server->root = -1;
+  server->write = write;
+  server->session = session;
+}
+/*---------------------------------------------------------------------------*/
+int
+mope_server_handle(mope_server_t *server, uint8_t *msg, uint16_t len)
+{
+  packet_batch_t *batch = (packet_batch_t *)msg;
+  packet_response_t *response = (packet_response_t *)msg;
+  packet_batch_entry_t entry;
+  uint8_t r;
+
+  if(len < sizeof(packet_insert_t)) {
+    return -1;
+  }
+  server->stats.bytes_in += len;
+
+  /* the length fields of client messages are not relied upon */
+  switch(msg[2]) {
+  case ENC_INS:
+    if(len < sizeof(packet_insert_t) + CIPHER_LEN_BYTE) {
+      return -1;
+    }
+    return insert(server, msg + sizeof(packet_insert_t), 1, 0);
+  case ENC_INS_BATCH:
+    if(len < sizeof(packet_batch_t)
+       || len < sizeof(packet_batch_t) + batch->count * CIPHER_LEN_BYTE) {
+      return -1;
+    }
+    return insert(server, msg + sizeof(packet_batch_t), batch->count, 1);
+  case INTERACT_FOR_LOOKUP_C:
+    if(!server->busy || server->batch || len < sizeof(packet_response_t)) {
+      return -1;
+    }
+    entry.index = response->index;
+    entry.stop_flg = response->stop_flg;
+    return answer(server, 0, &entry);
+  case INTERACT_FOR_LOOKUP_BATCH_C:
+    if(!server->busy || !server->batch || len < sizeof(packet_batch_t)
+       || len < sizeof(packet_batch_t) + batch->count * sizeof(packet_batch_entry_t)) {
+      return -1;
+    }
+    for(r = 0; r < server->requests; r++) {
+      if(server->request[r].first == batch->first
+         && server->request[r].count == batch->count) {
+        return answer(server, r, (packet_batch_entry_t *)(msg + sizeof(packet_batch_t)));
+      }
+    }
+    return -1;
+  }
+  return -1;
+}
+/*---------------------------------------------------------------------------*/
+int
+mope_server_lookup(mope_server_t *server, const uint8_t *cipher, uint8_t *encoding)
+{
+  uint32_t key[CIPHER_LEN_WORD];
+  int16_t node;
+  uint8_t pos;
+
+  memcpy(key, cipher, CIPHER_LEN_BYTE);
+  if(!locate(server, key, &node, &pos)) {
+    return 0;
+  }
+  memcpy(encoding, server->node[node].key[pos].encoding, ENCODING_LEN);
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+uint8_t
+mope_server_depth(mope_server_t *server)
+{
+  int16_t node = server->root;
+  uint8_t depth = 0;
+
+  if(server->nodes == 0) {
+    return 0;
+  }
+  for(depth = 1; !server->node[node].leaf; depth++) {
+    node = server->node[node].child[0];
+  }
+  return depth;
+}
+/*---------------------------------------------------------------------------*/
+uint32_t
+mope_server_size(mope_server_t *server)
+{
+  uint32_t size = 0;
+  int16_t i;
+
+  for(i = 0; i < server->nodes; i++) {
+    size += server->node[i].count;
+  }
+  return size;
+}
+/*---------------------------------------------------------------------------*/
+
+/** @} */
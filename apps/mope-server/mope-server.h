@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) 2015, Institute for Pervasive Computing, ETH Zurich.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/**
+ * \addtogroup cc2538-mOPE
+ * @{
+ *
+ * \defgroup mope-server mOPE reference server
+ *
+ * Reference implementation of the server side of the mOPE protocol: a
+ * B-tree of DET ciphertexts whose order is learned from the client, with
+ * mutable order encodings that change as the tree is rebalanced. It is
+ * transport agnostic, messages leave through a write callback, and is used
+ * to measure the protocol without a CryptDB deployment.
+ * @{
+ *
+ * \file
+ * Header file for the mOPE reference server
+ */
+#ifndef MOPE_SERVER_H_
+#define MOPE_SERVER_H_
+
+#include "contiki.h"
+#include "mope.h"
+
+#include <stdint.h>
+
+/* Maximum number of keys of a tree node, at most 7 so that a level of the
+ * encoding fits in 4 bits */
+#ifdef MOPE_SERVER_CONF_ORDER
+#define MOPE_SERVER_ORDER      MOPE_SERVER_CONF_ORDER
+#else
+#define MOPE_SERVER_ORDER      4
+#endif
+
+#if MOPE_SERVER_ORDER < 2 || MOPE_SERVER_ORDER > 7
+#error "MOPE_SERVER_ORDER must be between 2 and 7"
+#endif
+
+/* Number of tree nodes */
+#ifdef MOPE_SERVER_CONF_NODES
+#define MOPE_SERVER_NODES      MOPE_SERVER_CONF_NODES
+#else
+#define MOPE_SERVER_NODES      128
+#endif
+
+/* Largest batch accepted in one ENC_INS_BATCH */
+#ifdef MOPE_SERVER_CONF_BATCH
+#define MOPE_SERVER_BATCH      MOPE_SERVER_CONF_BATCH
+#elif MOPE_BATCH_SIZE
+#define MOPE_SERVER_BATCH      MOPE_BATCH_SIZE
+#else
+#define MOPE_SERVER_BATCH      1
+#endif
+
+/* UDP port of the server */
+#ifdef MOPE_SERVER_CONF_PORT
+#define MOPE_SERVER_PORT       MOPE_SERVER_CONF_PORT
+#else
+#define MOPE_SERVER_PORT       5684
+#endif
+
+typedef struct {
+  uint32_t         cipher[CIPHER_LEN_WORD];
+  uint8_t          encoding[ENCODING_LEN];           /*big endian*/
+  uint8_t          encoded;                          /*encoding was sent*/
+} mope_server_key_t;
+
+/* One spare key and child so that a node can overflow before its split */
+typedef struct {
+  mope_server_key_t key[MOPE_SERVER_ORDER + 1];
+  int16_t          child[MOPE_SERVER_ORDER + 2];
+  int16_t          parent;
+  uint8_t          count;
+  uint8_t          leaf;
+} mope_server_node_t;
+
+/* Outstanding node request for values first..first+count-1 */
+typedef struct {
+  int16_t          node;
+  uint8_t          first;
+  uint8_t          count;
+  uint8_t          level;
+} mope_server_request_t;
+
+typedef struct {
+  uint32_t         inserts;                          /*values received*/
+  uint32_t         new_keys;                         /*values added to the tree*/
+  uint32_t         requests;                         /*node requests, one round-trip each*/
+  uint32_t         rounds;                           /*sequential request levels*/
+  uint32_t         bytes_in;                         /*payload received*/
+  uint32_t         bytes_out;                        /*payload sent*/
+  uint32_t         reencodings;                      /*encodings of older keys changed*/
+  uint32_t         failures;                         /*inserts refused, tree full*/
+} mope_server_stats_t;
+
+struct mope_server_t;
+
+/**
+ * Called to send a message to the client of the insert in progress.
+ * Returns the number of bytes sent, or a value less than zero on error.
+ */
+typedef int (*mope_server_write_t)(struct mope_server_t *server,
+                                   uint8_t *buf, uint16_t len);
+
+/** Holds the tree and the insert in progress. A single client is served
+ * at a time. */
+typedef struct mope_server_t {
+  mope_server_node_t    node[MOPE_SERVER_NODES];
+  uint16_t              nodes;                       /*nodes in use*/
+  int16_t               root;
+  mope_server_write_t   write;
+  void                  *session;                    /*for the write callback*/
+  /* insert in progress */
+  uint8_t               busy;
+  uint8_t               batch;                       /*batch message formats*/
+  uint8_t               count;
+  uint8_t               levels;
+  uint32_t              cipher[MOPE_SERVER_BATCH][CIPHER_LEN_WORD];
+  uint32_t              successor[MOPE_SERVER_BATCH][CIPHER_LEN_WORD];
+  uint8_t               gap[MOPE_SERVER_BATCH];
+  mope_server_request_t request[MOPE_SERVER_BATCH];
+  uint8_t               requests;
+  uint8_t               buf[UIP_CONF_BUFFER_SIZE];
+  mope_server_stats_t   stats;
+} mope_server_t;
+
+/*---------------------------------------------------------------------------*/
+/** \name mOPE reference server functions
+ * @{
+ */
+
+/** \brief Initializes an empty tree
+ *
+ * \param server  A pointer the server
+ * \param write   Callback sending messages to the client
+ * \param session Opaque pointer for the callback
+ */
+void mope_server_init(mope_server_t *server, mope_server_write_t write,
+                      void *session);
+
+/** \brief Handles a message of the client: ENC_INS, ENC_INS_BATCH or an
+ * answer to a node request. Answers are sent through the write callback.
+ *
+ * \param server  A pointer the server
+ * \param msg     The message
+ * \param len     The length of the message
+ * \return \c 0 if the message was handled, -1 otherwise
+ */
+int mope_server_handle(mope_server_t *server, uint8_t *msg, uint16_t len);
+
+/** \brief Looks up the current encoding of a DET cipher
+ *
+ * \param server   A pointer the server
+ * \param cipher   The DET cipher, CIPHER_LEN_BYTE bytes
+ * \param encoding Receives ENCODING_LEN bytes
+ * \return \c 1 if the cipher is in the tree, 0 otherwise
+ */
+int mope_server_lookup(mope_server_t *server, const uint8_t *cipher,
+                       uint8_t *encoding);
+
+/** \brief Returns the number of levels of the tree */
+uint8_t mope_server_depth(mope_server_t *server);
+
+/** \brief Returns the number of keys in the tree */
+uint32_t mope_server_size(mope_server_t *server);
+
+/** @} */
+
+#endif /* MOPE_SERVER_H_ */
+
+/**
+ * @}
+ * @}
+ */
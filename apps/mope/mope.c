@@ -41,11 +41,7 @@
  * Implementation of the cc2538 mutable Order Preserving Encryption (OPE) driver
  */
 #include "contiki.h"
-#include "dev/crypto.h"
-#include "dev/aes.h"
-#include "dev/nvic.h"
 #include "mope.h"
-#include "reg.h"
 #include <uip-ds6.h>
 
 #include <stdbool.h>
@@ -55,12 +51,14 @@
 
 #if (CIPHER_BLOCK==BLOWFISH_CIPHER_BLOCK)
 #include "blowfish.h"
+#elif (CIPHER_BLOCK==ECB_CIPHER_BLOCK)
+#include "dev/crypto.h"
+#include "dev/aes.h"
+#include "dev/nvic.h"
+#include "reg.h"
 #endif /*CIPHER_BLOCK*/
 
 
-//Initialization Vector Out
-static uint8_t iv_inout[16];
-
 void hexdump(const uint32_t *packet, int length) {
   int n = 0;
 
@@ -80,84 +78,340 @@ void hexdump(const uint32_t *packet, int length) {
   }
 }
 
-int aes_operation(uint8_t *pui8MsgIn, uint8_t *pui8MsgOut, uint8_t ui8KeyLocation,
-                     uint8_t ui8Encrypt, uint32_t len){
+#if (CIPHER_BLOCK==ECB_CIPHER_BLOCK)
+//Initialization Vector, ECB does not use it but the engine is loaded with it
+static uint8_t iv_inout[16];
+
+/* One block through the register interface, for single values */
+static uint8_t aes_block(struct mope_context_t* ctx, uint32_t* in, uint32_t* out, uint8_t encrypt) {
+    uint8_t ret = key_store_acquire(ctx->key_handle, &ctx->ui8KeyLocation);
 
+    if (ret != AES_SUCCESS)
+      return ret;
     memset(iv_inout, 0, sizeof(iv_inout));
-    //printf("AES-%s len %lu\n", ui8Encrypt == AES_ENC ? "ENC" : "DEC", len);
-    if(aes(pui8MsgOut, iv_inout, pui8MsgOut, ui8KeyLocation, ui8Encrypt, AES_ECB, len)) {
-      return 0;
-    }
+    ret = aes((uint8_t*) in, iv_inout, (uint8_t*) out, ctx->ui8KeyLocation, encrypt, AES_ECB, CIPHER_LEN_BYTE);
+    key_store_release(ctx->key_handle);
+    return ret;
+}
 
-    if(aes_start(pui8MsgIn, iv_inout, pui8MsgOut, ui8KeyLocation, ui8Encrypt, AES_ECB, len, PROCESS_CURRENT())) {
-      return 0;
+/* Starts the DMA job on the copied node, the key stays acquired until
+ * node_decrypt_finish */
+static uint8_t node_decrypt_restart(struct mope_context_t* ctx, struct process* process) {
+    uint8_t ret = key_store_acquire(ctx->key_handle, &ctx->ui8KeyLocation);
+
+    if (ret != AES_SUCCESS)
+      return ret;
+    memset(iv_inout, 0, sizeof(iv_inout));
+    ret = aes_start((uint8_t*) ctx->node_cipher, iv_inout, (uint8_t*) ctx->node_plain,
+                    ctx->ui8KeyLocation, AES_DEC, AES_ECB, ctx->node_elements*CIPHER_LEN_BYTE, process);
+    if (ret != AES_SUCCESS)
+      key_store_release(ctx->key_handle);
+    return ret;
+}
+
+/* Starts the decryption of a whole node as one ECB DMA job. The elements
+ * are copied first, the message may be gone when the engine completes. */
+static uint8_t node_decrypt_start(struct mope_context_t* ctx, uint8_t* node_elements,
+                                  uint8_t elements, struct process* process) {
+    ctx->node_ready = 0;
+    if (elements == 0 || elements > MOPE_NODE_MAX)
+      return AES_INVALID_PARAM;
+    memcpy(ctx->node_cipher, node_elements, elements*CIPHER_LEN_BYTE);
+    ctx->node_elements = elements;
+    return node_decrypt_restart(ctx, process);
+}
+
+static uint8_t node_decrypt_finish(struct mope_context_t* ctx) {
+    uint8_t ret = aes_get_result(iv_inout);
+
+    key_store_release(ctx->key_handle);
+    ctx->node_ready = (ret == AES_SUCCESS);
+    return ret;
+}
+
+/* Decrypts a whole node for the synchronous handler */
+static uint8_t node_decrypt(struct mope_context_t* ctx, uint8_t* node_elements, uint8_t elements) {
+    uint8_t ret = node_decrypt_start(ctx, node_elements, elements, NULL);
+
+    if (ret != AES_SUCCESS)
+      return ret;
+    while(!aes_check_status());
+    return node_decrypt_finish(ctx);
+}
+#endif /*CIPHER_BLOCK*/
+
+
+/* Decrypts a DET cipher */
+static uint32_t det_decrypt(struct mope_context_t* ctx, uint8_t* cipher) {
+#if (CIPHER_BLOCK==BLOWFISH_CIPHER_BLOCK)
+    uint32_t low, high;
+
+    low  =  *(uint32_t*)(cipher);
+    high =  *(uint32_t*)(cipher + 4);
+    blowfish_cipher(ctx->container, &high, &low, BLOWFISH_DECRYPT);
+    return UIP_HTONL(high);
+#elif (CIPHER_BLOCK==ECB_CIPHER_BLOCK)
+    uint32_t block[CIPHER_LEN_WORD], plain[CIPHER_LEN_WORD];
+
+    memcpy(block, cipher, CIPHER_LEN_BYTE);
+    aes_block(ctx, block, plain, AES_DEC);
+    return UIP_HTONL(plain[0]);
+#endif /*CIPHER_BLOCK*/
+}
+
+#if MOPE_CACHE_SIZE
+static uint8_t cache_hash(const uint32_t* cipher) {
+    /* DET ciphers are pseudorandom, mixing two words is enough */
+    uint32_t h = cipher[0] ^ cipher[CIPHER_LEN_WORD-1];
+
+    h ^= h >> 16;
+    h ^= h >> 8;
+    return h & (MOPE_CACHE_BUCKETS-1);
+}
+
+/* Picks an entry with the clock algorithm and unlinks it from its chain */
+static mope_cache_entry_t* cache_evict(mope_cache_t* cache) {
+    mope_cache_entry_t* e;
+    uint8_t* link;
+
+    if (cache->used < MOPE_CACHE_SIZE)
+      return &cache->entry[cache->used++];
+
+    for(;;) {
+      e = &cache->entry[cache->hand];
+      cache->hand = (cache->hand + 1) % MOPE_CACHE_SIZE;
+      if (!e->referenced)
+        break;
+      e->referenced = 0;
     }
+    for(link = &cache->bucket[cache_hash(e->cipher)];
+        *link != e - cache->entry + 1; link = &cache->entry[*link - 1].next);
+    *link = e->next;
+    cache->stats.evictions++;
+    return e;
+}
 
-    while(!aes_check_status()) {
-      asm("nop");
+/* Decrypts a DET cipher through the cache */
+static uint32_t cache_decrypt(struct mope_context_t* ctx, uint8_t* cipher) {
+    mope_cache_t* cache = &ctx->cache;
+    mope_cache_entry_t* e;
+    uint32_t key[CIPHER_LEN_WORD];
+    uint8_t i, h;
+
+    memcpy(key, cipher, CIPHER_LEN_BYTE);
+    h = cache_hash(key);
+    for(i = cache->bucket[h]; i; i = e->next) {
+      e = &cache->entry[i - 1];
+      if (memcmp(e->cipher, key, CIPHER_LEN_BYTE) == 0) {
+        e->referenced = 1;
+        cache->stats.hits++;
+        return e->value;
+      }
     }
 
-    if(aes_get_result(iv_inout)) {
-      return 0;
+    cache->stats.misses++;
+    e = cache_evict(cache);
+    memcpy(e->cipher, key, CIPHER_LEN_BYTE);
+    e->value = det_decrypt(ctx, cipher);
+    e->referenced = 0;
+    e->next = cache->bucket[h];
+    cache->bucket[h] = e - cache->entry + 1;
+    return e->value;
+}
+#endif /*MOPE_CACHE_SIZE*/
+
+/* Decrypts the index-th element of a node */
+static uint32_t node_value(struct mope_context_t* ctx, uint8_t* node_elements, uint8_t index) {
+#if (CIPHER_BLOCK==ECB_CIPHER_BLOCK)
+    if (ctx->node_ready)
+      return UIP_HTONL(ctx->node_plain[index][0]);
+#endif /*CIPHER_BLOCK*/
+#if MOPE_CACHE_SIZE
+    return cache_decrypt(ctx, node_elements + CIPHER_LEN_BYTE*index);
+#else
+    return det_decrypt(ctx, node_elements + CIPHER_LEN_BYTE*index);
+#endif /*MOPE_CACHE_SIZE*/
+}
+
+/* Binary search of the sorted elements index..elements-1 of a node for the
+ * first one greater or equal to value, sets stop_flag if it is equal */
+static uint8_t node_search(struct mope_context_t* ctx, uint8_t* node_elements,
+                           uint8_t index, uint8_t elements, uint32_t value,
+                           uint8_t* stop_flag) {
+    uint8_t high = elements, mid;
+
+    while(index < high) {
+      mid = index + (high - index)/2;
+      if (node_value(ctx, node_elements, mid) >= value) {
+        high = mid;
+      } else {
+        index = mid + 1;
+      }
     }
+    *stop_flag = index < elements && node_value(ctx, node_elements, index) == value;
+    return index;
+}
 
-    return 1;
+/* DET encryption of a value */
+static void det_encrypt(struct mope_context_t* ctx, uint32_t ptext, uint32_t* cipher) {
+#if (CIPHER_BLOCK==BLOWFISH_CIPHER_BLOCK)
+    uint32_t low  = UIP_HTONL(0);
+    uint32_t high = UIP_HTONL(ptext); /* we assume 32bit values!*/
+    blowfish_cipher(ctx->container, &high, &low, BLOWFISH_ENCRYPT);
+    cipher[0] = low;
+    cipher[1] = high;
+#elif (CIPHER_BLOCK==ECB_CIPHER_BLOCK)
+    /* DET encryption: the value padded with zeros to one block */
+    uint32_t block[CIPHER_LEN_WORD] = { UIP_HTONL(ptext) };
+    aes_block(ctx, block, cipher, AES_ENC);
+#endif /*CIPHER_BLOCK*/
 }
 
+#if MOPE_BATCH_SIZE
+/* Answers a node request for the sorted batch values first..first+count-1 */
+static uint16_t batch_lookup(struct mope_context_t* ctx, uint8_t first, uint8_t count,
+                             uint8_t* node_elements, uint8_t elements) {
+   packet_batch_t* response = (packet_batch_t*) ctx->readbuf;
+   packet_batch_entry_t* entry = (packet_batch_entry_t*) (ctx->readbuf + sizeof(packet_batch_t));
+   uint16_t v = first;
+   uint16_t end = (uint16_t) first + count;
+   uint8_t index = 1;
+   uint16_t len_msg;
+
+   if(end > ctx->batch_count) {
+     return 0;
+   }
 
-uint8_t mope_handle_interaction(struct mope_context_t* ctx, uint8_t* msg, uint16_t len){
+   /* the values are sorted, each search starts where the previous ended */
+   for(; v < end; v++, entry++) {
+     index = node_search(ctx, node_elements, index, elements, ctx->batch_value[v], &entry->stop_flg);
+     entry->index = index-1;
+   }
+
+   len_msg = sizeof(packet_batch_t) + count*sizeof(packet_batch_entry_t);
+   response->len = UIP_HTONS(len_msg);
+   response->type = INTERACT_FOR_LOOKUP_BATCH_C;
+   response->first = first;
+   response->count = count;
+   return len_msg;
+}
+#endif /*MOPE_BATCH_SIZE*/
+
+/* Finds the elements of a node request, returns their number or 0 if msg
+ * is not a well-formed node request */
+static uint8_t node_request(uint8_t* msg, uint16_t len, uint8_t** node_elements) {
+   packet_insert_t* request = (packet_insert_t*) msg;
+   uint16_t header;
+
+   if (len < sizeof(packet_insert_t))
+     return 0;
+
+   switch(request->type) {
+    case INTERACT_FOR_LOOKUP_S:
+      header = sizeof(packet_insert_t);
+      break;
+#if MOPE_BATCH_SIZE
+    case INTERACT_FOR_LOOKUP_BATCH_S:
+      header = sizeof(packet_batch_t);
+      break;
+#endif /*MOPE_BATCH_SIZE*/
+    default:
+      return 0;
+   }
+
+   if (UIP_HTONS(request->len) > len)
+     return 0;
+   len = UIP_HTONS(request->len);
+   if (len < header)
+     return 0;
+   *node_elements = msg + header;
+   return (len - header)/CIPHER_LEN_BYTE;
+}
+
+/* Answers a node request in readbuf, returns the length of the answer */
+static uint16_t lookup(struct mope_context_t* ctx, uint8_t type, uint8_t first, uint8_t count,
+                       uint8_t* node_elements, uint8_t elements) {
    uint8_t stop_flag = 0;
-   uint8_t index, ret;
+   uint8_t index;
    uint8_t* pkt = ctx->readbuf;
-   uint32_t low, high;
    uint16_t len_msg;
 
+#if MOPE_BATCH_SIZE
+   if (type == INTERACT_FOR_LOOKUP_BATCH_S)
+     return batch_lookup(ctx, first, count, node_elements, elements);
+#endif /*MOPE_BATCH_SIZE*/
+
+   /* search the elements of the node for the first key
+    * greater or equal to_be_inserted_value,
+    * remember if there was an equal value*/
+   index = node_search(ctx, node_elements, 1, elements, ctx->to_be_inserted_value, &stop_flag);
+   len_msg = sizeof(packet_response_t);
+   pkt[0] = UIP_HTONS(len_msg);             // uint16_t
+   pkt[2] = INTERACT_FOR_LOOKUP_C;          // uint8_t
+   pkt[3] = index-1;                        // uint8_t
+   pkt[4] = stop_flag;                      // uint8_t
+   return len_msg;
+}
+
+uint8_t mope_handle_interaction(struct mope_context_t* ctx, uint8_t* msg, uint16_t len){
+   uint8_t ret;
+   uint16_t len_msg;
+   uint8_t* node_elements;
+   uint8_t elements;
+
    if (len < sizeof(packet_insert_t))
      return 0;
 
    //printf("Received inquiry from server\n");
 
    packet_insert_t* request = (packet_insert_t*) msg;
+   packet_batch_t* batch = (packet_batch_t*) msg;
    len_msg = UIP_HTONS(request->len);
-   uint8_t elements = (len_msg - sizeof(packet_insert_t))/CIPHER_LEN_BYTE; // deduce 3 bytes for header: len and type
-   uint8_t* node_elements = msg + sizeof(packet_insert_t);
 
    switch(request->type) {
-    case INTERACT_FOR_LOOKUP_S: {
-       /* iterate through the elements of the node and stop if
-        * to_be_inserted_value smaller or equal the key,
-        * remember if there was an equal value*/
-
-       for(index=1; index < elements; index++) {
-          #if (CIPHER_BLOCK==BLOWFISH_CIPHER_BLOCK)
-          low  =  *(uint32_t*)(node_elements + CIPHER_LEN_BYTE*index);
-          high =  *(uint32_t*)(node_elements + CIPHER_LEN_BYTE*index + 4);
-          blowfish_cipher(ctx->container, &high, &low, BLOWFISH_DECRYPT);
-          high = UIP_HTONL(high);
-          low  = UIP_HTONL(low);
-          #elif (CIPHER_BLOCK==ECB_CIPHER_BLOCK)
-            aes_operation((uint8_t *) &tmp_value, node_elements + CIPHER_LEN_BYTE*index , ctx->ui8KeyLocation, AES_DEC, CIPHER_LEN_BYTE);
-          #endif /*CIPHER_BLOCK*/
-          stop_flag  =  (ctx->to_be_inserted_value==high);
-          if (high >= ctx->to_be_inserted_value){
-              break;
-          }
-       }
-       len_msg = sizeof(packet_response_t);
-       pkt[0] = UIP_HTONS(len_msg);             // uint16_t
-       pkt[2] = INTERACT_FOR_LOOKUP_C;          // uint8_t
-       pkt[3] = index-1;                        // uint8_t
-       pkt[4] = stop_flag;                      // uint8_t
+    case INTERACT_FOR_LOOKUP_S:
+#if MOPE_BATCH_SIZE
+    case INTERACT_FOR_LOOKUP_BATCH_S:
+#endif /*MOPE_BATCH_SIZE*/
+    {
+       elements = node_request(msg, len, &node_elements);
+       if (elements == 0)
+         return 0;
+#if (CIPHER_BLOCK==ECB_CIPHER_BLOCK)
+       if (node_decrypt(ctx, node_elements, elements) != AES_SUCCESS)
+         return 0;
+#endif /*CIPHER_BLOCK*/
+       len_msg = lookup(ctx, request->type, batch->first, batch->count, node_elements, elements);
+#if (CIPHER_BLOCK==ECB_CIPHER_BLOCK)
+       ctx->node_ready = 0;
+#endif /*CIPHER_BLOCK*/
+       if (len_msg == 0)
+         return 0;
        ret = ctx->h->write(ctx, ctx->h->session, ctx->readbuf, len_msg);
        break;
     }
     case OPE_ENCODING:{
        /* we got the final encoding */
-       memcpy(ctx->mope_encoding, node_elements, sizeof(ctx->mope_encoding));
+       memcpy(ctx->mope_encoding, msg + sizeof(packet_insert_t), sizeof(ctx->mope_encoding));
        //printf("mOPE insert succeeded.\n");
        ret = 0;
        break;
     }
+#if MOPE_BATCH_SIZE
+    case OPE_ENCODING_BATCH:{
+       /* the encodings must be in the datagram, not only in the header */
+       if (len_msg > len)
+         len_msg = len;
+       if (len_msg < sizeof(packet_batch_t)
+           || len_msg < sizeof(packet_batch_t) + batch->count*ENCODING_LEN
+           || batch->first + batch->count > ctx->batch_count)
+         return 0;
+       memcpy(ctx->batch_encoding[batch->first], msg + sizeof(packet_batch_t), batch->count*ENCODING_LEN);
+       ctx->batch_done += batch->count;
+       ret = 0;
+       break;
+    }
+#endif /*MOPE_BATCH_SIZE*/
     default:
       ret = -1;
    }
@@ -165,6 +419,49 @@ uint8_t mope_handle_interaction(struct mope_context_t* ctx, uint8_t* msg, uint16
    return ret <= 0 ? 0 : len_msg;;
 }
 
+#if (CIPHER_BLOCK==ECB_CIPHER_BLOCK)
+PT_THREAD(mope_handle_interaction_async(struct mope_context_t* ctx, uint8_t* msg, uint16_t len)) {
+   uint8_t* node_elements;
+
+   PT_BEGIN(&ctx->pt);
+
+   ctx->process = PROCESS_CURRENT();
+   ctx->sent = 0;
+   ctx->node_elements = node_request(msg, len, &node_elements);
+   if (ctx->node_elements == 0) {
+     /* nothing to decrypt */
+     ctx->sent = mope_handle_interaction(ctx, msg, len);
+     PT_EXIT(&ctx->pt);
+   }
+   ctx->node_type = ((packet_batch_t*) msg)->type;
+   ctx->node_first = ((packet_batch_t*) msg)->first;
+   ctx->node_count = ((packet_batch_t*) msg)->count;
+
+   /* msg is only valid until the first yield */
+   ctx->result = node_decrypt_start(ctx, node_elements, ctx->node_elements, ctx->process);
+   while(ctx->result == AES_RESOURCE_IN_USE) {
+     process_poll(ctx->process);
+     PT_YIELD(&ctx->pt);
+     ctx->result = node_decrypt_restart(ctx, ctx->process);
+   }
+   if (ctx->result != AES_SUCCESS)
+     PT_EXIT(&ctx->pt);
+
+   PT_WAIT_UNTIL(&ctx->pt, aes_check_status());
+   ctx->result = node_decrypt_finish(ctx);
+   if (ctx->result != AES_SUCCESS)
+     PT_EXIT(&ctx->pt);
+
+   ctx->sent = lookup(ctx, ctx->node_type, ctx->node_first, ctx->node_count,
+                      (uint8_t*) ctx->node_cipher, ctx->node_elements);
+   ctx->node_ready = 0;
+   if (ctx->sent && ctx->h->write(ctx, ctx->h->session, ctx->readbuf, ctx->sent) <= 0)
+     ctx->sent = 0;
+
+   PT_END(&ctx->pt);
+}
+#endif /*CIPHER_BLOCK*/
+
 
 uint8_t mope_client_encrypt(struct mope_context_t* ctx, uint32_t ptext) {
     uint8_t ret;
@@ -175,16 +472,7 @@ uint8_t mope_client_encrypt(struct mope_context_t* ctx, uint32_t ptext) {
 
     //printf("Initiating mOPE encrypt and insert %x\n", (unsigned int) ptext);
 
-#if (CIPHER_BLOCK==BLOWFISH_CIPHER_BLOCK)
-    uint32_t low  = UIP_HTONL(0);
-    uint32_t high = UIP_HTONL(ptext); /* we assume 32bit values!*/
-    blowfish_cipher(ctx->container, &high, &low, BLOWFISH_ENCRYPT);
-    ctx->to_be_inserted_cipher[0] = low;
-    ctx->to_be_inserted_cipher[1] = high;
-#elif (CIPHER_BLOCK==ECB_CIPHER_BLOCK)
-    /* DET encryption for short blocks: ECM */
-    ret = aes_operation((uint8_t*)&ptext, (uint8_t*) ctx->to_be_inserted_cipher, ctx->ui8KeyLocation, AES_ENC, (uint32_t) sizeof(uint32_t));
-#endif /*CIPHER_BLOCK*/
+    det_encrypt(ctx, ptext, ctx->to_be_inserted_cipher);
 
     //printf("Cipher           ");
     //hexdump(ctx->to_be_inserted_cipher, CIPHER_LEN_WORD);
@@ -212,4 +500,91 @@ uint8_t mope_client_encrypt(struct mope_context_t* ctx, uint32_t ptext) {
     return ret <= 0 ? 0 : len_msg;
 }
 
+#if MOPE_CACHE_SIZE
+void mope_client_cache_flush(struct mope_context_t* ctx) {
+    memset(&ctx->cache, 0, sizeof(ctx->cache));
+}
+
+
+const mope_cache_stats_t* mope_client_cache_stats(struct mope_context_t* ctx) {
+    return &ctx->cache.stats;
+}
+#endif /*MOPE_CACHE_SIZE*/
+
+#if MOPE_BATCH_SIZE
+uint8_t mope_client_batch_add(struct mope_context_t* ctx, uint32_t ptext) {
+    if (ctx->batch_sent) {
+      ctx->batch_count = 0;
+      ctx->batch_done = 0;
+      ctx->batch_sent = 0;
+    }
+    if (ctx->batch_count == MOPE_BATCH_SIZE)
+      return 0;
+    ctx->batch_value[ctx->batch_count++] = ptext;
+    return ctx->batch_count;
+}
+
+
+uint8_t mope_client_encrypt_batch(struct mope_context_t* ctx) {
+    packet_batch_t* request = (packet_batch_t*) ctx->readbuf;
+    uint8_t* cipher = ctx->readbuf + sizeof(packet_batch_t);
+    uint32_t value;
+    uint16_t len_msg;
+    uint8_t i, j, n;
+    int ret;
+
+    if (ctx->batch_count == 0 || ctx->batch_sent)
+      return 0;
+
+    /* insertion sort, dropping duplicates: they share one encoding */
+    for(i = 1, n = 1; i < ctx->batch_count; i++) {
+      value = ctx->batch_value[i];
+      for(j = n; j > 0 && ctx->batch_value[j-1] > value; j--);
+      if (j > 0 && ctx->batch_value[j-1] == value)
+        continue;
+      memmove(&ctx->batch_value[j+1], &ctx->batch_value[j], (n-j)*sizeof(uint32_t));
+      ctx->batch_value[j] = value;
+      n++;
+    }
+    ctx->batch_count = n;
+    ctx->batch_done = 0;
+
+    len_msg = sizeof(packet_batch_t) + n*CIPHER_LEN_BYTE;
+    if (len_msg > sizeof(ctx->readbuf))
+      return 0;
+    ctx->batch_sent = 1;
+    memset(ctx->readbuf, 0, len_msg);
+    request->len = UIP_HTONS(len_msg);
+    request->type = ENC_INS_BATCH;
+    request->first = 0;
+    request->count = n;
+    for(i = 0; i < n; i++, cipher += CIPHER_LEN_BYTE) {
+      det_encrypt(ctx, ctx->batch_value[i], ctx->to_be_inserted_cipher);
+      memcpy(cipher, (uint8_t*) ctx->to_be_inserted_cipher, CIPHER_LEN_BYTE);
+    }
+
+    ret = ctx->h->write(ctx, ctx->h->session, ctx->readbuf, len_msg);
+    return ret <= 0 ? 0 : len_msg;
+}
+
+
+const uint8_t* mope_client_batch_encoding(struct mope_context_t* ctx, uint32_t ptext) {
+    uint8_t low = 0, high = ctx->batch_count, mid;
+
+    if (!ctx->batch_sent || ctx->batch_done < ctx->batch_count)
+      return NULL;
+    while(low < high) {
+      mid = (low + high)/2;
+      if (ctx->batch_value[mid] < ptext) {
+        low = mid + 1;
+      } else {
+        high = mid;
+      }
+    }
+    if (low == ctx->batch_count || ctx->batch_value[low] != ptext)
+      return NULL;
+    return ctx->batch_encoding[low];
+}
+#endif /*MOPE_BATCH_SIZE*/
+
 /** @} */
@@ -49,7 +49,6 @@
 #define MOPE_H_
 
 #include "contiki.h"
-#include "dev/crypto.h"
 
 #include <stdbool.h>
 #include <stdint.h>
@@ -61,13 +60,30 @@ enum MsgType {
     INTERACT_FOR_LOOKUP_C, /* Client Response */
     INTERACT_FOR_LOOKUP_S, /* Server Request */
     OPE_ENCODING,  /*OPE ENCCODING in tree*/
-    CLOSE /* Close connection*/
+    CLOSE, /* Close connection*/
+    ENC_INS_BATCH,               /* Insert of a sorted batch */
+    INTERACT_FOR_LOOKUP_BATCH_C, /* Client Response for a batch */
+    INTERACT_FOR_LOOKUP_BATCH_S, /* Server Request for a batch */
+    OPE_ENCODING_BATCH           /* OPE ENCODINGs of a batch */
 };
 
+/* DET cipher of the tree elements, Blowfish unless configured otherwise */
+#ifndef BLOWFISH_CIPHER_BLOCK
+#define BLOWFISH_CIPHER_BLOCK  1
+#endif
+#ifndef ECB_CIPHER_BLOCK
+#define ECB_CIPHER_BLOCK       2
+#endif
+#ifndef CIPHER_BLOCK
+#define CIPHER_BLOCK           BLOWFISH_CIPHER_BLOCK
+#endif
+
 #if (CIPHER_BLOCK==BLOWFISH_CIPHER_BLOCK)
 #include "blowfish.h"
   #define CIPHER_LEN_BYTE    8
 #elif (CIPHER_BLOCK==ECB_CIPHER_BLOCK)
+#include "dev/crypto.h"
+#include "dev/key-store.h"
   #define CIPHER_LEN_BYTE    16
 #endif /*CIPHER_BLOCK*/
 
@@ -77,7 +93,50 @@ enum MsgType {
 
 #define ENCODING_LEN        8
 
+/* Largest node, including element 0, decrypted in one AES DMA job */
+#ifdef MOPE_CONF_NODE_MAX
+#define MOPE_NODE_MAX       MOPE_CONF_NODE_MAX
+#else
+#define MOPE_NODE_MAX       33
+#endif
+
+/* Number of values that can be buffered and inserted in one batch */
+#ifdef MOPE_CONF_BATCH_SIZE
+#define MOPE_BATCH_SIZE     MOPE_CONF_BATCH_SIZE
+#else
+#define MOPE_BATCH_SIZE     8
+#endif
+
+
+
+/* Number of decrypted tree elements cached by the client, 0 disables the
+ * cache. With AES the whole node is decrypted by the engine instead. */
+#ifdef MOPE_CONF_CACHE_SIZE
+#define MOPE_CACHE_SIZE     MOPE_CONF_CACHE_SIZE
+#elif (CIPHER_BLOCK==ECB_CIPHER_BLOCK)
+#define MOPE_CACHE_SIZE     0
+#else
+#define MOPE_CACHE_SIZE     64
+#endif
+
+/* Number of hash buckets of the cache, a power of two */
+#ifdef MOPE_CONF_CACHE_BUCKETS
+#define MOPE_CACHE_BUCKETS  MOPE_CONF_CACHE_BUCKETS
+#else
+#define MOPE_CACHE_BUCKETS  32
+#endif
+
+#if MOPE_CACHE_SIZE > 255
+#error "MOPE_CACHE_SIZE must be below 256"
+#endif
+
+#if MOPE_CACHE_BUCKETS < 1 || (MOPE_CACHE_BUCKETS & (MOPE_CACHE_BUCKETS - 1))
+#error "MOPE_CACHE_BUCKETS must be a power of two"
+#endif
 
+#if MOPE_CACHE_BUCKETS > 256
+#error "MOPE_CACHE_BUCKETS must not exceed 256, the bucket index is a uint8_t"
+#endif
 
 typedef struct {
   unsigned char    size;
@@ -86,6 +145,31 @@ typedef struct {
   int              ifindex;
 } session_t;
 
+#if MOPE_CACHE_SIZE
+/* Cached DET ciphertext to plaintext mapping */
+typedef struct {
+  uint32_t         cipher[CIPHER_LEN_WORD];
+  uint32_t         value;
+  uint8_t          next;                             /*chain, entry index + 1*/
+  uint8_t          referenced;                       /*clock bit*/
+} mope_cache_entry_t;
+
+typedef struct {
+  uint32_t         hits;
+  uint32_t         misses;
+  uint32_t         evictions;
+} mope_cache_stats_t;
+
+/* A zeroed cache is empty */
+typedef struct {
+  mope_cache_entry_t entry[MOPE_CACHE_SIZE];
+  uint8_t          bucket[MOPE_CACHE_BUCKETS];       /*entry index + 1*/
+  uint8_t          used;
+  uint8_t          hand;                             /*clock hand*/
+  mope_cache_stats_t stats;
+} mope_cache_t;
+#endif /*MOPE_CACHE_SIZE*/
+
 struct mope_context_t;
 /**
  * This structure contains callback functions used by mOPE to
@@ -125,7 +209,34 @@ typedef struct mope_context_t{
   uint32_t         to_be_inserted_cipher[CIPHER_LEN_WORD];
   uint32_t         to_be_inserted_value;
   uint8_t          mope_encoding[ENCODING_LEN];
-  uint8_t          ui8KeyLocation;                   /*AES key in the storage*/
+  uint8_t          ui8KeyLocation;                   /*AES key area while an operation runs*/
+#if (CIPHER_BLOCK==ECB_CIPHER_BLOCK)
+  key_store_handle_t key_handle;                     /*AES key, from key_store_add*/
+  /* node decrypted by one AES DMA job */
+  uint32_t         node_cipher[MOPE_NODE_MAX][CIPHER_LEN_WORD];
+  uint32_t         node_plain[MOPE_NODE_MAX][CIPHER_LEN_WORD];
+  uint8_t          node_elements;
+  uint8_t          node_ready;
+  uint8_t          node_type;
+  uint8_t          node_first;
+  uint8_t          node_count;
+  /* mope_handle_interaction_async */
+  struct pt        pt;
+  struct process   *process;
+  uint8_t          result;                           /*AES return code*/
+  uint16_t         sent;                             /*bytes of the answer*/
+#endif /*CIPHER_BLOCK*/
+#if MOPE_CACHE_SIZE
+  mope_cache_t     cache;                            /*decrypted tree elements*/
+#endif /*MOPE_CACHE_SIZE*/
+#if MOPE_BATCH_SIZE
+  /* sorted distinct values of the batch and their encodings */
+  uint32_t         batch_value[MOPE_BATCH_SIZE];
+  uint8_t          batch_encoding[MOPE_BATCH_SIZE][ENCODING_LEN];
+  uint8_t          batch_count;
+  uint8_t          batch_done;                       /*encodings received*/
+  uint8_t          batch_sent;
+#endif /*MOPE_BATCH_SIZE*/
 } mope_context_t;
 
 
@@ -145,6 +256,22 @@ typedef struct __attribute__((__packed__)) {
  /*payload cipher!*/
 } packet_insert_t;
 
+/* Structure of the Packets for batches, the values concerned are
+ * batch_value[first] to batch_value[first + count - 1] */
+typedef struct __attribute__((__packed__)) {
+ uint16_t       len;
+ uint8_t        type;
+ uint8_t        first;
+ uint8_t        count;
+ /*payload: ciphers, count entries or count encodings*/
+} packet_batch_t;
+
+/* Entry of a batched Client response, one per value concerned */
+typedef struct __attribute__((__packed__)) {
+ uint8_t        index;
+ uint8_t        stop_flg;
+} packet_batch_entry_t;
+
 /*---------------------------------------------------------------------------*/
 /** \name mOPE functions on the client side
  * @{
@@ -169,6 +296,65 @@ uint8_t mope_client_encrypt(struct mope_context_t* ctx, uint32_t ptext);
  * \return \c successful transmitted bytes
  */
 uint8_t mope_handle_interaction(struct mope_context_t* ctx, uint8_t* msg, uint16_t len);
+
+#if (CIPHER_BLOCK==ECB_CIPHER_BLOCK)
+/** \brief Handles interaction with the server like mope_handle_interaction,
+ * but the node of a request is decrypted as a single AES ECB DMA job while
+ * the calling process is released. The node is copied, msg may be reused
+ * once the thread yields. On exit ctx->sent holds the number of bytes sent
+ * and ctx->result the AES return code.
+ *
+ * \param ctx   A pointer the mope context
+ * \param msg   A pointer to the received msg from server
+ * \param len   The length of the message
+ */
+PT_THREAD(mope_handle_interaction_async(struct mope_context_t* ctx, uint8_t* msg, uint16_t len));
+#endif /*CIPHER_BLOCK*/
+
+#if MOPE_CACHE_SIZE
+/** \brief Empties the client cache, must be called when the key changes
+ *
+ * \param ctx   A pointer the mope context
+ */
+void mope_client_cache_flush(struct mope_context_t* ctx);
+
+/** \brief Returns the hit, miss and eviction counters of the client cache
+ *
+ * \param ctx   A pointer the mope context
+ * \return \c the counters since the last flush
+ */
+const mope_cache_stats_t* mope_client_cache_stats(struct mope_context_t* ctx);
+#endif /*MOPE_CACHE_SIZE*/
+
+#if MOPE_BATCH_SIZE
+/** \brief Buffers a value for the next batch. A batch that has been sent
+ * is discarded by the first value added afterwards.
+ *
+ * \param ctx   A pointer the mope context
+ * \param ptext The plaintext
+ * \return \c the number of buffered values, 0 if the batch is full
+ */
+uint8_t mope_client_batch_add(struct mope_context_t* ctx, uint32_t ptext);
+
+/** \brief Performs the mOPE encryption of all buffered values at once. The
+ * values are sorted and sent in a single ENC_INS_BATCH, so that the server
+ * walks its tree once for the whole batch. Each INTERACT_FOR_LOOKUP_BATCH_S
+ * is answered with the child indices of all the values it concerns.
+ *
+ * \param ctx   A pointer the mope context
+ * \return \c successful transmitted bytes
+ */
+uint8_t mope_client_encrypt_batch(struct mope_context_t* ctx);
+
+/** \brief Looks up the encoding of a value of the last batch
+ *
+ * \param ctx   A pointer the mope context
+ * \param ptext The plaintext
+ * \return \c the encoding, NULL if the value is not in the batch or its
+ *            encoding has not been received yet
+ */
+const uint8_t* mope_client_batch_encoding(struct mope_context_t* ctx, uint32_t ptext);
+#endif /*MOPE_BATCH_SIZE*/
 #endif /* MOPE_H_ */
 
 /**
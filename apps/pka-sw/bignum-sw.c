@@ -0,0 +1,1106 @@
+/*
+ * Copyright (c) 2015, Institute for Pervasive Computing, ETH Zurich.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/**
+ * \addtogroup pka-sw
+ * @{
+ *
+ * \file
+ * Software implementation of the cc2538 BigNum driver
+ *
+ * The operands are copied into an emulated PKA RAM with the same layout as
+ * used by the hardware driver, hence the result vector locations handed
+ * out by the start functions are interchangeable with the ones of the
+ * hardware. Modular exponentiation uses Montgomery multiplication and a
+ * sliding window of PKA_SW_EXP_WINDOW bits, the Montgomery constants of the
+ * most recently used moduli are cached.
+ */
+#include "bignum-driver.h"
+#include "pka-sw.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define ASSERT(IF) if(!(IF)) return PKA_STATUS_INVALID_PARAM;
+
+#define DEBUG 0
+#if DEBUG
+ #define PRINTF(...) printf(__VA_ARGS__)
+#else
+ #define PRINTF(...)
+#endif /* DEBUG */
+
+#ifdef PKA_SW_CONF_EXP_WINDOW
+#define PKA_SW_EXP_WINDOW PKA_SW_CONF_EXP_WINDOW
+#else
+#define PKA_SW_EXP_WINDOW 4
+#endif
+
+#ifdef PKA_SW_CONF_MONT_CACHE_SIZE
+#define PKA_SW_MONT_CACHE_SIZE PKA_SW_CONF_MONT_CACHE_SIZE
+#else
+#define PKA_SW_MONT_CACHE_SIZE 2
+#endif
+
+/** Largest intermediate result (product of two PKA_MAX_LEN numbers) */
+#define BN_MAX_LEN            (2 * PKA_MAX_LEN + 2)
+
+/** Emulated PKA RAM */
+static uint32_t pka_ram[PKA_RAM_SIZE / 4];
+#define RAM(offset)           (&pka_ram[(offset) >> 2])
+
+/** Bit i of the exponent e */
+#define EXP_BIT(e, i)         (((e)[(i) >> 5] >> ((i) & 31)) & 1)
+
+/** Emulated PKA_MSW/PKA_DIVMSW: significant words of the last result */
+static uint32_t result_len;
+/** Emulated PKA_COMPARE */
+static int compare;
+
+/** Montgomery constants of a modulus */
+typedef struct {
+  uint32_t m[PKA_MAX_LEN];    /* modulus */
+  uint32_t rr[PKA_MAX_LEN];   /* R^2 mod m, R = 2^(32 * len) */
+  uint32_t m0inv;             /* -m^-1 mod 2^32 */
+  uint8_t  len;               /* length of m in 32-bit words */
+} mont_ctx_t;
+
+static mont_ctx_t mont_cache[PKA_SW_MONT_CACHE_SIZE];
+static uint8_t mont_next;
+
+/* Scratch space shared by the operations */
+static uint32_t tmp_a[BN_MAX_LEN + 1];
+static uint32_t tmp_b[BN_MAX_LEN + 1];
+static uint32_t tmp_c[BN_MAX_LEN + 1];
+/*---------------------------------------------------------------------------*/
+void printNumber(const uint32_t *x, int numberLength) {
+  int n; for(n = numberLength - 1; n >= 0; n--){
+    printf("%08x", (unsigned int)x[n]);
+  }
+  printf("\n");
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Word level arithmetic on little endian vectors
+ */
+static uint32_t
+bn_size(const uint32_t *a, uint32_t len)
+{
+  while(len > 0 && a[len - 1] == 0) {
+    len--;
+  }
+  return len;
+}
+/*---------------------------------------------------------------------------*/
+static int
+bn_cmp(const uint32_t *a, uint32_t alen, const uint32_t *b, uint32_t blen)
+{
+  alen = bn_size(a, alen);
+  blen = bn_size(b, blen);
+  if(alen != blen) {
+    return alen > blen ? 1 : -1;
+  }
+  while(alen-- > 0) {
+    if(a[alen] != b[alen]) {
+      return a[alen] > b[alen] ? 1 : -1;
+    }
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+/* r = a + b, r has room for max(alen, blen) + 1 words, returns the length */
+static uint32_t
+bn_add(uint32_t *r, const uint32_t *a, uint32_t alen,
+       const uint32_t *b, uint32_t blen)
+{
+  uint64_t sum = 0;
+  uint32_t i;
+  uint32_t len = alen > blen ? alen : blen;
+
+  for(i = 0; i < len; i++) {
+    sum += (uint64_t)(i < alen ? a[i] : 0) + (i < blen ? b[i] : 0);
+    r[i] = (uint32_t)sum;
+    sum >>= 32;
+  }
+  r[len] = (uint32_t)sum;
+  return len + 1;
+}
+/*---------------------------------------------------------------------------*/
+/* r = a - b, r has room for alen words, returns the borrow */
+static uint32_t
+bn_sub(uint32_t *r, const uint32_t *a, uint32_t alen,
+       const uint32_t *b, uint32_t blen)
+{
+  int64_t diff = 0;
+  uint32_t i;
+
+  for(i = 0; i < alen; i++) {
+    diff += (int64_t)a[i] - (i < blen ? b[i] : 0);
+    r[i] = (uint32_t)diff;
+    diff >>= 32;
+  }
+  return diff != 0;
+}
+/*---------------------------------------------------------------------------*/
+/* r = a * b, r must not overlap a or b and has room for alen + blen words */
+static void
+bn_mul(uint32_t *r, const uint32_t *a, uint32_t alen,
+       const uint32_t *b, uint32_t blen)
+{
+  uint64_t carry;
+  uint32_t i, j;
+
+  memset(r, 0, sizeof(uint32_t) * (alen + blen));
+  for(i = 0; i < alen; i++) {
+    carry = 0;
+    for(j = 0; j < blen; j++) {
+      carry += (uint64_t)a[i] * b[j] + r[i + j];
+      r[i + j] = (uint32_t)carry;
+      carry >>= 32;
+    }
+    r[i + blen] = (uint32_t)carry;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * q = a / m and r = a mod m (Knuth, Algorithm D). Either q or r may be NULL.
+ * q has room for alen words, r for mlen words. m must not be zero.
+ */
+static void
+bn_divmod(uint32_t *q, uint32_t *r, const uint32_t *a, uint32_t alen,
+          const uint32_t *m, uint32_t mlen)
+{
+  static uint32_t un[BN_MAX_LEN + 2];
+  static uint32_t vn[BN_MAX_LEN + 1];
+  uint64_t qhat, rhat, p;
+  int64_t t, k;
+  uint32_t s, i;
+  int j;
+
+  if(q != NULL) {
+    memset(q, 0, sizeof(uint32_t) * alen);
+  }
+  alen = bn_size(a, alen);
+  mlen = bn_size(m, mlen);
+
+  /* a < m: the quotient is zero and the remainder a */
+  if(bn_cmp(a, alen, m, mlen) < 0) {
+    if(r != NULL) {
+      memset(r, 0, sizeof(uint32_t) * mlen);
+      memcpy(r, a, sizeof(uint32_t) * alen);
+    }
+    return;
+  }
+
+  /* Single word divisor */
+  if(mlen == 1) {
+    k = 0;
+    for(j = alen - 1; j >= 0; j--) {
+      p = ((uint64_t)k << 32) | a[j];
+      if(q != NULL) {
+        q[j] = (uint32_t)(p / m[0]);
+      }
+      k = p % m[0];
+    }
+    if(r != NULL) {
+      r[0] = (uint32_t)k;
+    }
+    return;
+  }
+
+  /* Normalize, such that the top bit of the divisor is set */
+  s = 0;
+  while((m[mlen - 1] << s & 0x80000000) == 0) {
+    s++;
+  }
+  for(i = mlen - 1; i > 0; i--) {
+    vn[i] = s ? (m[i] << s) | (m[i - 1] >> (32 - s)) : m[i];
+  }
+  vn[0] = m[0] << s;
+  un[alen] = s ? a[alen - 1] >> (32 - s) : 0;
+  for(i = alen - 1; i > 0; i--) {
+    un[i] = s ? (a[i] << s) | (a[i - 1] >> (32 - s)) : a[i];
+  }
+  un[0] = a[0] << s;
+
+  for(j = alen - mlen; j >= 0; j--) {
+    /* Estimate the quotient digit */
+    p = ((uint64_t)un[j + mlen] << 32) | un[j + mlen - 1];
+    qhat = p / vn[mlen - 1];
+    rhat = p - qhat * vn[mlen - 1];
+    while(qhat >> 32
+          || qhat * vn[mlen - 2] > ((rhat << 32) | un[j + mlen - 2])) {
+      qhat--;
+      rhat += vn[mlen - 1];
+      if(rhat >> 32) {
+        break;
+      }
+    }
+
+    /* Multiply and subtract */
+    k = 0;
+    for(i = 0; i < mlen; i++) {
+      p = qhat * vn[i];
+      t = (int64_t)un[i + j] - k - (int64_t)(p & 0xFFFFFFFF);
+      un[i + j] = (uint32_t)t;
+      k = (int64_t)(p >> 32) - (t >> 32);
+    }
+    t = (int64_t)un[j + mlen] - k;
+    un[j + mlen] = (uint32_t)t;
+
+    /* Add back if the estimate was one too large */
+    if(t < 0) {
+      qhat--;
+      p = 0;
+      for(i = 0; i < mlen; i++) {
+        p += (uint64_t)un[i + j] + vn[i];
+        un[i + j] = (uint32_t)p;
+        p >>= 32;
+      }
+      un[j + mlen] += (uint32_t)p;
+    }
+    if(q != NULL) {
+      q[j] = (uint32_t)qhat;
+    }
+  }
+
+  /* Denormalize the remainder */
+  if(r != NULL) {
+    for(i = 0; i < mlen - 1; i++) {
+      r[i] = s ? (un[i] >> s) | (un[i + 1] << (32 - s)) : un[i];
+    }
+    r[mlen - 1] = un[mlen - 1] >> s;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Montgomery arithmetic
+ */
+static const mont_ctx_t *
+mont_get(const uint32_t *m, uint8_t len)
+{
+  mont_ctx_t *ctx;
+  uint32_t x;
+  int i;
+
+  len = bn_size(m, len);
+  for(i = 0; i < PKA_SW_MONT_CACHE_SIZE; i++) {
+    ctx = &mont_cache[i];
+    if(ctx->len == len && memcmp(ctx->m, m, sizeof(uint32_t) * len) == 0) {
+      return ctx;
+    }
+  }
+
+  ctx = &mont_cache[mont_next];
+  mont_next = (mont_next + 1) % PKA_SW_MONT_CACHE_SIZE;
+  PRINTF("pka-sw: new Montgomery context (%u words)\n", len);
+
+  memset(ctx->m, 0, sizeof(ctx->m));
+  memcpy(ctx->m, m, sizeof(uint32_t) * len);
+  ctx->len = len;
+
+  /* m^-1 mod 2^32 by Newton iteration, m is odd */
+  x = m[0];
+  for(i = 0; i < 4; i++) {
+    x *= 2 - m[0] * x;
+  }
+  ctx->m0inv = -x;
+
+  /* R^2 mod m */
+  memset(tmp_a, 0, sizeof(uint32_t) * (2 * len + 1));
+  tmp_a[2 * len] = 1;
+  bn_divmod(NULL, ctx->rr, tmp_a, 2 * len + 1, m, len);
+  return ctx;
+}
+/*---------------------------------------------------------------------------*/
+/* r = a * b * R^-1 mod m, a and b are smaller than m, r may overlap a or b */
+static void
+mont_mul(uint32_t *r, const uint32_t *a, const uint32_t *b,
+         const mont_ctx_t *ctx)
+{
+  uint32_t t[PKA_MAX_LEN + 2];
+  uint32_t n = ctx->len;
+  uint32_t i, j, u;
+  uint64_t c;
+
+  memset(t, 0, sizeof(uint32_t) * (n + 2));
+  for(i = 0; i < n; i++) {
+    c = 0;
+    for(j = 0; j < n; j++) {
+      c += (uint64_t)a[j] * b[i] + t[j];
+      t[j] = (uint32_t)c;
+      c >>= 32;
+    }
+    c += t[n];
+    t[n] = (uint32_t)c;
+    t[n + 1] = (uint32_t)(c >> 32);
+
+    u = t[0] * ctx->m0inv;
+    c = ((uint64_t)u * ctx->m[0] + t[0]) >> 32;
+    for(j = 1; j < n; j++) {
+      c += (uint64_t)u * ctx->m[j] + t[j];
+      t[j - 1] = (uint32_t)c;
+      c >>= 32;
+    }
+    c += t[n];
+    t[n - 1] = (uint32_t)c;
+    t[n] = t[n + 1] + (uint32_t)(c >> 32);
+  }
+
+  if(t[n] != 0 || bn_cmp(t, n, ctx->m, n) >= 0) {
+    bn_sub(t, t, n + 1, ctx->m, n);
+  }
+  memcpy(r, t, sizeof(uint32_t) * n);
+}
+/*---------------------------------------------------------------------------*/
+/* r = b^e mod m, r has room for the length of m */
+static void
+mont_exp(uint32_t *r, const uint32_t *e, uint32_t elen,
+         const uint32_t *b, const mont_ctx_t *ctx)
+{
+  /* Odd powers b^1, b^3, ..., b^(2^w - 1) in the Montgomery domain */
+  static uint32_t odd[1 << (PKA_SW_EXP_WINDOW - 1)][PKA_MAX_LEN];
+  uint32_t x[PKA_MAX_LEN];
+  uint32_t n = ctx->len;
+  uint32_t window;
+  int i, low, started;
+
+  /* Transform into the Montgomery domain */
+  mont_mul(odd[0], b, ctx->rr, ctx);
+  mont_mul(x, odd[0], odd[0], ctx);
+  for(i = 1; i < (1 << (PKA_SW_EXP_WINDOW - 1)); i++) {
+    mont_mul(odd[i], odd[i - 1], x, ctx);
+  }
+  memset(x, 0, sizeof(x));
+  x[0] = 1;
+  mont_mul(x, x, ctx->rr, ctx);
+
+  /* Left to right sliding window exponentiation */
+  started = 0;
+  i = 32 * bn_size(e, elen) - 1;
+  while(i >= 0) {
+    if(!EXP_BIT(e, i)) {
+      if(started) {
+        mont_mul(x, x, x, ctx);
+      }
+      i--;
+      continue;
+    }
+
+    /* Longest window of at most w bits that ends with a one */
+    low = i - PKA_SW_EXP_WINDOW + 1;
+    if(low < 0) {
+      low = 0;
+    }
+    while(!EXP_BIT(e, low)) {
+      low++;
+    }
+    window = 0;
+    for(; i >= low; i--) {
+      window = (window << 1) | EXP_BIT(e, i);
+      if(started) {
+        mont_mul(x, x, x, ctx);
+      }
+    }
+
+    if(started) {
+      mont_mul(x, x, odd[window >> 1], ctx);
+    } else {
+      memcpy(x, odd[window >> 1], sizeof(uint32_t) * n);
+      started = 1;
+    }
+  }
+
+  /* Transform back */
+  memset(odd[0], 0, sizeof(uint32_t) * n);
+  odd[0][0] = 1;
+  mont_mul(r, x, odd[0], ctx);
+}
+/*---------------------------------------------------------------------------*/
+/* Halves y until it is odd and keeps x * 2^k == y (mod m), m is odd */
+static void
+bn_halve(uint32_t *y, uint32_t *x, const uint32_t *m, uint32_t mlen)
+{
+  uint32_t i;
+
+  while((y[0] & 1) == 0) {
+    for(i = 0; i < mlen; i++) {
+      y[i] = (y[i] >> 1) | (y[i + 1] << 31);
+    }
+    y[mlen] >>= 1;
+    if(x[0] & 1) {
+      bn_add(x, x, mlen, m, mlen);
+    }
+    for(i = 0; i < mlen; i++) {
+      x[i] = (x[i] >> 1) | (x[i + 1] << 31);
+    }
+    x[mlen] >>= 1;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* r = a^-1 mod m (binary extended euclid), m is odd. Returns 0 on success */
+static int
+bn_invmod(uint32_t *r, const uint32_t *a, uint32_t alen,
+          const uint32_t *m, uint32_t mlen)
+{
+  static uint32_t u[PKA_MAX_LEN + 1], v[PKA_MAX_LEN + 1];
+  static uint32_t x1[PKA_MAX_LEN + 1], x2[PKA_MAX_LEN + 1];
+  uint32_t *y, *z;
+  uint32_t n = mlen + 1;
+
+  memset(u, 0, sizeof(u));
+  memset(v, 0, sizeof(v));
+  memset(x1, 0, sizeof(x1));
+  memset(x2, 0, sizeof(x2));
+  bn_divmod(NULL, u, a, alen, m, mlen);
+  memcpy(v, m, sizeof(uint32_t) * mlen);
+  x1[0] = 1;
+
+  /* Invariant: x1 * a == u and x2 * a == v (mod m) */
+  for(;;) {
+    if(bn_size(u, n) == 0 || bn_size(v, n) == 0) {
+      return 1;
+    }
+    bn_halve(u, x1, m, mlen);
+    bn_halve(v, x2, m, mlen);
+    if(bn_size(u, n) == 1 && u[0] == 1) {
+      memcpy(r, x1, sizeof(uint32_t) * mlen);
+      return 0;
+    }
+    if(bn_size(v, n) == 1 && v[0] == 1) {
+      memcpy(r, x2, sizeof(uint32_t) * mlen);
+      return 0;
+    }
+    if(bn_cmp(u, n, v, n) >= 0) {
+      bn_sub(u, u, n, v, n);
+      y = x1;
+      z = x2;
+    } else {
+      bn_sub(v, v, n, u, n);
+      y = x2;
+      z = x1;
+    }
+    /* y = y - z mod m */
+    if(bn_cmp(y, n, z, n) < 0) {
+      bn_add(y, y, mlen, m, mlen);
+    }
+    bn_sub(y, y, n, z, n);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Modular arithmetic for the other software drivers, see pka-sw.h
+ */
+void
+pka_sw_mod_mul(uint32_t *r, const uint32_t *a, const uint32_t *b,
+               const uint32_t *m, uint32_t len)
+{
+  bn_mul(tmp_a, a, len, b, len);
+  bn_divmod(NULL, r, tmp_a, 2 * len, m, len);
+}
+/*---------------------------------------------------------------------------*/
+void
+pka_sw_mod_add(uint32_t *r, const uint32_t *a, const uint32_t *b,
+               const uint32_t *m, uint32_t len)
+{
+  bn_add(tmp_a, a, len, b, len);
+  if(bn_cmp(tmp_a, len + 1, m, len) >= 0) {
+    bn_sub(tmp_a, tmp_a, len + 1, m, len);
+  }
+  memcpy(r, tmp_a, sizeof(uint32_t) * len);
+}
+/*---------------------------------------------------------------------------*/
+void
+pka_sw_mod_sub(uint32_t *r, const uint32_t *a, const uint32_t *b,
+               const uint32_t *m, uint32_t len)
+{
+  if(bn_sub(r, a, len, b, len)) {
+    bn_add(tmp_a, r, len, m, len);
+    memcpy(r, tmp_a, sizeof(uint32_t) * len);
+  }
+}
+/*---------------------------------------------------------------------------*/
+int
+pka_sw_mod_inv(uint32_t *r, const uint32_t *a, const uint32_t *m, uint32_t len)
+{
+  return bn_invmod(r, a, len, m, len);
+}
+/*---------------------------------------------------------------------------*/
+int
+pka_sw_cmp(const uint32_t *a, const uint32_t *b, uint32_t len)
+{
+  return bn_cmp(a, len, b, len);
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Emulated PKA RAM access, with the layout of the hardware driver: resident
+ * vectors at the end, the vectors of an operation allocated from offset 0
+ * around the operands which are used in place.
+ */
+static uint32_t resident_floor = PKA_RAM_SIZE;
+static uint32_t bus_bytes;
+
+/* Process that holds the PKA RAM, see PKABigNumLock() */
+static struct process *lock_owner;
+static uint8_t locked;
+
+static uint32_t layout_next;
+static uint32_t layout_keep_start[2];
+static uint32_t layout_keep_end[2];
+static uint8_t layout_kept;
+static uint8_t layout_overflow;
+
+#define IN_PKA_RAM(p)          ((uintptr_t)(p) >= PKA_RAM_BASE &&           \
+                                (uintptr_t)(p) < PKA_RAM_BASE + PKA_RAM_SIZE)
+#define VECTOR_OFFSET(p)       ((uint32_t)((uintptr_t)(p) - PKA_RAM_BASE))
+#define VECTOR_WORDS(len, extra) ((len) + (len) % 2 + (extra))
+#define EXPMOD_WORDS(len)        (4 * VECTOR_WORDS(len, 2))
+
+static void
+layout_begin(void)
+{
+  layout_next = 0;
+  layout_kept = 0;
+  layout_overflow = 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+layout_keep(const uint32_t *vector, uint8_t len)
+{
+  uint32_t offset;
+
+  if(!IN_PKA_RAM(vector) || layout_kept == 2) {
+    return;
+  }
+  offset = VECTOR_OFFSET(vector);
+  if(offset >= resident_floor) {
+    return;
+  }
+  layout_keep_start[layout_kept] = offset;
+  layout_keep_end[layout_kept] = offset + 4 * VECTOR_WORDS(len, 2);
+  layout_kept++;
+}
+/*---------------------------------------------------------------------------*/
+static uint32_t
+layout_alloc(uint32_t words)
+{
+  uint32_t offset = layout_next;
+  uint8_t i = 0;
+
+  while(i < layout_kept) {
+    if(offset < layout_keep_end[i] &&
+       offset + 4 * words > layout_keep_start[i]) {
+      offset = layout_keep_end[i];
+      i = 0;
+    } else {
+      i++;
+    }
+  }
+
+  if(offset + 4 * words > resident_floor) {
+    layout_overflow = 1;
+    return 0;
+  }
+  layout_next = offset + 4 * words;
+  return offset;
+}
+/*---------------------------------------------------------------------------*/
+static uint32_t *
+layout_load(const uint32_t *vector, uint8_t len, uint8_t extra)
+{
+  uint32_t offset;
+
+  if(IN_PKA_RAM(vector)) {
+    return RAM(VECTOR_OFFSET(vector));
+  }
+
+  offset = layout_alloc(VECTOR_WORDS(len, extra));
+  if(!layout_overflow) {
+    memcpy(RAM(offset), vector, sizeof(uint32_t) * len);
+    bus_bytes += 4 * len;
+  }
+  return RAM(offset);
+}
+/*---------------------------------------------------------------------------*/
+static void
+store(uint32_t offset, const uint32_t *res, uint32_t len)
+{
+  result_len = bn_size(res, len);
+  memcpy(RAM(offset), res, sizeof(uint32_t) * len);
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t
+get_result(uint32_t* pui32ResultBuf, uint32_t ui32Size,
+           uint32_t ui32ResVectorLoc)
+{
+  if(result_len == 0) {
+    return (PKA_STATUS_RESULT_0);
+  }
+
+  PRINTF("length= %lu\n", (unsigned long)result_len);
+  if(ui32Size < result_len) {
+    return (PKA_STATUS_BUF_UNDERFLOW);
+  }
+
+  memcpy(pui32ResultBuf, RAM(ui32ResVectorLoc - PKA_RAM_BASE),
+         sizeof(uint32_t) * result_len);
+  bus_bytes += 4 * result_len;
+  return (PKA_STATUS_SUCCESS);
+}
+/*---------------------------------------------------------------------------*/
+#define ASSERT_RESULT_VECTOR(loc)                                            \
+  ASSERT((loc) >= PKA_RAM_BASE);                                             \
+  ASSERT((loc) < (PKA_RAM_BASE + PKA_RAM_SIZE));
+/*---------------------------------------------------------------------------*/
+uint8_t PKABigNumPin(uint32_t* pui32BNum, uint8_t ui8Size,
+                     uint32_t* pui32VectorLoc) {
+  uint32_t words;
+
+  ASSERT(NULL != pui32BNum);
+  ASSERT(NULL != pui32VectorLoc);
+  ASSERT(!IN_PKA_RAM(pui32BNum));
+  if(PKABigNumLocked()) {
+    return (PKA_STATUS_OPERATION_INPRG);
+  }
+  ASSERT(locked);
+
+  words = VECTOR_WORDS(ui8Size, 2);
+  ASSERT(4 * words <= resident_floor);
+  resident_floor -= 4 * words;
+
+  memcpy(RAM(resident_floor), pui32BNum, sizeof(uint32_t) * ui8Size);
+  bus_bytes += 4 * ui8Size;
+  *pui32VectorLoc = PKA_RAM_BASE + resident_floor;
+
+  return (PKA_STATUS_SUCCESS);
+}
+/*---------------------------------------------------------------------------*/
+void PKABigNumUnpinAll(void) {
+  if(PKABigNumLocked()) {
+    return;
+  }
+  resident_floor = PKA_RAM_SIZE;
+}
+/*---------------------------------------------------------------------------*/
+uint8_t PKABigNumLock(void) {
+  if(PKABigNumLocked()) {
+    return (PKA_STATUS_OPERATION_INPRG);
+  }
+  lock_owner = PROCESS_CURRENT();
+  locked = 1;
+  return (PKA_STATUS_SUCCESS);
+}
+/*---------------------------------------------------------------------------*/
+void PKABigNumUnlock(void) {
+  if(PKABigNumLocked()) {
+    return;
+  }
+  resident_floor = PKA_RAM_SIZE;
+  lock_owner = NULL;
+  locked = 0;
+}
+/*---------------------------------------------------------------------------*/
+uint8_t PKABigNumLocked(void) {
+  return locked && lock_owner != PROCESS_CURRENT();
+}
+/*---------------------------------------------------------------------------*/
+uint32_t PKABigNumBusBytes(void) {
+  return bus_bytes;
+}
+/*---------------------------------------------------------------------------*/
+uint8_t PKABigNumModStart(uint32_t* pui32BNum, uint8_t ui8BNSize,
+                          uint32_t* pui32Modulus, uint8_t ui8ModSize,
+                          uint32_t* pui32ResultVector, struct process *process) {
+  uint32_t *a, *m;
+  uint32_t offset;
+
+  ASSERT(NULL != pui32BNum);
+  ASSERT(NULL != pui32Modulus);
+  ASSERT(NULL != pui32ResultVector);
+  ASSERT(ui8BNSize <= BN_MAX_LEN);
+
+  if(PKABigNumLocked()) {
+    return (PKA_STATUS_OPERATION_INPRG);
+  }
+
+  layout_begin();
+  layout_keep(pui32BNum, ui8BNSize);
+  layout_keep(pui32Modulus, ui8ModSize);
+  a = layout_load(pui32BNum, ui8BNSize, 0);
+  m = layout_load(pui32Modulus, ui8ModSize, 2);
+  offset = layout_alloc(VECTOR_WORDS(ui8ModSize, 2));
+  ASSERT(!layout_overflow);
+  ASSERT(bn_size(m, ui8ModSize) > 0);
+
+  bn_divmod(NULL, tmp_c, a, ui8BNSize, m, ui8ModSize);
+  memset(tmp_c + bn_size(m, ui8ModSize), 0,
+         sizeof(uint32_t) * (ui8ModSize - bn_size(m, ui8ModSize)));
+  store(offset, tmp_c, ui8ModSize);
+  *pui32ResultVector = PKA_RAM_BASE + offset;
+
+  pka_register_process_notification(process);
+  pka_sw_done();
+
+  return (PKA_STATUS_SUCCESS);
+}
+/*---------------------------------------------------------------------------*/
+uint8_t PKABigNumModGetResult(uint32_t* pui32ResultBuf, uint8_t ui8Size,
+                              uint32_t ui32ResVectorLoc) {
+  ASSERT(NULL != pui32ResultBuf);
+  ASSERT_RESULT_VECTOR(ui32ResVectorLoc);
+
+  return get_result(pui32ResultBuf, ui8Size, ui32ResVectorLoc);
+}
+/*---------------------------------------------------------------------------*/
+uint8_t PKABigNumCmpStart(uint32_t* pui32BNum1, uint32_t* pui32BNum2,
+                          uint8_t ui8Size, struct process *process) {
+  uint32_t *a, *b;
+
+  ASSERT(NULL != pui32BNum1);
+  ASSERT(NULL != pui32BNum2);
+
+  if(PKABigNumLocked()) {
+    return (PKA_STATUS_OPERATION_INPRG);
+  }
+
+  layout_begin();
+  layout_keep(pui32BNum1, ui8Size);
+  layout_keep(pui32BNum2, ui8Size);
+  a = layout_load(pui32BNum1, ui8Size, 0);
+  b = layout_load(pui32BNum2, ui8Size, 0);
+  ASSERT(!layout_overflow);
+
+  compare = bn_cmp(a, ui8Size, b, ui8Size);
+
+  pka_register_process_notification(process);
+  pka_sw_done();
+
+  return (PKA_STATUS_SUCCESS);
+}
+/*---------------------------------------------------------------------------*/
+uint8_t PKABigNumCmpGetResult(void) {
+  if(compare > 0) {
+    return (PKA_STATUS_A_GR_B);
+  } else if(compare < 0) {
+    return (PKA_STATUS_A_LT_B);
+  }
+  return (PKA_STATUS_SUCCESS);
+}
+/*---------------------------------------------------------------------------*/
+uint8_t PKABigNumInvModStart(uint32_t* pui32BNum, uint8_t ui8BNSize,
+                             uint32_t* pui32Modulus, uint8_t ui8Size,
+                             uint32_t* pui32ResultVector, struct process *process) {
+  uint32_t *a, *m;
+  uint32_t offset;
+
+  ASSERT(NULL != pui32BNum);
+  ASSERT(NULL != pui32Modulus);
+  ASSERT(NULL != pui32ResultVector);
+  ASSERT(ui8BNSize <= BN_MAX_LEN);
+  ASSERT(ui8Size <= PKA_MAX_LEN);
+
+  if(PKABigNumLocked()) {
+    return (PKA_STATUS_OPERATION_INPRG);
+  }
+
+  layout_begin();
+  layout_keep(pui32BNum, ui8BNSize);
+  layout_keep(pui32Modulus, ui8Size);
+  a = layout_load(pui32BNum, ui8BNSize, 0);
+  m = layout_load(pui32Modulus, ui8Size, 0);
+  offset = layout_alloc(VECTOR_WORDS(ui8Size, 2));
+  ASSERT(!layout_overflow);
+  ASSERT(m[0] & 1);
+
+  if(bn_invmod(tmp_c, a, ui8BNSize, m, ui8Size)) {
+    /* Not invertible, reported as all zero result */
+    memset(tmp_c, 0, sizeof(uint32_t) * ui8Size);
+  }
+  store(offset, tmp_c, ui8Size);
+  *pui32ResultVector = PKA_RAM_BASE + offset;
+
+  pka_register_process_notification(process);
+  pka_sw_done();
+
+  return (PKA_STATUS_SUCCESS);
+}
+/*---------------------------------------------------------------------------*/
+uint8_t PKABigNumInvModGetResult(uint32_t* pui32ResultBuf, uint8_t ui8Size,
+                                 uint32_t ui32ResVectorLoc) {
+  ASSERT(NULL != pui32ResultBuf);
+  ASSERT_RESULT_VECTOR(ui32ResVectorLoc);
+
+  return get_result(pui32ResultBuf, ui8Size, ui32ResVectorLoc);
+}
+/*---------------------------------------------------------------------------*/
+uint8_t PKABigNumMultiplyStart(uint32_t* pui32Xplicand, uint8_t ui8XplicandSize,
+                               uint32_t* pui32Xplier, uint8_t ui8XplierSize,
+                               uint32_t* pui32ResultVector, struct process *process) {
+  uint32_t *a, *b;
+  uint32_t offset;
+
+  ASSERT(NULL != pui32Xplicand);
+  ASSERT(NULL != pui32Xplier);
+  ASSERT(NULL != pui32ResultVector);
+  ASSERT(ui8XplicandSize <= PKA_MAX_LEN);
+  ASSERT(ui8XplierSize <= PKA_MAX_LEN);
+
+  if(PKABigNumLocked()) {
+    return (PKA_STATUS_OPERATION_INPRG);
+  }
+
+  layout_begin();
+  layout_keep(pui32Xplicand, ui8XplicandSize);
+  layout_keep(pui32Xplier, ui8XplierSize);
+  a = layout_load(pui32Xplicand, ui8XplicandSize, 0);
+  b = layout_load(pui32Xplier, ui8XplierSize, 0);
+  offset = layout_alloc(VECTOR_WORDS(ui8XplicandSize + ui8XplierSize, 2));
+  ASSERT(!layout_overflow);
+
+  bn_mul(tmp_c, a, ui8XplicandSize, b, ui8XplierSize);
+  store(offset, tmp_c, ui8XplicandSize + ui8XplierSize);
+  *pui32ResultVector = PKA_RAM_BASE + offset;
+
+  pka_register_process_notification(process);
+  pka_sw_done();
+
+  return (PKA_STATUS_SUCCESS);
+}
+/*---------------------------------------------------------------------------*/
+uint8_t PKABigNumMultGetResult(uint32_t* pui32ResultBuf, uint32_t* pui32Len,
+                               uint32_t ui32ResVectorLoc) {
+  uint8_t status;
+
+  ASSERT(NULL != pui32ResultBuf);
+  ASSERT(NULL != pui32Len);
+  ASSERT_RESULT_VECTOR(ui32ResVectorLoc);
+
+  status = get_result(pui32ResultBuf, *pui32Len, ui32ResVectorLoc);
+  if(status == PKA_STATUS_SUCCESS) {
+    *pui32Len = result_len;
+  }
+  return status;
+}
+/*---------------------------------------------------------------------------*/
+uint8_t PKABigNumAddStart(uint32_t* pui32BN1, uint8_t ui8BN1Size,
+                          uint32_t* pui32BN2, uint8_t ui8BN2Size,
+                          uint32_t* pui32ResultVector, struct process *process) {
+  uint32_t *a, *b;
+  uint32_t offset, len;
+
+  ASSERT(NULL != pui32BN1);
+  ASSERT(NULL != pui32BN2);
+  ASSERT(NULL != pui32ResultVector);
+  ASSERT(ui8BN1Size < BN_MAX_LEN);
+  ASSERT(ui8BN2Size < BN_MAX_LEN);
+
+  len = ui8BN1Size > ui8BN2Size ? ui8BN1Size : ui8BN2Size;
+  if(PKABigNumLocked()) {
+    return (PKA_STATUS_OPERATION_INPRG);
+  }
+
+  layout_begin();
+  layout_keep(pui32BN1, ui8BN1Size);
+  layout_keep(pui32BN2, ui8BN2Size);
+  a = layout_load(pui32BN1, ui8BN1Size, 0);
+  b = layout_load(pui32BN2, ui8BN2Size, 0);
+  offset = layout_alloc(VECTOR_WORDS(len, 2));
+  ASSERT(!layout_overflow);
+
+  len = bn_add(tmp_c, a, ui8BN1Size, b, ui8BN2Size);
+  store(offset, tmp_c, len);
+  *pui32ResultVector = PKA_RAM_BASE + offset;
+
+  pka_register_process_notification(process);
+  pka_sw_done();
+
+  return (PKA_STATUS_SUCCESS);
+}
+/*---------------------------------------------------------------------------*/
+uint8_t PKABigNumAddGetResult(uint32_t* pui32ResultBuf, uint32_t* pui32Len,
+                              uint32_t ui32ResVectorLoc) {
+  return PKABigNumMultGetResult(pui32ResultBuf, pui32Len, ui32ResVectorLoc);
+}
+/*---------------------------------------------------------------------------*/
+uint8_t PKABigNumSubtractStart(uint32_t* pui32BN1, uint8_t ui8BN1Size,
+                               uint32_t* pui32BN2, uint8_t ui8BN2Size,
+                               uint32_t* pui32ResultVector, struct process *process) {
+  uint32_t *a, *b;
+  uint32_t offset, len;
+
+  ASSERT(NULL != pui32BN1);
+  ASSERT(NULL != pui32BN2);
+  ASSERT(NULL != pui32ResultVector);
+  ASSERT(ui8BN1Size < BN_MAX_LEN);
+  ASSERT(ui8BN2Size < BN_MAX_LEN);
+
+  len = ui8BN1Size > ui8BN2Size ? ui8BN1Size : ui8BN2Size;
+  if(PKABigNumLocked()) {
+    return (PKA_STATUS_OPERATION_INPRG);
+  }
+
+  layout_begin();
+  layout_keep(pui32BN1, ui8BN1Size);
+  layout_keep(pui32BN2, ui8BN2Size);
+  a = layout_load(pui32BN1, ui8BN1Size, 0);
+  b = layout_load(pui32BN2, ui8BN2Size, 0);
+  offset = layout_alloc(VECTOR_WORDS(len, 2));
+  ASSERT(!layout_overflow);
+
+  /* The PKA computes modulo 2^(32 * max length) */
+  memset(tmp_a, 0, sizeof(uint32_t) * len);
+  memcpy(tmp_a, a, sizeof(uint32_t) * ui8BN1Size);
+  bn_sub(tmp_c, tmp_a, len, b, ui8BN2Size);
+  store(offset, tmp_c, len);
+  *pui32ResultVector = PKA_RAM_BASE + offset;
+
+  pka_register_process_notification(process);
+  pka_sw_done();
+
+  return (PKA_STATUS_SUCCESS);
+}
+/*---------------------------------------------------------------------------*/
+uint8_t PKABigNumSubtractGetResult(uint32_t* pui32ResultBuf, uint32_t* pui32Len,
+                                   uint32_t ui32ResVectorLoc) {
+  return PKABigNumMultGetResult(pui32ResultBuf, pui32Len, ui32ResVectorLoc);
+}
+/*---------------------------------------------------------------------------*/
+uint8_t PKABigNumExpModStart(uint32_t* pui32BNum, uint8_t ui8BNSize,
+                             uint32_t* pui32Modulus, uint8_t ui8ModSize,
+                             uint32_t* pui32Base, uint8_t ui8BaseSize,
+                             uint32_t* pui32ResultVector,
+                             struct process *process) {
+  const mont_ctx_t *ctx;
+  uint32_t *e, *m;
+  uint32_t offset;
+
+  ASSERT(NULL != pui32BNum);
+  ASSERT(NULL != pui32Modulus);
+  ASSERT(NULL != pui32Base);
+  ASSERT(NULL != pui32ResultVector);
+  ASSERT(pui32Modulus != pui32Base);
+  ASSERT(!IN_PKA_RAM(pui32Base));
+  ASSERT(ui8BaseSize <= BN_MAX_LEN);
+  ASSERT(ui8ModSize <= PKA_MAX_LEN);
+
+  if(PKABigNumLocked()) {
+    return (PKA_STATUS_OPERATION_INPRG);
+  }
+
+  layout_begin();
+  layout_keep(pui32BNum, ui8BNSize);
+  layout_keep(pui32Modulus, ui8ModSize);
+  e = layout_load(pui32BNum, ui8BNSize, 0);
+  m = layout_load(pui32Modulus, ui8ModSize, 2);
+  offset = layout_alloc(EXPMOD_WORDS(ui8ModSize > ui8BaseSize ?
+                                     ui8ModSize : ui8BaseSize));
+  ASSERT(!layout_overflow);
+  ASSERT(m[0] & 1);
+  ASSERT(bn_size(m, ui8ModSize) > 1);
+
+  /* The base goes to vector C, which is replaced by the result */
+  memcpy(RAM(offset), pui32Base, sizeof(uint32_t) * ui8BaseSize);
+  bus_bytes += 4 * ui8BaseSize;
+
+  ctx = mont_get(m, ui8ModSize);
+  memset(tmp_b, 0, sizeof(uint32_t) * PKA_MAX_LEN);
+  bn_divmod(NULL, tmp_b, RAM(offset), ui8BaseSize, ctx->m, ctx->len);
+  mont_exp(tmp_c, e, ui8BNSize, tmp_b, ctx);
+  memset(tmp_c + ctx->len, 0, sizeof(uint32_t) * (ui8ModSize - ctx->len));
+  store(offset, tmp_c, ui8ModSize);
+  *pui32ResultVector = PKA_RAM_BASE + offset;
+
+  pka_register_process_notification(process);
+  pka_sw_done();
+
+  return (PKA_STATUS_SUCCESS);
+}
+/*---------------------------------------------------------------------------*/
+uint8_t PKABigNumExpModGetResult(uint32_t* pui32ResultBuf, uint8_t ui8Size,
+                                 uint32_t ui32ResVectorLoc) {
+  ASSERT(NULL != pui32ResultBuf);
+  ASSERT_RESULT_VECTOR(ui32ResVectorLoc);
+
+  return get_result(pui32ResultBuf, ui8Size, ui32ResVectorLoc);
+}
+/*---------------------------------------------------------------------------*/
+uint8_t PKABigNumDivideStart(uint32_t* pui32Xdividend, uint8_t ui8XdividendSize,
+                             uint32_t* pui32Xdivisor, uint8_t ui8XdivisorSize,
+                             uint32_t* pui32ResultVector, struct process *process) {
+  uint32_t *a, *m;
+  uint32_t offset, remainder;
+  uint32_t spacing;
+
+  ASSERT(NULL != pui32Xdividend);
+  ASSERT(NULL != pui32Xdivisor);
+  ASSERT(NULL != pui32ResultVector);
+  ASSERT(ui8XdividendSize <= BN_MAX_LEN);
+
+  // We use largest len for spacing
+  if(ui8XdividendSize > ui8XdivisorSize) {
+    spacing = ui8XdividendSize;
+  } else {
+    spacing = ui8XdivisorSize;
+  }
+  spacing += 2 + spacing % 2;
+
+  if(PKABigNumLocked()) {
+    return (PKA_STATUS_OPERATION_INPRG);
+  }
+
+  layout_begin();
+  layout_keep(pui32Xdividend, ui8XdividendSize);
+  layout_keep(pui32Xdivisor, ui8XdivisorSize);
+  a = layout_load(pui32Xdividend, ui8XdividendSize,
+                  spacing - VECTOR_WORDS(ui8XdividendSize, 0));
+  m = layout_load(pui32Xdivisor, ui8XdivisorSize,
+                  spacing - VECTOR_WORDS(ui8XdivisorSize, 0));
+  remainder = layout_alloc(spacing);
+  offset = layout_alloc(spacing);
+  ASSERT(!layout_overflow);
+  ASSERT(bn_size(m, ui8XdivisorSize) > 0);
+
+  /* Remainder at C, quotient at D */
+  bn_divmod(tmp_c, tmp_b, a, ui8XdividendSize, m, ui8XdivisorSize);
+  memcpy(RAM(remainder), tmp_b,
+         sizeof(uint32_t) * bn_size(m, ui8XdivisorSize));
+  store(offset, tmp_c, ui8XdividendSize);
+  *pui32ResultVector = PKA_RAM_BASE + offset;
+
+  pka_register_process_notification(process);
+  pka_sw_done();
+
+  return (PKA_STATUS_SUCCESS);
+}
+/*---------------------------------------------------------------------------*/
+uint8_t PKABigNumDivideGetResult(uint32_t* pui32ResultBuf, uint32_t* pui32Len,
+                                 uint32_t ui32ResVectorLoc) {
+  return PKABigNumMultGetResult(pui32ResultBuf, pui32Len, ui32ResVectorLoc);
+}
+
+/** @} */
@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2015, Institute for Pervasive Computing, ETH Zurich.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/**
+ * \addtogroup pka-sw
+ * @{
+ *
+ * \file
+ * Software backend of the cc2538 CTR-DRBG
+ *
+ * \note
+ * The key stream is computed with the AES_128 driver, whose key is replaced
+ * on every call. Do not combine it with users that keep a key in AES_128,
+ * e.g. noncoresec.
+ */
+#include "contiki.h"
+#include "ctr-drbg.h"
+#include "lib/aes-128.h"
+#include "lib/random.h"
+
+#include <stdint.h>
+#include <string.h>
+/*---------------------------------------------------------------------------*/
+uint8_t
+ctr_drbg_keystream(const uint8_t *key, const uint8_t *ctr,
+                   uint8_t *buf, uint16_t len)
+{
+  uint8_t block[AES_128_KEY_LENGTH];
+  uint8_t i;
+
+  memcpy(block, key, sizeof(block));
+  AES_128.set_key(block);
+  memcpy(block, ctr, sizeof(block));
+  for(; len >= AES_128_BLOCK_SIZE; len -= AES_128_BLOCK_SIZE) {
+    memcpy(buf, block, AES_128_BLOCK_SIZE);
+    AES_128.encrypt(buf);
+    buf += AES_128_BLOCK_SIZE;
+
+    /* Counter on the low 32 bits, like the AES engine */
+    for(i = AES_128_BLOCK_SIZE - 1; i >= AES_128_BLOCK_SIZE - 4; i--) {
+      if(++block[i]) {
+        break;
+      }
+    }
+  }
+  memset(block, 0, sizeof(block));
+  return CTR_DRBG_SUCCESS;
+}
+/*---------------------------------------------------------------------------*/
+void
+ctr_drbg_entropy(uint8_t *buf, uint16_t len)
+{
+  unsigned short r;
+
+  /* There is no noise source, the seed is only as good as random_rand() */
+  while(len--) {
+    r = random_rand();
+    *buf++ = r ^ (r >> 8);
+  }
+}
+
+/** @} */
@@ -0,0 +1,260 @@
+/*
+ * Copyright (c) 2015, Institute for Pervasive Computing, ETH Zurich.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/**
+ * \addtogroup pka-sw
+ * @{
+ *
+ * \file
+ * Software implementation of the cc2538 ECC driver
+ *
+ * Points are handled in affine coordinates. The results are kept outside
+ * of the emulated PKA RAM, the result vector locations handed out by the
+ * start functions only serve as handles.
+ */
+#include "ecc-driver.h"
+#include "bignum-driver.h"
+#include "pka-sw.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define ASSERT(IF) if(!(IF)) return PKA_STATUS_INVALID_PARAM;
+
+#define DEBUG 0
+#if DEBUG
+ #define PRINTF(...) printf(__VA_ARGS__)
+#else
+ #define PRINTF(...)
+#endif /* DEBUG */
+
+/* Handle of the result, behind the operands of the largest curve */
+#define RESULT_VECTOR         (PKA_RAM_BASE + 4 * 8 * (PKA_MAX_CURVE_SIZE + 3))
+
+/** Result of the last operation */
+static ec_point_t result;
+static uint8_t result_status;
+/*---------------------------------------------------------------------------*/
+/*
+ * Affine point arithmetic, the point at infinity is signaled by the return
+ * value 1
+ */
+static uint8_t
+ecc_double(ec_point_t *r, const ec_point_t *p, const ecc_curve_info_t *curve)
+{
+  uint32_t l[PKA_MAX_CURVE_SIZE], t[PKA_MAX_CURVE_SIZE];
+  uint32_t x[PKA_MAX_CURVE_SIZE];
+  const uint32_t *m = curve->pui32Prime;
+  uint8_t len = curve->ui8Size;
+
+  /* l = (3x^2 + a) / 2y */
+  pka_sw_mod_add(t, p->pui32Y, p->pui32Y, m, len);
+  if(pka_sw_mod_inv(t, t, m, len)) {
+    return 1; /* y = 0 */
+  }
+  pka_sw_mod_mul(l, p->pui32X, p->pui32X, m, len);
+  pka_sw_mod_add(x, l, l, m, len);
+  pka_sw_mod_add(l, x, l, m, len);
+  pka_sw_mod_add(l, l, curve->pui32A, m, len);
+  pka_sw_mod_mul(l, l, t, m, len);
+
+  /* x' = l^2 - 2x, y' = l(x - x') - y */
+  pka_sw_mod_mul(x, l, l, m, len);
+  pka_sw_mod_sub(x, x, p->pui32X, m, len);
+  pka_sw_mod_sub(x, x, p->pui32X, m, len);
+  pka_sw_mod_sub(t, p->pui32X, x, m, len);
+  pka_sw_mod_mul(t, l, t, m, len);
+  pka_sw_mod_sub(r->pui32Y, t, p->pui32Y, m, len);
+  memcpy(r->pui32X, x, sizeof(uint32_t) * len);
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t
+ecc_add(ec_point_t *r, const ec_point_t *p, const ec_point_t *q,
+        const ecc_curve_info_t *curve)
+{
+  uint32_t l[PKA_MAX_CURVE_SIZE], t[PKA_MAX_CURVE_SIZE];
+  uint32_t x[PKA_MAX_CURVE_SIZE];
+  const uint32_t *m = curve->pui32Prime;
+  uint8_t len = curve->ui8Size;
+
+  if(pka_sw_cmp(p->pui32X, q->pui32X, len) == 0) {
+    if(pka_sw_cmp(p->pui32Y, q->pui32Y, len) == 0) {
+      return ecc_double(r, p, curve);
+    }
+    return 1; /* q = -p */
+  }
+
+  /* l = (y2 - y1) / (x2 - x1) */
+  pka_sw_mod_sub(t, q->pui32X, p->pui32X, m, len);
+  pka_sw_mod_inv(t, t, m, len);
+  pka_sw_mod_sub(l, q->pui32Y, p->pui32Y, m, len);
+  pka_sw_mod_mul(l, l, t, m, len);
+
+  /* x' = l^2 - x1 - x2, y' = l(x1 - x') - y1 */
+  pka_sw_mod_mul(x, l, l, m, len);
+  pka_sw_mod_sub(x, x, p->pui32X, m, len);
+  pka_sw_mod_sub(x, x, q->pui32X, m, len);
+  pka_sw_mod_sub(t, p->pui32X, x, m, len);
+  pka_sw_mod_mul(t, l, t, m, len);
+  pka_sw_mod_sub(r->pui32Y, t, p->pui32Y, m, len);
+  memcpy(r->pui32X, x, sizeof(uint32_t) * len);
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+/* Left to right double and add */
+static uint8_t
+ecc_mul(ec_point_t *r, const uint32_t *k, const ec_point_t *p,
+        const ecc_curve_info_t *curve)
+{
+  ec_point_t acc;
+  uint8_t infinity = 1;
+  int i, bit;
+
+  memset(&acc, 0, sizeof(acc));
+  for(i = curve->ui8Size - 1; i >= 0; i--) {
+    for(bit = 31; bit >= 0; bit--) {
+      if(!infinity) {
+        infinity = ecc_double(&acc, &acc, curve);
+      }
+      if((k[i] >> bit) & 1) {
+        if(infinity) {
+          memcpy(&acc, p, sizeof(acc));
+          infinity = 0;
+        } else {
+          infinity = ecc_add(&acc, &acc, p, curve);
+        }
+      }
+    }
+  }
+  memcpy(r, &acc, sizeof(acc));
+  return infinity;
+}
+/*---------------------------------------------------------------------------*/
+static void
+set_result(uint8_t infinity, uint32_t *pui32ResultVector,
+           struct process *process)
+{
+  result_status = infinity ? PKA_STATUS_RESULT_0 : PKA_STATUS_SUCCESS;
+  *pui32ResultVector = RESULT_VECTOR;
+  pka_register_process_notification(process);
+  pka_sw_done();
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t
+get_result(ec_point_t* ptOutEcPt, uint32_t ui32ResVectorLoc)
+{
+  ASSERT(NULL != ptOutEcPt);
+  ASSERT(ui32ResVectorLoc == RESULT_VECTOR);
+
+  if(result_status != PKA_STATUS_SUCCESS) {
+    return result_status;
+  }
+  memcpy(ptOutEcPt, &result, sizeof(result));
+  return (PKA_STATUS_SUCCESS);
+}
+/*---------------------------------------------------------------------------*/
+uint8_t PKAECCMultiplyStart(uint32_t* pui32Scalar, ec_point_t* ptEcPt,
+                            ecc_curve_info_t* ptCurve, uint32_t* pui32ResultVector,
+                            struct process *process) {
+  ec_point_t p;
+
+  ASSERT(NULL != pui32Scalar);
+  ASSERT(NULL != ptEcPt);
+  ASSERT(NULL != ptCurve);
+  ASSERT(ptCurve->ui8Size <= PKA_MAX_CURVE_SIZE);
+  ASSERT(NULL != pui32ResultVector);
+  if(PKABigNumLocked()) {
+    return (PKA_STATUS_OPERATION_INPRG);
+  }
+
+  PKABigNumUnpinAll();
+  memcpy(&p, ptEcPt, sizeof(p));
+  set_result(ecc_mul(&result, pui32Scalar, &p, ptCurve),
+             pui32ResultVector, process);
+  return (PKA_STATUS_SUCCESS);
+}
+/*---------------------------------------------------------------------------*/
+uint8_t PKAECCMultiplyGetResult(ec_point_t* ptOutEcPt,
+                                uint32_t ui32ResVectorLoc) {
+  return get_result(ptOutEcPt, ui32ResVectorLoc);
+}
+/*---------------------------------------------------------------------------*/
+uint8_t PKAECCMultGenPtStart(uint32_t* pui32Scalar, ecc_curve_info_t* ptCurve,
+                             uint32_t* pui32ResultVector, struct process *process) {
+  ec_point_t g;
+
+  ASSERT(NULL != pui32Scalar);
+  ASSERT(NULL != ptCurve);
+  ASSERT(ptCurve->ui8Size <= PKA_MAX_CURVE_SIZE);
+  ASSERT(NULL != pui32ResultVector);
+  if(PKABigNumLocked()) {
+    return (PKA_STATUS_OPERATION_INPRG);
+  }
+
+  PKABigNumUnpinAll();
+  memset(&g, 0, sizeof(g));
+  memcpy(g.pui32X, ptCurve->pui32Gx, sizeof(uint32_t) * ptCurve->ui8Size);
+  memcpy(g.pui32Y, ptCurve->pui32Gy, sizeof(uint32_t) * ptCurve->ui8Size);
+  set_result(ecc_mul(&result, pui32Scalar, &g, ptCurve),
+             pui32ResultVector, process);
+  return (PKA_STATUS_SUCCESS);
+}
+/*---------------------------------------------------------------------------*/
+uint8_t PKAECCMultGenPtGetResult(ec_point_t* ptOutEcPt,
+                                 uint32_t ui32ResVectorLoc) {
+  return get_result(ptOutEcPt, ui32ResVectorLoc);
+}
+/*---------------------------------------------------------------------------*/
+uint8_t PKAECCAddStart(ec_point_t* ptEcPt1, ec_point_t* ptEcPt2,
+                       ecc_curve_info_t* ptCurve, uint32_t* pui32ResultVector,
+                       struct process *process) {
+  ec_point_t p, q;
+
+  ASSERT(NULL != ptEcPt1);
+  ASSERT(NULL != ptEcPt2);
+  ASSERT(NULL != ptCurve);
+  ASSERT(ptCurve->ui8Size <= PKA_MAX_CURVE_SIZE);
+  ASSERT(NULL != pui32ResultVector);
+  if(PKABigNumLocked()) {
+    return (PKA_STATUS_OPERATION_INPRG);
+  }
+
+  PKABigNumUnpinAll();
+  memcpy(&p, ptEcPt1, sizeof(p));
+  memcpy(&q, ptEcPt2, sizeof(q));
+  set_result(ecc_add(&result, &p, &q, ptCurve), pui32ResultVector, process);
+  return (PKA_STATUS_SUCCESS);
+}
+/*---------------------------------------------------------------------------*/
+uint8_t PKAECCAddGetResult(ec_point_t* ptOutEcPt, uint32_t ui32ResVectorLoc) {
+  return get_result(ptOutEcPt, ui32ResVectorLoc);
+}
+/*---------------------------------------------------------------------------*/
+
+/** @} */
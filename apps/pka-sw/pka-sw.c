@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2015, Institute for Pervasive Computing, ETH Zurich.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/**
+ * \addtogroup pka-sw
+ * @{
+ *
+ * \file
+ * Implementation of the software PKA engine
+ */
+#include "contiki.h"
+#include "pka-sw.h"
+
+#include <stdint.h>
+
+static struct process *notification_process = NULL;
+/*---------------------------------------------------------------------------*/
+void
+pka_sw_done(void)
+{
+  if(notification_process != NULL) {
+    process_poll(notification_process);
+    notification_process = NULL;
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+pka_init(void)
+{
+  pka_enable();
+}
+/*---------------------------------------------------------------------------*/
+void
+pka_enable(void)
+{
+}
+/*---------------------------------------------------------------------------*/
+void
+pka_disable(void)
+{
+}
+/*---------------------------------------------------------------------------*/
+uint8_t
+pka_check_status(void)
+{
+  /* Operations complete synchronously */
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+void
+pka_register_process_notification(struct process *p)
+{
+  notification_process = p;
+}
+
+/** @} */
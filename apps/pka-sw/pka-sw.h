@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2015, Institute for Pervasive Computing, ETH Zurich.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/**
+ * \addtogroup sofware-crypto
+ * @{
+ *
+ * \defgroup pka-sw Software PKA
+ *
+ * Software implementation of the cc2538 PKA driver API. The functions
+ * declared in pka.h, bignum-driver.h and ecc-driver.h are provided with the same
+ * start/check/get contract, the operations complete inside the start
+ * function and the registered process is polled as if the PKA interrupt
+ * had fired.
+ * @{
+ *
+ * \file
+ * Header file for the software PKA
+ */
+#ifndef PKA_SW_H_
+#define PKA_SW_H_
+
+#include "contiki.h"
+#include "pka.h"
+
+/** \brief Signals the completion of an operation
+ *
+ * Polls the process registered with pka_register_process_notification().
+ * This function takes the role of the PKA ISR and is only supposed to be
+ * called by the software drivers.
+ */
+void pka_sw_done(void);
+
+/** \name Modular arithmetic shared by the software drivers
+ *
+ * Operands are little endian vectors of \e len words, smaller than the
+ * modulus \e m. The result \e r may overlap the operands.
+ * @{
+ */
+/** \brief r = a * b mod m */
+void pka_sw_mod_mul(uint32_t *r, const uint32_t *a, const uint32_t *b,
+                    const uint32_t *m, uint32_t len);
+
+/** \brief r = a + b mod m */
+void pka_sw_mod_add(uint32_t *r, const uint32_t *a, const uint32_t *b,
+                    const uint32_t *m, uint32_t len);
+
+/** \brief r = a - b mod m */
+void pka_sw_mod_sub(uint32_t *r, const uint32_t *a, const uint32_t *b,
+                    const uint32_t *m, uint32_t len);
+
+/** \brief r = a^-1 mod m, m odd. Returns 0 on success */
+int pka_sw_mod_inv(uint32_t *r, const uint32_t *a, const uint32_t *m,
+                   uint32_t len);
+
+/** \brief Compares a and b, returns <0, 0 or >0 */
+int pka_sw_cmp(const uint32_t *a, const uint32_t *b, uint32_t len);
+/** @} */
+
+#endif /* PKA_SW_H_ */
+
+/**
+ * @}
+ * @}
+ */
@@ -52,6 +52,7 @@
 #include <crypto.h>
 #include <aes.h>
 #include <cmc.h>
+#include <key-store.h>
 
 //Is Upload Enabled
 static int8_t aes_upload = 1;
@@ -71,6 +72,13 @@ static uint8_t aes_interface = 0;
 //Selected AES Engine
 static int8_t aes_engine = 0;
 
+//Key in the key store, and the area it is loaded into during an operation
+static key_store_handle_t key_handle = KEY_STORE_INVALID;
+static uint8_t key_area;
+
+//State of the AES-CMC operation
+static cmc_state_t cmc;
+
 //Storage for keying material
 #if HAVE_RELIC
 static uint32_t *ctxe;
@@ -123,7 +131,11 @@ PT_THREAD(app_aes(struct pt *pt, struct packet_t *packet)) {
     }
 
     if(aes_engine == 0) { //Use Hardware Crypto
-      aes_load_keys(INCOMMING.payload.uint8, AES_KEY_STORE_SIZE_KEY_SIZE_128, 1, 0);
+      key_store_remove(key_handle);
+      key_handle = key_store_add(INCOMMING.payload.uint8, AES_KEY_STORE_SIZE_KEY_SIZE_128);
+      if(key_handle == KEY_STORE_INVALID) {
+        EXIT_APP(pt, RES_ERROR);
+      }
     } else {              //Use Software Crypto
       #if HAVE_RELIC
       //Allocate Memory during first run
@@ -170,16 +182,22 @@ PT_THREAD(app_aes(struct pt *pt, struct packet_t *packet)) {
     memcpy(buffer, BUFFER.uint8, BUFFER_SIZE);
 
     if(aes_engine == 0) { //Use Hardware Crypto
+      if(key_store_acquire(key_handle, &key_area)) {
+        free(buffer);
+        EXIT_APP(pt, RES_ERROR);
+      }
       if(aes_interface) { //aes_interface selects between DMA and Register based i/o)
         memcpy(iv_out, iv_in, 16);
         start_high_res_timer();
-        if(aes(buffer, iv_out, buffer, 0, enc, aes_mode, UIP_HTONL(INCOMMING.payload.uint32[0]))) {
+        if(aes(buffer, iv_out, buffer, key_area, enc, aes_mode, UIP_HTONL(INCOMMING.payload.uint32[0]))) {
+          key_store_release(key_handle);
           EXIT_APP(pt, RES_ERROR);
         }
         stop_high_res_timer(1);
       } else {
         start_high_res_timer();
-        if(aes_start(buffer, iv_in, buffer, 0, enc, aes_mode, UIP_HTONL(INCOMMING.payload.uint32[0]), PROCESS_CURRENT())) {
+        if(aes_start(buffer, iv_in, buffer, key_area, enc, aes_mode, UIP_HTONL(INCOMMING.payload.uint32[0]), PROCESS_CURRENT())) {
+          key_store_release(key_handle);
           EXIT_APP(pt, RES_ERROR);
         }
 
@@ -188,10 +206,12 @@ PT_THREAD(app_aes(struct pt *pt, struct packet_t *packet)) {
         }
 
         if(aes_get_result(iv_out)) {
+          key_store_release(key_handle);
           EXIT_APP(pt, RES_ERROR);
         }
         stop_high_res_timer(1);
       }
+      key_store_release(key_handle);
     } else { //Relic (supports only AES ECB encrypt)
       #if HAVE_RELIC
       if(aes_mode != AES_ECB) {
@@ -240,18 +260,28 @@ PT_THREAD(app_aes(struct pt *pt, struct packet_t *packet)) {
       EXIT_APP(pt, RES_OUT_OF_MEMORY);
     }
 
+    //Both CBC passes run as DMA jobs, the AES interrupt polls this process
+    cmc.process = PROCESS_CURRENT();
+    cmc.in = BUFFER.uint8;
+    cmc.out = buffer;
+    cmc.len = UIP_HTONL(INCOMMING.payload.uint32[0]);
+    if(key_store_acquire(key_handle, &(cmc.key_area))) {
+      free(buffer);
+      EXIT_APP(pt, RES_ERROR);
+    }
+
+    start_high_res_timer();
     if(INCOMMING.function == CMC_ENCRYPT) {
-      start_high_res_timer();
-      if(cmc_encrypt(BUFFER.uint8, buffer, 0, UIP_HTONL(INCOMMING.payload.uint32[0]))) {
-        EXIT_APP(pt, RES_ERROR);
-      }
-      stop_high_res_timer(1);
+      PT_SPAWN(pt, &(cmc.pt), cmc_encrypt_async(&cmc));
     } else {
-      start_high_res_timer();
-      if(cmc_decrypt(BUFFER.uint8, buffer, 0, UIP_HTONL(INCOMMING.payload.uint32[0]))) {
-        EXIT_APP(pt, RES_ERROR);
-      }
-      stop_high_res_timer(1);
+      PT_SPAWN(pt, &(cmc.pt), cmc_decrypt_async(&cmc));
+    }
+    stop_high_res_timer(1);
+    key_store_release(key_handle);
+
+    if(cmc.result) {
+      free(buffer);
+      EXIT_APP(pt, RES_ERROR);
     }
 
     if(aes_upload) {
@@ -50,6 +50,9 @@
 static uint32_t high, low;
 static blowfish_t *container = 0;
 
+//File holding the persisted key schedule
+#define BLOWFISH_SCHEDULE_FILE "bf-schedule"
+
 PT_THREAD(app_blowfish(struct pt *pt, struct packet_t *packet)) {
   PT_BEGIN(pt);
   /*--------------------------------------------------------------------------*/
@@ -74,6 +77,28 @@ PT_THREAD(app_blowfish(struct pt *pt, struct packet_t *packet)) {
     EXIT_APP(pt, RES_SUCCESS);
   } else
   /*--------------------------------------------------------------------------*/
+  if(INCOMMING.function == BLOWFISH_INIT_PERSISTENT) {
+    //Same as BLOWFISH_INIT, but reads the schedule back if it was stored before
+    if(UIP_HTONS(packet->payload_length) < 4) {
+      ERROR_MSG("payload_length < 4");
+      EXIT_APP(pt, RES_WRONG_PARAMETER);
+    }
+    if(UIP_HTONS(packet->payload_length) > 56) {
+      ERROR_MSG("payload_length > 56");
+      EXIT_APP(pt, RES_WRONG_PARAMETER);
+    }
+
+    if(!container) { container = malloc(sizeof(blowfish_t)); }
+    if(!container) { EXIT_APP(pt, RES_OUT_OF_MEMORY); }
+
+    start_high_res_timer();
+    blowfish_initialize_persistent(packet->payload.uint8, UIP_HTONS(packet->payload_length),
+                                   container, BLOWFISH_SCHEDULE_FILE);
+    stop_high_res_timer(1);
+
+    EXIT_APP(pt, RES_SUCCESS);
+  } else
+  /*--------------------------------------------------------------------------*/
   if(INCOMMING.function == BLOWFISH_ENC) {
     if(UIP_HTONS(packet->payload_length) != 8) {
       ERROR_MSG("payload_length != 8");
@@ -110,6 +135,78 @@ PT_THREAD(app_blowfish(struct pt *pt, struct packet_t *packet)) {
     OUTGOING.payload.uint32[1] = UIP_HTONL(high);
 
     send_result(8);
+  } else
+  /*--------------------------------------------------------------------------*/
+  if(INCOMMING.function == BLOWFISH_DEC_NODE) {
+    //Decrypts the elements of an mOPE node uploaded into BUFFER
+    if(UIP_HTONS(packet->payload_length) != 4) {
+      ERROR_MSG("payload_length != 4");
+      EXIT_APP(pt, RES_WRONG_PARAMETER);
+    }
+    static uint32_t i, elements;
+    elements = UIP_HTONL(packet->payload.uint32[0]);
+    if(elements > BUFFER_SIZE/8) {
+      ERROR_MSG("elements > BUFFER_SIZE/8");
+      EXIT_APP(pt, RES_WRONG_PARAMETER);
+    }
+
+    start_high_res_timer();
+    for(i = 0; i < elements; i++) {
+      low = BUFFER.uint32[2*i];
+      high = BUFFER.uint32[2*i+1];
+      blowfish_cipher(container, &high, &low, BLOWFISH_DECRYPT);
+    }
+    stop_high_res_timer(1);
+
+    EXIT_APP(pt, RES_SUCCESS);
+  } else
+  /*--------------------------------------------------------------------------*/
+  if(INCOMMING.function == BLOWFISH_ECB) {
+    //Encrypts or decrypts the first length bytes of BUFFER in place
+    if(UIP_HTONS(packet->payload_length) != 8) {
+      ERROR_MSG("payload_length != 8");
+      EXIT_APP(pt, RES_WRONG_PARAMETER);
+    }
+    static uint32_t mode, length;
+    mode = UIP_HTONL(packet->payload.uint32[0]);
+    length = UIP_HTONL(packet->payload.uint32[1]);
+    if(length > BUFFER_SIZE || length % BLOWFISH_BLOCK_BYTES) {
+      ERROR_MSG("length > BUFFER_SIZE or not a multiple of the block size");
+      EXIT_APP(pt, RES_WRONG_PARAMETER);
+    }
+    if(mode != BLOWFISH_ENCRYPT && mode != BLOWFISH_DECRYPT) {
+      ERROR_MSG("Unknown mode");
+      EXIT_APP(pt, RES_WRONG_PARAMETER);
+    }
+
+    start_high_res_timer();
+    blowfish_ecb(container, BUFFER.uint8, BUFFER.uint8, length, mode);
+    stop_high_res_timer(1);
+
+    EXIT_APP(pt, RES_SUCCESS);
+  } else
+  /*--------------------------------------------------------------------------*/
+  if(INCOMMING.function == BLOWFISH_CTR) {
+    //Encrypts the first length bytes of BUFFER in place, returns the counter
+    if(UIP_HTONS(packet->payload_length) != 12) {
+      ERROR_MSG("payload_length != 12");
+      EXIT_APP(pt, RES_WRONG_PARAMETER);
+    }
+    static uint32_t length;
+    static uint8_t counter[BLOWFISH_BLOCK_BYTES];
+    length = UIP_HTONL(packet->payload.uint32[0]);
+    if(length > BUFFER_SIZE) {
+      ERROR_MSG("length > BUFFER_SIZE");
+      EXIT_APP(pt, RES_WRONG_PARAMETER);
+    }
+    memcpy(counter, packet->payload.uint8 + 4, BLOWFISH_BLOCK_BYTES);
+
+    start_high_res_timer();
+    blowfish_ctr(container, counter, BUFFER.uint8, BUFFER.uint8, length);
+    stop_high_res_timer(1);
+
+    memcpy(OUTGOING.payload.uint8, counter, BLOWFISH_BLOCK_BYTES);
+    send_result(BLOWFISH_BLOCK_BYTES);
   }
   /*--------------------------------------------------------------------------*/
   else {
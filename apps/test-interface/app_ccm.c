@@ -50,6 +50,7 @@
 #include <test-interface.h>
 #include <app_timer.h>
 #include <ccm.h>
+#include <key-store.h>
 
 //Selected CCM Engine
 static int8_t ccm_engine = 0;
@@ -57,6 +58,10 @@ static int8_t ccm_engine = 0;
 //Is Upload Enabled
 static int8_t ccm_upload = 1;
 
+//Key in the key store, and the area it is loaded into during an operation
+static key_store_handle_t key_handle = KEY_STORE_INVALID;
+static uint8_t key_area;
+
 //Storage for keying material
 #if HAVE_RELIC
 static uint32_t* ctx = 0;
@@ -96,7 +101,11 @@ PT_THREAD(app_ccm(struct pt *pt, struct packet_t *packet)) {
     }
 
     if(ccm_engine == 0) { //Use Hardware Crypto
-      aes_load_keys(INCOMMING.payload.uint8, AES_KEY_STORE_SIZE_KEY_SIZE_128, 1, 0);
+      key_store_remove(key_handle);
+      key_handle = key_store_add(INCOMMING.payload.uint8, AES_KEY_STORE_SIZE_KEY_SIZE_128);
+      if(key_handle == KEY_STORE_INVALID) {
+        EXIT_APP(pt, RES_ERROR);
+      }
     } else {              //Use Software Crypto
 #if HAVE_RELIC
       //Allocate Memory during first run
@@ -128,9 +137,14 @@ PT_THREAD(app_ccm(struct pt *pt, struct packet_t *packet)) {
     }
 
     memcpy(buffer, BUFFER.uint8, BUFFER_SIZE);
+    if(ccm_engine == 0 && key_store_acquire(key_handle, &key_area)) {
+      free(buffer);
+      EXIT_APP(pt, RES_ERROR);
+    }
     start_high_res_timer();
     if(ccm_engine == 0) { //Use Hardware Crypto
-      if(ccm_auth_encrypt_start(len_len, 0, buffer+msg_len+16, buffer+msg_len+32, add_len, buffer, msg_len, mac_len, PROCESS_CURRENT())) {
+      if(ccm_auth_encrypt_start(len_len, key_area, buffer+msg_len+16, buffer+msg_len+32, add_len, buffer, msg_len, mac_len, PROCESS_CURRENT())) {
+        key_store_release(key_handle);
         EXIT_APP(pt, RES_ERROR);
       }
 
@@ -138,6 +152,7 @@ PT_THREAD(app_ccm(struct pt *pt, struct packet_t *packet)) {
         asm("nop");
       }
 
+      key_store_release(key_handle);
       if(ccm_auth_encrypt_get_result(buffer+msg_len, mac_len)) {
         EXIT_APP(pt, RES_ERROR);
       }
@@ -180,9 +195,14 @@ PT_THREAD(app_ccm(struct pt *pt, struct packet_t *packet)) {
     }
 
     memcpy(buffer, BUFFER.uint8, BUFFER_SIZE);
+    if(ccm_engine == 0 && key_store_acquire(key_handle, &key_area)) {
+      free(buffer);
+      EXIT_APP(pt, RES_ERROR);
+    }
     start_high_res_timer();
     if(ccm_engine == 0) { //Use Hardware Crypto
-      if(ccm_auth_decrypt_start(len_len, 0, buffer+msg_len+16, buffer+msg_len+32, add_len, buffer, msg_len, mac_len, PROCESS_CURRENT())) {
+      if(ccm_auth_decrypt_start(len_len, key_area, buffer+msg_len+16, buffer+msg_len+32, add_len, buffer, msg_len, mac_len, PROCESS_CURRENT())) {
+        key_store_release(key_handle);
         EXIT_APP(pt, RES_ERROR);
       }
 
@@ -190,6 +210,7 @@ PT_THREAD(app_ccm(struct pt *pt, struct packet_t *packet)) {
         asm("nop");
       }
 
+      key_store_release(key_handle);
       if(ccm_auth_decrypt_get_result(buffer, msg_len, buffer+msg_len-mac_len, mac_len)) {
         res = 0;
       } else {
@@ -39,6 +39,7 @@
 
 //System Includes
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 //Additional Apps and Drivers
@@ -57,6 +58,8 @@ extern uint32_t              pui32Gy[12];
 static ecc_curve_info_t      ec_custrom_curve;
 static ec_elgmal_map_state_t ec_elgmal_map;
 static ec_elgmal_enc_state_t ec_elgmal;
+static ec_elgamal_dlog_state_t ec_elgmal_dlog;
+static ec_elgamal_bsgs_table_t ec_elgmal_table;
 
 PT_THREAD(app_elgamal(struct pt *pt, struct packet_t *packet)) {
   PT_BEGIN(pt);
@@ -73,6 +76,8 @@ PT_THREAD(app_elgamal(struct pt *pt, struct packet_t *packet)) {
   ec_elgmal_map.process       = PROCESS_CURRENT();
   ec_elgmal.curve_info        = &ec_custrom_curve;
   ec_elgmal.process           = PROCESS_CURRENT();
+  ec_elgmal_dlog.curve_info   = &ec_custrom_curve;
+  ec_elgmal_dlog.process      = PROCESS_CURRENT();
 
   /*--------------------------------------------------------------------------*/
   if(INCOMMING.function == EG_SET_CURVE) {
@@ -103,10 +108,8 @@ PT_THREAD(app_elgamal(struct pt *pt, struct packet_t *packet)) {
       EXIT_APP(pt, RES_WRONG_PARAMETER);
     }
 
-    uint8_t i; for(i = 0; i< ec_custrom_curve.ui8Size; i++) {
-      ec_elgmal_map.exponent[i] = UIP_HTONL(packet->payload.uint32[i]);
-    }
-
+    /* Accepted for older hosts, the square root exponent (p+1)/4 is
+     * derived from the curve */
     EXIT_APP(pt, RES_SUCCESS);
   } else
   /*--------------------------------------------------------------------------*/
@@ -245,6 +248,122 @@ PT_THREAD(app_elgamal(struct pt *pt, struct packet_t *packet)) {
     }
   } else
   /*--------------------------------------------------------------------------*/
+  if(INCOMMING.function == EG_PRECOMPUTE) {
+    if(UIP_HTONS(packet->payload_length) != 1) {
+      ERROR_MSG("payload_length != 1");
+      EXIT_APP(pt, RES_WRONG_PARAMETER);
+    }
+
+    //Disable the fixed-base tables
+    if(!packet->payload.uint8[0]) {
+      ec_elgmal.comb = 0;
+      EXIT_APP(pt, RES_SUCCESS);
+    }
+
+    start_timer(0);
+    PT_SPAWN(pt, &(ec_elgmal.pt), ec_elgamal_precompute(&ec_elgmal));
+    stop_timer(0, 1);
+
+    if(ec_elgmal.result) {
+      EXIT_APP(pt, RES_ERROR);
+    } else {
+      EXIT_APP(pt, RES_SUCCESS);
+    }
+  } else
+  /*--------------------------------------------------------------------------*/
+  if(INCOMMING.function == EG_RING) {
+    if(UIP_HTONS(packet->payload_length) != 1) {
+      ERROR_MSG("payload_length != 1");
+      EXIT_APP(pt, RES_WRONG_PARAMETER);
+    }
+
+    #if EC_ELGAMAL_RING_SIZE
+    if(packet->payload.uint8[0]) {
+      ec_elgamal_ring_start(&ec_elgmal);
+    } else {
+      ec_elgamal_ring_stop();
+    }
+    EXIT_APP(pt, RES_SUCCESS);
+    #else
+    EXIT_APP(pt, RES_NOT_IMPLEMENTED);
+    #endif
+  } else
+  /*--------------------------------------------------------------------------*/
+  if(INCOMMING.function == EG_RING_STATS) {
+    #if EC_ELGAMAL_RING_SIZE
+    const ec_elgamal_ring_stats_t *stats = ec_elgamal_ring_get_stats();
+
+    //We Upload the occupancy and the counters
+    OUTGOING.payload.uint32[0] = UIP_HTONL(ec_elgamal_ring_count());
+    OUTGOING.payload.uint32[1] = UIP_HTONL(stats->filled);
+    OUTGOING.payload.uint32[2] = UIP_HTONL(stats->drained);
+    OUTGOING.payload.uint32[3] = UIP_HTONL(stats->empty);
+    send_result(16);
+    #else
+    EXIT_APP(pt, RES_NOT_IMPLEMENTED);
+    #endif
+  } else
+  /*--------------------------------------------------------------------------*/
+  if(INCOMMING.function == EG_BSGS_TABLE) {
+    if(UIP_HTONS(packet->payload_length) != 4) {
+      ERROR_MSG("payload_length != 4");
+      EXIT_APP(pt, RES_WRONG_PARAMETER);
+    }
+
+    //Replace the previous table
+    free(ec_elgmal_dlog.table_x);
+    free(ec_elgmal_dlog.table_j);
+    ec_elgmal_table.size = 0;
+    ec_elgmal_dlog.table_size = UIP_HTONL(packet->payload.uint32[0]);
+    ec_elgmal_dlog.table_x = malloc(sizeof(uint32_t) * ec_elgmal_dlog.table_size);
+    ec_elgmal_dlog.table_j = malloc(sizeof(uint16_t) * ec_elgmal_dlog.table_size);
+    if(!ec_elgmal_dlog.table_x || !ec_elgmal_dlog.table_j) {
+      EXIT_APP(pt, RES_OUT_OF_MEMORY);
+    }
+
+    start_timer(0);
+    PT_SPAWN(pt, &(ec_elgmal_dlog.pt), ec_elgamal_bsgs_generate(&ec_elgmal_dlog));
+    stop_timer(0, 1);
+
+    if(ec_elgmal_dlog.result) {
+      EXIT_APP(pt, RES_ERROR);
+    }
+
+    ec_elgmal_table.size = ec_elgmal_dlog.table_size;
+    ec_elgmal_table.x    = ec_elgmal_dlog.table_x;
+    ec_elgmal_table.j    = ec_elgmal_dlog.table_j;
+    ec_elgmal_dlog.table = &ec_elgmal_table;
+    EXIT_APP(pt, RES_SUCCESS);
+  } else
+  /*--------------------------------------------------------------------------*/
+  if(INCOMMING.function == EG_BSGS_DECODE) {
+    if(UIP_HTONS(packet->payload_length) != 4) {
+      ERROR_MSG("payload_length != 4");
+      EXIT_APP(pt, RES_WRONG_PARAMETER);
+    }
+    if(!ec_elgmal_table.size) {
+      ERROR_MSG("EG_BSGS_TABLE missing");
+      EXIT_APP(pt, RES_ERROR);
+    }
+
+    //Decode the plain text point of ec_elgmal
+    ec_elgmal_dlog.bound = UIP_HTONL(packet->payload.uint32[0]);
+    memcpy(&ec_elgmal_dlog.plain, &ec_elgmal.plain, sizeof(ec_point_t));
+
+    start_timer(0);
+    PT_SPAWN(pt, &(ec_elgmal_dlog.pt), ec_elgamal_dlog(&ec_elgmal_dlog));
+    stop_timer(0, 1);
+
+    if(ec_elgmal_dlog.result) {
+      EXIT_APP(pt, RES_ERROR);
+    }
+
+    //We Upload the plain text and the number of giant steps
+    OUTGOING.payload.uint32[0] = UIP_HTONL(ec_elgmal_dlog.plain_int);
+    OUTGOING.payload.uint32[1] = UIP_HTONL(ec_elgmal_dlog.giant_steps);
+    send_result(8);
+  } else
+  /*--------------------------------------------------------------------------*/
   if(INCOMMING.function == EG_ENC) {
     //Clear Output Variable
     memset(ec_elgmal.cipher_p1.pui32X, 0, sizeof(ec_elgmal.cipher_p1.pui32X));
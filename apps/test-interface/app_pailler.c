@@ -49,6 +49,7 @@
 
 //Storage for keying material
 static paillier_secrete_state_t* paillier_state = 0;
+static paillier_agg_t* paillier_agg = 0;
 
 PT_THREAD(app_pailler(struct pt *pt, struct packet_t *packet)) {
   PT_BEGIN(pt);
@@ -129,6 +130,18 @@ PT_THREAD(app_pailler(struct pt *pt, struct packet_t *packet)) {
     send_result(paillier_state->CTLen*4);
   } else
   /*--------------------------------------------------------------------------*/
+  if(INCOMMING.function == PAILLER_SET_FAST_G) {
+    //g = n+1 shortcut of paillier_enc(), set by paillier_gen()
+    paillier_state->FastG = packet->payload.uint8[0];
+    EXIT_APP(pt, RES_SUCCESS);
+  } else
+  /*--------------------------------------------------------------------------*/
+  if(INCOMMING.function == PAILLER_SET_CRT) {
+    //CRT decryption of paillier_dec(), set by paillier_gen()
+    paillier_state->Crt = packet->payload.uint8[0];
+    EXIT_APP(pt, RES_SUCCESS);
+  } else
+  /*--------------------------------------------------------------------------*/
   if(INCOMMING.function == PAILLER_GEN) {
     //Clear Output Variable
     memset(paillier_state->PublicN, 0,  sizeof(uint32_t) * plain_size);
@@ -175,6 +188,50 @@ PT_THREAD(app_pailler(struct pt *pt, struct packet_t *packet)) {
     }
   } else
   /*--------------------------------------------------------------------------*/
+  if(INCOMMING.function == PAILLER_AGG_INIT) {
+    if(!paillier_agg) { paillier_agg = malloc(sizeof(paillier_agg_t)); }
+    if(!paillier_agg) { EXIT_APP(pt, RES_OUT_OF_MEMORY); }
+
+    paillier_agg_init(paillier_agg);
+    EXIT_APP(pt, RES_SUCCESS);
+  } else
+  /*--------------------------------------------------------------------------*/
+  if(INCOMMING.function == PAILLER_AGG_ADD || INCOMMING.function == PAILLER_AGG_ADD_SCALED) {
+    if(!paillier_agg) {
+      ERROR_MSG("PAILLER_AGG_INIT missing");
+      EXIT_APP(pt, RES_ERROR);
+    }
+
+    //Adds the cipher-text, scaled by the plain-text constant if requested
+    start_timer(0);
+    PT_SPAWN(pt, &(paillier_state->pt), paillier_agg_add(paillier_state, paillier_agg, INCOMMING.function == PAILLER_AGG_ADD_SCALED));
+    stop_timer(0, 1);
+
+    if(paillier_state->result) {
+      EXIT_APP(pt, RES_ERROR);
+    } else {
+      EXIT_APP(pt, RES_SUCCESS);
+    }
+  } else
+  /*--------------------------------------------------------------------------*/
+  if(INCOMMING.function == PAILLER_AGG_FINISH) {
+    if(!paillier_agg) {
+      ERROR_MSG("PAILLER_AGG_INIT missing");
+      EXIT_APP(pt, RES_ERROR);
+    }
+
+    //Result is stored in the cipher-text
+    start_timer(0);
+    PT_SPAWN(pt, &(paillier_state->pt), paillier_agg_finish(paillier_state, paillier_agg));
+    stop_timer(0, 1);
+
+    if(paillier_state->result) {
+      EXIT_APP(pt, RES_ERROR);
+    } else {
+      EXIT_APP(pt, RES_SUCCESS);
+    }
+  } else
+  /*--------------------------------------------------------------------------*/
   if(INCOMMING.function == PAILLER_DEC) {
     //Clear Output Variable
     memset(paillier_state->PlainText, 0, sizeof(uint32_t) * plain_size);
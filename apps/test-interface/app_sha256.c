@@ -50,6 +50,12 @@
 #include <test-interface.h>
 #include <app_timer.h>
 
+//TinyDTLS HMAC and PRF
+#if USE_APP_HMAC
+#include "hmac.h"
+#include "dtlscrypto.h"
+#endif
+
 //Selected Hash Engine
 int8_t sha_engine = 0;
 
@@ -83,7 +89,9 @@ PT_THREAD(app_sha256(struct pt *pt, struct packet_t *packet)) {
       start_high_res_timer();
       static sha256_state_t state;
       CHECK_RESULT(pt, sha256_init(&state));
-      CHECK_RESULT(pt, sha256_process(&state, BUFFER.uint8, UIP_HTONS(INCOMMING.payload.uint16[0])));
+      CHECK_RESULT(pt, sha256_process_start(&state, BUFFER.uint8, UIP_HTONS(INCOMMING.payload.uint16[0]), PROCESS_CURRENT()));
+      PT_WAIT_UNTIL(pt, sha256_check_status(&state));
+      CHECK_RESULT(pt, sha256_get_result(&state));
       CHECK_RESULT(pt, sha256_done(&state, OUTGOING.payload.uint8));
       stop_high_res_timer(1);
 
@@ -97,6 +105,83 @@ PT_THREAD(app_sha256(struct pt *pt, struct packet_t *packet)) {
     }
     send_result(32);
   /*--------------------------------------------------------------------------*/
+  } else
+  if(INCOMMING.function == CALC_HMAC) {
+    //Payload: key length, message length, key. The message is in BUFFER
+    if(UIP_HTONS(packet->payload_length) < 4 ||
+       UIP_HTONS(packet->payload_length) != 4 + UIP_HTONS(INCOMMING.payload.uint16[0])) {
+      ERROR_MSG("payload_length != 4 + key length");
+      EXIT_APP(pt, RES_WRONG_PARAMETER);
+    }
+    if(UIP_HTONS(INCOMMING.payload.uint16[1]) > BUFFER_SIZE) {
+      ERROR_MSG("message length > BUFFER_SIZE");
+      EXIT_APP(pt, RES_WRONG_PARAMETER);
+    }
+
+#if USE_APP_HMAC
+    {
+      static dtls_hmac_context_t hmac;
+      uint16_t msg_len = UIP_HTONS(INCOMMING.payload.uint16[1]);
+
+      //1: key pads, 2: MAC, 3: MAC with the cached key pads
+      start_high_res_timer();
+      dtls_hmac_init(&hmac, &INCOMMING.payload.uint8[4], UIP_HTONS(INCOMMING.payload.uint16[0]));
+      stop_high_res_timer(1);
+
+      start_high_res_timer();
+      dtls_hmac_update(&hmac, BUFFER.uint8, msg_len);
+      dtls_hmac_finalize(&hmac, OUTGOING.payload.uint8);
+      stop_high_res_timer(2);
+
+      start_high_res_timer();
+      dtls_hmac_reset(&hmac);
+      dtls_hmac_update(&hmac, BUFFER.uint8, msg_len);
+      dtls_hmac_finalize(&hmac, OUTGOING.payload.uint8);
+      stop_high_res_timer(3);
+    }
+    send_result(DTLS_HMAC_DIGEST_SIZE);
+#else
+    ERROR_MSG("TinyDTLS not compiled in");
+    EXIT_APP(pt, RES_NOT_IMPLEMENTED);
+#endif
+  /*--------------------------------------------------------------------------*/
+  } else
+  if(INCOMMING.function == CALC_PRF) {
+    //Payload: output length, key length, label length, seed length, key,
+    //label. The seed is in BUFFER
+    if(UIP_HTONS(packet->payload_length) < 8 ||
+       UIP_HTONS(packet->payload_length) != 8 + UIP_HTONS(INCOMMING.payload.uint16[1])
+                                              + UIP_HTONS(INCOMMING.payload.uint16[2])) {
+      ERROR_MSG("payload_length != 8 + key length + label length");
+      EXIT_APP(pt, RES_WRONG_PARAMETER);
+    }
+    if(UIP_HTONS(INCOMMING.payload.uint16[0]) > PAYLOAD_SIZE) {
+      ERROR_MSG("output length > PAYLOAD_SIZE");
+      EXIT_APP(pt, RES_WRONG_PARAMETER);
+    }
+    if(UIP_HTONS(INCOMMING.payload.uint16[3]) > BUFFER_SIZE) {
+      ERROR_MSG("seed length > BUFFER_SIZE");
+      EXIT_APP(pt, RES_WRONG_PARAMETER);
+    }
+
+#if USE_APP_HMAC
+    {
+      uint16_t key_len = UIP_HTONS(INCOMMING.payload.uint16[1]);
+
+      start_high_res_timer();
+      dtls_prf(&INCOMMING.payload.uint8[8], key_len,
+               &INCOMMING.payload.uint8[8 + key_len], UIP_HTONS(INCOMMING.payload.uint16[2]),
+               BUFFER.uint8, UIP_HTONS(INCOMMING.payload.uint16[3]),
+               NULL, 0,
+               OUTGOING.payload.uint8, UIP_HTONS(INCOMMING.payload.uint16[0]));
+      stop_high_res_timer(1);
+    }
+    send_result(UIP_HTONS(INCOMMING.payload.uint16[0]));
+#else
+    ERROR_MSG("TinyDTLS not compiled in");
+    EXIT_APP(pt, RES_NOT_IMPLEMENTED);
+#endif
+  /*--------------------------------------------------------------------------*/
   } else {
     ERROR_MSG("Unknown Function");
     EXIT_APP(pt, RES_UNKOWN_FUNCTION);
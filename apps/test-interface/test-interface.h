@@ -110,6 +110,8 @@ enum TIMER_FUNCTION {
 enum SHA256_FUNCTION {
   SELECT_SHA256_ENGINE    =  1,
   CALC_HASH               =  2,
+  CALC_HMAC               =  3,
+  CALC_PRF                =  4,
 };
 
 enum CCM_FUNCTION {
@@ -159,6 +161,12 @@ enum PAILLER_FUNCTION {
   PAILLER_ENC             =  8,
   PAILLER_DEC             =  9,
   PAILLER_ADD             = 10,
+  PAILLER_SET_FAST_G      = 11,
+  PAILLER_SET_CRT         = 12,
+  PAILLER_AGG_INIT        = 13,
+  PAILLER_AGG_ADD         = 14,
+  PAILLER_AGG_ADD_SCALED  = 15,
+  PAILLER_AGG_FINISH      = 16,
 };
 
 enum ELGAMAL_FUNCTION {
@@ -173,12 +181,21 @@ enum ELGAMAL_FUNCTION {
   EG_DEC                  =  9,
   EG_ADD                  = 10,
   EG_MAP_TO_EC_ALT        = 11,
+  EG_BSGS_TABLE           = 12,
+  EG_BSGS_DECODE          = 13,
+  EG_PRECOMPUTE           = 14,
+  EG_RING                 = 15,
+  EG_RING_STATS           = 16,
 };
 
 enum BLOWFISH_FUNCTION {
   BLOWFISH_INIT           =  1,
   BLOWFISH_ENC            =  2,
   BLOWFISH_DEC            =  3,
+  BLOWFISH_DEC_NODE       =  4,
+  BLOWFISH_ECB            =  5,
+  BLOWFISH_CTR            =  6,
+  BLOWFISH_INIT_PERSISTENT =  7,
 };
 
 /**
@@ -32,16 +32,30 @@
 #include "ccm-glue.h"
 #include "crypto.h"
 #include "ccm.h"
+#include "key-store.h"
 #include "pt.h"
 #include "mt.h"
 #include "debug.h"
 
+/* Key of the next record, loaded into a key area only when not cached.
+ * The operations keep their own copy, other threads may set a key while
+ * they yield. */
+static key_store_handle_t key_handle = KEY_STORE_INVALID;
+
 int
 hw_ccm_encrypt(aes128_ccm_t *ccm_ctx, const unsigned char *src, size_t srclen,
                  unsigned char *buf, unsigned char *nounce,
                  const unsigned char *aad, size_t la) {
+  key_store_handle_t handle = key_handle;
+  uint8_t area;
+
   crypto_enable();
-  if(ccm_auth_encrypt_start(3, 0, nounce, aad, la, buf, srclen, 8, PROCESS_CURRENT())) {
+  if(key_store_acquire(handle, &area)) {
+    crypto_disable();
+    return -1;
+  }
+  if(ccm_auth_encrypt_start(3, area, nounce, aad, la, buf, srclen, 8, PROCESS_CURRENT())) {
+    key_store_release(handle);
     crypto_disable();
     return -1;
   }
@@ -50,6 +64,7 @@ hw_ccm_encrypt(aes128_ccm_t *ccm_ctx, const unsigned char *src, size_t srclen,
     mt_yield();
   }
 
+  key_store_release(handle);
   if(ccm_auth_encrypt_get_result(buf + srclen, 8)) {
     crypto_disable();
     return -1;
@@ -64,8 +79,16 @@ hw_ccm_decrypt(aes128_ccm_t *ccm_ctx, const unsigned char *src,
                  size_t srclen, unsigned char *buf,
                  unsigned char *nounce,
                  const unsigned char *aad, size_t la) {
+  key_store_handle_t handle = key_handle;
+  uint8_t area;
+
   crypto_enable();
-  if(ccm_auth_decrypt_start(3, 0, nounce, aad, la, buf, srclen, 8, PROCESS_CURRENT())) {
+  if(key_store_acquire(handle, &area)) {
+    crypto_disable();
+    return -1;
+  }
+  if(ccm_auth_decrypt_start(3, area, nounce, aad, la, buf, srclen, 8, PROCESS_CURRENT())) {
+    key_store_release(handle);
     crypto_disable();
     return -1;
   }
@@ -74,6 +97,7 @@ hw_ccm_decrypt(aes128_ccm_t *ccm_ctx, const unsigned char *src,
     mt_yield();
   }
 
+  key_store_release(handle);
   if(ccm_auth_decrypt_get_result(buf, srclen-8, 0, 0)) {
     crypto_disable();
     return -1;
@@ -85,6 +109,8 @@ hw_ccm_decrypt(aes128_ccm_t *ccm_ctx, const unsigned char *src,
 
 int
 hw_ccm_set_key(const u_char *key, int bits) {
+  key_store_handle_t handle;
+
   switch(bits) {
     case 128:
       bits = AES_KEY_STORE_SIZE_KEY_SIZE_128;
@@ -99,8 +125,13 @@ hw_ccm_set_key(const u_char *key, int bits) {
       return -1;
   }
 
-  crypto_enable();
-  int res = aes_load_keys(key, bits, 1, 0);
-  crypto_disable();
-  return -res;
+  /* The previous key is dropped only after the new one was added, a
+   * record with the same key keeps it loaded */
+  handle = key_store_add(key, bits);
+  if(handle == KEY_STORE_INVALID) {
+    return -1;
+  }
+  key_store_remove(key_handle);
+  key_handle = handle;
+  return 0;
 }
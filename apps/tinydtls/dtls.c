@@ -1791,7 +1791,10 @@ dtls_send_server_hello(dtls_context_t *ctx, dtls_peer_t *peer)
    * followed by 28 bytes of generate random data. */
   dtls_ticks(&now);
   dtls_int_to_uint32(handshake->tmp.random.server, now / CLOCK_SECOND);
-  dtls_prng(handshake->tmp.random.server + 4, 28);
+  if (!dtls_prng_wait(handshake->tmp.random.server + 4, 28)) {
+    dtls_crit("can not generate the server random\n");
+    return dtls_alert_fatal_create(DTLS_ALERT_INTERNAL_ERROR);
+  }
 
   memcpy(p, handshake->tmp.random.server, DTLS_RANDOM_LENGTH);
   p += DTLS_RANDOM_LENGTH;
@@ -2017,16 +2020,18 @@ dtls_send_server_key_exchange_ecdh(dtls_context_t *ctx, dtls_peer_t *peer,
   ephemeral_pub_y = p;
   p += DTLS_EC_KEY_SIZE;
 
-  dtls_ecdsa_generate_key(config->keyx.ecdsa.own_eph_priv,
-			  ephemeral_pub_x, ephemeral_pub_y,
-			  DTLS_EC_KEY_SIZE);
+  if (dtls_ecdsa_generate_key(config->keyx.ecdsa.own_eph_priv,
+			      ephemeral_pub_x, ephemeral_pub_y,
+			      DTLS_EC_KEY_SIZE) < 0)
+    return dtls_alert_fatal_create(DTLS_ALERT_INTERNAL_ERROR);
 
   /* sign the ephemeral and its paramaters */
-  dtls_ecdsa_create_sig(key->priv_key, DTLS_EC_KEY_SIZE,
-		       config->tmp.random.client, DTLS_RANDOM_LENGTH,
-		       config->tmp.random.server, DTLS_RANDOM_LENGTH,
-		       key_params, p - key_params,
-		       point_r, point_s);
+  if (dtls_ecdsa_create_sig(key->priv_key, DTLS_EC_KEY_SIZE,
+			    config->tmp.random.client, DTLS_RANDOM_LENGTH,
+			    config->tmp.random.server, DTLS_RANDOM_LENGTH,
+			    key_params, p - key_params,
+			    point_r, point_s) < 0)
+    return dtls_alert_fatal_create(DTLS_ALERT_INTERNAL_ERROR);
 
   p = dtls_add_ecdsa_signature_elem(p, point_r, point_s);
 
@@ -2269,9 +2274,10 @@ dtls_send_client_key_exchange(dtls_context_t *ctx, dtls_peer_t *peer)
     ephemeral_pub_y = p;
     p += DTLS_EC_KEY_SIZE;
 
-    dtls_ecdsa_generate_key(peer->handshake_params->keyx.ecdsa.own_eph_priv,
-    			    ephemeral_pub_x, ephemeral_pub_y,
-    			    DTLS_EC_KEY_SIZE);
+    if (dtls_ecdsa_generate_key(peer->handshake_params->keyx.ecdsa.own_eph_priv,
+				ephemeral_pub_x, ephemeral_pub_y,
+				DTLS_EC_KEY_SIZE) < 0)
+      return dtls_alert_fatal_create(DTLS_ALERT_INTERNAL_ERROR);
 
     break;
   }
@@ -2311,9 +2317,10 @@ dtls_send_certificate_verify_ecdh(dtls_context_t *ctx, dtls_peer_t *peer,
   dtls_hash_finalize(sha256hash, &hs_hash);
 
   /* sign the ephemeral and its paramaters */
-  dtls_ecdsa_create_sig_hash(key->priv_key, DTLS_EC_KEY_SIZE,
-			     sha256hash, sizeof(sha256hash),
-			     point_r, point_s);
+  if (dtls_ecdsa_create_sig_hash(key->priv_key, DTLS_EC_KEY_SIZE,
+				 sha256hash, sizeof(sha256hash),
+				 point_r, point_s) < 0)
+    return dtls_alert_fatal_create(DTLS_ALERT_INTERNAL_ERROR);
 
   p = dtls_add_ecdsa_signature_elem(p, point_r, point_s);
 
@@ -2392,8 +2399,11 @@ dtls_send_client_hello(dtls_context_t *ctx, dtls_peer_t *peer,
      * followed by 28 bytes of generate random data. */
     dtls_ticks(&now);
     dtls_int_to_uint32(handshake->tmp.random.client, now / CLOCK_SECOND);
-    dtls_prng(handshake->tmp.random.client + sizeof(uint32),
-         DTLS_RANDOM_LENGTH - sizeof(uint32));
+    if (!dtls_prng(handshake->tmp.random.client + sizeof(uint32),
+		   DTLS_RANDOM_LENGTH - sizeof(uint32))) {
+      dtls_crit("can not generate the client random\n");
+      return dtls_alert_fatal_create(DTLS_ALERT_INTERNAL_ERROR);
+    }
   }
   /* we must use the same Client Random as for the previous request */
   memcpy(p, handshake->tmp.random.client, DTLS_RANDOM_LENGTH);
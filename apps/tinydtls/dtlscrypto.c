@@ -191,61 +191,53 @@ dtls_p_hash(dtls_hashfunc_t h,
 	    const unsigned char *random1, size_t random1len,
 	    const unsigned char *random2, size_t random2len,
 	    unsigned char *buf, size_t buflen) {
-  dtls_hmac_context_t *hmac_a, *hmac_p;
+  dtls_hmac_context_t *hmac;
 
   unsigned char A[DTLS_HMAC_DIGEST_SIZE];
   unsigned char tmp[DTLS_HMAC_DIGEST_SIZE];
   size_t dlen;			/* digest length */
   size_t len = 0;			/* result length */
-
-  hmac_a = dtls_hmac_new(key, keylen);
-  if (!hmac_a)
+  size_t n;
+
+  /* A(i) and the output blocks use the same key, one context hashes the
+   * key pads once and the engine stays on for the whole expansion */
+  dtls_hash_hold();
+  hmac = dtls_hmac_new(key, keylen);
+  if (!hmac) {
+    dtls_hash_release();
     return 0;
+  }
 
   /* calculate A(1) from A(0) == seed */
-  HMAC_UPDATE_SEED(hmac_a, label, labellen);
-  HMAC_UPDATE_SEED(hmac_a, random1, random1len);
-  HMAC_UPDATE_SEED(hmac_a, random2, random2len);
-
-  dlen = dtls_hmac_finalize(hmac_a, A);
-
-  hmac_p = dtls_hmac_new(key, keylen);
-  if (!hmac_p)
-    goto error;
+  HMAC_UPDATE_SEED(hmac, label, labellen);
+  HMAC_UPDATE_SEED(hmac, random1, random1len);
+  HMAC_UPDATE_SEED(hmac, random2, random2len);
 
-  while (len + dlen < buflen) {
+  dlen = dtls_hmac_finalize(hmac, A);
 
-    /* FIXME: rewrite loop to avoid superflous call to dtls_hmac_init() */
-    dtls_hmac_init(hmac_p, key, keylen);
-    dtls_hmac_update(hmac_p, A, dlen);
+  while (len < buflen) {
+    dtls_hmac_reset(hmac);
+    dtls_hmac_update(hmac, A, dlen);
 
-    HMAC_UPDATE_SEED(hmac_p, label, labellen);
-    HMAC_UPDATE_SEED(hmac_p, random1, random1len);
-    HMAC_UPDATE_SEED(hmac_p, random2, random2len);
+    HMAC_UPDATE_SEED(hmac, label, labellen);
+    HMAC_UPDATE_SEED(hmac, random1, random1len);
+    HMAC_UPDATE_SEED(hmac, random2, random2len);
 
-    len += dtls_hmac_finalize(hmac_p, tmp);
-    memcpy(buf, tmp, dlen);
-    buf += dlen;
+    dtls_hmac_finalize(hmac, tmp);
+    n = buflen - len < dlen ? buflen - len : dlen;
+    memcpy(buf + len, tmp, n);
+    len += n;
 
     /* calculate A(i+1) */
-    dtls_hmac_init(hmac_a, key, keylen);
-    dtls_hmac_update(hmac_a, A, dlen);
-    dtls_hmac_finalize(hmac_a, A);
+    if (len < buflen) {
+      dtls_hmac_reset(hmac);
+      dtls_hmac_update(hmac, A, dlen);
+      dtls_hmac_finalize(hmac, A);
+    }
   }
 
-  dtls_hmac_init(hmac_p, key, keylen);
-  dtls_hmac_update(hmac_p, A, dlen);
-  
-  HMAC_UPDATE_SEED(hmac_p, label, labellen);
-  HMAC_UPDATE_SEED(hmac_p, random1, random1len);
-  HMAC_UPDATE_SEED(hmac_p, random2, random2len);
-  
-  dtls_hmac_finalize(hmac_p, tmp);
-  memcpy(buf, tmp, buflen - len);
-
- error:
-  dtls_hmac_free(hmac_a);
-  dtls_hmac_free(hmac_p);
+  dtls_hmac_free(hmac);
+  dtls_hash_release();
 
   return buflen;
 }
@@ -428,7 +420,7 @@ int dtls_ecdh_pre_master_secret(unsigned char *priv_key,
   return key_size;
 }
 
-void
+int
 dtls_ecdsa_generate_key(unsigned char *priv_key,
 			unsigned char *pub_key_x,
 			unsigned char *pub_key_y,
@@ -438,7 +430,10 @@ dtls_ecdsa_generate_key(unsigned char *priv_key,
   uint32_t pub_y[8];
 
   do {
-    dtls_prng((unsigned char *)priv, key_size);
+    if (!dtls_prng_wait((unsigned char *)priv, key_size)) {
+      dtls_crit("can not generate a private key\n");
+      return -1;
+    }
   } while (!ecc_is_valid_key(priv));
 
   ecc_gen_pub_key(priv, pub_x, pub_y);
@@ -446,10 +441,11 @@ dtls_ecdsa_generate_key(unsigned char *priv_key,
   dtls_ec_key_from_uint32(priv, key_size, priv_key);
   dtls_ec_key_from_uint32(pub_x, key_size, pub_key_x);
   dtls_ec_key_from_uint32(pub_y, key_size, pub_key_y);
+  return 0;
 }
 
 /* rfc4492#section-5.4 */
-void
+int
 dtls_ecdsa_create_sig_hash(const unsigned char *priv_key, size_t key_size,
 			   const unsigned char *sign_hash, size_t sign_hash_size,
 			   uint32_t point_r[9], uint32_t point_s[9]) {
@@ -461,12 +457,16 @@ dtls_ecdsa_create_sig_hash(const unsigned char *priv_key, size_t key_size,
   dtls_ec_key_to_uint32(priv_key, key_size, priv);
   dtls_ec_key_to_uint32(sign_hash, sign_hash_size, hash);
   do {
-    dtls_prng((unsigned char *)rand, key_size);
+    if (!dtls_prng_wait((unsigned char *)rand, key_size)) {
+      dtls_crit("can not generate a signature nonce\n");
+      return -1;
+    }
     ret = ecc_ecdsa_sign(priv, hash, rand, point_r, point_s);
   } while (ret);
+  return 0;
 }
 
-void
+int
 dtls_ecdsa_create_sig(const unsigned char *priv_key, size_t key_size,
 		      const unsigned char *client_random, size_t client_random_size,
 		      const unsigned char *server_random, size_t server_random_size,
@@ -481,8 +481,8 @@ dtls_ecdsa_create_sig(const unsigned char *priv_key, size_t key_size,
   dtls_hash_update(&data, keyx_params, keyx_params_size);
   dtls_hash_finalize(sha256hash, &data);
   
-  dtls_ecdsa_create_sig_hash(priv_key, key_size, sha256hash,
-			     sizeof(sha256hash), point_r, point_s);
+  return dtls_ecdsa_create_sig_hash(priv_key, key_size, sha256hash,
+				    sizeof(sha256hash), point_r, point_s);
 }
 
 /* rfc4492#section-5.4 */
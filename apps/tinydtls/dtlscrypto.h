@@ -314,20 +314,22 @@ int dtls_ecdh_pre_master_secret(unsigned char *priv_key,
                                 unsigned char *result,
                                 size_t result_len);
 
-void dtls_ecdsa_generate_key(unsigned char *priv_key,
-			     unsigned char *pub_key_x,
-			     unsigned char *pub_key_y,
-			     size_t key_size);
-
-void dtls_ecdsa_create_sig_hash(const unsigned char *priv_key, size_t key_size,
-				const unsigned char *sign_hash, size_t sign_hash_size,
-				uint32_t point_r[9], uint32_t point_s[9]);
-
-void dtls_ecdsa_create_sig(const unsigned char *priv_key, size_t key_size,
-			   const unsigned char *client_random, size_t client_random_size,
-			   const unsigned char *server_random, size_t server_random_size,
-			   const unsigned char *keyx_params, size_t keyx_params_size,
-			   uint32_t point_r[9], uint32_t point_s[9]);
+/* The key and signature functions return 0, or -1 if no random
+ * number could be drawn. */
+int dtls_ecdsa_generate_key(unsigned char *priv_key,
+			    unsigned char *pub_key_x,
+			    unsigned char *pub_key_y,
+			    size_t key_size);
+
+int dtls_ecdsa_create_sig_hash(const unsigned char *priv_key, size_t key_size,
+			       const unsigned char *sign_hash, size_t sign_hash_size,
+			       uint32_t point_r[9], uint32_t point_s[9]);
+
+int dtls_ecdsa_create_sig(const unsigned char *priv_key, size_t key_size,
+			  const unsigned char *client_random, size_t client_random_size,
+			  const unsigned char *server_random, size_t server_random_size,
+			  const unsigned char *keyx_params, size_t keyx_params_size,
+			  uint32_t point_r[9], uint32_t point_s[9]);
 
 int dtls_ecdsa_verify_sig_hash(const unsigned char *pub_key_x,
 			       const unsigned char *pub_key_y, size_t key_size,
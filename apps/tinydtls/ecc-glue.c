@@ -33,32 +33,52 @@
 #include "ccm-glue.h"
 #include "ecc-algorithm.h"
 #include "ecc-curve.h"
+#include "crypto-queue-pka.h"
 #include "pt.h"
 #include "mt.h"
 #include "debug.h"
 
+/* Runs a single ECC operation through the crypto queue, the thread yields
+ * while other PKA jobs of the node are served */
+static uint8_t ecc_queue_run(crypto_queue_ecc_t *op) {
+  static crypto_job_t job;
+
+  crypto_queue_init();
+  crypto_queue_ecc_job(&job, op);
+  job.process = PROCESS_CURRENT();
+  job.priority = CRYPTO_QUEUE_PRIO_NORMAL;
+  if(crypto_queue_submit(&job)) {
+    return PKA_STATUS_FAILURE;
+  }
+  while(!job.done) {
+    mt_yield();
+  }
+  return job.result;
+}
+
 void ecc_ecdh(const uint32_t *px, const uint32_t *py, const uint32_t *secret, uint32_t *resultx, uint32_t *resulty) {
   //Prepare Data
-  static ecc_multiply_state_t state = {
+  static ec_point_t point_in, point_out;
+  static uint32_t scalar[8];
+  static crypto_queue_ecc_t op = {
+    .op = CRYPTO_QUEUE_ECC_MULTIPLY,
     .curve_info = &nist_p_256,
+    .scalar = scalar,
+    .point_a = &point_in,
+    .point_out = &point_out,
   };
-  state.process = PROCESS_CURRENT();
-  memcpy(state.point_in.pui32X, px, sizeof(uint32_t)*8);
-  memcpy(state.point_in.pui32Y, py, sizeof(uint32_t)*8);
-  memcpy(state.secret, secret, sizeof(uint32_t)*8);
+  memcpy(point_in.pui32X, px, sizeof(uint32_t)*8);
+  memcpy(point_in.pui32Y, py, sizeof(uint32_t)*8);
+  memcpy(scalar, secret, sizeof(uint32_t)*8);
 
   //Process
   pka_enable();
-  PT_INIT(&state.pt);
-  while(PT_SCHEDULE(ecc_multiply(&state))) {
-    mt_yield();
-  }
+  if(ecc_queue_run(&op)) { dtls_crit("can not calculate shared secret\n"); }
   pka_disable();
-  if(state.result) { dtls_crit("can not calculate shared secret\n"); }
 
   //Get Result
-  memcpy(resultx, state.point_out.pui32X, sizeof(uint32_t)*8);
-  memcpy(resulty, state.point_out.pui32Y, sizeof(uint32_t)*8);
+  memcpy(resultx, point_out.pui32X, sizeof(uint32_t)*8);
+  memcpy(resulty, point_out.pui32Y, sizeof(uint32_t)*8);
 }
 
 int ecc_is_valid_key(const uint32_t * priv_key) {
@@ -82,26 +102,24 @@ int ecc_is_valid_key(const uint32_t * priv_key) {
 
 void ecc_gen_pub_key(const uint32_t *priv_key, uint32_t *pub_x, uint32_t *pub_y) {
   //Prepare Data
-  static ecc_multiply_state_t state = {
+  static ec_point_t point_out;
+  static uint32_t scalar[8];
+  static crypto_queue_ecc_t op = {
+    .op = CRYPTO_QUEUE_ECC_MULT_GEN,
     .curve_info = &nist_p_256,
+    .scalar = scalar,
+    .point_out = &point_out,
   };
-  state.process = PROCESS_CURRENT();
-  memcpy(state.point_in.pui32X, nist_p_256.pui32Gx, sizeof(uint32_t)*8);
-  memcpy(state.point_in.pui32Y, nist_p_256.pui32Gy, sizeof(uint32_t)*8);
-  memcpy(state.secret, priv_key, sizeof(uint32_t)*8);
+  memcpy(scalar, priv_key, sizeof(uint32_t)*8);
 
   //Process
   pka_enable();
-  PT_INIT(&state.pt);
-  while(PT_SCHEDULE(ecc_multiply(&state))) {
-    mt_yield();
-  }
+  if(ecc_queue_run(&op)) { dtls_crit("can not calculate public key\n"); }
   pka_disable();
-  if(state.result) { dtls_crit("can not calculate public key\n"); }
 
   //Get Result
-  memcpy(pub_x, state.point_out.pui32X, sizeof(uint32_t)*8);
-  memcpy(pub_y, state.point_out.pui32Y, sizeof(uint32_t)*8);
+  memcpy(pub_x, point_out.pui32X, sizeof(uint32_t)*8);
+  memcpy(pub_y, point_out.pui32Y, sizeof(uint32_t)*8);
 }
 
 int ecc_ecdsa_sign(const uint32_t *d, const uint32_t *e, const uint32_t *k, uint32_t *r, uint32_t *s) {
@@ -27,6 +27,7 @@
 #define _DTLS_HMAC_H_
 
 #include <sys/types.h>
+#include <string.h>
 
 #include "global.h"
 
@@ -38,27 +39,84 @@ typedef sha256_state_t dtls_hash_ctx;
 typedef dtls_hash_ctx *dtls_hash_t;
 #define DTLS_HASH_CTX_SIZE sizeof(sha256_state_t)
 
+/** Hash state after whole blocks, e.g. an HMAC key pad */
+typedef struct {
+  uint64_t length;
+  uint32_t state[8];
+} dtls_hash_midstate_t;
+
+/** Number of dtls_hash_hold() without dtls_hash_release() */
+extern uint8_t dtls_hash_held;
+
+/**
+ * Keeps the crypto engine enabled until the matching dtls_hash_release(),
+ * instead of toggling its clock for every hash call. Calls nest.
+ */
+static inline void
+dtls_hash_hold(void) {
+  if(!dtls_hash_held++) {
+    crypto_enable();
+  }
+}
+
+static inline void
+dtls_hash_release(void) {
+  if(!--dtls_hash_held) {
+    crypto_disable();
+  }
+}
+
 static inline void
 dtls_hash_init(dtls_hash_t ctx) {
-  crypto_enable();
+  dtls_hash_hold();
   sha256_init((sha256_state_t *)ctx);
-  crypto_disable();
+  dtls_hash_release();
 }
 
 static inline void 
 dtls_hash_update(dtls_hash_t ctx, const unsigned char *input, size_t len) {
-  crypto_enable();
+  dtls_hash_hold();
   sha256_process((sha256_state_t *)ctx, input, len);
-  crypto_disable();
+  dtls_hash_release();
 }
 
 static inline size_t
 dtls_hash_finalize(unsigned char *buf, dtls_hash_t ctx) {
-  crypto_enable();
+  dtls_hash_hold();
   sha256_done((sha256_state_t *)ctx, buf);
-  crypto_disable();
+  dtls_hash_release();
   return 32; //SHA256_DIGEST_LENGTH
 }
+
+/**
+ * Hashes one 64 byte \p block and saves the state in \p mid.
+ */
+static inline void
+dtls_hash_midstate(dtls_hash_midstate_t *mid, const unsigned char *block) {
+  sha256_state_t ctx;
+
+  dtls_hash_hold();
+  sha256_init(&ctx);
+  /* the driver keeps a full block until more data follows, one more byte
+   * pushes it through the engine */
+  sha256_process(&ctx, block, 64);
+  sha256_process(&ctx, block, 1);
+  dtls_hash_release();
+  memcpy(mid->state, ctx.state, sizeof(mid->state));
+  mid->length = ctx.length;
+  memset(&ctx, 0, sizeof(ctx));
+}
+
+/**
+ * Initializes \p ctx to continue from the state \p mid.
+ */
+static inline void
+dtls_hash_resume(dtls_hash_t ctx, const dtls_hash_midstate_t *mid) {
+  sha256_init((sha256_state_t *)ctx);
+  memcpy(ctx->state, mid->state, sizeof(mid->state));
+  ctx->length = mid->length;
+  ctx->new_digest = 0;
+}
 #endif /* WITH_SHA256 */
 //-----------------------------------------------------------------------------
 
@@ -94,12 +152,13 @@ typedef enum {
 /**
  * Context for HMAC generation. This object is initialized with
  * dtls_hmac_init() and must be passed to dtls_hmac_update() and
- * dtls_hmac_finalize(). Once, finalized, the component \c H is
- * invalid and must be initialized again with dtls_hmac_init() before
- * the structure can be used again. 
+ * dtls_hmac_finalize(). The hash states after the ipad and opad
+ * blocks are kept, once finalized, dtls_hmac_reset() starts the next
+ * HMAC with the same key without hashing the key again.
  */
 typedef struct {
-  unsigned char pad[DTLS_HMAC_BLOCKSIZE]; /**< ipad and opad storage */
+  dtls_hash_midstate_t inner;	          /**< state after the ipad */
+  dtls_hash_midstate_t outer;	          /**< state after the opad */
   dtls_hash_ctx data;		          /**< context for hash function */
 } dtls_hmac_context_t;
 
@@ -112,6 +171,13 @@ typedef struct {
  */
 void dtls_hmac_init(dtls_hmac_context_t *ctx, const unsigned char *key, size_t klen);
 
+/**
+ * Starts a new HMAC with the key of \p ctx, from the cached ipad state.
+ *
+ * @param ctx The HMAC context, initialized with dtls_hmac_init().
+ */
+void dtls_hmac_reset(dtls_hmac_context_t *ctx);
+
 /**
  * Allocates a new HMAC context \p ctx with the given secret key.
  * This function returns \c 1 if \c ctx has been set correctly, or \c
@@ -49,6 +49,37 @@ dtls_prng(unsigned char *buf, size_t len)
 {
 	return contiki_prng_impl(buf, len);
 }
+#elif defined(HAVE_CTR_DRBG)
+#include "dev/ctr-drbg.h"
+#include "mt.h"
+
+/**
+ * Fills \p buf with \p len random bytes from the CTR-DRBG of the
+ * cc2538, which is seeded with radio noise at boot. Returns 0 and a
+ * zeroed buffer if another operation holds the AES engine or the DRBG
+ * fails, the caller must then give up.
+ */
+static inline int
+dtls_prng(unsigned char *buf, size_t len) {
+  return ctr_drbg_generate(buf, len) == CTR_DRBG_SUCCESS;
+}
+
+/**
+ * dtls_prng() for the DTLS thread: yields while another operation
+ * holds the AES engine, the process that runs the thread is polled to
+ * retry. Returns 0 if the DRBG fails or must be reseeded.
+ */
+static inline int
+dtls_prng_wait(unsigned char *buf, size_t len) {
+  uint8_t result;
+
+  while((result = ctr_drbg_generate(buf, len)) == CTR_DRBG_BUSY) {
+    process_poll(PROCESS_CURRENT());
+    mt_yield();
+  }
+  return result == CTR_DRBG_SUCCESS;
+}
+#define DTLS_PRNG_WAIT 1
 #else
 #include <core/lib/random.h> 
 
@@ -72,12 +103,29 @@ dtls_prng(unsigned char *buf, size_t len) {
 }
 #endif /* HAVE_PRNG */
 
+#ifdef HAVE_CTR_DRBG
+static inline void
+dtls_prng_init(unsigned short seed) {
+  /* The platform seeds the CTR-DRBG at boot */
+}
+#else /* HAVE_CTR_DRBG */
 static inline void
 dtls_prng_init(unsigned short seed) {
 	random_init(seed);
 }
+#endif /* HAVE_CTR_DRBG */
 #endif /* WITH_CONTIKI */
 
+#ifndef DTLS_PRNG_WAIT
+/**
+ * dtls_prng() for the DTLS thread. This PRNG never has to wait.
+ */
+static inline int
+dtls_prng_wait(unsigned char *buf, size_t len) {
+  return dtls_prng(buf, len);
+}
+#endif /* DTLS_PRNG_WAIT */
+
 /** @} */
 
 #endif /* _DTLS_PRNG_H_ */
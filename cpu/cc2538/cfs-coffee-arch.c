@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2015, Institute for Pervasive Computing, ETH Zurich.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/**
+ * \addtogroup cc2538
+ * @{
+ *
+ * \file
+ * Coffee architecture-dependent functionality for the cc2538
+ *
+ * Coffee expects erased storage to read as zero, while erased flash reads
+ * as ones. All data is therefore stored complemented. The flash is
+ * programmed in aligned words, bytes outside of the written range are
+ * padded with ones, which leaves them unchanged.
+ */
+#include "contiki.h"
+#include "cfs-coffee-arch.h"
+#include "dev/rom-util.h"
+
+#include <string.h>
+
+/* Words programmed per ROM call */
+#define WRITE_WORDS 16
+/*---------------------------------------------------------------------------*/
+void
+cfs_coffee_arch_write(const void *buf, unsigned int size, cfs_offset_t offset)
+{
+  const uint8_t *src = buf;
+  uint32_t words[WRITE_WORDS];
+  uint32_t address = COFFEE_START + offset;
+  uint32_t head, chunk, i;
+
+  while(size) {
+    head = address & 3;
+    chunk = sizeof(words) - head;
+    if(chunk > size) {
+      chunk = size;
+    }
+
+    memset(words, 0xff, sizeof(words));
+    for(i = 0; i < chunk; i++) {
+      ((uint8_t *)words)[head + i] = ~src[i];
+    }
+    rom_util_program_flash(words, address - head, (head + chunk + 3) & ~3UL);
+
+    address += chunk;
+    src += chunk;
+    size -= chunk;
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+cfs_coffee_arch_read(void *buf, unsigned int size, cfs_offset_t offset)
+{
+  const uint8_t *src = (const uint8_t *)(COFFEE_START + offset);
+  uint8_t *dst = buf;
+
+  while(size--) {
+    *dst++ = ~*src++;
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+cfs_coffee_arch_erase(uint16_t sector)
+{
+  rom_util_page_erase(COFFEE_START + sector * COFFEE_SECTOR_SIZE,
+                      COFFEE_SECTOR_SIZE);
+}
+/*---------------------------------------------------------------------------*/
+
+/**
+ * @}
+ */
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2015, Institute for Pervasive Computing, ETH Zurich.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/**
+ * \addtogroup cc2538
+ * @{
+ *
+ * \file
+ * Coffee architecture-dependent configuration for the cc2538
+ *
+ * Coffee is placed in the internal flash, in the pages right below the page
+ * holding the CCA. It is disabled unless COFFEE_CONF_SIZE is set to a
+ * multiple of the flash page size, the linker script then keeps the
+ * firmware out of this area.
+ */
+#ifndef CFS_COFFEE_ARCH_H_
+#define CFS_COFFEE_ARCH_H_
+
+#include "contiki-conf.h"
+#include "cfs/cfs.h"
+
+#include <stdint.h>
+
+/** Flash page size, the smallest erasable unit */
+#define COFFEE_SECTOR_SIZE      2048UL
+#define COFFEE_PAGE_SIZE        256UL
+
+#ifdef COFFEE_CONF_SIZE
+#define COFFEE_SIZE             COFFEE_CONF_SIZE
+#else
+#define COFFEE_SIZE             0
+#endif
+
+#if COFFEE_SIZE % COFFEE_SECTOR_SIZE
+#error COFFEE_CONF_SIZE must be a multiple of the flash page size.
+#endif
+
+/** Coffee ends right below the flash page holding the CCA */
+#define COFFEE_START            (FLASH_CONF_ORIGIN + FLASH_CONF_SIZE - \
+                                 COFFEE_SECTOR_SIZE - COFFEE_SIZE)
+
+#define COFFEE_NAME_LENGTH      16
+#define COFFEE_MAX_OPEN_FILES   6
+#define COFFEE_FD_SET_SIZE      8
+#define COFFEE_LOG_TABLE_LIMIT  256
+#ifdef COFFEE_CONF_DYN_SIZE
+#define COFFEE_DYN_SIZE         COFFEE_CONF_DYN_SIZE
+#else
+#define COFFEE_DYN_SIZE         (4 * 1024)
+#endif
+#define COFFEE_LOG_SIZE         1024
+
+#define COFFEE_IO_SEMANTICS     1
+#define COFFEE_APPEND_ONLY      0
+#define COFFEE_MICRO_LOGS       1
+
+/* Flash operations, addresses are relative to COFFEE_START */
+#define COFFEE_WRITE(buf, size, offset) \
+  cfs_coffee_arch_write((buf), (size), (offset))
+
+#define COFFEE_READ(buf, size, offset) \
+  cfs_coffee_arch_read((void *)(buf), (size), (offset))
+
+#define COFFEE_ERASE(sector) \
+  cfs_coffee_arch_erase(sector)
+
+/* Coffee types */
+typedef int16_t coffee_page_t;
+
+void cfs_coffee_arch_write(const void *buf, unsigned int size, cfs_offset_t offset);
+void cfs_coffee_arch_read(void *buf, unsigned int size, cfs_offset_t offset);
+void cfs_coffee_arch_erase(uint16_t sector);
+
+#endif /* CFS_COFFEE_ARCH_H_ */
+
+/**
+ * @}
+ */
@@ -33,6 +33,7 @@
 #include <stdio.h>
 
 #include "RSA-algorithm.h"
+#include "bignum-driver.h"
 #include "ecc-driver.h"
 #include "pka.h"
 
@@ -70,12 +71,12 @@ PT_THREAD(RSA_create_public(RSA_secrete_state_t *state)) {
 
 
 PT_THREAD(RSA_create_private(RSA_secrete_state_t *state)){
-	PT_BEGIN(&state->pt);
-
-	uint32_t result_temp;
-	uint32_t result_store[17];
-	uint32_t size=17;
+	/* static, the thread yields while the PKA is busy */
+	static uint32_t result_temp;
+	static uint32_t result_store[17];
+	static uint32_t size;
 
+	PT_BEGIN(&state->pt);
 
 //d=(1+((p-1)*(q-1)*(e-ModInv((q-1)*(p-1),e)))/e
 	CHECK_RESULT(PKABigNumInvModStart(state->PrimeF, state->FLen, &state->PrimeE, state->ESize,&state->rv, state->process));
@@ -88,6 +89,7 @@ PT_THREAD(RSA_create_private(RSA_secrete_state_t *state)){
 //
 	CHECK_RESULT(PKABigNumMultiplyStart(state->PrimeF,state->FLen,&result_temp,state->ESize,&state->rv,state->process));
 	PT_WAIT_UNTIL(&state->pt, pka_check_status());
+	size = 17;
 	CHECK_RESULT(PKABigNumMultGetResult(result_store,&size,state->rv));
 //
 	CHECK_RESULT(PKABigNumAddStart(state->ONEDATA, 1, result_store, size, &state->rv, state->process));
@@ -65,11 +65,11 @@ typedef struct {
   //Input Variables
 
   uint32_t    PrimeP[8];       //prime p
-  uint8_t     PSize;     /*the size of prime number p*/
+  uint32_t    PSize;     /*the size of prime number p*/
   uint32_t    PrimeQ[8];   /*the size of prime number Q*/
-  uint8_t     QSize;     /*the size of prime number Q*/
+  uint32_t    QSize;     /*the size of prime number Q*/
   uint32_t    PrimeE;           //prime e
-  uint8_t     ESize;     /*the size of prime number E*/
+  uint32_t    ESize;     /*the size of prime number E*/
 
   uint32_t    ONEDATA[8];
 
@@ -101,7 +101,7 @@ typedef struct {
   //Input Variables
 
   uint32_t    PrimeE;           //prime e
-  uint8_t     ESize;     /*the size of prime number E*/
+  uint32_t    ESize;     /*the size of prime number E*/
 
   uint32_t    rv;                     //Address of Next Result in PKA SRAM
   //Output Variables
@@ -73,54 +73,214 @@ void printNumber(const uint32_t *x, int numberLength) {
   }
   printf("\n");
 }
+/*---------------------------------------------------------------------------*/
+/*
+ * PKA RAM layout
+ *
+ * Resident vectors are stacked downwards from the end of the PKA RAM. The
+ * vectors of an operation are allocated upwards from offset 0 and have to
+ * stay below the resident vectors. Operands which already live in the PKA
+ * RAM (resident vectors and chained results) are used in place, the
+ * allocation of the other vectors skips them.
+ */
+static uint32_t resident_floor = PKA_RAM_SIZE;
+static uint32_t bus_bytes;
+
+/* Process that holds the PKA RAM, see PKABigNumLock() */
+static struct process *lock_owner;
+static uint8_t locked;
+
+static uint32_t layout_next;
+static uint32_t layout_keep_start[2];
+static uint32_t layout_keep_end[2];
+static uint8_t layout_kept;
+static uint8_t layout_overflow;
+
+#define IN_PKA_RAM(p)          ((uintptr_t)(p) >= PKA_RAM_BASE &&           \
+                                (uintptr_t)(p) < PKA_RAM_BASE + PKA_RAM_SIZE)
+#define VECTOR_OFFSET(p)       ((uint32_t)((uintptr_t)(p) - PKA_RAM_BASE))
+/* Words taken by a vector of len words, 64-bit aligned, plus extra words */
+#define VECTOR_WORDS(len, extra) ((len) + (len) % 2 + (extra))
+/* Words from vector C on used by the ExpMod: the base, which is replaced by
+ * the result, and the intermediate powers */
+#define EXPMOD_WORDS(len)        (4 * VECTOR_WORDS(len, 2))
+
+static void
+layout_begin(void)
+{
+  layout_next = 0;
+  layout_kept = 0;
+  layout_overflow = 0;
+}
+/*---------------------------------------------------------------------------*/
+/* Protects an operand used in place from the allocation */
+static void
+layout_keep(const uint32_t *vector, uint8_t len)
+{
+  uint32_t offset;
 
+  if(!IN_PKA_RAM(vector) || layout_kept == 2) {
+    return;
+  }
+  offset = VECTOR_OFFSET(vector);
+  if(offset >= resident_floor) {
+    return;
+  }
+  layout_keep_start[layout_kept] = offset;
+  layout_keep_end[layout_kept] = offset + 4 * VECTOR_WORDS(len, 2);
+  layout_kept++;
+}
 /*---------------------------------------------------------------------------*/
-uint8_t PKABigNumModStart(uint32_t* pui32BNum, uint8_t ui8BNSize,
-                          uint32_t* pui32Modulus, uint8_t ui8ModSize,
-                          uint32_t* pui32ResultVector, struct process *process) {
+/* Returns the offset of a free area of the given number of words */
+static uint32_t
+layout_alloc(uint32_t words)
+{
+  uint32_t offset = layout_next;
+  uint8_t i = 0;
+
+  while(i < layout_kept) {
+    if(offset < layout_keep_end[i] &&
+       offset + 4 * words > layout_keep_start[i]) {
+      offset = layout_keep_end[i];
+      i = 0;
+    } else {
+      i++;
+    }
+  }
 
-  uint8_t extraBuf;
+  if(offset + 4 * words > resident_floor) {
+    layout_overflow = 1;
+    return 0;
+  }
+  layout_next = offset + 4 * words;
+  return offset;
+}
+/*---------------------------------------------------------------------------*/
+/* Returns the offset of an operand, it is loaded unless it is in PKA RAM */
+static uint32_t
+layout_load(const uint32_t *vector, uint8_t len, uint8_t extra)
+{
   uint32_t offset;
   int i;
 
+  if(IN_PKA_RAM(vector)) {
+    return VECTOR_OFFSET(vector);
+  }
+
+  offset = layout_alloc(VECTOR_WORDS(len, extra));
+  if(!layout_overflow) {
+    for(i = 0; i < len; i++) {
+      REG((PKA_RAM_BASE + offset + 4 * i)) = vector[i];
+    }
+    bus_bytes += 4 * len;
+  }
+  return offset;
+}
+/*---------------------------------------------------------------------------*/
+uint8_t PKABigNumPin(uint32_t* pui32BNum, uint8_t ui8Size,
+                     uint32_t* pui32VectorLoc) {
+
+  uint32_t words;
+  int i;
+
   // Check the arguments.
   ASSERT(NULL != pui32BNum);
-  ASSERT(NULL != pui32Modulus);
-  ASSERT(NULL != pui32ResultVector);
+  ASSERT(NULL != pui32VectorLoc);
+  ASSERT(!IN_PKA_RAM(pui32BNum));
 
-  // make sure no operation is in progress.
+  // Only the holder of the lock may keep vectors in the PKA RAM.
+  if(PKABigNumLocked()) {
+    return (PKA_STATUS_OPERATION_INPRG);
+  }
+  ASSERT(locked);
+
+  // Make sure no operation is in progress, it may use the area.
   if((REG(PKA_FUNCTION) & PKA_FUNCTION_RUN) != 0) {
     return (PKA_STATUS_OPERATION_INPRG);
   }
 
-  // calculate the extra buffer requirement.
-  extraBuf = 2 + ui8ModSize % 2;
+  // Two spare words, the vector may be used as modulus.
+  words = VECTOR_WORDS(ui8Size, 2);
+  ASSERT(4 * words <= resident_floor);
+  resident_floor -= 4 * words;
 
-  offset = 0;
+  // Load the number below the other resident vectors.
+  for(i = 0; i < ui8Size; i++) {
+    REG((PKA_RAM_BASE + resident_floor + 4 * i)) = pui32BNum[i];
+  }
+  bus_bytes += 4 * ui8Size;
 
-  // Update the A ptr with the offset address of the PKA RAM location
-  // where the number will be stored.
-  REG((PKA_APTR)) = offset >> 2;
+  *pui32VectorLoc = PKA_RAM_BASE + resident_floor;
 
-  // Load the number in PKA RAM
-  for(i = 0; i < ui8BNSize; i++) {
-    REG((PKA_RAM_BASE + offset + 4 * i)) = pui32BNum[i];
+  return (PKA_STATUS_SUCCESS);
+}
+/*---------------------------------------------------------------------------*/
+void PKABigNumUnpinAll(void) {
+  if(PKABigNumLocked()) {
+    return;
   }
+  resident_floor = PKA_RAM_SIZE;
+}
+/*---------------------------------------------------------------------------*/
+uint8_t PKABigNumLock(void) {
+  if(PKABigNumLocked()) {
+    return (PKA_STATUS_OPERATION_INPRG);
+  }
+  lock_owner = PROCESS_CURRENT();
+  locked = 1;
+  return (PKA_STATUS_SUCCESS);
+}
+/*---------------------------------------------------------------------------*/
+void PKABigNumUnlock(void) {
+  if(PKABigNumLocked()) {
+    return;
+  }
+  resident_floor = PKA_RAM_SIZE;
+  lock_owner = NULL;
+  locked = 0;
+}
+/*---------------------------------------------------------------------------*/
+uint8_t PKABigNumLocked(void) {
+  return locked && lock_owner != PROCESS_CURRENT();
+}
+/*---------------------------------------------------------------------------*/
+uint32_t PKABigNumBusBytes(void) {
+  return bus_bytes;
+}
+/*---------------------------------------------------------------------------*/
+uint8_t PKABigNumModStart(uint32_t* pui32BNum, uint8_t ui8BNSize,
+                          uint32_t* pui32Modulus, uint8_t ui8ModSize,
+                          uint32_t* pui32ResultVector, struct process *process) {
 
-  // determine the offset for the next data input.
-  offset += 4 * (i + ui8BNSize % 2);
+  uint32_t offset;
 
-  // Update the B ptr with the offset address of the PKA RAM location
-  // where the divisor will be stored.
-  REG((PKA_BPTR)) = offset >> 2;
+  // Check the arguments.
+  ASSERT(NULL != pui32BNum);
+  ASSERT(NULL != pui32Modulus);
+  ASSERT(NULL != pui32ResultVector);
 
-  // Load the divisor in PKA RAM.
-  for(i = 0; i < ui8ModSize; i++) {
-    REG((PKA_RAM_BASE + offset + 4 * i)) = pui32Modulus[i];
+  // make sure no operation is in progress.
+  if((REG(PKA_FUNCTION) & PKA_FUNCTION_RUN) != 0 ||
+     PKABigNumLocked()) {
+    return (PKA_STATUS_OPERATION_INPRG);
   }
 
-  // determine the offset for the next data.
-  offset += 4 * (i + extraBuf);
+  // The vectors are placed around the operands already in PKA RAM.
+  layout_begin();
+  layout_keep(pui32BNum, ui8BNSize);
+  layout_keep(pui32Modulus, ui8ModSize);
+
+  // Update the A ptr with the offset address of the PKA RAM location
+  // where the number is stored.
+  REG((PKA_APTR)) = layout_load(pui32BNum, ui8BNSize, 0) >> 2;
+
+  // Update the B ptr with the offset address of the PKA RAM location
+  // where the divisor is stored, it needs two extra words.
+  REG((PKA_BPTR)) = layout_load(pui32Modulus, ui8ModSize, 2) >> 2;
+
+  // Determine the offset of the result.
+  offset = layout_alloc(VECTOR_WORDS(ui8ModSize, 2));
+  ASSERT(!layout_overflow);
 
   // Copy the result vector address location.
   *pui32ResultVector = PKA_RAM_BASE + offset;
@@ -156,7 +316,7 @@ uint8_t PKABigNumModGetResult(uint32_t* pui32ResultBuf, uint8_t ui8Size,
 
   // Check the arguments.
   ASSERT(NULL != pui32ResultBuf);
-  ASSERT(ui32ResVectorLoc > PKA_RAM_BASE);
+  ASSERT(ui32ResVectorLoc >= PKA_RAM_BASE);
   ASSERT(ui32ResVectorLoc < (PKA_RAM_BASE + PKA_RAM_SIZE));
 
   // verify that the operation is complete.
@@ -190,6 +350,7 @@ uint8_t PKABigNumModGetResult(uint32_t* pui32ResultBuf, uint8_t ui8Size,
   for(i = 0; i < len; i++) {
     pui32ResultBuf[i] = REG((ui32ResVectorLoc + 4 * i));
   }
+  bus_bytes += 4 * len;
 
   return (PKA_STATUS_SUCCESS);
 }
@@ -197,40 +358,29 @@ uint8_t PKABigNumModGetResult(uint32_t* pui32ResultBuf, uint8_t ui8Size,
 uint8_t PKABigNumCmpStart(uint32_t* pui32BNum1, uint32_t* pui32BNum2,
                           uint8_t ui8Size, struct process *process) {
 
-  uint32_t offset;
-  int i;
-
   // Check the arguments.
   ASSERT(NULL != pui32BNum1);
   ASSERT(NULL != pui32BNum2);
 
-  offset = 0;
-
   // Make sure no operation is in progress.
-  if((REG(PKA_FUNCTION) & PKA_FUNCTION_RUN) != 0) {
+  if((REG(PKA_FUNCTION) & PKA_FUNCTION_RUN) != 0 ||
+     PKABigNumLocked()) {
     return (PKA_STATUS_OPERATION_INPRG);
   }
 
-  // Update the A ptr with the offset address of the PKA RAM location
-  // where the first big number will be stored.
-  REG((PKA_APTR)) = offset >> 2;
-
-  // Load the first big number in PKA RAM.
-  for(i = 0; i < ui8Size; i++) {
-    REG((PKA_RAM_BASE + offset + 4 * i)) = pui32BNum1[i];
-  }
+  // The vectors are placed around the operands already in PKA RAM.
+  layout_begin();
+  layout_keep(pui32BNum1, ui8Size);
+  layout_keep(pui32BNum2, ui8Size);
 
-  // Determine the offset in PKA RAM for the next pointer.
-  offset += 4 * (i + ui8Size % 2);
+  // Update the A ptr with the offset address of the PKA RAM location
+  // where the first big number is stored.
+  REG((PKA_APTR)) = layout_load(pui32BNum1, ui8Size, 0) >> 2;
 
   // Update the B ptr with the offset address of the PKA RAM location
-  // where the second big number will be stored.
-  REG((PKA_BPTR)) = offset >> 2;
-
-  // Load the second big number in PKA RAM.
-  for(i = 0; i < ui8Size; i++) {
-    REG((PKA_RAM_BASE + offset + 4 * i)) = pui32BNum2[i];
-  }
+  // where the second big number is stored.
+  REG((PKA_BPTR)) = layout_load(pui32BNum2, ui8Size, 0) >> 2;
+  ASSERT(!layout_overflow);
 
   // Load length registers in 32 bit word size.
   REG((PKA_ALENGTH)) = ui8Size;
@@ -289,43 +439,34 @@ uint8_t PKABigNumInvModStart(uint32_t* pui32BNum, uint8_t ui8BNSize,
                              uint32_t* pui32ResultVector, struct process *process) {
 
   uint32_t offset;
-  int i;
 
   // Check the arguments.
   ASSERT(NULL != pui32BNum);
   ASSERT(NULL != pui32Modulus);
   ASSERT(NULL != pui32ResultVector);
 
-  offset = 0;
-
   // Make sure no operation is in progress.
-  if((REG(PKA_FUNCTION) & PKA_FUNCTION_RUN) != 0) {
+  if((REG(PKA_FUNCTION) & PKA_FUNCTION_RUN) != 0 ||
+     PKABigNumLocked()) {
     return (PKA_STATUS_OPERATION_INPRG);
   }
 
-  // Update the A ptr with the offset address of the PKA RAM location
-  // where the number will be stored.
-  REG((PKA_APTR)) = offset >> 2;
-
-  // Load the \e pui32BNum number in PKA RAM.
-  for(i = 0; i < ui8BNSize; i++) {
-    REG((PKA_RAM_BASE + offset + 4 * i)) = pui32BNum[i];
-  }
+  // The vectors are placed around the operands already in PKA RAM.
+  layout_begin();
+  layout_keep(pui32BNum, ui8BNSize);
+  layout_keep(pui32Modulus, ui8Size);
 
-  // Determine the offset for next data.
-  offset += 4 * (i + ui8BNSize % 2);
+  // Update the A ptr with the offset address of the PKA RAM location
+  // where the number is stored.
+  REG((PKA_APTR)) = layout_load(pui32BNum, ui8BNSize, 0) >> 2;
 
   // Update the B ptr with the offset address of the PKA RAM location
-  // where the modulus will be stored.
-  REG((PKA_BPTR)) = offset >> 2;
-
-  // Load the \e pui32Modulus divisor in PKA RAM.
-  for(i = 0; i < ui8Size; i++) {
-    REG((PKA_RAM_BASE + offset + 4 * i)) = pui32Modulus[i];
-  }
+  // where the modulus is stored.
+  REG((PKA_BPTR)) = layout_load(pui32Modulus, ui8Size, 0) >> 2;
 
   // Determine the offset for result data.
-  offset += 4 * (i + ui8Size % 2);
+  offset = layout_alloc(VECTOR_WORDS(ui8Size, 2));
+  ASSERT(!layout_overflow);
 
   // Copy the result vector address location.
   *pui32ResultVector = PKA_RAM_BASE + offset;
@@ -359,7 +500,7 @@ uint8_t PKABigNumInvModGetResult(uint32_t* pui32ResultBuf, uint8_t ui8Size,
 
   // Check the arguments.
   ASSERT(NULL != pui32ResultBuf);
-  ASSERT(ui32ResVectorLoc > PKA_RAM_BASE);
+  ASSERT(ui32ResVectorLoc >= PKA_RAM_BASE);
   ASSERT(ui32ResVectorLoc < (PKA_RAM_BASE + PKA_RAM_SIZE));
 
   // Verify that the operation is complete.
@@ -394,6 +535,7 @@ uint8_t PKABigNumInvModGetResult(uint32_t* pui32ResultBuf, uint8_t ui8Size,
   for(i = 0; i < len; i++) {
     pui32ResultBuf[i] = REG((ui32ResVectorLoc + 4 * i));
   }
+  bus_bytes += 4 * len;
 
   return (PKA_STATUS_SUCCESS);
 }
@@ -403,45 +545,34 @@ uint8_t PKABigNumMultiplyStart(uint32_t* pui32Xplicand, uint8_t ui8XplicandSize,
                                uint32_t* pui32ResultVector, struct process *process) {
 
   uint32_t offset;
-  int i;
 
   // Check for the arguments.
   ASSERT(NULL != pui32Xplicand);
   ASSERT(NULL != pui32Xplier);
   ASSERT(NULL != pui32ResultVector);
 
-  offset = 0;
-
   // Make sure no operation is in progress.
-  if((REG(PKA_FUNCTION) & PKA_FUNCTION_RUN) != 0) {
+  if((REG(PKA_FUNCTION) & PKA_FUNCTION_RUN) != 0 ||
+     PKABigNumLocked()) {
     return (PKA_STATUS_OPERATION_INPRG);
   }
 
-  // Update the A ptr with the offset address of the PKA RAM location
-  // where the multiplicand will be stored.
-  REG((PKA_APTR)) = offset >> 2;
-
-  // Load the multiplicand in PKA RAM.
-  for(i = 0; i < ui8XplicandSize; i++) {
-    REG((PKA_RAM_BASE + offset + 4 * i)) = *pui32Xplicand;
-    pui32Xplicand++;
-  }
+  // The vectors are placed around the operands already in PKA RAM.
+  layout_begin();
+  layout_keep(pui32Xplicand, ui8XplicandSize);
+  layout_keep(pui32Xplier, ui8XplierSize);
 
-  // Determine the offset for the next data.
-  offset += 4 * (i + (ui8XplicandSize % 2));
+  // Update the A ptr with the offset address of the PKA RAM location
+  // where the multiplicand is stored.
+  REG((PKA_APTR)) = layout_load(pui32Xplicand, ui8XplicandSize, 0) >> 2;
 
   // Update the B ptr with the offset address of the PKA RAM location
-  // where the multiplier will be stored.
-  REG((PKA_BPTR)) = offset >> 2;
+  // where the multiplier is stored.
+  REG((PKA_BPTR)) = layout_load(pui32Xplier, ui8XplierSize, 0) >> 2;
 
-  // Load the multiplier in PKA RAM.
-  for(i = 0; i < ui8XplierSize; i++) {
-    REG((PKA_RAM_BASE + offset + 4 * i)) = *pui32Xplier;
-    pui32Xplier++;
-  }
-
-  // Determine the offset for the next data.
-  offset += 4 * (i + (ui8XplierSize % 2));
+  // Determine the offset for the result.
+  offset = layout_alloc(VECTOR_WORDS(ui8XplicandSize + ui8XplierSize, 2));
+  ASSERT(!layout_overflow);
 
   // Copy the result vector address location.
   *pui32ResultVector = PKA_RAM_BASE + offset;
@@ -476,7 +607,7 @@ uint8_t PKABigNumMultGetResult(uint32_t* pui32ResultBuf, uint32_t* pui32Len,
   // Check for arguments.
   ASSERT(NULL != pui32ResultBuf);
   ASSERT(NULL != pui32Len);
-  ASSERT(ui32ResVectorLoc > PKA_RAM_BASE);
+  ASSERT(ui32ResVectorLoc >= PKA_RAM_BASE);
   ASSERT(ui32ResVectorLoc < (PKA_RAM_BASE + PKA_RAM_SIZE));
 
   // Verify that the operation is complete.
@@ -514,6 +645,7 @@ uint8_t PKABigNumMultGetResult(uint32_t* pui32ResultBuf, uint32_t* pui32Len,
   for(i = 0; i < *pui32Len; i++) {
     pui32ResultBuf[i] = REG((ui32ResVectorLoc + 4 * i));
   }
+  bus_bytes += 4 * len;
 
   return (PKA_STATUS_SUCCESS);
 }
@@ -523,43 +655,36 @@ uint8_t PKABigNumAddStart(uint32_t* pui32BN1, uint8_t ui8BN1Size,
                           uint32_t* pui32ResultVector, struct process *process) {
 
   uint32_t offset;
-  int i;
+  uint8_t len;
 
   // Check for arguments.
   ASSERT(NULL != pui32BN1);
   ASSERT(NULL != pui32BN2);
   ASSERT(NULL != pui32ResultVector);
 
-  offset = 0;
-
   // Make sure no operation is in progress.
-  if((REG(PKA_FUNCTION) & PKA_FUNCTION_RUN) != 0) {
+  if((REG(PKA_FUNCTION) & PKA_FUNCTION_RUN) != 0 ||
+     PKABigNumLocked()) {
     return (PKA_STATUS_OPERATION_INPRG);
   }
 
-  // Update the A ptr with the offset address of the PKA RAM location
-  // where the big number 1 will be stored.
-  REG((PKA_APTR)) = offset >> 2;
+  // The vectors are placed around the operands already in PKA RAM.
+  layout_begin();
+  layout_keep(pui32BN1, ui8BN1Size);
+  layout_keep(pui32BN2, ui8BN2Size);
 
-  // Load the big number 1 in PKA RAM.
-  for(i = 0; i < ui8BN1Size; i++) {
-    REG((PKA_RAM_BASE + offset + 4 * i)) = pui32BN1[i];
-  }
-
-  // Determine the offset in PKA RAM for the next data.
-  offset += 4 * (i + (ui8BN1Size % 2));
+  // Update the A ptr with the offset address of the PKA RAM location
+  // where the big number 1 is stored.
+  REG((PKA_APTR)) = layout_load(pui32BN1, ui8BN1Size, 0) >> 2;
 
   // Update the B ptr with the offset address of the PKA RAM location
-  // where the big number 2 will be stored.
-  REG((PKA_BPTR)) = offset >> 2;
+  // where the big number 2 is stored.
+  REG((PKA_BPTR)) = layout_load(pui32BN2, ui8BN2Size, 0) >> 2;
 
-  // Load the big number 2 in PKA RAM.
-  for(i = 0; i < ui8BN2Size; i++) {
-    REG((PKA_RAM_BASE + offset + 4 * i)) = pui32BN2[i];
-  }
-
-  // Determine the offset in PKA RAM for the next data.
-  offset += 4 * (i + (ui8BN2Size % 2));
+  // Determine the offset in PKA RAM for the result.
+  len = ui8BN1Size > ui8BN2Size ? ui8BN1Size : ui8BN2Size;
+  offset = layout_alloc(VECTOR_WORDS(len, 2));
+  ASSERT(!layout_overflow);
 
   // Copy the result vector address location.
   *pui32ResultVector = PKA_RAM_BASE + offset;
@@ -594,7 +719,7 @@ uint8_t PKABigNumAddGetResult(uint32_t* pui32ResultBuf, uint32_t* pui32Len,
   // Check for the arguments.
   ASSERT(NULL != pui32ResultBuf);
   ASSERT(NULL != pui32Len);
-  ASSERT(ui32ResVectorLoc > PKA_RAM_BASE);
+  ASSERT(ui32ResVectorLoc >= PKA_RAM_BASE);
   ASSERT(ui32ResVectorLoc < (PKA_RAM_BASE + PKA_RAM_SIZE));
 
   // Verify that the operation is complete.
@@ -632,6 +757,7 @@ uint8_t PKABigNumAddGetResult(uint32_t* pui32ResultBuf, uint32_t* pui32Len,
   for(i = 0; i < *pui32Len; i++) {
     pui32ResultBuf[i] = REG((ui32ResVectorLoc + 4 * i));
   }
+  bus_bytes += 4 * len;
 
   return (PKA_STATUS_SUCCESS);
 }
@@ -642,43 +768,36 @@ uint8_t PKABigNumSubtractStart(uint32_t* pui32BN1, uint8_t ui8BN1Size,
                                uint32_t* pui32ResultVector, struct process *process) {
 
   uint32_t offset;
-  int i;
+  uint8_t len;
 
   // Check for arguments.
   ASSERT(NULL != pui32BN1);
   ASSERT(NULL != pui32BN2);
   ASSERT(NULL != pui32ResultVector);
 
-  offset = 0;
-
   // Make sure no operation is in progress.
-  if((REG(PKA_FUNCTION) & PKA_FUNCTION_RUN) != 0) {
+  if((REG(PKA_FUNCTION) & PKA_FUNCTION_RUN) != 0 ||
+     PKABigNumLocked()) {
     return (PKA_STATUS_OPERATION_INPRG);
   }
 
-  // Update the A ptr with the offset address of the PKA RAM location
-  // where the big number 1 will be stored.
-  REG((PKA_APTR)) = offset >> 2;
-
-  // Load the big number 1 in PKA RAM.
-  for(i = 0; i < ui8BN1Size; i++) {
-    REG((PKA_RAM_BASE + offset + 4 * i)) = pui32BN1[i];
-  }
+  // The vectors are placed around the operands already in PKA RAM.
+  layout_begin();
+  layout_keep(pui32BN1, ui8BN1Size);
+  layout_keep(pui32BN2, ui8BN2Size);
 
-  // Determine the offset in PKA RAM for the next data.
-  offset += 4 * (i + (ui8BN1Size % 2));
+  // Update the A ptr with the offset address of the PKA RAM location
+  // where the big number 1 is stored.
+  REG((PKA_APTR)) = layout_load(pui32BN1, ui8BN1Size, 0) >> 2;
 
   // Update the B ptr with the offset address of the PKA RAM location
-  // where the big number 2 will be stored.
-  REG((PKA_BPTR)) = offset >> 2;
-
-  // Load the big number 2 in PKA RAM.
-  for(i = 0; i < ui8BN2Size; i++) {
-    REG((PKA_RAM_BASE + offset + 4 * i)) = pui32BN2[i];
-  }
+  // where the big number 2 is stored.
+  REG((PKA_BPTR)) = layout_load(pui32BN2, ui8BN2Size, 0) >> 2;
 
-  // Determine the offset in PKA RAM for the next data.
-  offset += 4 * (i + (ui8BN2Size % 2));
+  // Determine the offset in PKA RAM for the result.
+  len = ui8BN1Size > ui8BN2Size ? ui8BN1Size : ui8BN2Size;
+  offset = layout_alloc(VECTOR_WORDS(len, 2));
+  ASSERT(!layout_overflow);
 
   // Copy the result vector address location.
   *pui32ResultVector = PKA_RAM_BASE + offset;
@@ -713,7 +832,7 @@ uint8_t PKABigNumSubtractGetResult(uint32_t* pui32ResultBuf, uint32_t* pui32Len,
   // Check for the arguments.
   ASSERT(NULL != pui32ResultBuf);
   ASSERT(NULL != pui32Len);
-  ASSERT(ui32ResVectorLoc > PKA_RAM_BASE);
+  ASSERT(ui32ResVectorLoc >= PKA_RAM_BASE);
   ASSERT(ui32ResVectorLoc < (PKA_RAM_BASE + PKA_RAM_SIZE));
 
   // Verify that the operation is complete.
@@ -751,6 +870,7 @@ uint8_t PKABigNumSubtractGetResult(uint32_t* pui32ResultBuf, uint32_t* pui32Len,
   for(i = 0; i < *pui32Len; i++) {
     pui32ResultBuf[i] = REG((ui32ResVectorLoc + 4 * i));
   }
+  bus_bytes += 4 * len;
 
   return (PKA_STATUS_SUCCESS);
 }
@@ -772,39 +892,33 @@ extern uint8_t PKABigNumExpModStart(uint32_t* pui32BNum, uint8_t ui8BNSize,
   //ASSERT(NULL != ui8BaseSize);
   ASSERT(NULL != pui32ResultVector);
   ASSERT(pui32Modulus != pui32Base);
-
-  offset = 0;
+  // The base is overwritten by the result, it can not be used in place.
+  ASSERT(!IN_PKA_RAM(pui32Base));
 
   // Make sure no PKA operation is in progress.
-  if((REG(PKA_FUNCTION) & PKA_FUNCTION_RUN) != 0) {
+  if((REG(PKA_FUNCTION) & PKA_FUNCTION_RUN) != 0 ||
+     PKABigNumLocked()) {
     return (PKA_STATUS_OPERATION_INPRG);
   }
 
-  // Update the A ptr with the offset address of the PKA RAM location
-  // where the exponent will be stored.
-  REG((PKA_APTR)) = offset >> 2;
+  // The vectors are placed around the operands already in PKA RAM.
+  layout_begin();
+  layout_keep(pui32BNum, ui8BNSize);
+  layout_keep(pui32Modulus, ui8ModSize);
 
-  // Load the Exponent in PKA RAM.
-  for(i = 0; i < ui8BNSize; i++) {
-    REG((PKA_RAM_BASE + offset + 4 * i)) = pui32BNum[i];
-    //PRINTF("the A register is ,%d\n",pui32BNum[i]);
-  }
+  // Update the A ptr with the offset address of the PKA RAM location
+  // where the exponent is stored.
+  REG((PKA_APTR)) = layout_load(pui32BNum, ui8BNSize, 0) >> 2;
 
-  // Determine the offset for the next data(BPTR).
-  offset += 4 * (i + ui8BNSize % 2);
-  PRINTF("the B offset is ,%d\n",offset);
   // Update the B ptr with the offset address of the PKA RAM location
-  // where the divisor will be stored.
-  REG((PKA_BPTR)) = offset >> 2;
-
-  // Load the Modulus in PKA RAM.
-  for(i = 0; i < ui8ModSize; i++) {
-    REG((PKA_RAM_BASE + offset + 4 * i)) = pui32Modulus[i];
-    //PRINTF("the B register is ,%X\n",pui32Modulus[i]);
-  }
-
-  // Determine the offset for the next data(CPTR).
-  offset += 4 * (i + ui8ModSize % 2 + 2);
+  // where the modulus is stored.
+  REG((PKA_BPTR)) = layout_load(pui32Modulus, ui8ModSize, 2) >> 2;
+
+  // Determine the offset for the base. The PKA uses the area from C on
+  // for the result and the intermediate powers.
+  offset = layout_alloc(EXPMOD_WORDS(ui8ModSize > ui8BaseSize ?
+                                     ui8ModSize : ui8BaseSize));
+  ASSERT(!layout_overflow);
   PRINTF("the C offset is ,%d\n",offset);
   // Update the C ptr with the offset address of the PKA RAM location
   // where the Base will be stored.
@@ -816,10 +930,9 @@ extern uint8_t PKABigNumExpModStart(uint32_t* pui32BNum, uint8_t ui8BNSize,
     REG((PKA_RAM_BASE + offset + 4 * i)) = pui32Base[i];
     //PRINTF("the C register is ,%X\n",pui32Base[i]);
   }
+  bus_bytes += 4 * ui8BaseSize;
 
-  // Determine the offset for the next data.
-  /*INFO D and B can share the same memory area!*/
-  //offset += 4 * (i + extraBuf + 2);
+  /*INFO D and C share the same memory area!*/
 
   PRINTF("the D offset is ,%d\n",offset);
   // Copy the result vector address location.
@@ -856,7 +969,7 @@ uint8_t PKABigNumExpModGetResult(uint32_t* pui32ResultBuf, uint8_t ui8Size,
 
   // Check the arguments.
   ASSERT(NULL != pui32ResultBuf);
-  ASSERT(ui32ResVectorLoc > PKA_RAM_BASE);
+  ASSERT(ui32ResVectorLoc >= PKA_RAM_BASE);
   ASSERT(ui32ResVectorLoc < (PKA_RAM_BASE + PKA_RAM_SIZE));
 
   // verify that the operation is complete.
@@ -890,6 +1003,7 @@ uint8_t PKABigNumExpModGetResult(uint32_t* pui32ResultBuf, uint8_t ui8Size,
   for(i = 0; i < len; i++) {
     pui32ResultBuf[i] = REG((ui32ResVectorLoc + 4 * i));
   }
+  bus_bytes += 4 * len;
 
   return (PKA_STATUS_SUCCESS);
 }
@@ -901,7 +1015,6 @@ uint8_t PKABigNumDivideStart(uint32_t* pui32Xdividend, uint8_t ui8XdividendSize,
 
   uint32_t offset;
   uint32_t spacing;
-  int i;
 
   // We use largest len for spacing
   if(ui8XdividendSize > ui8XdivisorSize) {
@@ -917,42 +1030,32 @@ uint8_t PKABigNumDivideStart(uint32_t* pui32Xdividend, uint8_t ui8XdividendSize,
   ASSERT(NULL != pui32ResultVector);
 
   // Make sure no operation is in progress.
-  if((REG(PKA_FUNCTION) & PKA_FUNCTION_RUN) != 0) {
+  if((REG(PKA_FUNCTION) & PKA_FUNCTION_RUN) != 0 ||
+     PKABigNumLocked()) {
     return (PKA_STATUS_OPERATION_INPRG);
   }
 
-  // Update the A ptr with the offset address of the PKA RAM location
-  // where the multiplicand will be stored.
-  offset = 0;
-  REG((PKA_APTR)) = offset >> 2;
-
-  // Load the multiplicand in PKA RAM.
-  for(i = 0; i < ui8XdividendSize; i++) {
-    REG((PKA_RAM_BASE + offset + 4 * i)) = *pui32Xdividend;
-    pui32Xdividend++;
-  }
+  // The vectors are placed around the operands already in PKA RAM.
+  layout_begin();
+  layout_keep(pui32Xdividend, ui8XdividendSize);
+  layout_keep(pui32Xdivisor, ui8XdivisorSize);
 
-  // Determine the offset for the next data.
-  offset += 4 * spacing;
+  // Update the A ptr with the offset address of the PKA RAM location
+  // where the dividend is stored.
+  REG((PKA_APTR)) = layout_load(pui32Xdividend, ui8XdividendSize,
+                                spacing - VECTOR_WORDS(ui8XdividendSize, 0)) >> 2;
 
   // Update the B ptr with the offset address of the PKA RAM location
-  // where the multiplier will be stored.
-  REG((PKA_BPTR)) = offset >> 2;
-
-  // Load the multiplier in PKA RAM.
-  for(i = 0; i < ui8XdivisorSize; i++) {
-    REG((PKA_RAM_BASE + offset + 4 * i)) = *pui32Xdivisor;
-    pui32Xdivisor++;
-  }
-
-  // Determine the offset for the reminder.
-  offset += 4 * spacing;
+  // where the divisor is stored.
+  REG((PKA_BPTR)) = layout_load(pui32Xdivisor, ui8XdivisorSize,
+                                spacing - VECTOR_WORDS(ui8XdivisorSize, 0)) >> 2;
 
-  // Load C ptr with the result location in PKA RAM.
-  REG((PKA_CPTR)) = offset >> 2;
+  // Load C ptr with the location of the reminder in PKA RAM.
+  REG((PKA_CPTR)) = layout_alloc(spacing) >> 2;
 
   // Determine the offset for the quotient.
-  offset += 4 * spacing;
+  offset = layout_alloc(spacing);
+  ASSERT(!layout_overflow);
 
   // Copy the quotient vector address location.
   *pui32ResultVector = PKA_RAM_BASE + offset;
@@ -988,7 +1091,7 @@ uint8_t PKABigNumDivideGetResult(uint32_t* pui32ResultBuf, uint32_t* pui32Len,
   // Check for arguments.
   ASSERT(NULL != pui32ResultBuf);
   ASSERT(NULL != pui32Len);
-  ASSERT(ui32ResVectorLoc > PKA_RAM_BASE);
+  ASSERT(ui32ResVectorLoc >= PKA_RAM_BASE);
   ASSERT(ui32ResVectorLoc < (PKA_RAM_BASE + PKA_RAM_SIZE));
 
   // Verify that the operation is complete.
@@ -1026,6 +1129,7 @@ uint8_t PKABigNumDivideGetResult(uint32_t* pui32ResultBuf, uint32_t* pui32Len,
   for(i = 0; i < *pui32Len; i++) {
     pui32ResultBuf[i] = REG((ui32ResVectorLoc + 4 * i));
   }
+  bus_bytes += 4 * len;
 
   return (PKA_STATUS_SUCCESS);
 }
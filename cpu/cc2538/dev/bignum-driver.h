@@ -76,6 +76,86 @@
  */
 void printNumber(const uint32_t *x, int numberLength);
 
+/** \brief Turns a PKA RAM vector location into an operand pointer
+ *
+ * Operands of the start functions which point into the PKA RAM are used in
+ * place instead of being copied. This applies to resident vectors, see
+ * PKABigNumPin(), and to the result vector of the previous operation, which
+ * is chained into the next one without reading it out. A chained result is
+ * only valid until the next operation has completed, its length is the
+ * length of the result buffer the get function would require:
+ * \e ui8ModSize words for the (inv)mod and exp-mod, the sum of the operand
+ * lengths for the multiplication and the longer operand plus one word for
+ * the addition and subtraction. The base of the exp-mod can not be used in
+ * place. Resident vectors and chained results require PKABigNumLock().
+ */
+#define PKA_VECTOR(loc)         ((uint32_t *)(uintptr_t)(loc))
+
+/** \brief Reserves the PKA RAM for the current process
+ *
+ * Resident vectors and chained results are global PKA RAM state. A process
+ * holds the lock from its first PKABigNumPin() or chained operation until
+ * it has read the last of them. Meanwhile the start functions of the
+ * BigNum and ECC drivers return \b PKA_STATUS_OPERATION_INPRG to other
+ * processes, as if the PKA was busy. Locking again from the holder is
+ * allowed.
+ *
+ * \return Returns:
+ * - \b PKA_STATUS_SUCCESS if successful.
+ * - \b PKA_STATUS_OPERATION_INPRG, if another process holds the lock.
+ */
+extern uint8_t PKABigNumLock(void);
+
+/** \brief Releases all resident vectors and the lock, unless another
+ *         process holds it
+ */
+extern void PKABigNumUnlock(void);
+
+/** \brief Returns non-zero if another process holds the lock */
+extern uint8_t PKABigNumLocked(void);
+
+/** \brief PKABigNumLock() for protothreads, which yield while another
+ *         process holds the lock
+ * \param pt The protothread
+ * \param process Process to poll for the retry
+ */
+#define PKA_WAIT_LOCK(pt, process)                                           \
+  while(PKABigNumLock() != PKA_STATUS_SUCCESS) {                             \
+    process_poll(process);                                                   \
+    PT_YIELD(pt);                                                            \
+  }
+
+/** \brief Loads a big number into the PKA RAM for the following operations
+ *
+ * \param pui32BNum is the pointer to the big number, e.g. a modulus.
+ * \param ui8Size is the size of the big number in 32-bit words.
+ * \param pui32VectorLoc is set to the PKA RAM location of the vector, pass
+ *        PKA_VECTOR(location) as operand.
+ *
+ * Resident vectors are stacked at the end of the PKA RAM, the operations
+ * place their vectors below them. The ECC driver uses the whole PKA RAM and
+ * releases all resident vectors. The caller must hold PKABigNumLock().
+ *
+ * \return Returns:
+ * - \b PKA_STATUS_SUCCESS if successful.
+ * - \b PKA_STATUS_OPERATION_INPRG, if the PKA hw module is busy or another
+ *   process holds the lock.
+ * - \b PKA_STATUS_INVALID_PARAM, if there is no room left or the lock is
+ *   not held.
+ */
+extern uint8_t PKABigNumPin(uint32_t* pui32BNum, uint8_t ui8Size,
+                            uint32_t* pui32VectorLoc);
+
+/** \brief Releases all resident vectors, unless another process holds the
+ *         lock
+ */
+extern void PKABigNumUnpinAll(void);
+
+/** \brief Returns the number of bytes copied between the CPU and the
+ *         PKA RAM by this driver since start up
+ */
+extern uint32_t PKABigNumBusBytes(void);
+
 /** \brief Starts the big number modulus operation.
  *
  * \param pui32BNum is the pointer to the big number on which modulo operation
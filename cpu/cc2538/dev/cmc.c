@@ -41,211 +41,188 @@
 #include "contiki.h"
 #include "dev/crypto.h"
 #include "dev/aes.h"
-#include "dev/nvic.h"
-#include "reg.h"
+#include "dev/cmc.h"
 
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 
-static uint8_t cmc_init(uint8_t ui8KeyLocation,  uint8_t ui8Encrypt, uint32_t len) {
-  if(REG(AES_CTRL_ALG_SEL) != 0x00000000) {
-    return AES_RESOURCE_IN_USE;
-  }
-
-  /* Workaround for AES registers not retained after PM2 */
-  REG(AES_CTRL_INT_CFG) = AES_CTRL_INT_CFG_LEVEL;
-  REG(AES_CTRL_INT_EN)  = 0x00000000;
-  REG(AES_CTRL_ALG_SEL) = 0x00000000;
-
-  REG(AES_KEY_STORE_READ_AREA) = (uint32_t) ui8KeyLocation;
-
-  /* Wait until key is loaded to the AES module */
-  while(REG(AES_KEY_STORE_READ_AREA) & AES_KEY_STORE_READ_AREA_BUSY);
-
-  /* Check for Key Store read error */
-  if(REG(AES_CTRL_INT_STAT) & AES_CTRL_INT_STAT_KEY_ST_RD_ERR) {
-    /* Clear the Keystore Read error bit */
-    REG(AES_CTRL_INT_CLR) = AES_CTRL_INT_CLR_KEY_ST_RD_ERR;
-    /* Disable the master control / DMA clock */
-    REG(AES_CTRL_ALG_SEL) = 0x00000000;
-    return AES_KEYSTORE_READ_ERROR;
-  }
+/* One AES job over len bytes from in to out, the CBC IV is zero */
+static
+PT_THREAD(aes_pass(struct pt *pt, cmc_state_t *state, uint8_t *in, uint8_t *out,
+                   uint32_t len, uint8_t encrypt, AES_MODE mode))
+{
+  PT_BEGIN(pt);
 
-  /* Write initialization vector */
-  REG(AES_AES_IV_0) = 0x00000000;
-  REG(AES_AES_IV_1) = 0x00000000;
-  REG(AES_AES_IV_2) = 0x00000000;
-  REG(AES_AES_IV_3) = 0x00000000;
-
-  /* Program AES engine */
-  if(ui8Encrypt) {
-    REG(AES_AES_CTRL) = AES_AES_CTRL_DIRECTION_ENCRYPT;
-  } else {
-    REG(AES_AES_CTRL) = 0x00000000;
+  memset(state->iv, 0, sizeof(state->iv));
+  state->result = aes_start(in, (uint8_t *)state->iv, out, state->key_area,
+                            encrypt, mode, len, state->process);
+  if(state->result != AES_SUCCESS) {
+    PT_EXIT(pt);
   }
+  PT_WAIT_UNTIL(pt, aes_check_status());
+  state->result = aes_get_result((uint8_t *)state->iv);
 
-  /* Write the length of the crypto block (lo) */
-  REG(AES_AES_C_LENGTH_0) = (uint32_t) len;
-  /* Write the length of the crypto block (hi) */
-  REG(AES_AES_C_LENGTH_1) = 0;
-
-  return AES_SUCCESS;
+  PT_END(pt);
 }
 
-static uint8_t cmc_cleanup() {
-  uint32_t aes_ctrl_int_stat = 0;
-
-  /* Wait until the AES module is done */
-  while(REG(AES_CTRL_ALG_SEL) != 0x00000000);
-
-  aes_ctrl_int_stat = REG(AES_CTRL_INT_STAT);
-  /* Clear the error bits */
-  REG(AES_CTRL_INT_CLR) = AES_CTRL_INT_CLR_DMA_BUS_ERR |
-                          AES_CTRL_INT_CLR_KEY_ST_WR_ERR |
-                          AES_CTRL_INT_CLR_KEY_ST_RD_ERR;
+static void xor_block(uint32_t *dst, const uint32_t *src) {
+  int j;
 
-  if(aes_ctrl_int_stat & AES_CTRL_INT_STAT_DMA_BUS_ERR) {
-    return AES_DMA_BUS_ERROR;
+  for(j = 0; j < 4; j++) {
+    dst[j] ^= src[j];
   }
-  if(aes_ctrl_int_stat & AES_CTRL_INT_STAT_KEY_ST_WR_ERR) {
-    return AES_KEYSTORE_WRITE_ERROR;
-  }
-  if(aes_ctrl_int_stat & AES_CTRL_INT_STAT_KEY_ST_RD_ERR) {
-    return AES_KEYSTORE_READ_ERROR;
-  }
-
-  /* Clear Mode */
-  REG(AES_AES_CTRL) = 0x00000000;
-  return AES_SUCCESS;
 }
 
-static void cmc_block(uint8_t* in, uint8_t *out) {
-  /* Wait until the AES module is ready for a block */
-  while(!(REG(AES_AES_CTRL) & AES_AES_CTRL_INPUT_READY));
-
-  /* Write Data */
-  REG(AES_AES_DATA_IN_OUT_0) = ((uint32_t*)in)[0];
-  REG(AES_AES_DATA_IN_OUT_1) = ((uint32_t*)in)[1];
-  REG(AES_AES_DATA_IN_OUT_2) = ((uint32_t*)in)[2];
-  REG(AES_AES_DATA_IN_OUT_3) = ((uint32_t*)in)[3];
-
-  /* Start processing next block */
-  REG(AES_AES_CTRL) |= AES_AES_CTRL_INPUT_READY |
-                       AES_AES_CTRL_OUTPUT_READY;
+/* Adds M = 2 * (first ^ last) to every block and reverses the block order */
+static void cmc_mask(uint8_t *data, uint32_t len) {
+  uint32_t *head, *tail;
+  uint32_t t[4];
+  uint8_t m[16];
+  uint8_t carry = 0;
+  int j;
 
-  /* Wait until the AES module processed the block */
-  while(!(REG(AES_AES_CTRL) & AES_AES_CTRL_OUTPUT_READY));
+  for(j = 15; j >= 0; j--) {
+    uint8_t a = data[j] ^ data[len - 16 + j];
+    m[j] = (uint8_t)(a << 1) | carry;
+    carry = a >> 7;
+  }
+  if(carry) {
+    m[15] ^= 0x87;
+  }
 
-  /* Read Data */
-  ((uint32_t*)out)[0] = REG(AES_AES_DATA_IN_OUT_0);
-  ((uint32_t*)out)[1] = REG(AES_AES_DATA_IN_OUT_1);
-  ((uint32_t*)out)[2] = REG(AES_AES_DATA_IN_OUT_2);
-  ((uint32_t*)out)[3] = REG(AES_AES_DATA_IN_OUT_3);
+  head = (uint32_t *)data;
+  tail = (uint32_t *)(data + len - 16);
+  for(; head < tail; head += 4, tail -= 4) {
+    for(j = 0; j < 4; j++) {
+      t[j] = head[j] ^ ((uint32_t *)m)[j];
+      head[j] = tail[j] ^ ((uint32_t *)m)[j];
+      tail[j] = t[j];
+    }
+  }
+  if(head == tail) {
+    xor_block(head, (uint32_t *)m);
+  }
 }
 
-uint8_t cmc_encrypt(uint8_t* ptext, uint8_t *ctext, uint8_t ui8KeyLocation, uint32_t len) {
-  uint32_t x[4];
+static
+PT_THREAD(cmc_encrypt_run(cmc_state_t *state))
+{
+  uint32_t *blocks = (uint32_t *)state->out;
   uint32_t i;
-  uint32_t j;
 
-  if(cmc_init(0, 1, len*2)) {
-    return AES_DMA_BUS_ERROR;
+  PT_BEGIN(&state->pt);
+
+  /* PPP_i = E(P_i ^ PPP_i-1): one CBC job */
+  PT_SPAWN(&state->pt, &state->pass_pt,
+           aes_pass(&state->pass_pt, state, state->in, state->out, state->len, 1, AES_CBC));
+  if(state->result != AES_SUCCESS) {
+    PT_EXIT(&state->pt);
   }
 
-  /* CBC */
-  memset(x, 0, 16);
-  for(i = 0; i < len; i += 16) {
-    uint32_t y[4];
-    for(j = 0; j < 4; j++)
-      y[j] = ((uint32_t*)ptext)[i/4 + j] ^ x[j];
+  /* CCC_i = PPP_m+1-i ^ M */
+  cmc_mask(state->out, state->len);
 
-    cmc_block((uint8_t*)y, &ctext[i]);
-    memcpy(x, &ctext[i], 16);
-  }
+  /* C_i = E(CCC_i) ^ CCC_i-1: ECB jobs in place from the last block on, the
+   * CCC_i-1 a job overwrites are saved first */
+  for(state->block = state->len / 16; state->block > 0; state->block = state->first) {
+    state->first = state->block > CMC_SAVE_BLOCKS ? state->block - CMC_SAVE_BLOCKS - 1 : 0;
+    memcpy(state->save, &blocks[4 * state->first], 16 * (state->block - state->first - 1));
 
-  /* Mask */
-  uint8_t m[16];
-  uint8_t carry = 0;
-  for(j = 16; j != 0; j--) {
-    uint16_t a = ctext[j - 1] ^ ctext[j - 1 + len - 16];
-    m[j] = carry | (uint8_t) (a << 1);
-    carry = a >> 7;
-  }
-  m[16 - 1] |= carry;
+    PT_SPAWN(&state->pt, &state->pass_pt,
+             aes_pass(&state->pass_pt, state, state->out + 16 * state->first,
+                      state->out + 16 * state->first, 16 * (state->block - state->first), 1, AES_ECB));
+    if(state->result != AES_SUCCESS) {
+      PT_EXIT(&state->pt);
+    }
 
-  for(i = 0; i < len; i += 16) {
-    for(j = 0; j < 4; j++)
-      ((uint32_t*)ctext)[i/4 + j] ^= ((uint32_t*)m)[j];
+    blocks = (uint32_t *)state->out;
+    for(i = state->first + 1; i < state->block; i++) {
+      xor_block(&blocks[4 * i], state->save[i - state->first - 1]);
+    }
+    if(state->first > 0) {
+      xor_block(&blocks[4 * state->first], &blocks[4 * (state->first - 1)]);
+    }
   }
 
-  /* CBC */
-  memset(x, 0, 16);
-  for(i = len; i != 0; i -= 16) {
-    uint32_t y[4];
-    cmc_block(&ctext[i - 16], (uint8_t*)y);
+  PT_END(&state->pt);
+}
 
-    uint32_t z[4];
-    for(j = 0; j < 4; j++)
-      z[j] = y[j] ^ x[j];
+static
+PT_THREAD(cmc_decrypt_run(cmc_state_t *state))
+{
+  uint32_t *block;
 
-    memcpy(x, &ctext[i - 16], 16);
-    memcpy(&ctext[i - 16], z, 16);
-  }
-  return cmc_cleanup();
-}
+  PT_BEGIN(&state->pt);
 
-uint8_t cmc_decrypt(uint8_t *ctext, uint8_t *ptext, uint8_t ui8KeyLocation, uint32_t len) {
-  uint32_t x[4];
-  uint32_t i;
-  uint32_t j;
+  /* CCC_i = D(C_i ^ CCC_i-1): the chaining goes through the decryption, which
+   * no AES mode does, so every block is a job of its own */
+  for(state->block = 0; state->block < state->len / 16; state->block++) {
+    block = (uint32_t *)state->out + 4 * state->block;
+    if(state->in != state->out) {
+      memcpy(block, state->in + 16 * state->block, 16);
+    }
+    if(state->block > 0) {
+      xor_block(block, block - 4);
+    }
 
-  if(cmc_init(0, 0, len * 2)) {
-    return AES_DMA_BUS_ERROR;
+    PT_SPAWN(&state->pt, &state->pass_pt,
+             aes_pass(&state->pass_pt, state, state->out + 16 * state->block,
+                      state->out + 16 * state->block, 16, 0, AES_ECB));
+    if(state->result != AES_SUCCESS) {
+      PT_EXIT(&state->pt);
+    }
   }
 
-  /* CBC */
-  memset(x, 0, 16);
-  for(i = len; i != 0; i -= 16) {
-    uint32_t y[4];
-    for(j = 0; j < 4; j++)
-      y[j] = ((uint32_t*)ctext)[i/4 - 4 + j] ^ x[j];
+  /* PPP_i = CCC_m+1-i ^ M */
+  cmc_mask(state->out, state->len);
 
-    cmc_block((uint8_t*)y, &ptext[i - 16]);
-    memcpy(x, &ptext[i - 16], 16);
-  }
+  /* P_i = D(PPP_i) ^ PPP_i-1: one CBC job */
+  PT_SPAWN(&state->pt, &state->pass_pt,
+           aes_pass(&state->pass_pt, state, state->out, state->out, state->len, 0, AES_CBC));
 
-  /* Mask */
-  uint8_t m[16];
-  uint8_t carry = 0;
-  for(j = 16; j != 0; j--) {
-    uint16_t a = ptext[j - 1] ^ ptext[j - 1 + len - 16];
-    m[j] = carry | (uint8_t) (a << 1);
-    carry = a >> 7;
-  }
+  PT_END(&state->pt);
+}
 
-  m[16 - 1] |= carry;
-  for(i = 0; i < len; i += 16) {
-    for(j = 0; j < 4; j++)
-      ((uint32_t*)ptext)[i/4 + j] ^= ((uint32_t*)m)[j];
+static
+PT_THREAD(cmc_run(cmc_state_t *state, uint8_t encrypt))
+{
+  if(state->len == 0 || state->len % 16) {
+    state->result = AES_INVALID_PARAM;
+    return PT_EXITED;
   }
+  return encrypt ? cmc_encrypt_run(state) : cmc_decrypt_run(state);
+}
+
+PT_THREAD(cmc_encrypt_async(cmc_state_t *state)) {
+  return cmc_run(state, 1);
+}
 
-  /* CBC */
-  memset(x, 0, 16);
-  for(i = 0; i < len; i += 16) {
-    uint32_t y[4];
-    cmc_block(&ptext[i], (uint8_t*)y);
+PT_THREAD(cmc_decrypt_async(cmc_state_t *state)) {
+  return cmc_run(state, 0);
+}
 
-    uint32_t z[4];
-    for(j = 0; j < 4; j++)
-      z[j] = y[j] ^ x[j];
+static uint8_t cmc_blocking(uint8_t *in, uint8_t *out, uint8_t ui8KeyLocation,
+                            uint32_t len, uint8_t encrypt) {
+  cmc_state_t state;
+
+  state.process = NULL;
+  state.in = in;
+  state.out = out;
+  state.len = len;
+  state.key_area = ui8KeyLocation;
+  PT_INIT(&state.pt);
+  while(PT_SCHEDULE(cmc_run(&state, encrypt)));
+  return state.result;
+}
 
-    memcpy(x, &ptext[i], 16);
-    memcpy(&ptext[i], z, 16);
-  }
+uint8_t cmc_encrypt(uint8_t* ptext, uint8_t *ctext, uint8_t ui8KeyLocation, uint32_t len) {
+  return cmc_blocking(ptext, ctext, ui8KeyLocation, len, 1);
+}
 
-  return cmc_cleanup();
+uint8_t cmc_decrypt(uint8_t *ctext, uint8_t *ptext, uint8_t ui8KeyLocation, uint32_t len) {
+  return cmc_blocking(ctext, ptext, ui8KeyLocation, len, 0);
 }
 
 /** @} */
@@ -53,24 +53,80 @@
 #include <stdint.h>
 /*---------------------------------------------------------------------------*/
 /** \name AES-CMC functions
+ *
+ * CMC of Halevi and Rogaway with a zero tweak: a CBC encryption with a zero
+ * IV (one DMA job), the mask M = 2 * (PPP_1 ^ PPP_m) in GF(2^128) added to
+ * every block while the block order is reversed, and the second pass
+ * C_i = E(CCC_i) ^ CCC_i-1, run as ECB jobs whose results are chained in
+ * software. Decryption inverts the steps; its first pass chains through the
+ * block decryption, so it takes one job per block. Every ciphertext block
+ * depends on every plaintext block, as needed for a deterministic mode.
+ *
+ * \note The buffers must be word aligned, input and output may be the same.
+ * The length must be a nonzero multiple of 16 bytes.
  * @{
  */
 
-/** \brief Performs an AES operation and is writing/reading data through registers.
+/** Blocks saved aside for the in-place second encryption pass, which runs in
+ * ECB jobs of CMC_SAVE_BLOCKS + 1 blocks */
+#ifdef CMC_CONF_SAVE_BLOCKS
+#define CMC_SAVE_BLOCKS CMC_CONF_SAVE_BLOCKS
+#else
+#define CMC_SAVE_BLOCKS 8
+#endif
+
+#if CMC_SAVE_BLOCKS < 1
+#error "CMC_SAVE_BLOCKS must be at least 1"
+#endif
+
+typedef struct {
+  //Containers for the State
+  struct pt      pt;
+  struct pt      pass_pt;
+  struct process *process;      //Process polled by the AES interrupt, or NULL
+
+  //Input Variables
+  uint8_t     *in;              //Input data
+  uint8_t     *out;             //Output data, may equal in
+  uint32_t    len;              //Length in bytes
+  uint8_t     key_area;         //Location in Key RAM
+
+  //Variables Holding intermediate data (initialized/used internally)
+  uint32_t    iv[4];
+  uint32_t    block;            //Next block, or end of the next ECB job
+  uint32_t    first;            //First block of the ECB job
+  uint32_t    save[CMC_SAVE_BLOCKS][4]; //CCC_i-1 overwritten by the ECB job
+
+  //Output Variables
+  uint8_t     result;           //AES_SUCCESS, AES_INVALID_PARAM, or AES error code
+} cmc_state_t;
+
+/** \brief Encrypts state->len bytes with AES-CMC
+ *
+ * Yields until the AES interrupt polls state->process after each job.
+ */
+PT_THREAD(cmc_encrypt_async(cmc_state_t *state));
+
+/** \brief Decrypts state->len bytes with AES-CMC */
+PT_THREAD(cmc_decrypt_async(cmc_state_t *state));
+
+/** \brief Encrypts, spinning until the engine is done.
  * \param ptext is pointer to input data.
  * \param ctext is pointer to output data.
  * \param ui8KeyLocation is the location in Key RAM.
- * \param len the data length
- * \return \c AES_SUCCESS if successful, or AES error code
+ * \param len the data length, a nonzero multiple of 16
+ * \return \c AES_SUCCESS if successful, \c AES_INVALID_PARAM for another
+ * length, or AES error code
  */
 uint8_t cmc_encrypt(uint8_t* ptext, uint8_t *ctext, uint8_t ui8KeyLocation, uint32_t len);
 
-/** \brief Performs an AES operation and is writing/reading data through registers.
+/** \brief Decrypts, spinning until the engine is done.
  * \param ctext is pointer to input data.
  * \param ptext is pointer to output data.
  * \param ui8KeyLocation is the location in Key RAM.
- * \param len the data length
- * \return \c AES_SUCCESS if successful, or AES error code
+ * \param len the data length, a nonzero multiple of 16
+ * \return \c AES_SUCCESS if successful, \c AES_INVALID_PARAM for another
+ * length, or AES error code
  */
 uint8_t cmc_decrypt(uint8_t *ctext, uint8_t *ptext, uint8_t ui8KeyLocation, uint32_t len);
 
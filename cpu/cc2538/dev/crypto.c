@@ -44,6 +44,7 @@
 #include "contiki.h"
 #include "sys/energest.h"
 #include "dev/crypto.h"
+#include "dev/key-store.h"
 #include "dev/sys-ctrl.h"
 #include "dev/nvic.h"
 #include "lpm.h"
@@ -98,6 +99,9 @@ crypto_init(void)
   REG(SYS_CTRL_SRSEC) |= SYS_CTRL_SRSEC_AES;
   for(i = 0; i < 16; i++);
   REG(SYS_CTRL_SRSEC) &= ~SYS_CTRL_SRSEC_AES;
+
+  /* The reset cleared the key store */
+  key_store_flush();
 }
 /*---------------------------------------------------------------------------*/
 void
@@ -118,6 +122,12 @@ crypto_disable(void)
   REG(SYS_CTRL_DCGCSEC) &= ~SYS_CTRL_DCGCSEC_AES;
 }
 /*---------------------------------------------------------------------------*/
+uint8_t
+crypto_is_enabled(void)
+{
+  return (REG(SYS_CTRL_RCGCSEC) & SYS_CTRL_RCGCSEC_AES) != 0;
+}
+/*---------------------------------------------------------------------------*/
 void
 crypto_register_process_notification(struct process *p)
 {
@@ -471,6 +471,7 @@
 #define CCM_AUTHENTICATION_FAILED     5
 #define SHA256_INVALID_PARAM          6
 #define SHA256_NULL_ERROR             7
+#define AES_INVALID_PARAM             8
 /** @} */
 /*---------------------------------------------------------------------------*/
 /** \name Crypto functions
@@ -490,6 +491,11 @@ void crypto_enable(void);
  */
 void crypto_disable(void);
 
+/** \brief Checks whether the AES / SHA cryptoprocessor is enabled
+ * \return Non-zero if the clock of the cryptoprocessor runs
+ */
+uint8_t crypto_is_enabled(void);
+
 /** \brief Registers a process to be notified of the completion of a crypto
  * operation
  * \param p Process to be polled upon IRQ
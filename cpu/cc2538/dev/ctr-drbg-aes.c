@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2015, Institute for Pervasive Computing, ETH Zurich.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/**
+ * \addtogroup cc2538-ctr-drbg
+ * @{
+ *
+ * \file
+ * AES engine backend of the cc2538 CTR-DRBG
+ */
+#include "contiki.h"
+#include "dev/aes.h"
+#include "dev/crypto.h"
+#include "dev/key-store.h"
+#include "ctr-drbg.h"
+
+#include <stdint.h>
+#include <string.h>
+/* The key of the DRBG, replaced in place by every request. It is taken by
+ * the first request, i.e. at instantiation, and kept afterwards. */
+static key_store_handle_t handle = KEY_STORE_INVALID;
+/*---------------------------------------------------------------------------*/
+static uint8_t
+keystream(const uint8_t *key, const uint8_t *ctr, uint8_t *buf, uint16_t len)
+{
+  uint32_t iv[4];
+  key_store_handle_t replaced;
+  uint8_t area;
+  uint8_t result;
+
+  replaced = key_store_replace(handle, key, AES_KEY_STORE_SIZE_KEY_SIZE_128);
+  if(replaced == KEY_STORE_INVALID) {
+    return CTR_DRBG_BUSY;
+  }
+  handle = replaced;
+  result = key_store_acquire(handle, &area);
+  if(result != AES_SUCCESS) {
+    return result == AES_RESOURCE_IN_USE ? CTR_DRBG_BUSY : CTR_DRBG_FAILURE;
+  }
+
+  /* The key stream is the encryption of zeros, in place. The CPU waits for
+   * the DMA job: requests are keys, nonces and scalars of a few blocks,
+   * done before a yield would come back, and the synchronous callers
+   * (tinydtls, the Paillier pool) could not yield anyway. */
+  memcpy(iv, ctr, sizeof(iv));
+  memset(buf, 0, len);
+  result = aes_start(buf, (uint8_t *)iv, buf, area, 1, AES_CTR, len, NULL);
+  if(result == AES_SUCCESS) {
+    while(!aes_check_status());
+    result = aes_get_result((uint8_t *)iv);
+  }
+
+  key_store_release(handle);
+  if(result == AES_SUCCESS) {
+    return CTR_DRBG_SUCCESS;
+  }
+  return result == AES_RESOURCE_IN_USE ? CTR_DRBG_BUSY : CTR_DRBG_FAILURE;
+}
+/*---------------------------------------------------------------------------*/
+uint8_t
+ctr_drbg_keystream(const uint8_t *key, const uint8_t *ctr,
+                   uint8_t *buf, uint16_t len)
+{
+  uint8_t enabled;
+  uint8_t result;
+
+  /* Most requests come from PKA code (Paillier, EC-ElGamal, ECC keys) that
+   * never runs the AES engine, so the clock is turned on here and gated
+   * again only if it was off, not under an AES or SHA job of another user */
+  enabled = crypto_is_enabled();
+  if(!enabled) {
+    crypto_enable();
+  }
+  result = keystream(key, ctr, buf, len);
+  if(!enabled) {
+    crypto_disable();
+  }
+  return result;
+}
+
+/** @} */
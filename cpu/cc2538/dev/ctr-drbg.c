@@ -0,0 +1,276 @@
+/*
+ * Copyright (c) 2015, Institute for Pervasive Computing, ETH Zurich.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/**
+ * \addtogroup cc2538-ctr-drbg
+ * @{
+ *
+ * \file
+ * Implementation of the cc2538 CTR-DRBG, independent of the AES backend
+ */
+#include "contiki.h"
+#include "ctr-drbg.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#define BLOCK_LEN 16
+
+static uint32_t key[BLOCK_LEN / 4];
+static uint32_t v[BLOCK_LEN / 4];
+static uint32_t seed[CTR_DRBG_ENTROPY_LEN / 4];
+static uint32_t reseed_counter;   /* Requests since the last seeding, from 1 */
+static uint8_t collected;         /* A seed is waiting in seed */
+static uint8_t instantiated;
+/*---------------------------------------------------------------------------*/
+/* v = v + n, on the low 32 bits in big endian order */
+static void
+advance(uint8_t *ctr, uint32_t n)
+{
+  uint32_t low;
+
+  low = (uint32_t)ctr[12] << 24 | (uint32_t)ctr[13] << 16
+      | (uint32_t)ctr[14] << 8 | ctr[15];
+  low += n;
+  ctr[12] = low >> 24;
+  ctr[13] = low >> 16;
+  ctr[14] = low >> 8;
+  ctr[15] = low;
+}
+/*---------------------------------------------------------------------------*/
+/* CTR_DRBG_Update: (key, v) = E(key, v + 1) || E(key, v + 2) xor data */
+static uint8_t
+update(const uint8_t *data)
+{
+  uint32_t ctr[BLOCK_LEN / 4];
+  uint32_t temp[CTR_DRBG_SEED_LEN / 4];
+  uint8_t result;
+  uint8_t i;
+
+  memcpy(ctr, v, sizeof(ctr));
+  advance((uint8_t *)ctr, 1);
+  result = ctr_drbg_keystream((uint8_t *)key, (uint8_t *)ctr,
+                              (uint8_t *)temp, sizeof(temp));
+  if(result != CTR_DRBG_SUCCESS) {
+    return result;
+  }
+
+  if(data != NULL) {
+    for(i = 0; i < CTR_DRBG_SEED_LEN; i++) {
+      ((uint8_t *)temp)[i] ^= data[i];
+    }
+  }
+  memcpy(key, temp, sizeof(key));
+  memcpy(v, (uint8_t *)temp + sizeof(key), sizeof(v));
+  memset(temp, 0, sizeof(temp));
+  return CTR_DRBG_SUCCESS;
+}
+/*---------------------------------------------------------------------------*/
+/* Byte k of S = L || N || input || 0x80 || 0..., with L = len and N the
+ * seed length as 32 bit big endian numbers */
+static uint8_t
+df_byte(const uint8_t *input, uint16_t len, uint16_t k)
+{
+  if(k < 4) {
+    return k < 2 ? 0 : (k == 2 ? len >> 8 : len);
+  }
+  if(k < 8) {
+    return k == 7 ? CTR_DRBG_SEED_LEN : 0;
+  }
+  if(k < 8 + len) {
+    return input[k - 8];
+  }
+  return k == 8 + len ? 0x80 : 0;
+}
+/*---------------------------------------------------------------------------*/
+/* Block_Cipher_df: compresses input of any length into CTR_DRBG_SEED_LEN
+ * bytes, each encryption is a one block key stream */
+static uint8_t
+derive(const uint8_t *input, uint16_t len, uint8_t *out)
+{
+  static const uint8_t df_key[BLOCK_LEN] = {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+    0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f
+  };
+  uint8_t temp[CTR_DRBG_SEED_LEN];
+  uint8_t block[BLOCK_LEN];
+  uint16_t k;
+  uint8_t result;
+  uint8_t i, j;
+
+  /* temp = BCC(df_key, IV_0 || S) || BCC(df_key, IV_1 || S), IV_i = i || 0 */
+  for(i = 0; i < CTR_DRBG_SEED_LEN / BLOCK_LEN; i++) {
+    memset(block, 0, sizeof(block));
+    block[3] = i;
+    for(k = 0; ; k += BLOCK_LEN) {
+      result = ctr_drbg_keystream(df_key, block, temp + i * BLOCK_LEN,
+                                  BLOCK_LEN);
+      if(result != CTR_DRBG_SUCCESS || k >= 8 + len + 1) {
+        break;
+      }
+      for(j = 0; j < BLOCK_LEN; j++) {
+        block[j] = temp[i * BLOCK_LEN + j] ^ df_byte(input, len, k + j);
+      }
+    }
+    if(result != CTR_DRBG_SUCCESS) {
+      return result;
+    }
+  }
+
+  /* out = E(K, X) || E(K, E(K, X)) with K || X = temp */
+  result = ctr_drbg_keystream(temp, temp + BLOCK_LEN, out, BLOCK_LEN);
+  if(result == CTR_DRBG_SUCCESS) {
+    result = ctr_drbg_keystream(temp, out, out + BLOCK_LEN, BLOCK_LEN);
+  }
+  memset(temp, 0, sizeof(temp));
+  memset(block, 0, sizeof(block));
+  return result;
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t
+instantiate(void)
+{
+  uint8_t result;
+
+  if(!collected) {
+    ctr_drbg_init();
+  }
+  result = ctr_drbg_instantiate((uint8_t *)seed, sizeof(seed));
+  if(result == CTR_DRBG_SUCCESS) {
+    memset(seed, 0, sizeof(seed));
+    collected = 0;
+  }
+  return result;
+}
+/*---------------------------------------------------------------------------*/
+void
+ctr_drbg_init(void)
+{
+  ctr_drbg_entropy((uint8_t *)seed, sizeof(seed));
+  collected = 1;
+  instantiated = 0;
+}
+/*---------------------------------------------------------------------------*/
+uint8_t
+ctr_drbg_instantiate(const uint8_t *entropy, uint16_t len)
+{
+  uint32_t material[CTR_DRBG_SEED_LEN / 4];
+  uint8_t result;
+
+  instantiated = 0;
+  result = derive(entropy, len, (uint8_t *)material);
+  if(result == CTR_DRBG_SUCCESS) {
+    memset(key, 0, sizeof(key));
+    memset(v, 0, sizeof(v));
+    result = update((uint8_t *)material);
+  }
+  memset(material, 0, sizeof(material));
+  if(result == CTR_DRBG_SUCCESS) {
+    reseed_counter = 1;
+    instantiated = 1;
+  }
+  return result;
+}
+/*---------------------------------------------------------------------------*/
+uint8_t
+ctr_drbg_reseed(const uint8_t *entropy, uint16_t len)
+{
+  uint32_t material[CTR_DRBG_SEED_LEN / 4];
+  uint8_t result;
+
+  if(!instantiated) {
+    result = instantiate();
+    if(result != CTR_DRBG_SUCCESS) {
+      return result;
+    }
+  }
+  result = derive(entropy, len, (uint8_t *)material);
+  if(result == CTR_DRBG_SUCCESS) {
+    result = update((uint8_t *)material);
+  }
+  memset(material, 0, sizeof(material));
+  if(result == CTR_DRBG_SUCCESS) {
+    reseed_counter = 1;
+  }
+  return result;
+}
+/*---------------------------------------------------------------------------*/
+uint8_t
+ctr_drbg_generate(void *buf, uint16_t len)
+{
+  uint32_t ctr[BLOCK_LEN / 4];
+  uint32_t last[BLOCK_LEN / 4];
+  uint16_t bulk = len & ~(BLOCK_LEN - 1);
+  uint8_t result;
+
+  if(!instantiated) {
+    result = instantiate();
+    if(result != CTR_DRBG_SUCCESS) {
+      return result;
+    }
+  }
+  if(reseed_counter > CTR_DRBG_RESEED_INTERVAL) {
+    return CTR_DRBG_RESEED;
+  }
+
+  /* Whole blocks go straight into buf, the last partial one through last */
+  memcpy(ctr, v, sizeof(ctr));
+  advance((uint8_t *)ctr, 1);
+  if(bulk) {
+    result = ctr_drbg_keystream((uint8_t *)key, (uint8_t *)ctr, buf, bulk);
+    if(result != CTR_DRBG_SUCCESS) {
+      return result;
+    }
+    advance((uint8_t *)ctr, bulk / BLOCK_LEN);
+  }
+  if(len > bulk) {
+    result = ctr_drbg_keystream((uint8_t *)key, (uint8_t *)ctr,
+                                (uint8_t *)last, sizeof(last));
+    if(result != CTR_DRBG_SUCCESS) {
+      memset(buf, 0, bulk);
+      return result;
+    }
+    memcpy((uint8_t *)buf + bulk, last, len - bulk);
+    memset(last, 0, sizeof(last));
+    advance((uint8_t *)ctr, 1);
+  }
+
+  /* v is the last counter used, then the state is updated for backtracking
+   * resistance */
+  advance((uint8_t *)ctr, -1);
+  memcpy(v, ctr, sizeof(v));
+  result = update(NULL);
+  if(result != CTR_DRBG_SUCCESS) {
+    memset(buf, 0, len);
+    return result;
+  }
+  reseed_counter++;
+  return CTR_DRBG_SUCCESS;
+}
+
+/** @} */
@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2015, Institute for Pervasive Computing, ETH Zurich.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/**
+ * \addtogroup cc2538-crypto
+ * @{
+ *
+ * \defgroup cc2538-ctr-drbg cc2538 CTR-DRBG
+ *
+ * CTR-DRBG with AES-128 and the block cipher derivation function (NIST
+ * SP 800-90A). Random bytes are the AES-CTR key stream of the DRBG state,
+ * produced by the AES engine through DMA directly into the caller's buffer.
+ * The counter is the low 32 bits of V, as the cc2538 CTR mode increments
+ * them.
+ *
+ * The seed is radio noise collected by random.c. The von Neumann debiased
+ * noise bits are not full entropy, so twice the seed length is collected
+ * and compressed by the derivation function. On native and Cooja, pka-sw
+ * provides a software backend with the core AES-128 driver.
+ *
+ * \note
+ * The platform collects the seed at boot by calling ctr_drbg_init(), the
+ * state is instantiated by the first request. After
+ * \c CTR_DRBG_RESEED_INTERVAL requests, ctr_drbg_init() or
+ * ctr_drbg_reseed() must be called before the next one. The AES backend
+ * turns the cryptoprocessor on for a request and leaves its clock as it
+ * found it.
+ * @{
+ *
+ * \file
+ * Header file for the cc2538 CTR-DRBG
+ */
+#ifndef CTR_DRBG_H_
+#define CTR_DRBG_H_
+
+#include "contiki.h"
+
+#include <stdint.h>
+/*---------------------------------------------------------------------------*/
+/** \name CTR-DRBG constants
+ * @{
+ */
+#define CTR_DRBG_SEED_LEN 32      /**< Bytes of the state: key and V */
+#define CTR_DRBG_ENTROPY_LEN 64   /**< Bytes collected by ctr_drbg_init() */
+
+/** Requests between two seedings, SP 800-90A allows up to 2^48 */
+#ifdef CTR_DRBG_CONF_RESEED_INTERVAL
+#define CTR_DRBG_RESEED_INTERVAL CTR_DRBG_CONF_RESEED_INTERVAL
+#else
+#define CTR_DRBG_RESEED_INTERVAL 0x40000000UL
+#endif
+
+#define CTR_DRBG_SUCCESS  0       /**< Success */
+#define CTR_DRBG_BUSY     1       /**< The AES engine is in use, retry later */
+#define CTR_DRBG_FAILURE  2       /**< AES or key store error */
+#define CTR_DRBG_RESEED   3       /**< Reseed interval reached, seed first */
+/** @} */
+/*---------------------------------------------------------------------------*/
+/** \name CTR-DRBG functions
+ * @{
+ */
+
+/** \brief Collects the seed from the entropy source of the platform
+ * \note On the cc2538 the radio is used, call it before the radio is
+ * initialised, like random_init().
+ */
+void ctr_drbg_init(void);
+
+/** \brief Instantiates the state from a given seed instead of the one
+ * collected by ctr_drbg_init(), e.g. for known answer tests
+ * \param seed Entropy input and nonce
+ * \param len Bytes of seed
+ * \return \c CTR_DRBG_SUCCESS, or an error code of ctr_drbg_generate()
+ */
+uint8_t ctr_drbg_instantiate(const uint8_t *seed, uint16_t len);
+
+/** \brief Mixes additional entropy into the state and restarts the reseed
+ * interval
+ * \param seed Entropy input
+ * \param len Bytes of seed
+ * \return \c CTR_DRBG_SUCCESS, or an error code of ctr_drbg_generate()
+ */
+uint8_t ctr_drbg_reseed(const uint8_t *seed, uint16_t len);
+
+/** \brief Fills a buffer with random bytes
+ * \param buf The buffer
+ * \param len Bytes requested
+ * \return \c CTR_DRBG_SUCCESS, \c CTR_DRBG_BUSY if another operation holds
+ * the AES engine, \c CTR_DRBG_RESEED, or \c CTR_DRBG_FAILURE
+ */
+uint8_t ctr_drbg_generate(void *buf, uint16_t len);
+
+/** \brief ctr_drbg_generate() for protothreads, which yield while the AES
+ * engine is busy
+ * \param pt The protothread
+ * \param process Process to poll for the retry, or \c NULL
+ * \param result Set to the return code of ctr_drbg_generate()
+ */
+#define CTR_DRBG_WAIT_GENERATE(pt, process, result, buf, len)                \
+  while(((result) = ctr_drbg_generate((buf), (len))) == CTR_DRBG_BUSY) {     \
+    process_poll(process);                                                   \
+    PT_YIELD(pt);                                                            \
+  }
+
+/** @} */
+/*---------------------------------------------------------------------------*/
+/** \name CTR-DRBG backend, provided by the platform
+ * @{
+ */
+
+/** \brief Writes the AES-CTR key stream E(key, ctr), E(key, ctr + 1), ...
+ * \param key 16 byte key
+ * \param ctr Initial counter block, not updated
+ * \param buf Output buffer
+ * \param len Bytes of key stream, a multiple of 16
+ * \return \c CTR_DRBG_SUCCESS, \c CTR_DRBG_BUSY or \c CTR_DRBG_FAILURE
+ */
+uint8_t ctr_drbg_keystream(const uint8_t *key, const uint8_t *ctr,
+                           uint8_t *buf, uint16_t len);
+
+/** \brief Fills a buffer with entropy
+ */
+void ctr_drbg_entropy(uint8_t *buf, uint16_t len);
+
+/** @} */
+
+#endif /* CTR_DRBG_H_ */
+
+/**
+ * @}
+ * @}
+ */
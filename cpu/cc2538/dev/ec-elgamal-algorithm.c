@@ -40,117 +40,464 @@
 
 #include <limits.h>
 #include <stdio.h>
-#include <random.h>
+#include <string.h>
 
 #include "ec-elgamal-algorithm.h"
 #include "ecc-algorithm.h"
 #include "ecc-driver.h"
 #include "bignum-driver.h"
 #include "pka.h"
+#include "ctr-drbg.h"
+#include "cfs/cfs.h"
+#if defined(COFFEE_CONF_SIZE) && (COFFEE_CONF_SIZE > 0)
+#include "cfs/cfs-coffee.h"
+#define COMB_RESERVE(name, size) cfs_coffee_reserve((name), (size))
+#else
+#define COMB_RESERVE(name, size)
+#endif
+
+#if EC_ELGAMAL_COMB_WINDOW != 2 && EC_ELGAMAL_COMB_WINDOW != 4 && EC_ELGAMAL_COMB_WINDOW != 8
+#error EC_ELGAMAL_CONF_COMB_WINDOW must be 2, 4 or 8
+#endif
+
+/* Header of a fixed-base table file, followed by the entries and COMB_MAGIC */
+typedef struct {
+  uint32_t magic;
+  uint32_t window;
+  uint32_t size;
+  uint32_t x[12];
+  uint32_t y[12];
+} comb_header_t;
+
+#define COMB_MAGIC 0x45474342
+
+#if EC_ELGAMAL_RING_SIZE
+/* The ring process and the EC-ElGamal operations share the PKA */
+static uint8_t ring_job;                /* ring process waits for a PKA result */
+static uint8_t foreground;              /* an EC-ElGamal operation is running */
+static struct process *waiting;         /* operation waiting for the ring */
+
+#define EC_ELGAMAL_ACQUIRE()                                                 \
+  if(ring_job) {                                                             \
+    waiting = state->process;                                                \
+  }                                                                          \
+  PT_WAIT_UNTIL(&state->pt, !ring_job);                                      \
+  foreground = 1;
+
+#define EC_ELGAMAL_RELEASE()                                                 \
+  foreground = 0;                                                            \
+  process_poll(&ec_elgamal_ring_process);
+#else
+#define EC_ELGAMAL_ACQUIRE()
+#define EC_ELGAMAL_RELEASE()
+#endif /* EC_ELGAMAL_RING_SIZE */
 
 #define CHECK_RESULT(...)                                                    \
   state->result = __VA_ARGS__;                                               \
   if(state->result) {                                                        \
     printf("Line: %u Error: %u\n", __LINE__, (unsigned int) state->result);  \
+    PKABigNumUnlock();                                                       \
+    EC_ELGAMAL_RELEASE();                                                    \
     PT_EXIT(&state->pt);                                                     \
   }
 
-static void ecc_random(uint32_t *secret, uint32_t size) {
-  uint32_t i; for (i = 0; i < size; ++i) {
-    secret[i] = (uint32_t)random_rand() | (uint32_t)random_rand() << 16;
+#define EXIT_RESULT(code)                                                    \
+  state->result = code;                                                      \
+  PKABigNumUnlock();                                                         \
+  EC_ELGAMAL_RELEASE();                                                      \
+  PT_EXIT(&state->pt);
+
+/* Fills secret with size random words from the CTR-DRBG */
+#define ECC_RANDOM(secret, size)                                             \
+  CTR_DRBG_WAIT_GENERATE(&state->pt, state->process, state->result,          \
+                         (secret), (size) * sizeof(uint32_t));               \
+  CHECK_RESULT(state->result ? PKA_STATUS_FAILURE : PKA_STATUS_SUCCESS);
+
+/* Windows of the ephemeral key */
+static uint32_t comb_windows(ec_elgmal_enc_state_t *state) {
+  return state->curve_info->ui8Size * 32 / EC_ELGAMAL_COMB_WINDOW;
+}
+
+/* Digit of the ephemeral key in window i */
+static uint32_t comb_digit(ec_elgmal_enc_state_t *state, uint32_t i) {
+  i *= EC_ELGAMAL_COMB_WINDOW;
+  return (state->random[i / 32] >> (i % 32)) & EC_ELGAMAL_COMB_DIGITS;
+}
+
+/* Byte offset of the entry (window, digit) */
+static cfs_offset_t comb_offset(ec_elgmal_enc_state_t *state, uint32_t entry) {
+  return sizeof(comb_header_t) + entry * 2 * state->curve_info->ui8Size * sizeof(uint32_t);
+}
+
+/* Describes the table of G (table 0) or Q (table 1) */
+static void comb_header(ec_elgmal_enc_state_t *state, comb_header_t *header) {
+  uint32_t len = state->curve_info->ui8Size * sizeof(uint32_t);
+
+  memset(header, 0, sizeof(comb_header_t));
+  header->magic = COMB_MAGIC;
+  header->window = EC_ELGAMAL_COMB_WINDOW;
+  header->size = state->curve_info->ui8Size;
+  if(state->comb_table) {
+    memcpy(header->x, state->public.pui32X, len);
+    memcpy(header->y, state->public.pui32Y, len);
+  } else {
+    memcpy(header->x, state->curve_info->pui32Gx, len);
+    memcpy(header->y, state->curve_info->pui32Gy, len);
+  }
+}
+
+static void comb_close(ec_elgmal_enc_state_t *state) {
+  uint8_t t; for(t = 0; t < 2; t++) {
+    if(state->comb_open & (1 << t)) {
+      cfs_close(state->comb_fd[t]);
+    }
+  }
+  state->comb_open = 0;
+  state->comb = 0;
+}
+
+/* Reads or writes comb_point at an entry of the table in use */
+static int comb_io(ec_elgmal_enc_state_t *state, uint32_t entry, uint8_t write) {
+  int fd = state->comb_fd[state->comb_table];
+  int len = state->curve_info->ui8Size * sizeof(uint32_t);
+
+  if(cfs_seek(fd, comb_offset(state, entry), CFS_SEEK_SET) < 0) {
+    return -1;
+  }
+  if(write) {
+    return cfs_write(fd, state->comb_point.pui32X, len) != len
+        || cfs_write(fd, state->comb_point.pui32Y, len) != len;
+  }
+  return cfs_read(fd, state->comb_point.pui32X, len) != len
+      || cfs_read(fd, state->comb_point.pui32Y, len) != len;
+}
+
+/* Checks the stored table against the expected header and its end marker */
+static int comb_valid(ec_elgmal_enc_state_t *state, int fd, const comb_header_t *header) {
+  comb_header_t stored;
+  uint32_t magic = 0;
+
+  if(cfs_read(fd, &stored, sizeof(stored)) != sizeof(stored)
+     || memcmp(&stored, header, sizeof(stored)) != 0) {
+    return 0;
+  }
+  if(cfs_seek(fd, comb_offset(state, comb_windows(state) * EC_ELGAMAL_COMB_DIGITS), CFS_SEEK_SET) < 0
+     || cfs_read(fd, &magic, sizeof(magic)) != sizeof(magic)) {
+    return 0;
+  }
+  return magic == COMB_MAGIC;
+}
+
+#if EC_ELGAMAL_RING_SIZE
+/* Ring of pre-generated ephemeral pairs */
+static struct {
+  ec_elgmal_enc_state_t *key;           /* key the pairs belong to */
+  ec_point_t rg[EC_ELGAMAL_RING_SIZE];  /* C" = rG */
+  ec_point_t rq[EC_ELGAMAL_RING_SIZE];  /* mask rQ */
+  uint8_t    head;                      /* oldest pair */
+  uint8_t    count;                     /* pairs ready for use */
+  uint8_t    epoch;                     /* changes whenever the key changes */
+} ring;
+static ec_elgamal_ring_stats_t ring_stats;
+
+PROCESS(ec_elgamal_ring_process, "EC-ElGamal ephemeral pairs");
+
+/*---------------------------------------------------------------------------*/
+static void
+ring_flush(void)
+{
+  memset(ring.rg, 0, sizeof(ring.rg));
+  memset(ring.rq, 0, sizeof(ring.rq));
+  ring.head = 0;
+  ring.count = 0;
+  ring.epoch++;
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t
+ring_take(ec_elgmal_enc_state_t *state)
+{
+  if(ring.key != state) {
+    return 0;
+  }
+  if(ring.count == 0) {
+    ring_stats.empty++;
+    return 0;
+  }
+
+  memcpy(&state->cipher_p2, &ring.rg[ring.head], sizeof(ec_point_t));
+  memcpy(&state->rand_public, &ring.rq[ring.head], sizeof(ec_point_t));
+  memset(&ring.rg[ring.head], 0, sizeof(ec_point_t));
+  memset(&ring.rq[ring.head], 0, sizeof(ec_point_t));
+  ring.head = (ring.head + 1) % EC_ELGAMAL_RING_SIZE;
+  ring.count--;
+  ring_stats.drained++;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+void
+ec_elgamal_ring_start(ec_elgmal_enc_state_t *state)
+{
+  ring_flush();
+  ring.key = state;
+  if(process_is_running(&ec_elgamal_ring_process)) {
+    process_poll(&ec_elgamal_ring_process);
+  } else {
+    process_start(&ec_elgamal_ring_process, NULL);
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+ec_elgamal_ring_stop(void)
+{
+  ring.key = NULL;
+  ring_flush();
+}
+/*---------------------------------------------------------------------------*/
+uint8_t
+ec_elgamal_ring_count(void)
+{
+  return ring.count;
+}
+/*---------------------------------------------------------------------------*/
+const ec_elgamal_ring_stats_t *
+ec_elgamal_ring_get_stats(void)
+{
+  return &ring_stats;
+}
+/*---------------------------------------------------------------------------*/
+/* 0 < r < n */
+static uint8_t
+ring_valid(const uint32_t *r, const ecc_curve_info_t *curve)
+{
+  uint32_t any = 0;
+  int i;
+
+  for(i = 0; i < curve->ui8Size; i++) {
+    any |= r[i];
+  }
+  for(i = curve->ui8Size - 1; any && i >= 0; i--) {
+    if(r[i] != curve->pui32N[i]) {
+      return r[i] < curve->pui32N[i];
+    }
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+/* Starts a PKA operation of the ring process, retries later if the PKA is
+ * in use. Must follow a wait until no EC-ElGamal operation is running. */
+#define RING_JOB(...)                                                        \
+  if(!pka_check_status() || (__VA_ARGS__) != PKA_STATUS_SUCCESS) {           \
+    etimer_set(&retry, CLOCK_SECOND / 8);                                    \
+    PROCESS_WAIT_UNTIL(etimer_expired(&retry));                              \
+    continue;                                                                \
+  }                                                                          \
+  ring_job = 1;
+
+#define RING_JOB_DONE()                                                      \
+  ring_job = 0;                                                              \
+  if(waiting != NULL) {                                                      \
+    process_poll(waiting);                                                   \
+    waiting = NULL;                                                          \
+  }
+
+PROCESS_THREAD(ec_elgamal_ring_process, ev, data)
+{
+  static ec_elgmal_enc_state_t *key;
+  static struct etimer retry;
+  static uint32_t r[8];
+  static ec_point_t rg, rq;
+  static uint32_t rv;
+  static uint8_t epoch;
+  uint8_t result, slot;
+
+  PROCESS_BEGIN();
+
+  while(1) {
+    PROCESS_WAIT_UNTIL(ring.key != NULL && ring.count < EC_ELGAMAL_RING_SIZE);
+    key = ring.key;
+    epoch = ring.epoch;
+
+    /* ephemeral key 0 < r < n */
+    if(ctr_drbg_generate(r, key->curve_info->ui8Size * sizeof(uint32_t))
+       != CTR_DRBG_SUCCESS) {
+      etimer_set(&retry, CLOCK_SECOND / 8);
+      PROCESS_WAIT_UNTIL(etimer_expired(&retry));
+      continue;
+    }
+    if(!ring_valid(r, key->curve_info)) {
+      continue;
+    }
+
+    /* C" = r * G */
+    PROCESS_WAIT_UNTIL(!foreground);
+    RING_JOB(PKAECCMultGenPtStart(r, key->curve_info, &rv, &ec_elgamal_ring_process));
+    PROCESS_WAIT_UNTIL(pka_check_status());
+    result = PKAECCMultGenPtGetResult(&rg, rv);
+    RING_JOB_DONE();
+    if(result != PKA_STATUS_SUCCESS || epoch != ring.epoch) {
+      continue;
+    }
+
+    /* rQ = r * Q */
+    PROCESS_WAIT_UNTIL(!foreground);
+    RING_JOB(PKAECCMultiplyStart(r, &key->public, key->curve_info, &rv, &ec_elgamal_ring_process));
+    PROCESS_WAIT_UNTIL(pka_check_status());
+    result = PKAECCMultiplyGetResult(&rq, rv);
+    RING_JOB_DONE();
+
+    if(result == PKA_STATUS_SUCCESS && epoch == ring.epoch
+       && ring.count < EC_ELGAMAL_RING_SIZE) {
+      slot = (ring.head + ring.count) % EC_ELGAMAL_RING_SIZE;
+      memcpy(&ring.rg[slot], &rg, sizeof(ec_point_t));
+      memcpy(&ring.rq[slot], &rq, sizeof(ec_point_t));
+      ring.count++;
+      ring_stats.filled++;
+    }
+    memset(r, 0, sizeof(r));
+    memset(&rg, 0, sizeof(rg));
+    memset(&rq, 0, sizeof(rq));
+  }
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
+#endif /* EC_ELGAMAL_RING_SIZE */
+
+/* Exponent of the square root mod p = 3 mod 4: (p+1)/4 = floor(p/4) + 1 */
+static void sqrt_exponent(const ecc_curve_info_t *curve, uint32_t *root) {
+  uint32_t size = curve->ui8Size;
+  uint32_t i;
+
+  memset(root, 0, sizeof(uint32_t) * 12);
+  for(i = 0; i < size; i++) {
+    root[i] = curve->pui32Prime[i] >> 2;
+    if(i + 1 < size) {
+      root[i] |= curve->pui32Prime[i + 1] << 30;
+    }
+  }
+  for(i = 0; ++root[i] == 0; i++);
+}
+
+
+/* Jacobi symbol (u/m) of u < m, m odd, by the binary algorithm on the CPU */
+static int8_t jacobi(const uint32_t *u, const uint32_t *m, uint32_t size) {
+  uint32_t a[12], b[12], t;
+  uint64_t borrow;
+  int8_t result = 1;
+  uint32_t i;
+
+  memcpy(a, u, sizeof(uint32_t) * size);
+  memcpy(b, m, sizeof(uint32_t) * size);
+  for(;;) {
+    for(i = 0; i < size && a[i] == 0; i++);
+    if(i == size) {
+      break;
+    }
+
+    /* (2/b) = -1 for b = 3, 5 mod 8 */
+    while(!(a[0] & 1)) {
+      for(i = 0; i < size - 1; i++) {
+        a[i] = a[i] >> 1 | a[i + 1] << 31;
+      }
+      a[size - 1] >>= 1;
+      if((b[0] & 7) == 3 || (b[0] & 7) == 5) {
+        result = -result;
+      }
+    }
+
+    /* reciprocity: (a/b) = -(b/a) for a = b = 3 mod 4 */
+    for(i = size - 1; i > 0 && a[i] == b[i]; i--);
+    if(a[i] < b[i]) {
+      for(i = 0; i < size; i++) {
+        t = a[i];
+        a[i] = b[i];
+        b[i] = t;
+      }
+      if((a[0] & 3) == 3 && (b[0] & 3) == 3) {
+        result = -result;
+      }
+    }
+
+    /* (a/b) = ((a - b)/b) */
+    borrow = 0;
+    for(i = 0; i < size; i++) {
+      borrow = (uint64_t)a[i] - b[i] - borrow;
+      a[i] = (uint32_t)borrow;
+      borrow = (borrow >> 32) & 1;
+    }
   }
+
+  /* gcd(u, m) = b */
+  for(i = 1; i < size && b[i] == 0; i++);
+  return i == size && b[0] == 1 ? result : 0;
 }
 
+
 PT_THREAD(ec_elgamal_map_koblitz(ec_elgmal_map_state_t *state)){
-  uint32_t ec_len = state->curve_info->ui8Size;
+  uint8_t ec_len = state->curve_info->ui8Size;
+  static uint32_t tmp2[10];
+  uint32_t i;
 
   PT_BEGIN(&state->pt);
-  static uint32_t tmp[10], tmp2[10];
-  static uint32_t tmp_len = 10;
+
+  EC_ELGAMAL_ACQUIRE();
 
   if (state->int_to_ecpoint == 1) {
-    state->j_rounds = 0;
+    if((state->curve_info->pui32Prime[0] & 3) != 3 || state->plain_len > ec_len) {
+      EXIT_RESULT(PKA_STATUS_INVALID_PARAM);
+    }
+    sqrt_exponent(state->curve_info, state->root);
+    PKA_WAIT_LOCK(&state->pt, state->process);
+    CHECK_RESULT(PKABigNumPin(state->curve_info->pui32Prime, ec_len, &state->prime_vector));
+    CHECK_RESULT(PKABigNumPin(state->root, ec_len, &state->root_vector));
+
     /* Define x = mK + j, m our plaintext message, 0 <= j < K */
     /* store x = mK */
     // FIXME: our PKI requires the lowest bit of the first byte of the divisor to be set!
+    memset(tmp2, 0, sizeof(tmp2));
     tmp2[0] = state->K + 0x00010000;
-    CHECK_RESULT(PKABigNumMultiplyStart(state->plain_int,ec_len, tmp2, 1, &state->rv, state->process));
+    CHECK_RESULT(PKABigNumMultiplyStart(state->plain_int, state->plain_len, tmp2, 1, &state->rv, state->process));
     PT_WAIT_UNTIL(&state->pt, pka_check_status());
-    CHECK_RESULT(PKABigNumMultGetResult(state->plain_ec.pui32X, &ec_len, state->rv));
-      /* plain to ec-point */
-      do{
-         memset(tmp,0, sizeof(tmp));
-         memset(tmp2,0, sizeof(tmp2));
-         if (state->j_rounds > 0){
-           /* iterate over j; x = mK + j, */
-           tmp2[0] = 1;
-           // TODO: This would do as well the job and saves code space! state->plain_ec.pui32X[0] += 1 (issue: possible overflow!);
-           CHECK_RESULT(PKABigNumAddStart(state->plain_ec.pui32X, ec_len, tmp2, 1, &state->rv, state->process));
-           PT_WAIT_UNTIL(&state->pt, pka_check_status());
-           CHECK_RESULT(PKABigNumAddGetResult(state->plain_ec.pui32X, &ec_len, state->rv));
-         }
-         /* Compute step by step: y^2 = x^3 - 3x + b (mod p) */
-         /* tmp = 3x mod p (we save the mod operation since 3x << p)*/
-         tmp2[0] = 3;
-         CHECK_RESULT(PKABigNumMultiplyStart(tmp2, 1, state->plain_ec.pui32X, ec_len, &state->rv, state->process));
-         PT_WAIT_UNTIL(&state->pt, pka_check_status());
-         CHECK_RESULT(PKABigNumMultGetResult(tmp, &tmp_len, state->rv));
-
-         /* tmp2 = x^3 mod p*/
-         tmp2[0] = 3;
-         CHECK_RESULT(PKABigNumExpModStart(tmp2, 1,
-                                       state->curve_info->pui32Prime, ec_len,
-                                       state->plain_ec.pui32X, ec_len,  &state->rv, state->process));
-         PT_WAIT_UNTIL(&state->pt, pka_check_status());
-         CHECK_RESULT(PKABigNumExpModGetResult(tmp2, tmp_len, state->rv));
-
-         /* tmp = tmp2 - tmp; x^3 - 3x */
-         CHECK_RESULT(PKABigNumSubtractStart(tmp2, ec_len, tmp, ec_len, &state->rv, state->process));
-         PT_WAIT_UNTIL(&state->pt, pka_check_status());
-         CHECK_RESULT(PKABigNumSubtractGetResult(tmp, &tmp_len, state->rv));
-
-         /* tmp = tmp + b;  x^3 - 3x + b */
-         CHECK_RESULT(PKABigNumAddStart(tmp, tmp_len, state->curve_info->pui32B, ec_len, &state->rv, state->process));
-         PT_WAIT_UNTIL(&state->pt, pka_check_status());
-         tmp_len=10; // reset the len
-         CHECK_RESULT(PKABigNumAddGetResult(tmp, &tmp_len, state->rv));
-
-         /* tmp = tmp (mod p) INFO: this is due to distributive feature of Modulo:
-          * (a+b) mod p = ((a mod p) + (b mod p)) mod p
-          */
-         CHECK_RESULT(PKABigNumModStart(tmp, ec_len, state->curve_info->pui32Prime, ec_len, &state->rv,state->process));
-         PT_WAIT_UNTIL(&state->pt, pka_check_status());
-         CHECK_RESULT(PKABigNumModGetResult(tmp, tmp_len, state->rv));
-
-         /* y^2 = x^3 - 3x + b (mod p) */
-         /* y^2 = tmp (mod p) */
-         /* compute the square root: (exp, len, mod p, len, base, len) */
-         CHECK_RESULT(PKABigNumExpModStart(state->exponent, ec_len,
-                                       state->curve_info->pui32Prime, ec_len,
-                                       tmp, ec_len,  &state->rv, state->process));
-         PT_WAIT_UNTIL(&state->pt, pka_check_status());
-         CHECK_RESULT(PKABigNumExpModGetResult(state->plain_ec.pui32Y, ec_len, state->rv));
-
-         /* check if the squire root was correct by
-          * calculating y2 */
-         tmp2[0] = 2;
-         CHECK_RESULT(PKABigNumExpModStart(tmp2, 1,
-                                          state->curve_info->pui32Prime, ec_len,
-                                          state->plain_ec.pui32Y, ec_len,  &state->rv, state->process));
-         PT_WAIT_UNTIL(&state->pt, pka_check_status());
-         CHECK_RESULT(PKABigNumExpModGetResult(tmp2, tmp_len, state->rv));
-
-         /* tmp = tmp (mod p)*/
-         CHECK_RESULT(PKABigNumModStart(tmp, ec_len, state->curve_info->pui32Prime, ec_len, &state->rv,state->process));
-         PT_WAIT_UNTIL(&state->pt, pka_check_status());
-         CHECK_RESULT(PKABigNumModGetResult(tmp, tmp_len, state->rv));
-
-         /* comparison*/
-         CHECK_RESULT(PKABigNumCmpStart(tmp2, tmp, tmp_len, state->process));
-         PT_WAIT_UNTIL(&state->pt, pka_check_status());
-         state->result = PKABigNumCmpGetResult();
-         state->j_rounds += 1;
-      }while(state->result != 0 && state->j_rounds < state->K);
+    memset(state->plain_ec.pui32X, 0, sizeof(state->plain_ec.pui32X));
+    state->len = ec_len;
+    CHECK_RESULT(PKABigNumMultGetResult(state->plain_ec.pui32X, &state->len, state->rv));
+
+    /* plain to ec-point */
+    for(state->j_rounds = 1; ; state->j_rounds++) {
+      /* rhs = x(x^2 + a) + b mod p, the intermediate results stay in the PKA RAM */
+      CHECK_RESULT(PKABigNumMultiplyStart(state->plain_ec.pui32X, ec_len, state->plain_ec.pui32X, ec_len, &state->rv, state->process));
+      PT_WAIT_UNTIL(&state->pt, pka_check_status());
+      CHECK_RESULT(PKABigNumModStart(PKA_VECTOR(state->rv), 2 * ec_len, PKA_VECTOR(state->prime_vector), ec_len, &state->rv, state->process));
+      PT_WAIT_UNTIL(&state->pt, pka_check_status());
+      CHECK_RESULT(PKABigNumAddStart(PKA_VECTOR(state->rv), ec_len, state->curve_info->pui32A, ec_len, &state->rv, state->process));
+      PT_WAIT_UNTIL(&state->pt, pka_check_status());
+      CHECK_RESULT(PKABigNumMultiplyStart(PKA_VECTOR(state->rv), ec_len + 1, state->plain_ec.pui32X, ec_len, &state->rv, state->process));
+      PT_WAIT_UNTIL(&state->pt, pka_check_status());
+      CHECK_RESULT(PKABigNumAddStart(PKA_VECTOR(state->rv), 2 * ec_len + 1, state->curve_info->pui32B, ec_len, &state->rv, state->process));
+      PT_WAIT_UNTIL(&state->pt, pka_check_status());
+      CHECK_RESULT(PKABigNumModStart(PKA_VECTOR(state->rv), 2 * ec_len + 2, PKA_VECTOR(state->prime_vector), ec_len, &state->rv, state->process));
+      PT_WAIT_UNTIL(&state->pt, pka_check_status());
+      memset(state->rhs, 0, sizeof(state->rhs));
+      CHECK_RESULT(PKABigNumModGetResult(state->rhs, ec_len, state->rv));
+
+      /* only quadratic residues have a square root, y = 0 is a point as well */
+      if(jacobi(state->rhs, state->curve_info->pui32Prime, ec_len) >= 0) {
+        break;
+      }
+      if(state->j_rounds >= state->K) {
+        EXIT_RESULT(PKA_STATUS_FAILURE);
+      }
+
+      /* iterate over j; x = mK + j */
+      for(i = 0; i < ec_len && ++state->plain_ec.pui32X[i] == 0; i++);
+    }
+
+    /* y = rhs^((p+1)/4) mod p */
+    CHECK_RESULT(PKABigNumExpModStart(PKA_VECTOR(state->root_vector), ec_len, PKA_VECTOR(state->prime_vector), ec_len, state->rhs, ec_len, &state->rv, state->process));
+    PT_WAIT_UNTIL(&state->pt, pka_check_status());
+    memset(state->plain_ec.pui32Y, 0, sizeof(state->plain_ec.pui32Y));
+    CHECK_RESULT(PKABigNumExpModGetResult(state->plain_ec.pui32Y, ec_len, state->rv));
+    PKABigNumUnlock();
   } else {
     /* ec-point to plain */
     /* m = floor(x/K) (greatest integer less or equal to x/K)*/
@@ -162,6 +509,7 @@ PT_THREAD(ec_elgamal_map_koblitz(ec_elgmal_map_state_t *state)){
     CHECK_RESULT(PKABigNumDivideGetResult(state->plain_int, &state->plain_len, state->rv));
   }
 
+  EC_ELGAMAL_RELEASE();
   PT_END(&state->pt);
 }
 
@@ -170,23 +518,34 @@ PT_THREAD(ec_elgamal_map_koblitz(ec_elgmal_map_state_t *state)){
 
 PT_THREAD(ec_elgamal_map_scalar(ec_elgmal_map_state_t *state)){
   PT_BEGIN(&state->pt);
+  EC_ELGAMAL_ACQUIRE();
   if (state->int_to_ecpoint == 1) {
     /* m = integer * G */
     CHECK_RESULT(PKAECCMultGenPtStart((uint32_t*)&state->plain_int, state->curve_info, &state->rv, state->process));
     PT_WAIT_UNTIL(&state->pt, pka_check_status());
     CHECK_RESULT(PKAECCMultGenPtGetResult(&state->plain_ec, state->rv));
   }else{
-    //This is a very hard problem!
+    //This is a very hard problem! See ec_elgamal_dlog() for small m
   };
 
+  EC_ELGAMAL_RELEASE();
   PT_END(&state->pt);
 }
 
 PT_THREAD(ec_elgamal_generate(ec_elgmal_enc_state_t *state)) {
   PT_BEGIN(&state->pt);
+  EC_ELGAMAL_ACQUIRE();
+  /* The tables and pairs of the old public key are of no use anymore */
+  comb_close(state);
+#if EC_ELGAMAL_RING_SIZE
+  if(ring.key == state) {
+    ring_flush();
+  }
+#endif
+
   /* secret: a random integer */
   do {
-    ecc_random(state->secret, state->curve_info->ui8Size);
+    ECC_RANDOM(state->secret, state->curve_info->ui8Size);
     CHECK_RESULT(PKABigNumCmpStart(state->secret, state->curve_info->pui32N, state->curve_info->ui8Size, state->process));
     PT_WAIT_UNTIL(&state->pt, pka_check_status());
     state->result = PKABigNumCmpGetResult();
@@ -194,7 +553,7 @@ PT_THREAD(ec_elgamal_generate(ec_elgmal_enc_state_t *state)) {
 
   /* another random integer */
   do {
-    ecc_random(state->random, state->curve_info->ui8Size);
+    ECC_RANDOM(state->random, state->curve_info->ui8Size);
     CHECK_RESULT(PKABigNumCmpStart(state->random, state->curve_info->pui32N, state->curve_info->ui8Size, state->process));
     PT_WAIT_UNTIL(&state->pt, pka_check_status());
     state->result = PKABigNumCmpGetResult();
@@ -205,39 +564,184 @@ PT_THREAD(ec_elgamal_generate(ec_elgmal_enc_state_t *state)) {
   PT_WAIT_UNTIL(&state->pt, pka_check_status());
   CHECK_RESULT(PKAECCMultGenPtGetResult(&state->public, state->rv));
 
+  EC_ELGAMAL_RELEASE();
   PT_END(&state->pt);
 }
 
 
+PT_THREAD(ec_elgamal_precompute(ec_elgmal_enc_state_t *state)) {
+  static comb_header_t header;
+  static uint32_t two[12];
+  static const char *name;
+  uint32_t magic = COMB_MAGIC;
+  int fd;
+
+  PT_BEGIN(&state->pt);
+
+  EC_ELGAMAL_ACQUIRE();
+  comb_close(state);
+
+  for(state->comb_table = 0; state->comb_table < 2; state->comb_table++) {
+    name = state->comb_table ? EC_ELGAMAL_COMB_FILE_Q : EC_ELGAMAL_COMB_FILE_G;
+    comb_header(state, &header);
+
+    /* Table survived from an earlier run */
+    fd = cfs_open(name, CFS_READ);
+    if(fd >= 0 && comb_valid(state, fd, &header)) {
+      state->comb_fd[state->comb_table] = fd;
+      state->comb_open |= 1 << state->comb_table;
+      continue;
+    }
+    if(fd >= 0) {
+      cfs_close(fd);
+    }
+
+    /* Build it, the end marker is only written once all entries are stored */
+    cfs_remove(name);
+    COMB_RESERVE(name, comb_offset(state, comb_windows(state) * EC_ELGAMAL_COMB_DIGITS) + sizeof(magic));
+    fd = cfs_open(name, CFS_WRITE);
+    if(fd < 0 || cfs_write(fd, &header, sizeof(header)) != sizeof(header)) {
+      if(fd >= 0) {
+        cfs_close(fd);
+      }
+      EXIT_RESULT(PKA_STATUS_FAILURE);
+    }
+    state->comb_fd[state->comb_table] = fd;
+    state->comb_open |= 1 << state->comb_table;
+
+    memcpy(state->comb_step.pui32X, header.x, sizeof(header.x));
+    memcpy(state->comb_step.pui32Y, header.y, sizeof(header.y));
+    memset(two, 0, sizeof(two));
+    two[0] = 2;
+
+    for(state->comb_index = 0; state->comb_index < comb_windows(state) * EC_ELGAMAL_COMB_DIGITS; state->comb_index++) {
+      switch(state->comb_index % EC_ELGAMAL_COMB_DIGITS) {
+      case 0:
+        /* 2^(wi) B */
+        memcpy(&state->comb_point, &state->comb_step, sizeof(ec_point_t));
+        break;
+      case 1:
+        /* 2 2^(wi) B, the PKA does not double by ECC-ADD */
+        CHECK_RESULT(PKAECCMultiplyStart(two, &state->comb_step, state->curve_info, &state->rv, state->process));
+        PT_WAIT_UNTIL(&state->pt, pka_check_status());
+        CHECK_RESULT(PKAECCMultiplyGetResult(&state->comb_point, state->rv));
+        break;
+      default:
+        /* d 2^(wi) B = (d-1) 2^(wi) B + 2^(wi) B */
+        CHECK_RESULT(PKAECCAddStart(&state->comb_point, &state->comb_step, state->curve_info, &state->rv, state->process));
+        PT_WAIT_UNTIL(&state->pt, pka_check_status());
+        CHECK_RESULT(PKAECCAddGetResult(&state->comb_point, state->rv));
+        break;
+      }
+
+      if(comb_io(state, state->comb_index, 1)) {
+        EXIT_RESULT(PKA_STATUS_FAILURE);
+      }
+
+      /* 2^(w(i+1)) B = (2^w - 1) 2^(wi) B + 2^(wi) B */
+      if(state->comb_index % EC_ELGAMAL_COMB_DIGITS == EC_ELGAMAL_COMB_DIGITS - 1
+         && state->comb_index + 1 < comb_windows(state) * EC_ELGAMAL_COMB_DIGITS) {
+        CHECK_RESULT(PKAECCAddStart(&state->comb_point, &state->comb_step, state->curve_info, &state->rv, state->process));
+        PT_WAIT_UNTIL(&state->pt, pka_check_status());
+        CHECK_RESULT(PKAECCAddGetResult(&state->comb_step, state->rv));
+      }
+    }
+
+    fd = state->comb_fd[state->comb_table];
+    if(cfs_write(fd, &magic, sizeof(magic)) != sizeof(magic)) {
+      EXIT_RESULT(PKA_STATUS_FAILURE);
+    }
+    cfs_close(fd);
+    state->comb_open &= ~(1 << state->comb_table);
+
+    fd = cfs_open(name, CFS_READ);
+    if(fd < 0) {
+      EXIT_RESULT(PKA_STATUS_FAILURE);
+    }
+    state->comb_fd[state->comb_table] = fd;
+    state->comb_open |= 1 << state->comb_table;
+  }
+
+  state->comb = 1;
+  state->result = PKA_STATUS_SUCCESS;
+  EC_ELGAMAL_RELEASE();
+  PT_END(&state->pt);
+}
+
 PT_THREAD(ec_elgamal_enc(ec_elgmal_enc_state_t *state)){
   PT_BEGIN(&state->pt);
+  EC_ELGAMAL_ACQUIRE();
   /* Encryption:
    * compute C'= M + rQ, r is random and Q the public key (rQ is pre-calculated)
    * compute C"= rG, G is the base point (C" is pre-calculated)
    * cipher is (C', C")
    */
 
-  /* C" = r * G */
-  CHECK_RESULT(PKAECCMultGenPtStart(state->random, state->curve_info, &state->rv, state->process));
-  PT_WAIT_UNTIL(&state->pt, pka_check_status());
-  CHECK_RESULT(PKAECCMultGenPtGetResult(&state->cipher_p2, state->rv));
+#if EC_ELGAMAL_RING_SIZE
+  /* C" = r * G and rQ = r * Q pre-generated by the ring process */
+  if(ring_take(state)) {
+    process_poll(&ec_elgamal_ring_process);
+  } else
+#endif
+  if(state->comb) {
+    /* C" = r * G and rQ = r * Q as sums of table entries. With r < n all
+     * partial sums are smaller multiples than the next entry, so the PKA
+     * never has to double or to return the point at infinity. */
+    for(state->comb_table = 0; state->comb_table < 2; state->comb_table++) {
+      state->comb_empty = 1;
+      for(state->comb_index = 0; state->comb_index < comb_windows(state); state->comb_index++) {
+        if(comb_digit(state, state->comb_index) == 0) {
+          continue;
+        }
 
-  /* rQ = r * Q, This should always be the same to have add. HOM ! */
-  CHECK_RESULT(PKAECCMultiplyStart(state->random, &state->public, state->curve_info, &state->rv, state->process));
-  PT_WAIT_UNTIL(&state->pt, pka_check_status());
-  CHECK_RESULT(PKAECCMultiplyGetResult(&state->rand_public, state->rv));
+        /* Entry of (window, digit) */
+        if(comb_io(state, state->comb_index * EC_ELGAMAL_COMB_DIGITS + comb_digit(state, state->comb_index) - 1, 0)) {
+          EXIT_RESULT(PKA_STATUS_FAILURE);
+        }
+
+        if(state->comb_empty) {
+          memcpy(state->comb_table ? &state->rand_public : &state->cipher_p2, &state->comb_point, sizeof(ec_point_t));
+          state->comb_empty = 0;
+          continue;
+        }
+        CHECK_RESULT(PKAECCAddStart(state->comb_table ? &state->rand_public : &state->cipher_p2, &state->comb_point,
+                                    state->curve_info, &state->rv, state->process));
+        PT_WAIT_UNTIL(&state->pt, pka_check_status());
+        CHECK_RESULT(PKAECCAddGetResult(state->comb_table ? &state->rand_public : &state->cipher_p2, state->rv));
+      }
+
+      /* r = 0 */
+      if(state->comb_empty) {
+        EXIT_RESULT(PKA_STATUS_FAILURE);
+      }
+    }
+  } else {
+    /* C" = r * G */
+    CHECK_RESULT(PKAECCMultGenPtStart(state->random, state->curve_info, &state->rv, state->process));
+    PT_WAIT_UNTIL(&state->pt, pka_check_status());
+    CHECK_RESULT(PKAECCMultGenPtGetResult(&state->cipher_p2, state->rv));
+
+    /* rQ = r * Q, This should always be the same to have add. HOM ! */
+    CHECK_RESULT(PKAECCMultiplyStart(state->random, &state->public, state->curve_info, &state->rv, state->process));
+    PT_WAIT_UNTIL(&state->pt, pka_check_status());
+    CHECK_RESULT(PKAECCMultiplyGetResult(&state->rand_public, state->rv));
+  }
 
   /* C' = M + rQ */
   CHECK_RESULT(PKAECCAddStart(&state->plain, &state->rand_public, state->curve_info, &state->rv, state->process));
   PT_WAIT_UNTIL(&state->pt, pka_check_status());
   CHECK_RESULT(PKAECCAddGetResult(&state->cipher_p1, state->rv));
 
+  /* The mask would reveal M */
+  memset(&state->rand_public, 0, sizeof(ec_point_t));
+  EC_ELGAMAL_RELEASE();
   PT_END(&state->pt);
 }
 
 
 PT_THREAD(ec_elgamal_dec(ec_elgmal_enc_state_t *state)){
    PT_BEGIN(&state->pt);
+   EC_ELGAMAL_ACQUIRE();
   /* Decryption: M = C' - dC" */
 
    state->len =  state->curve_info->ui8Size;
@@ -261,6 +765,315 @@ PT_THREAD(ec_elgamal_dec(ec_elgmal_enc_state_t *state)){
   PT_WAIT_UNTIL(&state->pt, pka_check_status());
   CHECK_RESULT(PKAECCAddGetResult(&state->plain, state->rv));
 
+  EC_ELGAMAL_RELEASE();
+  PT_END(&state->pt);
+}
+
+
+/* Writes the compressed SEC1 encoding of point: 02/03 prefix, then x */
+static void wire_put_point(const ec_point_t *point, uint32_t size, uint8_t *wire) {
+  uint32_t i;
+
+  wire[0] = 0x02 | (point->pui32Y[0] & 1);
+  for(i = 0; i < size; i++) {
+    wire[1 + 4 * i] = point->pui32X[size - 1 - i] >> 24;
+    wire[2 + 4 * i] = point->pui32X[size - 1 - i] >> 16;
+    wire[3 + 4 * i] = point->pui32X[size - 1 - i] >> 8;
+    wire[4 + 4 * i] = point->pui32X[size - 1 - i];
+  }
+}
+
+
+/* Returns the parity of y, or 0xff if the prefix or x >= p is invalid */
+static uint8_t wire_get_point(ec_point_t *point, const ecc_curve_info_t *curve, const uint8_t *wire) {
+  uint32_t size = curve->ui8Size;
+  uint32_t i;
+
+  memset(point, 0, sizeof(ec_point_t));
+  if((wire[0] & 0xfe) != 0x02) {
+    return 0xff;
+  }
+  for(i = 0; i < size; i++) {
+    point->pui32X[size - 1 - i] = (uint32_t)wire[1 + 4 * i] << 24 | (uint32_t)wire[2 + 4 * i] << 16
+                                  | (uint32_t)wire[3 + 4 * i] << 8 | wire[4 + 4 * i];
+  }
+  for(i = size; i-- > 0;) {
+    if(point->pui32X[i] != curve->pui32Prime[i]) {
+      return point->pui32X[i] < curve->pui32Prime[i] ? wire[0] & 1 : 0xff;
+    }
+  }
+  return 0xff;
+}
+
+
+uint32_t ec_elgamal_encode(const ec_elgmal_enc_state_t *state, uint8_t *wire) {
+  uint32_t size = state->curve_info->ui8Size;
+
+  wire_put_point(&state->cipher_p1, size, wire);
+  wire_put_point(&state->cipher_p2, size, wire + 1 + 4 * size);
+  return EC_ELGAMAL_WIRE_LEN(size);
+}
+
+
+PT_THREAD(ec_elgamal_decode(ec_elgamal_wire_state_t *state)) {
+  static uint32_t Two[1] = { 2 };
+  static uint32_t Three[1] = { 3 };
+  uint8_t size = state->curve_info->ui8Size;
+
+  PT_BEGIN(&state->pt);
+  EC_ELGAMAL_ACQUIRE();
+
+  /* sqrt(u) = u^((p+1)/4) mod p for p = 3 mod 4 */
+  if((state->curve_info->pui32Prime[0] & 3) != 3) {
+    EXIT_RESULT(PKA_STATUS_INVALID_PARAM);
+  }
+  sqrt_exponent(state->curve_info, state->root);
+
+  PKA_WAIT_LOCK(&state->pt, state->process);
+  CHECK_RESULT(PKABigNumPin(state->curve_info->pui32Prime, size, &state->prime_vector));
+  CHECK_RESULT(PKABigNumPin(state->root, size, &state->root_vector));
+
+#define POINT (&state->cipher[state->index])
+  for(state->index = 0; state->index < 2 * state->count; state->index++) {
+    state->parity = wire_get_point(POINT, state->curve_info, state->wire + state->index * (1 + 4 * size));
+    if(state->parity == 0xff) {
+      EXIT_RESULT(PKA_STATUS_FAILURE);
+    }
+
+    /* rhs = x^3 mod p */
+    CHECK_RESULT(PKABigNumExpModStart(Three, 1, PKA_VECTOR(state->prime_vector), size, POINT->pui32X, size, &state->rv, state->process));
+    PT_WAIT_UNTIL(&state->pt, pka_check_status());
+    memset(state->rhs, 0, sizeof(state->rhs));
+    CHECK_RESULT(PKABigNumExpModGetResult(state->rhs, size, state->rv));
+
+    /* tmp = ax + x^3 + b */
+    CHECK_RESULT(PKABigNumMultiplyStart(state->curve_info->pui32A, size, POINT->pui32X, size, &state->rv, state->process));
+    PT_WAIT_UNTIL(&state->pt, pka_check_status());
+    state->len = sizeof(state->tmp) / sizeof(uint32_t);
+    CHECK_RESULT(PKABigNumMultGetResult(state->tmp, &state->len, state->rv));
+    CHECK_RESULT(PKABigNumAddStart(state->tmp, state->len, state->rhs, size, &state->rv, state->process));
+    PT_WAIT_UNTIL(&state->pt, pka_check_status());
+    state->len = sizeof(state->tmp) / sizeof(uint32_t);
+    CHECK_RESULT(PKABigNumAddGetResult(state->tmp, &state->len, state->rv));
+    CHECK_RESULT(PKABigNumAddStart(state->tmp, state->len, state->curve_info->pui32B, size, &state->rv, state->process));
+    PT_WAIT_UNTIL(&state->pt, pka_check_status());
+    state->len = sizeof(state->tmp) / sizeof(uint32_t);
+    CHECK_RESULT(PKABigNumAddGetResult(state->tmp, &state->len, state->rv));
+
+    /* rhs = tmp mod p */
+    CHECK_RESULT(PKABigNumModStart(state->tmp, state->len, PKA_VECTOR(state->prime_vector), size, &state->rv, state->process));
+    PT_WAIT_UNTIL(&state->pt, pka_check_status());
+    memset(state->rhs, 0, sizeof(state->rhs));
+    CHECK_RESULT(PKABigNumModGetResult(state->rhs, size, state->rv));
+
+    /* y = rhs^((p+1)/4) mod p */
+    CHECK_RESULT(PKABigNumExpModStart(PKA_VECTOR(state->root_vector), size, PKA_VECTOR(state->prime_vector), size, state->rhs, size, &state->rv, state->process));
+    PT_WAIT_UNTIL(&state->pt, pka_check_status());
+    memset(POINT->pui32Y, 0, sizeof(POINT->pui32Y));
+    CHECK_RESULT(PKABigNumExpModGetResult(POINT->pui32Y, size, state->rv));
+
+    /* y^2 = rhs, unless x is not on the curve */
+    CHECK_RESULT(PKABigNumExpModStart(Two, 1, PKA_VECTOR(state->prime_vector), size, POINT->pui32Y, size, &state->rv, state->process));
+    PT_WAIT_UNTIL(&state->pt, pka_check_status());
+    memset(state->tmp, 0, sizeof(state->tmp));
+    CHECK_RESULT(PKABigNumExpModGetResult(state->tmp, size, state->rv));
+    CHECK_RESULT(PKABigNumCmpStart(state->tmp, state->rhs, size, state->process));
+    PT_WAIT_UNTIL(&state->pt, pka_check_status());
+    if(PKABigNumCmpGetResult() != PKA_STATUS_SUCCESS) {
+      EXIT_RESULT(PKA_STATUS_FAILURE);
+    }
+
+    /* the other root p - y has the opposite parity */
+    if((POINT->pui32Y[0] & 1) != state->parity) {
+      CHECK_RESULT(PKABigNumSubtractStart(PKA_VECTOR(state->prime_vector), size, POINT->pui32Y, size, &state->rv, state->process));
+      PT_WAIT_UNTIL(&state->pt, pka_check_status());
+      memset(POINT->pui32Y, 0, sizeof(POINT->pui32Y));
+      state->len = size;
+      CHECK_RESULT(PKABigNumSubtractGetResult(POINT->pui32Y, &state->len, state->rv));
+    }
+  }
+#undef POINT
+
+  PKABigNumUnlock();
+  EC_ELGAMAL_RELEASE();
+  PT_END(&state->pt);
+}
+
+
+static void bsgs_sift(uint32_t *x, uint16_t *j, uint32_t root, uint32_t size) {
+  uint32_t child, tx;
+  uint16_t tj;
+
+  while((child = 2 * root + 1) < size) {
+    if(child + 1 < size && x[child + 1] > x[child]) {
+      child++;
+    }
+    if(x[root] >= x[child]) {
+      return;
+    }
+    tx = x[root]; x[root] = x[child]; x[child] = tx;
+    tj = j[root]; j[root] = j[child]; j[child] = tj;
+    root = child;
+  }
+}
+
+/* Sorts the baby steps by x (heap sort, no additional memory) */
+static void bsgs_sort(uint32_t *x, uint16_t *j, uint32_t size) {
+  uint32_t i, tx;
+  uint16_t tj;
+
+  for(i = size / 2; i > 0; i--) {
+    bsgs_sift(x, j, i - 1, size);
+  }
+  for(i = size - 1; i > 0; i--) {
+    tx = x[0]; x[0] = x[i]; x[i] = tx;
+    tj = j[0]; j[0] = j[i]; j[i] = tj;
+    bsgs_sift(x, j, 0, i);
+  }
+}
+
+/* First entry with an x word not smaller than key */
+static uint32_t bsgs_lookup(const ec_elgamal_bsgs_table_t *table, uint32_t key) {
+  uint32_t lo = 0, hi = table->size, mid;
+
+  while(lo < hi) {
+    mid = lo + (hi - lo) / 2;
+    if(table->x[mid] < key) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+PT_THREAD(ec_elgamal_bsgs_generate(ec_elgamal_dlog_state_t *state)) {
+  PT_BEGIN(&state->pt);
+  EC_ELGAMAL_ACQUIRE();
+
+  if(state->table_size == 0 || state->table_size > UINT16_MAX) {
+    EXIT_RESULT(PKA_STATUS_INVALID_PARAM);
+  }
+
+  /* 1G, 2G (the PKA does not double by ECC-ADD) */
+  for(state->index = 0; state->index < 2 && state->index < state->table_size; state->index++) {
+    memset(state->scalar, 0, sizeof(state->scalar));
+    state->scalar[0] = state->index + 1;
+    CHECK_RESULT(PKAECCMultGenPtStart(state->scalar, state->curve_info, &state->rv, state->process));
+    PT_WAIT_UNTIL(&state->pt, pka_check_status());
+    CHECK_RESULT(PKAECCMultGenPtGetResult(&state->point, state->rv));
+    state->table_x[state->index] = state->point.pui32X[0];
+    state->table_j[state->index] = state->index + 1;
+  }
+
+  /* jG = (j-1)G + G */
+  memset(&state->step, 0, sizeof(state->step));
+  memcpy(state->step.pui32X, state->curve_info->pui32Gx, sizeof(uint32_t) * state->curve_info->ui8Size);
+  memcpy(state->step.pui32Y, state->curve_info->pui32Gy, sizeof(uint32_t) * state->curve_info->ui8Size);
+  for(; state->index < state->table_size; state->index++) {
+    CHECK_RESULT(PKAECCAddStart(&state->point, &state->step, state->curve_info, &state->rv, state->process));
+    PT_WAIT_UNTIL(&state->pt, pka_check_status());
+    CHECK_RESULT(PKAECCAddGetResult(&state->point, state->rv));
+    state->table_x[state->index] = state->point.pui32X[0];
+    state->table_j[state->index] = state->index + 1;
+  }
+
+  bsgs_sort(state->table_x, state->table_j, state->table_size);
+
+  EC_ELGAMAL_RELEASE();
+  PT_END(&state->pt);
+}
+
+PT_THREAD(ec_elgamal_dlog(ec_elgamal_dlog_state_t *state)) {
+  uint32_t ec_len = state->curve_info->ui8Size;
+
+  PT_BEGIN(&state->pt);
+
+  EC_ELGAMAL_ACQUIRE();
+  /* plain = mG with m = base + k, point = kG and -M <= k <= M */
+  state->giant_steps = 0;
+
+  /* step = -(2M+1)G */
+  memset(state->scalar, 0, sizeof(state->scalar));
+  state->scalar[0] = 2 * state->table->size + 1;
+  CHECK_RESULT(PKAECCMultGenPtStart(state->scalar, state->curve_info, &state->rv, state->process));
+  PT_WAIT_UNTIL(&state->pt, pka_check_status());
+  CHECK_RESULT(PKAECCMultGenPtGetResult(&state->step, state->rv));
+
+  state->len = ec_len;
+  CHECK_RESULT(PKABigNumSubtractStart(state->curve_info->pui32Prime, ec_len, state->step.pui32Y, ec_len, &state->rv, state->process));
+  PT_WAIT_UNTIL(&state->pt, pka_check_status());
+  CHECK_RESULT(PKABigNumSubtractGetResult(state->step.pui32Y, &state->len, state->rv));
+
+  /* point = plain - MG */
+  state->scalar[0] = state->table->size;
+  CHECK_RESULT(PKAECCMultGenPtStart(state->scalar, state->curve_info, &state->rv, state->process));
+  PT_WAIT_UNTIL(&state->pt, pka_check_status());
+  CHECK_RESULT(PKAECCMultGenPtGetResult(&state->point, state->rv));
+
+  state->len = ec_len;
+  CHECK_RESULT(PKABigNumSubtractStart(state->curve_info->pui32Prime, ec_len, state->point.pui32Y, ec_len, &state->rv, state->process));
+  PT_WAIT_UNTIL(&state->pt, pka_check_status());
+  CHECK_RESULT(PKABigNumSubtractGetResult(state->point.pui32Y, &state->len, state->rv));
+
+  state->base = state->table->size;
+  CHECK_RESULT(PKAECCAddStart(&state->plain, &state->point, state->curve_info, &state->rv, state->process));
+  PT_WAIT_UNTIL(&state->pt, pka_check_status());
+  state->result = PKAECCAddGetResult(&state->point, state->rv);
+
+  while(1) {
+    if(state->result == PKA_STATUS_RESULT_0) {
+      /* point at infinity: k = 0 */
+      if(state->base > state->bound) {
+        break;
+      }
+      state->plain_int = (uint32_t) state->base;
+      EXIT_RESULT(PKA_STATUS_SUCCESS);
+    }
+    CHECK_RESULT(state->result);
+
+    /* baby steps: point = jG or -jG */
+    for(state->index = bsgs_lookup(state->table, state->point.pui32X[0]);
+        state->index < state->table->size && state->table->x[state->index] == state->point.pui32X[0];
+        state->index++) {
+      for(state->sign = 0; state->sign < 2; state->sign++) {
+        if(state->sign) {
+          state->candidate = state->base - state->table->j[state->index];
+        } else {
+          state->candidate = state->base + state->table->j[state->index];
+        }
+        if(state->candidate == 0 || state->candidate > state->bound) {
+          continue;
+        }
+
+        /* verify the candidate, the table holds one word of x only */
+        memset(state->scalar, 0, sizeof(state->scalar));
+        state->scalar[0] = (uint32_t) state->candidate;
+        CHECK_RESULT(PKAECCMultGenPtStart(state->scalar, state->curve_info, &state->rv, state->process));
+        PT_WAIT_UNTIL(&state->pt, pka_check_status());
+        CHECK_RESULT(PKAECCMultGenPtGetResult(&state->check, state->rv));
+        if(memcmp(state->check.pui32X, state->plain.pui32X, sizeof(uint32_t) * ec_len) == 0
+           && memcmp(state->check.pui32Y, state->plain.pui32Y, sizeof(uint32_t) * ec_len) == 0) {
+          state->plain_int = (uint32_t) state->candidate;
+          EXIT_RESULT(PKA_STATUS_SUCCESS);
+        }
+      }
+    }
+
+    /* giant step: the next window starts at base + M + 1 */
+    if(state->base + state->table->size + 1 > state->bound) {
+      break;
+    }
+    CHECK_RESULT(PKAECCAddStart(&state->point, &state->step, state->curve_info, &state->rv, state->process));
+    PT_WAIT_UNTIL(&state->pt, pka_check_status());
+    state->result = PKAECCAddGetResult(&state->point, state->rv);
+    state->base += 2 * state->table->size + 1;
+    state->giant_steps++;
+  }
+
+  /* m > bound */
+  state->result = PKA_STATUS_FAILURE;
+  EC_ELGAMAL_RELEASE();
   PT_END(&state->pt);
 }
 
@@ -52,6 +52,24 @@
 #include "bignum-driver.h"
 #include "ecc-driver.h"
 
+/* Bits of the ephemeral key per window of the fixed-base tables (2, 4 or 8) */
+#ifdef EC_ELGAMAL_CONF_COMB_WINDOW
+#define EC_ELGAMAL_COMB_WINDOW       EC_ELGAMAL_CONF_COMB_WINDOW
+#else
+#define EC_ELGAMAL_COMB_WINDOW       4
+#endif
+#define EC_ELGAMAL_COMB_DIGITS       ((1 << EC_ELGAMAL_COMB_WINDOW) - 1)
+
+/* Size of the ring of pre-generated ephemeral pairs (rG, rQ) (0 disables the ring) */
+#ifdef EC_ELGAMAL_CONF_RING_SIZE
+#define EC_ELGAMAL_RING_SIZE         EC_ELGAMAL_CONF_RING_SIZE
+#else
+#define EC_ELGAMAL_RING_SIZE         0
+#endif
+
+/* CFS files holding the fixed-base tables of G and of the public key */
+#define EC_ELGAMAL_COMB_FILE_G       "eg-comb-g"
+#define EC_ELGAMAL_COMB_FILE_Q       "eg-comb-q"
 
 typedef struct {
   /* Containers for the State */
@@ -65,10 +83,18 @@ typedef struct {
   uint32_t    random[8];        /* Ephemeral Key */
   ec_point_t  rand_public;      /* Random x Public Point (rQ: summand of first part of cipher)*/
   ec_point_t  inverse_secret_cipher_p2;  /* DEC: inverse of Secret multiplied C" */
+  uint8_t     comb;             /* ENC: use the fixed-base tables (set by ec_elgamal_precompute) */
 
   /* Variables Holding intermediate data (initialized/used internally) */
   uint32_t    rv;               /* Address of Next Result in PKA SRAM */
   uint32_t    len;              /* len of input */
+  int         comb_fd[2];       /* open tables of G and Q */
+  uint8_t     comb_open;        /* bit t is set if comb_fd[t] is open */
+  uint8_t     comb_table;       /* table in use */
+  uint8_t     comb_empty;       /* ENC: the sum is still the point at infinity */
+  uint32_t    comb_index;       /* window (ENC) or entry (PRECOMPUTE) in use */
+  ec_point_t  comb_step;        /* PRECOMPUTE: 2^(wi) B of the current window */
+  ec_point_t  comb_point;       /* table entry d 2^(wi) B */
 
   /* In/Output Variables */
   uint8_t     result;           /* Result Code */
@@ -87,10 +113,14 @@ typedef struct {
   ecc_curve_info_t* curve_info;   /* Curve defining the CyclicGroup */
   uint8_t     int_to_ecpoint;     /* direction of the mapping */
   uint32_t    K;                 /* (m+1)K < prime p and 1/2^K chance of failure */
-  uint32_t    exponent[6];        /* NIST-Routines 3.2.2  (mp_mod_sqrt_192) = 2^190 - 2^62 */
 
   /* Variables Holding intermediate data (initialized/used internally) */
   uint32_t    rv;                 /* Address of Next Result in PKA SRAM */
+  uint32_t    len;                /* length of results */
+  uint32_t    prime_vector;       /* p, resident in PKA SRAM */
+  uint32_t    root_vector;        /* (p+1)/4, resident in PKA SRAM */
+  uint32_t    root[12];           /* exponent of the square root (p+1)/4 */
+  uint32_t    rhs[12];            /* x^3 + ax + b mod p */
 
   /* Input/Output */
   uint8_t     result;             /* Result Code */
@@ -100,6 +130,82 @@ typedef struct {
   ec_point_t  plain_ec;           /* plain text as ECC curve point */
 } ec_elgmal_map_state_t;
 
+/* Baby-step table of the discrete log decoder, may be placed in flash */
+typedef struct {
+  uint32_t        size;         /* number of baby steps M (at most 65535) */
+  const uint32_t  *x;           /* lowest word of x(jG), sorted ascending */
+  const uint16_t  *j;           /* baby step j of every entry, 1 <= j <= M */
+} ec_elgamal_bsgs_table_t;
+
+
+typedef struct {
+  /* Containers for the State */
+  struct pt      pt;
+  struct process *process;
+
+  /* Config Variables */
+  ecc_curve_info_t* curve_info;   /* Curve defining the CyclicGroup */
+  const ec_elgamal_bsgs_table_t* table; /* DECODE: baby steps */
+  uint32_t    bound;              /* DECODE: largest plain text searched */
+  uint32_t    *table_x;           /* GENERATE: storage of table_size x words */
+  uint16_t    *table_j;           /* GENERATE: storage of table_size j */
+  uint32_t    table_size;         /* GENERATE: number of baby steps */
+
+  /* Variables Holding intermediate data (initialized/used internally) */
+  uint32_t    rv;                 /* Address of Next Result in PKA SRAM */
+  uint32_t    len;                /* length of results */
+  uint32_t    scalar[12];         /* scalar of point multiplications */
+  ec_point_t  step;               /* giant step -(2M+1)G */
+  ec_point_t  point;              /* current point */
+  ec_point_t  check;              /* point of a candidate */
+  uint64_t    base;               /* point = (plain - base)G */
+  uint64_t    candidate;          /* candidate plain text */
+  uint32_t    index;              /* table entry under test */
+  uint8_t     sign;               /* candidate base + j or base - j */
+
+  /* Input/Output */
+  uint8_t     result;             /* Result Code, PKA_STATUS_FAILURE if m > bound */
+  ec_point_t  plain;              /* plain text as ECC curve point mG */
+  uint32_t    plain_int;          /* plain text integer m */
+  uint32_t    giant_steps;        /* giant steps of the last decoding */
+} ec_elgamal_dlog_state_t;
+
+/* Counters of the ephemeral pair ring */
+typedef struct {
+  uint32_t    filled;             /* pairs generated by the ring process */
+  uint32_t    drained;            /* pairs used by ec_elgamal_enc() */
+  uint32_t    empty;              /* encryptions that found the ring empty */
+} ec_elgamal_ring_stats_t;
+
+/* Bytes of a compressed cipher-text: prefix byte and x of C' and C" */
+#define EC_ELGAMAL_WIRE_LEN(words)   (2 * (1 + 4 * (words)))
+
+typedef struct {
+  /* Containers for the State */
+  struct pt      pt;
+  struct process *process;
+
+  /* Config Variables */
+  ecc_curve_info_t* curve_info;   /* Curve defining the CyclicGroup */
+
+  /* Variables Holding intermediate data (initialized/used internally) */
+  uint32_t    rv;                 /* Address of Next Result in PKA SRAM */
+  uint32_t    len;                /* length of results */
+  uint32_t    index;              /* point under decompression */
+  uint8_t     parity;             /* lowest bit of y of the point */
+  uint32_t    prime_vector;       /* p, resident in PKA SRAM */
+  uint32_t    root_vector;        /* (p+1)/4, resident in PKA SRAM */
+  uint32_t    root[12];           /* exponent of the square root (p+1)/4 */
+  uint32_t    rhs[12];            /* x^3 + ax + b mod p */
+  uint32_t    tmp[25];            /* unreduced sums and products */
+
+  /* Input/Output */
+  uint8_t     result;             /* Result Code, PKA_STATUS_FAILURE if a point is invalid */
+  const uint8_t *wire;            /* count compressed cipher-texts, back to back */
+  uint32_t    count;              /* number of cipher-texts */
+  ec_point_t  *cipher;            /* 2 * count points, C' and C" of every cipher-text */
+} ec_elgamal_wire_state_t;
+
 //TODO Documentation
 PT_THREAD(ec_elgamal_generate(ec_elgmal_enc_state_t *state));
 
@@ -118,13 +224,37 @@ PT_THREAD(ec_elgamal_map_scalar(ec_elgmal_map_state_t *state));
  * Maps integers values to EC points and reverse!
  * By the help of Koublitz method
  * x = mK + j, for a given K such that (m+1)K < prime p, and 0<=j<K
- * y^2 = x^3 + 3x + b mod p
+ * y^2 = x^3 + ax + b mod p
  * ec-point = (x,y)
  * reverse: m = floor(x/K)
+ *
+ * x^3 + ax + b is computed as x(x^2 + a) + b with the intermediate results
+ * chained in the PKA RAM, p and (p+1)/4 stay resident. The CPU checks the
+ * Jacobi symbol of every candidate, so only the final x costs a square
+ * root. Requires p = 3 mod 4, j_rounds returns the number of candidates.
  */
 PT_THREAD(ec_elgamal_map_koblitz(ec_elgmal_map_state_t *state));
 
 
+/**
+ * \brief Generates the baby-step table of the discrete log decoder
+ *
+ * Computes x(jG) for j = 1..table_size into table_x/table_j and sorts the
+ * entries by x. Costs table_size point additions.
+ */
+PT_THREAD(ec_elgamal_bsgs_generate(ec_elgamal_dlog_state_t *state));
+
+/**
+ * \brief Maps the ec-point mG back to m, with 0 < m <= bound
+ *
+ * Baby-step giant-step: with M baby steps in the table, the giant steps
+ * are 2M+1 long, since x(jG) = x(-jG) matches both signs. Decoding takes
+ * at most bound / (2M+1) point additions and a table lookup each,
+ * matches are verified by a point multiplication.
+ */
+PT_THREAD(ec_elgamal_dlog(ec_elgamal_dlog_state_t *state));
+
+
 /**
  * \brief Encryption with EC-ElGamal
  *
@@ -137,6 +267,46 @@ PT_THREAD(ec_elgamal_map_koblitz(ec_elgmal_map_state_t *state));
 PT_THREAD(ec_elgamal_enc(ec_elgmal_enc_state_t *state));
 
 
+/**
+ * \brief Loads or builds the fixed-base tables of G and the public key
+ *
+ * For every window i of EC_ELGAMAL_COMB_WINDOW bits the tables hold
+ * d 2^(wi) B for 0 < d < 2^w. They are kept in CFS (Coffee on the cc2538)
+ * and are only rebuilt if the curve, the public key or the window changed.
+ * On success ec_elgamal_enc() computes rG and rQ with one point addition per
+ * nonzero window. ec_elgamal_generate() disables the tables again.
+ */
+PT_THREAD(ec_elgamal_precompute(ec_elgmal_enc_state_t *state));
+
+#if EC_ELGAMAL_RING_SIZE
+/**
+ * \brief Pre-generate ephemeral pairs (rG, rQ) for the key of \e state while the PKA is idle
+ *
+ * Starts the ring process, which keeps up to EC_ELGAMAL_RING_SIZE pairs
+ * ready. ec_elgamal_enc() takes the oldest pair, wipes it and only adds
+ * the plain text, it falls back to computing the pair if the ring is empty.
+ * \note \e state must stay valid until ec_elgamal_ring_stop() is called
+ */
+void ec_elgamal_ring_start(ec_elgmal_enc_state_t *state);
+
+/**
+ * \brief Stops the ring process and wipes all pairs
+ */
+void ec_elgamal_ring_stop(void);
+
+/**
+ * \brief Number of pairs ready for use
+ */
+uint8_t ec_elgamal_ring_count(void);
+
+/**
+ * \brief Fill and drain counters of the ring
+ */
+const ec_elgamal_ring_stats_t *ec_elgamal_ring_get_stats(void);
+
+PROCESS_NAME(ec_elgamal_ring_process);
+#endif /* EC_ELGAMAL_RING_SIZE */
+
 /**
  * \brief Decryption with EC-ElGamal
  *
@@ -146,6 +316,27 @@ PT_THREAD(ec_elgamal_enc(ec_elgmal_enc_state_t *state));
  */
 PT_THREAD(ec_elgamal_dec(ec_elgmal_enc_state_t *state));
 
+/**
+ * \brief Compresses the cipher-text (C', C") of \e state into \e wire
+ *
+ * Each point is stored as in SEC 1: a prefix byte 0x02 or 0x03 with the
+ * lowest bit of y, followed by x big endian. Takes
+ * EC_ELGAMAL_WIRE_LEN(curve_info->ui8Size) bytes, 50 on P-192 and 66 on
+ * P-256 instead of two points of 48 and 64 bytes.
+ * \return The number of bytes written
+ */
+uint32_t ec_elgamal_encode(const ec_elgmal_enc_state_t *state, uint8_t *wire);
+
+/**
+ * \brief Decompresses a batch of cipher-texts written by ec_elgamal_encode()
+ *
+ * Recovers y = (x^3 + ax + b)^((p+1)/4) mod p for every point, which
+ * requires p = 3 mod 4 (true for the NIST curves). p and the exponent stay
+ * resident in the PKA SRAM for the whole batch. Points that are not on the
+ * curve are rejected.
+ */
+PT_THREAD(ec_elgamal_decode(ec_elgamal_wire_state_t *state));
+
 
 
 #endif /* EC_ELGAMAL_PROCESS_H_ */
@@ -40,11 +40,12 @@
 
 #include <limits.h>
 #include <stdio.h>
-#include <random.h>
+#include <string.h>
 
 #include "ecc-algorithm.h"
 #include "ecc-driver.h"
 #include "pka.h"
+#include "ctr-drbg.h"
 
 #if !defined(START_ECC_TIMER)
 #define START_ECC_TIMER(index)
@@ -58,14 +59,15 @@
   state->result = __VA_ARGS__;                                               \
   if(state->result) {                                                        \
     printf("Line: %u Error: %u\n", __LINE__, (unsigned int) state->result);  \
+    PKABigNumUnlock();                                                       \
     PT_EXIT(&state->pt);                                                     \
   }
 
-static void ecc_random(uint32_t *secret, uint32_t size) {
-  uint32_t i; for (i = 0; i < size; ++i) {
-    secret[i] = (uint32_t)random_rand() | (uint32_t)random_rand() << 16;
-  }
-}
+/* Fills secret with size random words from the CTR-DRBG */
+#define ECC_RANDOM(secret, size)                                             \
+  CTR_DRBG_WAIT_GENERATE(&state->pt, state->process, state->result,          \
+                         (secret), (size) * sizeof(uint32_t));               \
+  CHECK_RESULT(state->result ? PKA_STATUS_FAILURE : PKA_STATUS_SUCCESS);
 
 PT_THREAD(ecc_compare(ecc_compare_state_t *state)) {
   PT_BEGIN(&state->pt);
@@ -93,7 +95,7 @@ PT_THREAD(ecc_generate(ecc_generate_state_t *state)) {
   PT_BEGIN(&state->pt);
 
   do {
-    ecc_random(state->secret, state->curve_info->ui8Size);
+    ECC_RANDOM(state->secret, state->curve_info->ui8Size);
     CHECK_RESULT(PKABigNumCmpStart(state->secret, state->curve_info->pui32N, state->curve_info->ui8Size, state->process));
     PT_WAIT_UNTIL(&state->pt, pka_check_status());
     state->result = PKABigNumCmpGetResult();
@@ -116,6 +118,85 @@ PT_THREAD(ecc_add(ecc_add_state_t *state)) {
   PT_END(&state->pt);
 }
 
+//Point added for the current bits of both scalars, NULL if none
+static ec_point_t *dual_term(ecc_dual_multiply_state_t *state) {
+  uint8_t a = (state->scalar_a[state->bit / 32] >> (state->bit % 32)) & 1;
+  uint8_t b = (state->scalar_b[state->bit / 32] >> (state->bit % 32)) & 1;
+
+  if(a && b) {
+    return state->sum_infinity ? NULL : &state->sum;
+  } else if(a) {
+    return &state->point_a;
+  } else if(b) {
+    return &state->point_b;
+  }
+  return NULL;
+}
+
+PT_THREAD(ecc_dual_multiply(ecc_dual_multiply_state_t *state)) {
+  //Executed Every Time
+  uint32_t len = sizeof(uint32_t) * state->curve_info->ui8Size;
+  static uint32_t two[12] = { 2 };
+  ec_point_t *term;
+
+  PT_BEGIN(&state->pt);
+
+  //Calculate A + B, the PKA can neither add P + P nor P + -P
+  state->sum_infinity = 0;
+  if(memcmp(state->point_a.pui32X, state->point_b.pui32X, len) != 0) {
+    CHECK_RESULT(PKAECCAddStart(&state->point_a, &state->point_b, state->curve_info, &state->rv, state->process));
+    PT_WAIT_UNTIL(&state->pt, pka_check_status());
+    CHECK_RESULT(PKAECCAddGetResult(&state->sum, state->rv));
+  } else if(memcmp(state->point_a.pui32Y, state->point_b.pui32Y, len) == 0) {
+    CHECK_RESULT(PKAECCMultiplyStart(two, &state->point_a, state->curve_info, &state->rv, state->process));
+    PT_WAIT_UNTIL(&state->pt, pka_check_status());
+    CHECK_RESULT(PKAECCMultiplyGetResult(&state->sum, state->rv));
+  } else {
+    state->sum_infinity = 1;
+  }
+
+  //Scan both scalars from the top bit
+  state->infinity = 1;
+  for(state->bit = state->curve_info->ui8Size * 32 - 1; state->bit >= 0; state->bit--) {
+    //R = 2R
+    if(!state->infinity) {
+      CHECK_RESULT(PKAECCMultiplyStart(two, &state->point_out, state->curve_info, &state->rv, state->process));
+      PT_WAIT_UNTIL(&state->pt, pka_check_status());
+      CHECK_RESULT(PKAECCMultiplyGetResult(&state->point_out, state->rv));
+    }
+
+    //R = R + A, R + B or R + (A + B)
+    term = dual_term(state);
+    if(term == NULL) {
+      continue;
+    }
+    if(state->infinity) {
+      memcpy(&state->point_out, term, sizeof(ec_point_t));
+      state->infinity = 0;
+      continue;
+    }
+    if(memcmp(state->point_out.pui32X, term->pui32X, len) == 0) {
+      if(memcmp(state->point_out.pui32Y, term->pui32Y, len) != 0) {
+        //R + -R
+        state->infinity = 1;
+        continue;
+      }
+      //R + R
+      CHECK_RESULT(PKAECCMultiplyStart(two, &state->point_out, state->curve_info, &state->rv, state->process));
+      PT_WAIT_UNTIL(&state->pt, pka_check_status());
+      CHECK_RESULT(PKAECCMultiplyGetResult(&state->point_out, state->rv));
+      continue;
+    }
+    CHECK_RESULT(PKAECCAddStart(&state->point_out, term, state->curve_info, &state->rv, state->process));
+    PT_WAIT_UNTIL(&state->pt, pka_check_status());
+    CHECK_RESULT(PKAECCAddGetResult(&state->point_out, state->rv));
+  }
+
+  state->result = state->infinity ? PKA_STATUS_RESULT_0 : PKA_STATUS_SUCCESS;
+
+  PT_END(&state->pt);
+}
+
 PT_THREAD(ecc_dsa_sign(ecc_dsa_sign_state_t *state)) {
   //Executed Every Time
   uint8_t   size = state->curve_info->ui8Size;
@@ -127,11 +208,6 @@ PT_THREAD(ecc_dsa_sign(ecc_dsa_sign_state_t *state)) {
 
   PT_BEGIN(&state->pt);
 
-  //Invert k_e mod n
-  CHECK_RESULT(PKABigNumInvModStart(state->k_e, size, ord, size, &state->rv, state->process));
-  PT_WAIT_UNTIL(&state->pt, pka_check_status());
-  CHECK_RESULT(PKABigNumInvModGetResult(state->k_e_inv, size, state->rv));
-
   //Calculate Point R = K_e * GeneratorPoint
   START_ECC_TIMER(7);
   CHECK_RESULT(PKAECCMultiplyStart(state->k_e, &point, state->curve_info, &state->rv, state->process));
@@ -139,40 +215,42 @@ PT_THREAD(ecc_dsa_sign(ecc_dsa_sign_state_t *state)) {
   CHECK_RESULT(PKAECCMultiplyGetResult(&state->point_r, state->rv));
   STOP_ECC_TIMER(7, 7);
 
+  //Keep n in the PKA RAM, the intermediate results of s are chained
+  PKA_WAIT_LOCK(&state->pt, state->process);
+  CHECK_RESULT(PKABigNumPin(ord, size, &state->ord_vector));
+
+  //Invert k_e mod n
+  CHECK_RESULT(PKABigNumInvModStart(state->k_e, size, PKA_VECTOR(state->ord_vector), size, &state->rv, state->process));
+  PT_WAIT_UNTIL(&state->pt, pka_check_status());
+  CHECK_RESULT(PKABigNumInvModGetResult(state->k_e_inv, size, state->rv));
+
   //Calculate signature using big math functions
   //d*r (r is the x coordinate of PointR)
   CHECK_RESULT(PKABigNumMultiplyStart(state->secret, size, state->point_r.pui32X, size, &state->rv, state->process));
   PT_WAIT_UNTIL(&state->pt, pka_check_status());
-  state->len = 24;
-  CHECK_RESULT(PKABigNumMultGetResult(state->signature_s, &state->len, state->rv));
 
   //d*r mod n
-  CHECK_RESULT(PKABigNumModStart(state->signature_s, state->len, ord, size, &state->rv, state->process));
+  CHECK_RESULT(PKABigNumModStart(PKA_VECTOR(state->rv), 2 * size, PKA_VECTOR(state->ord_vector), size, &state->rv, state->process));
   PT_WAIT_UNTIL(&state->pt, pka_check_status());
-  CHECK_RESULT(PKABigNumModGetResult(state->signature_s, size, state->rv));
 
   //hash + d*r
-  CHECK_RESULT(PKABigNumAddStart(state->hash, size, state->signature_s, size, &state->rv, state->process));
+  CHECK_RESULT(PKABigNumAddStart(state->hash, size, PKA_VECTOR(state->rv), size, &state->rv, state->process));
   PT_WAIT_UNTIL(&state->pt, pka_check_status());
-  state->len = 24;
-  CHECK_RESULT(PKABigNumAddGetResult(state->signature_s, &state->len, state->rv));
 
   //hash + d*r mod n
-  CHECK_RESULT(PKABigNumModStart(state->signature_s, state->len, ord, size, &state->rv, state->process));
+  CHECK_RESULT(PKABigNumModStart(PKA_VECTOR(state->rv), size + 1, PKA_VECTOR(state->ord_vector), size, &state->rv, state->process));
   PT_WAIT_UNTIL(&state->pt, pka_check_status());
-  CHECK_RESULT(PKABigNumModGetResult(state->signature_s, size, state->rv));
 
   //k_e_inv * (hash + d*r)
-  CHECK_RESULT(PKABigNumMultiplyStart(state->k_e_inv, size, state->signature_s, size, &state->rv, state->process));
+  CHECK_RESULT(PKABigNumMultiplyStart(state->k_e_inv, size, PKA_VECTOR(state->rv), size, &state->rv, state->process));
   PT_WAIT_UNTIL(&state->pt, pka_check_status());
-  state->len = 24;
-  CHECK_RESULT(PKABigNumMultGetResult(state->signature_s, &state->len, state->rv));
 
   //k_e_inv * (hash + d*r) mod n
-  CHECK_RESULT(PKABigNumModStart(state->signature_s, state->len, ord, size, &state->rv, state->process));
+  CHECK_RESULT(PKABigNumModStart(PKA_VECTOR(state->rv), 2 * size, PKA_VECTOR(state->ord_vector), size, &state->rv, state->process));
   PT_WAIT_UNTIL(&state->pt, pka_check_status());
   CHECK_RESULT(PKABigNumModGetResult(state->signature_s, size, state->rv));
 
+  PKABigNumUnlock();
   PT_END(&state->pt);
 }
 
@@ -214,6 +292,22 @@ PT_THREAD(ecc_dsa_verify(ecc_dsa_verify_state_t *state)) {
   PT_WAIT_UNTIL(&state->pt, pka_check_status());
   CHECK_RESULT(PKABigNumModGetResult(state->u2, size, state->rv));
 
+#if ECC_VERIFY_SHAMIR
+  //Calculate P = u1 * A (Generator) + u2 * B (Public Key) in one pass
+  START_ECC_TIMER(7);
+  state->dual.process    = state->process;
+  state->dual.curve_info = state->curve_info;
+  memcpy(&state->dual.point_a, &point, sizeof(ec_point_t));
+  memcpy(&state->dual.point_b, &state->public, sizeof(ec_point_t));
+  memset(state->dual.scalar_a, 0, sizeof(state->dual.scalar_a));
+  memset(state->dual.scalar_b, 0, sizeof(state->dual.scalar_b));
+  memcpy(state->dual.scalar_a, state->u1, sizeof(uint32_t) * size);
+  memcpy(state->dual.scalar_b, state->u2, sizeof(uint32_t) * size);
+  PT_SPAWN(&state->pt, &state->dual.pt, ecc_dual_multiply(&state->dual));
+  CHECK_RESULT(state->dual.result);
+  memcpy(&state->p1, &state->dual.point_out, sizeof(ec_point_t));
+  STOP_ECC_TIMER(7, 7);
+#else
   //Calculate p1 = u1 * A (Generator)
   START_ECC_TIMER(7);
   CHECK_RESULT(PKAECCMultiplyStart(state->u1, &point, state->curve_info, &state->rv, state->process));
@@ -230,6 +324,7 @@ PT_THREAD(ecc_dsa_verify(ecc_dsa_verify_state_t *state)) {
   CHECK_RESULT(PKAECCAddStart(&state->p1, &state->p2, state->curve_info, &state->rv, state->process));
   PT_WAIT_UNTIL(&state->pt, pka_check_status());
   CHECK_RESULT(PKAECCAddGetResult(&state->p1, state->rv));
+#endif
 
   //Verify Result
   CHECK_RESULT(PKABigNumCmpStart(state->signature_r, state->p1.pui32X, size, state->process));
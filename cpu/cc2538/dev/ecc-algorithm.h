@@ -52,6 +52,16 @@
 #include "bignum-driver.h"
 #include "ecc-driver.h"
 
+//Verify with one joint multiplication u1 * G + u2 * Q (Shamir's trick).
+//Only pka-sw enables it. The cc2538 PKA has no point doubling, and ECC-ADD
+//can not add P + P, so every doubling would be a full ECC-MUL by 2: about
+//256 multiplications instead of the two of the plain verify.
+#ifdef ECC_CONF_VERIFY_SHAMIR
+#define ECC_VERIFY_SHAMIR ECC_CONF_VERIFY_SHAMIR
+#else
+#define ECC_VERIFY_SHAMIR 0
+#endif
+
 typedef struct  {
   //Containers for the State
   struct pt      pt;
@@ -152,6 +162,40 @@ typedef struct {
  */
 PT_THREAD(ecc_add(ecc_add_state_t *state));
 
+typedef struct {
+  //Containers for the State
+  struct pt      pt;
+  struct process *process;
+
+  //Input Variables
+  ecc_curve_info_t* curve_info; //Curve defining the CyclicGroup
+  ec_point_t  point_a;          //Point A
+  uint32_t    scalar_a[12];     //Scalar of A
+  ec_point_t  point_b;          //Point B
+  uint32_t    scalar_b[12];     //Scalar of B
+
+  //Variables Holding intermediate data (initialized/used internally)
+  uint32_t    rv;               //Address of Next Result in PKA SRAM
+  ec_point_t  sum;              //A + B
+  uint8_t     sum_infinity;     //A + B is the point at infinity
+  uint8_t     infinity;         //point_out is the point at infinity
+  int         bit;              //Bit of the scalars in use
+
+  //Output Variables
+  uint8_t     result;           //Result Code
+  ec_point_t  point_out;        //scalar_a * A + scalar_b * B
+} ecc_dual_multiply_state_t;
+
+/**
+ * \brief Joint Multiplication scalar_a * A + scalar_b * B
+ *
+ * Straus-Shamir: both scalars are scanned in one pass from the top bit,
+ * every bit costs one doubling and at most one addition of A, B or A + B.
+ * The PKA has no doubling, it is done by a multiplication with 2.
+ * Returns PKA_STATUS_RESULT_0 if the sum is the point at infinity.
+ */
+PT_THREAD(ecc_dual_multiply(ecc_dual_multiply_state_t *state));
+
 typedef struct {
   //Containers for the State
   struct pt      pt;
@@ -165,6 +209,7 @@ typedef struct {
 
   //Variables Holding intermediate data (initialized/used internally)
   uint32_t    rv;               //Address of Next Result in PKA SRAM
+  uint32_t    ord_vector;       //Curve order, resident in PKA SRAM
   uint32_t    k_e_inv[12];      //Inverted ephemeral Key
   uint32_t    len;              //Length of intermediate Result
 
@@ -204,6 +249,9 @@ typedef struct {
   ec_point_t  p1;               //Intermediate result
   ec_point_t  p2;               //Intermediate result
   uint32_t    len;              //Length of intermediate Result
+#if ECC_VERIFY_SHAMIR
+  ecc_dual_multiply_state_t dual; //u1 * G + u2 * Q
+#endif
 
   //Output Variables
   uint8_t     result;           //Result Code
@@ -40,6 +40,7 @@
  * Implementation of the cc2538 ECC driver
  */
 #include "ecc-driver.h"
+#include "bignum-driver.h"
 #include "reg.h"
 #include "dev/nvic.h"
 
@@ -65,11 +66,15 @@ uint8_t PKAECCMultiplyStart(uint32_t* pui32Scalar, ec_point_t* ptEcPt,
 
   offset = 0;
 
-  // Make sure no PKA operation is in progress.
-  if((REG(PKA_FUNCTION) & PKA_FUNCTION_RUN) != 0) {
+  // Make sure no PKA operation is in progress and no other process holds
+  // the PKA RAM.
+  if((REG(PKA_FUNCTION) & PKA_FUNCTION_RUN) != 0 || PKABigNumLocked()) {
     return (PKA_STATUS_OPERATION_INPRG);
   }
 
+  // The operation uses the whole PKA RAM, resident vectors are lost.
+  PKABigNumUnpinAll();
+
   // Calculate the extra buffer requirement.
   extraBuf = 2 + ptCurve->ui8Size % 2;
 
@@ -229,11 +234,15 @@ uint8_t PKAECCMultGenPtStart(uint32_t* pui32Scalar, ecc_curve_info_t* ptCurve,
 
   offset = 0;
 
-  // Make sure no operation is in progress.
-  if((REG(PKA_FUNCTION) & PKA_FUNCTION_RUN) != 0) {
+  // Make sure no operation is in progress and no other process holds the
+  // PKA RAM.
+  if((REG(PKA_FUNCTION) & PKA_FUNCTION_RUN) != 0 || PKABigNumLocked()) {
     return (PKA_STATUS_OPERATION_INPRG);
   }
 
+  // The operation uses the whole PKA RAM, resident vectors are lost.
+  PKABigNumUnpinAll();
+
   // Calculate the extra buffer requirement.
   extraBuf = 2 + ptCurve->ui8Size % 2;
 
@@ -399,11 +408,15 @@ uint8_t PKAECCAddStart(ec_point_t* ptEcPt1, ec_point_t* ptEcPt2,
 
   offset = 0;
 
-  // Make sure no operation is in progress.
-  if((REG(PKA_FUNCTION) & PKA_FUNCTION_RUN) != 0) {
+  // Make sure no operation is in progress and no other process holds the
+  // PKA RAM.
+  if((REG(PKA_FUNCTION) & PKA_FUNCTION_RUN) != 0 || PKABigNumLocked()) {
     return (PKA_STATUS_OPERATION_INPRG);
   }
 
+  // The operation uses the whole PKA RAM, resident vectors are lost.
+  PKABigNumUnpinAll();
+
   // Calculate the extra buffer requirement.
   extraBuf = 2 + ptCurve->ui8Size % 2;
 
@@ -0,0 +1,340 @@
+/*
+ * Copyright (c) 2015, Institute for Pervasive Computing, ETH Zurich.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/**
+ * \addtogroup cc2538-key-store
+ * @{
+ *
+ * \file
+ * Implementation of the cc2538 key store manager
+ */
+#include "contiki.h"
+#include "dev/crypto.h"
+#include "dev/key-store.h"
+
+#include <stdint.h>
+#include <string.h>
+
+typedef struct {
+  uint32_t key[8];                //Key, padded to 256 bits
+  uint32_t used;                  //Time of the last acquire
+  uint8_t  size;                  //AES_KEY_STORE_SIZE_KEY_SIZE_x, 0 if free
+  uint8_t  area;                  //First key area, or KEY_STORE_INVALID
+  uint8_t  refs;                  //References taken by key_store_acquire
+  uint8_t  owners;                //Calls of key_store_add not yet removed
+} key_entry_t;
+
+static key_entry_t entries[KEY_STORE_HANDLES];
+static key_store_handle_t owner[KEY_STORE_AREAS];
+static uint8_t store_size;        //Key size of the key store, 0 if unknown
+static uint8_t initialized;
+static uint32_t now;
+static key_store_stats_t counters;
+/*---------------------------------------------------------------------------*/
+static uint8_t
+key_bytes(uint8_t key_size)
+{
+  switch(key_size) {
+  case AES_KEY_STORE_SIZE_KEY_SIZE_128:
+    return 16;
+  case AES_KEY_STORE_SIZE_KEY_SIZE_192:
+    return 24;
+  case AES_KEY_STORE_SIZE_KEY_SIZE_256:
+    return 32;
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+/* 192- and 256-bit keys take two areas starting at an even one */
+static uint8_t
+key_areas(uint8_t key_size)
+{
+  return key_size == AES_KEY_STORE_SIZE_KEY_SIZE_128 ? 1 : 2;
+}
+/*---------------------------------------------------------------------------*/
+static void
+init(void)
+{
+  uint8_t i;
+
+  if(initialized) {
+    return;
+  }
+  for(i = 0; i < KEY_STORE_AREAS; i++) {
+    owner[i] = KEY_STORE_INVALID;
+  }
+  for(i = 0; i < KEY_STORE_HANDLES; i++) {
+    entries[i].area = KEY_STORE_INVALID;
+  }
+  initialized = 1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+unload(key_store_handle_t handle)
+{
+  key_entry_t *e = &entries[handle];
+  uint8_t i;
+
+  if(e->area == KEY_STORE_INVALID) {
+    return;
+  }
+  for(i = 0; i < key_areas(e->size); i++) {
+    owner[e->area + i] = KEY_STORE_INVALID;
+  }
+  e->area = KEY_STORE_INVALID;
+}
+/*---------------------------------------------------------------------------*/
+/* Finds the areas for a key of key_size: empty ones first, then the ones
+ * whose keys were used least recently. Referenced areas are never taken. */
+static uint8_t
+find_area(uint8_t key_size)
+{
+  uint8_t n = key_areas(key_size);
+  uint8_t best = KEY_STORE_INVALID;
+  uint32_t best_age = 0;
+  uint8_t a, i;
+
+  for(a = 0; a < KEY_STORE_AREAS; a += n) {
+    uint32_t age = 0;
+    uint8_t empty = 1, pinned = 0;
+
+    for(i = a; i < a + n; i++) {
+      if(owner[i] != KEY_STORE_INVALID) {
+        empty = 0;
+        pinned |= entries[owner[i]].refs != 0;
+        if(now - entries[owner[i]].used > age) {
+          age = now - entries[owner[i]].used;
+        }
+      }
+    }
+    if(empty) {
+      return a;
+    }
+    if(!pinned && (best == KEY_STORE_INVALID || age > best_age)) {
+      best = a;
+      best_age = age;
+    }
+  }
+  return best;
+}
+/*---------------------------------------------------------------------------*/
+static void
+forget(key_store_handle_t handle)
+{
+  key_entry_t *e = &entries[handle];
+
+  unload(handle);
+  memset(e->key, 0, sizeof(e->key));
+  e->size = 0;
+}
+/*---------------------------------------------------------------------------*/
+static key_store_handle_t
+find(const void *key, uint8_t key_size)
+{
+  uint8_t i;
+
+  for(i = 0; i < KEY_STORE_HANDLES; i++) {
+    if(entries[i].size == key_size
+       && memcmp(entries[i].key, key, key_bytes(key_size)) == 0) {
+      return i;
+    }
+  }
+  return KEY_STORE_INVALID;
+}
+/*---------------------------------------------------------------------------*/
+key_store_handle_t
+key_store_add(const void *key, uint8_t key_size)
+{
+  uint8_t bytes = key_bytes(key_size);
+  key_store_handle_t slot = KEY_STORE_INVALID;
+  uint8_t i;
+
+  if(bytes == 0) {
+    return KEY_STORE_INVALID;
+  }
+  init();
+
+  for(i = 0; i < KEY_STORE_HANDLES; i++) {
+    if(entries[i].size == 0) {
+      if(slot == KEY_STORE_INVALID) {
+        slot = i;
+      }
+    } else if(entries[i].size == key_size
+              && memcmp(entries[i].key, key, bytes) == 0
+              && entries[i].owners < 0xff) {
+      entries[i].owners++;
+      return i;
+    }
+  }
+
+  /* Handles are never recycled behind the back of their owners, a full
+   * table fails until a key is removed */
+  if(slot == KEY_STORE_INVALID) {
+    return KEY_STORE_INVALID;
+  }
+
+  memset(entries[slot].key, 0, sizeof(entries[slot].key));
+  memcpy(entries[slot].key, key, bytes);
+  entries[slot].size = key_size;
+  entries[slot].used = now;
+  entries[slot].owners = 1;
+  return slot;
+}
+/*---------------------------------------------------------------------------*/
+void
+key_store_remove(key_store_handle_t handle)
+{
+  if(handle >= KEY_STORE_HANDLES || entries[handle].owners == 0) {
+    return;
+  }
+  init();
+  if(--entries[handle].owners == 0 && entries[handle].refs == 0) {
+    forget(handle);
+  }
+}
+/*---------------------------------------------------------------------------*/
+key_store_handle_t
+key_store_replace(key_store_handle_t handle, const void *key, uint8_t key_size)
+{
+  uint8_t bytes = key_bytes(key_size);
+  key_store_handle_t other;
+  key_entry_t *e;
+
+  if(bytes == 0) {
+    return KEY_STORE_INVALID;
+  }
+  init();
+
+  /* A handle of its own gets the new key in place */
+  if(handle < KEY_STORE_HANDLES && find(key, key_size) == KEY_STORE_INVALID) {
+    e = &entries[handle];
+    if(e->owners == 1 && e->refs == 0) {
+      unload(handle);
+      memset(e->key, 0, sizeof(e->key));
+      memcpy(e->key, key, bytes);
+      e->size = key_size;
+      return handle;
+    }
+  }
+
+  /* Shared, referenced, or the key is registered already */
+  other = key_store_add(key, key_size);
+  if(other != KEY_STORE_INVALID) {
+    key_store_remove(handle);
+  }
+  return other;
+}
+/*---------------------------------------------------------------------------*/
+uint8_t
+key_store_acquire(key_store_handle_t handle, uint8_t *area)
+{
+  key_entry_t *e;
+  uint8_t a, i, ret;
+
+  if(handle >= KEY_STORE_HANDLES || entries[handle].owners == 0) {
+    return AES_INVALID_PARAM;
+  }
+  init();
+  e = &entries[handle];
+
+  if(e->area == KEY_STORE_INVALID) {
+    counters.misses++;
+
+    /* Changing the key size deletes every stored key */
+    if(store_size != e->size) {
+      for(i = 0; i < KEY_STORE_HANDLES; i++) {
+        if(entries[i].area != KEY_STORE_INVALID && entries[i].refs) {
+          return AES_RESOURCE_IN_USE;
+        }
+      }
+      key_store_flush();
+    }
+
+    a = find_area(e->size);
+    if(a == KEY_STORE_INVALID) {
+      return AES_RESOURCE_IN_USE;
+    }
+    for(i = a; i < a + key_areas(e->size); i++) {
+      if(owner[i] != KEY_STORE_INVALID) {
+        counters.evictions++;
+        unload(owner[i]);
+      }
+    }
+
+    ret = aes_load_keys(e->key, e->size, 1, a);
+    if(ret != AES_SUCCESS) {
+      return ret;
+    }
+    store_size = e->size;
+    for(i = a; i < a + key_areas(e->size); i++) {
+      owner[i] = handle;
+    }
+    e->area = a;
+  } else {
+    counters.hits++;
+  }
+
+  e->refs++;
+  e->used = ++now;
+  *area = e->area;
+  return AES_SUCCESS;
+}
+/*---------------------------------------------------------------------------*/
+void
+key_store_release(key_store_handle_t handle)
+{
+  if(handle < KEY_STORE_HANDLES && entries[handle].refs) {
+    /* The last reference of a removed key forgets it */
+    if(--entries[handle].refs == 0 && entries[handle].owners == 0) {
+      forget(handle);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+key_store_flush(void)
+{
+  uint8_t i;
+
+  init();
+  for(i = 0; i < KEY_STORE_HANDLES; i++) {
+    entries[i].area = KEY_STORE_INVALID;
+  }
+  for(i = 0; i < KEY_STORE_AREAS; i++) {
+    owner[i] = KEY_STORE_INVALID;
+  }
+  store_size = 0;
+}
+/*---------------------------------------------------------------------------*/
+void
+key_store_stats(key_store_stats_t *stats)
+{
+  memcpy(stats, &counters, sizeof(key_store_stats_t));
+}
+
+/** @} */
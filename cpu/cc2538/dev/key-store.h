@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2015, Institute for Pervasive Computing, ETH Zurich.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/**
+ * \addtogroup cc2538-crypto
+ * @{
+ *
+ * \defgroup cc2538-key-store cc2538 Key Store Manager
+ *
+ * Assigns the 8 key areas of the AES key store to logical keys. A key is
+ * registered once and gets a handle, it is loaded into a key area when it
+ * is acquired and stays there until the least recently used unreferenced
+ * areas are needed for another key.
+ *
+ * \note
+ * All keys must be loaded through this manager, the cache does not notice
+ * direct calls of aes_load_keys(). The key store holds keys of one size
+ * only, acquiring a key of another size drops all loaded keys.
+ * @{
+ *
+ * \file
+ * Header file for the cc2538 key store manager
+ */
+#ifndef KEY_STORE_H_
+#define KEY_STORE_H_
+
+#include "contiki.h"
+#include "dev/crypto.h"
+
+#include <stdint.h>
+/*---------------------------------------------------------------------------*/
+/** \name Key store manager configuration
+ * @{
+ */
+#ifdef KEY_STORE_CONF_HANDLES
+#define KEY_STORE_HANDLES KEY_STORE_CONF_HANDLES
+#else
+#define KEY_STORE_HANDLES 16      /**< Logical keys remembered */
+#endif
+
+#define KEY_STORE_AREAS   8       /**< 128-bit areas of the key store */
+#define KEY_STORE_INVALID 0xff    /**< No handle, or not loaded */
+/** @} */
+/*---------------------------------------------------------------------------*/
+/** \name Key store manager functions
+ * @{
+ */
+typedef uint8_t key_store_handle_t;
+
+typedef struct {
+  uint32_t hits;                  //Acquired keys that were loaded
+  uint32_t misses;                //Acquired keys that had to be loaded
+  uint32_t evictions;             //Loaded keys dropped for another key
+} key_store_stats_t;
+
+/** \brief Registers a key
+ * \param key Pointer to the key
+ * \param key_size Key size: \c AES_KEY_STORE_SIZE_KEY_SIZE_x
+ * \return The handle of the key, \c KEY_STORE_INVALID if all handles are
+ * in use
+ * \note The same key gets the same handle, it stays valid until every
+ * caller that added the key has called key_store_remove(). Handles are
+ * never recycled, keys that are no longer needed must be removed to make
+ * room for others.
+ */
+key_store_handle_t key_store_add(const void *key, uint8_t key_size);
+
+/** \brief Drops a registration of a key
+ * \note The key is forgotten when the last caller that added it removed it
+ * and the last reference is released.
+ */
+void key_store_remove(key_store_handle_t handle);
+
+/** \brief Registers a new key in place of the key of handle, for keys that
+ * change often
+ * \param handle Handle of the old key, or \c KEY_STORE_INVALID
+ * \param key Pointer to the new key
+ * \param key_size Key size: \c AES_KEY_STORE_SIZE_KEY_SIZE_x
+ * \return The handle of the new key, \c KEY_STORE_INVALID if all handles
+ * are in use, the old key is kept then
+ * \note A handle that is not shared keeps its number. Otherwise this is
+ * key_store_add() of the new key followed by key_store_remove() of the old.
+ */
+key_store_handle_t key_store_replace(key_store_handle_t handle,
+                                     const void *key, uint8_t key_size);
+
+/** \brief Loads the key if needed and takes a reference
+ * \param handle Handle of the key
+ * \param area Set to the key area holding the key
+ * \return \c AES_SUCCESS if successful, \c AES_RESOURCE_IN_USE if all areas
+ * are referenced or the engine is busy, \c AES_INVALID_PARAM if the handle
+ * is not in use, or AES error code
+ * \note The cryptoprocessor must be enabled. The area is valid until
+ * key_store_release() is called.
+ */
+uint8_t key_store_acquire(key_store_handle_t handle, uint8_t *area);
+
+/** \brief Drops a reference taken by key_store_acquire()
+ */
+void key_store_release(key_store_handle_t handle);
+
+/** \brief Marks all areas as empty, e.g. after the key store was reset
+ */
+void key_store_flush(void);
+
+/** \brief Copies the hit/miss counters
+ */
+void key_store_stats(key_store_stats_t *stats);
+
+/** @} */
+
+#endif /* KEY_STORE_H_ */
+
+/**
+ * @}
+ * @}
+ */
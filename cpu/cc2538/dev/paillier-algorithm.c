@@ -40,10 +40,11 @@
 
 #include <limits.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "bignum-driver.h"
 #include "pka.h"
-#include "random.h"
+#include "ctr-drbg.h"
 #include "paillier-algorithm.h"
 
 #define DEBUG 0
@@ -61,24 +62,194 @@
 #define STOP_PAILLIER_TIMER(index, id)
 #endif
 
+#if PAILLIER_POOL_SIZE
+/* The pool process and the Paillier operations share the PKA */
+static uint8_t pool_job;                /* pool process waits for a PKA result */
+static uint8_t foreground;              /* a Paillier operation is running */
+static struct process *waiting;         /* operation waiting for the pool */
+
+#define PAILLIER_ACQUIRE()                                                   \
+  if(pool_job) {                                                             \
+    waiting = state->process;                                                \
+  }                                                                          \
+  PT_WAIT_UNTIL(&state->pt, !pool_job);                                      \
+  foreground = 1;
+
+#define PAILLIER_RELEASE()                                                   \
+  foreground = 0;                                                            \
+  process_poll(&paillier_pool_process);
+#else
+#define PAILLIER_ACQUIRE()
+#define PAILLIER_RELEASE()
+#endif /* PAILLIER_POOL_SIZE */
+
+
 #define CHECK_RESULT(...)                                                    \
   state->result = __VA_ARGS__;                                               \
   if(state->result) {                                                        \
     PRINTF("Line: %u Error: %u\n", __LINE__, (unsigned int) state->result);  \
+    PKABigNumUnlock();                                                       \
+    PAILLIER_RELEASE();                                                      \
     PT_EXIT(&state->pt);                                                     \
   }
 
-  /* Variables: Rand, Square */
-  static uint32_t  S[cipher_size];           /* Square */
-  static uint32_t  SSize = cipher_size;      /* size of Square */
-  static uint32_t  G[cipher_size];           /* G */
-  static uint32_t  GSize = cipher_size;      /* size of G */
+  /* Variables: Rand, CrtSum, One */
   static uint32_t  Rand[cipher_size];        /* Random number R */
   static uint32_t  RSize = cipher_size;      /* size of R */
+  static uint32_t  CrtSum[cipher_size];      /* sum of the CRT terms */
+  static uint32_t  CrtSize;                  /* size of the sum */
+  static uint32_t  One[1] = { 1 };           /* represent one */
+#if PAILLIER_POOL_SIZE
+  static uint8_t   RPooled;                  /* R was taken from the pool */
+#endif /* PAILLIER_POOL_SIZE */
+
+#if PAILLIER_POOL_SIZE
+  /* Pool of precomputed r^n mod n^2 */
+  static struct {
+    paillier_secrete_state_t *key;          /* key the values belong to */
+    uint32_t values[PAILLIER_POOL_SIZE][cipher_size];
+    uint8_t  count;                         /* values ready for use */
+    uint8_t  epoch;                         /* changes whenever the key changes */
+  } pool;
+  static paillier_pool_stats_t pool_stats;
+  static uint32_t  PoolRand[cipher_size];   /* value the pool process works on */
+
+PROCESS(paillier_pool_process, "Paillier randomness pool");
+
+/*---------------------------------------------------------------------------*/
+static void
+pool_flush(void)
+{
+  memset(pool.values, 0, sizeof(pool.values));
+  pool.count = 0;
+  pool.epoch++;
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t
+pool_take(paillier_secrete_state_t *state, uint32_t *r)
+{
+  if(pool.key != state) {
+    return 0;
+  }
+  if(pool.count == 0) {
+    pool_stats.empty++;
+    return 0;
+  }
+
+  pool.count--;
+  memcpy(r, pool.values[pool.count], sizeof(uint32_t) * cipher_size);
+  memset(pool.values[pool.count], 0, sizeof(uint32_t) * cipher_size);
+  pool_stats.drained++;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+void
+paillier_pool_start(paillier_secrete_state_t *state)
+{
+  pool_flush();
+  pool.key = state;
+  if(process_is_running(&paillier_pool_process)) {
+    process_poll(&paillier_pool_process);
+  } else {
+    process_start(&paillier_pool_process, NULL);
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+paillier_pool_stop(void)
+{
+  pool.key = NULL;
+  pool_flush();
+}
+/*---------------------------------------------------------------------------*/
+uint8_t
+paillier_pool_count(void)
+{
+  return pool.count;
+}
+/*---------------------------------------------------------------------------*/
+const paillier_pool_stats_t *
+paillier_pool_get_stats(void)
+{
+  return &pool_stats;
+}
+/*---------------------------------------------------------------------------*/
+/* Starts a PKA operation of the pool process, retries later if the PKA is
+ * in use. Must follow a wait until no Paillier operation is running. */
+#define POOL_JOB(...)                                                        \
+  if(!pka_check_status() || (__VA_ARGS__) != PKA_STATUS_SUCCESS) {           \
+    etimer_set(&retry, CLOCK_SECOND / 8);                                    \
+    PROCESS_WAIT_UNTIL(etimer_expired(&retry));                              \
+    continue;                                                                \
+  }                                                                          \
+  pool_job = 1;
+
+#define POOL_JOB_DONE()                                                      \
+  pool_job = 0;                                                              \
+  if(waiting != NULL) {                                                      \
+    process_poll(waiting);                                                   \
+    waiting = NULL;                                                          \
+  }
+
+PROCESS_THREAD(paillier_pool_process, ev, data)
+{
+  static paillier_secrete_state_t *key;
+  static struct etimer retry;
+  static uint32_t rv;
+  static uint8_t epoch;
+  uint8_t result;
+
+  PROCESS_BEGIN();
+
+  while(1) {
+    PROCESS_WAIT_UNTIL(pool.key != NULL && pool.count < PAILLIER_POOL_SIZE);
+    key = pool.key;
+    epoch = pool.epoch;
+
+    /* Generate R in Z_n^*. */
+    if(ctr_drbg_generate(PoolRand, key->NLen * sizeof(uint32_t))
+       != CTR_DRBG_SUCCESS) {
+      etimer_set(&retry, CLOCK_SECOND / 8);
+      PROCESS_WAIT_UNTIL(etimer_expired(&retry));
+      continue;
+    }
+
+    /* r =  r mod n*/
+    PROCESS_WAIT_UNTIL(!foreground);
+    POOL_JOB(PKABigNumModStart(PoolRand, (uint8_t) key->NLen, key->PublicN, (uint8_t) key->NLen, &rv, &paillier_pool_process));
+    PROCESS_WAIT_UNTIL(pka_check_status());
+    memset(PoolRand, 0, sizeof(uint32_t) * cipher_size);
+    result = PKABigNumModGetResult(PoolRand, (uint8_t) key->NLen, rv);
+    POOL_JOB_DONE();
+    if(result != PKA_STATUS_SUCCESS || epoch != pool.epoch) {
+      continue;
+    }
+
+    /* R = R^n mod s */
+    PROCESS_WAIT_UNTIL(!foreground);
+    POOL_JOB(PKABigNumExpModStart(key->PublicN, (uint8_t) key->NLen, key->NSquare, (uint8_t) key->NSLen, PoolRand, (uint8_t) key->NSLen, &rv, &paillier_pool_process));
+    PROCESS_WAIT_UNTIL(pka_check_status());
+    result = PKABigNumExpModGetResult(PoolRand, (uint8_t) key->NSLen, rv);
+    POOL_JOB_DONE();
+
+    if(result == PKA_STATUS_SUCCESS && epoch == pool.epoch
+       && pool.count < PAILLIER_POOL_SIZE) {
+      memcpy(pool.values[pool.count++], PoolRand, sizeof(uint32_t) * cipher_size);
+      pool_stats.filled++;
+      PRINTF("pool: %u values\n", pool.count);
+    }
+    memset(PoolRand, 0, sizeof(uint32_t) * cipher_size);
+  }
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
+#endif /* PAILLIER_POOL_SIZE */
 
 
 PT_THREAD(paillier_gen(paillier_secrete_state_t *state)) {
   PT_BEGIN(&state->pt);
+  PAILLIER_ACQUIRE();
   /* TODO: Generate primes p and q with equivalent length */
 
   /* Compute n= p*q */
@@ -86,121 +257,318 @@ PT_THREAD(paillier_gen(paillier_secrete_state_t *state)) {
   PT_WAIT_UNTIL(&state->pt, pka_check_status());
   CHECK_RESULT(PKABigNumMultGetResult(state->PublicN, &state->NLen,state->rv));
 
-  /* S=1 (tmp use of S) */
-  memset(S, 0, sizeof(uint32_t) * state->PSize);
-  S[0] = 1;  /* represent one */
-
   /* p-1 */
-  CHECK_RESULT(PKABigNumSubtractStart(state->PrimeP, state->PSize, S, state->PSize, &state->rv, state->process));
+  state->PExpLen = key_size;
+  CHECK_RESULT(PKABigNumSubtractStart(state->PrimeP, state->PSize, One, 1, &state->rv, state->process));
   PT_WAIT_UNTIL(&state->pt, pka_check_status());
-  CHECK_RESULT(PKABigNumSubtractGetResult(state->PrimeP, &state->PSize, state->rv));
+  CHECK_RESULT(PKABigNumSubtractGetResult(state->PExp, &state->PExpLen, state->rv));
 
   /* q-1 */
-  CHECK_RESULT(PKABigNumSubtractStart(state->PrimeQ, state->QSize, S, state->QSize, &state->rv, state->process));
+  state->QExpLen = key_size;
+  CHECK_RESULT(PKABigNumSubtractStart(state->PrimeQ, state->QSize, One, 1, &state->rv, state->process));
   PT_WAIT_UNTIL(&state->pt, pka_check_status());
-  CHECK_RESULT(PKABigNumSubtractGetResult(state->PrimeQ, &state->QSize, state->rv));
+  CHECK_RESULT(PKABigNumSubtractGetResult(state->QExp, &state->QExpLen, state->rv));
 
   /* L = (q-1)*(p-1), coz we use |q| = |p|*/
-  CHECK_RESULT(PKABigNumMultiplyStart(state->PrimeQ,state->QSize,state->PrimeP,state->PSize,&state->rv,state->process));
+  CHECK_RESULT(PKABigNumMultiplyStart(state->QExp, state->QExpLen, state->PExp, state->PExpLen, &state->rv, state->process));
   PT_WAIT_UNTIL(&state->pt, pka_check_status());
   CHECK_RESULT(PKABigNumMultGetResult(state->PrviateL,&state->LLen,state->rv));
 
+  /* s = n^2 == n * n, modulus of all cipher-text operations */
+  memset(state->NSquare, 0, sizeof(uint32_t) * cipher_size);
+  state->NSLen = cipher_size;
+  CHECK_RESULT(PKABigNumMultiplyStart(state->PublicN, (uint8_t) state->NLen, state->PublicN, (uint8_t) state->NLen, &state->rv, state->process));
+  PT_WAIT_UNTIL(&state->pt, pka_check_status());
+  CHECK_RESULT(PKABigNumMultGetResult(state->NSquare, &state->NSLen, state->rv));
+  PRINTF("%d: %lu\n", __LINE__, state->NSLen);
+
+  /* g = n + 1, padded with zeros to |n^2| */
+  memset(state->G, 0, sizeof(uint32_t) * cipher_size);
+  RSize = cipher_size;
+  CHECK_RESULT(PKABigNumAddStart(state->PublicN, (uint8_t) state->NLen, One, 1, &state->rv, state->process));
+  PT_WAIT_UNTIL(&state->pt, pka_check_status());
+  CHECK_RESULT(PKABigNumAddGetResult(state->G, &RSize, state->rv));
+
+  /* Since we use |q| = |p| => g = n + 1 and u = L^-1 mod n */
+  memset(state->PrivateU, 0, sizeof(uint32_t) * plain_size);
+  state->ULen = state->NLen;
+  CHECK_RESULT(PKABigNumInvModStart(state->PrviateL, state->LLen, state->PublicN, state->NLen, &state->rv, state->process));
+  PT_WAIT_UNTIL(&state->pt, pka_check_status());
+  CHECK_RESULT(PKABigNumInvModGetResult(state->PrivateU, state->ULen, state->rv));
+  PRINTF("%d: %lu\n", __LINE__, state->ULen);
+
+  /* g = n + 1 allows encryption without g^m mod s, see paillier_enc() */
+  state->FastG = 1;
+
+  /* CRT decryption: with g = n+1, L_p(g^(p-1) mod p^2) = -q mod p, so
+   * hp = -q^-1 mod p and CrtP = q * (-(q^2)^-1 mod p) is hp mod p and 0 mod q */
+  /* p^2 */
+  state->PSqLen = plain_size;
+  CHECK_RESULT(PKABigNumMultiplyStart(state->PrimeP, state->PSize, state->PrimeP, state->PSize, &state->rv, state->process));
+  PT_WAIT_UNTIL(&state->pt, pka_check_status());
+  CHECK_RESULT(PKABigNumMultGetResult(state->PSquare, &state->PSqLen, state->rv));
+
+  /* q^2 */
+  state->QSqLen = plain_size;
+  CHECK_RESULT(PKABigNumMultiplyStart(state->PrimeQ, state->QSize, state->PrimeQ, state->QSize, &state->rv, state->process));
+  PT_WAIT_UNTIL(&state->pt, pka_check_status());
+  CHECK_RESULT(PKABigNumMultGetResult(state->QSquare, &state->QSqLen, state->rv));
+
+  /* R = q^2 mod p */
+  CHECK_RESULT(PKABigNumModStart(state->QSquare, state->QSqLen, state->PrimeP, state->PSize, &state->rv, state->process));
+  PT_WAIT_UNTIL(&state->pt, pka_check_status());
+  memset(Rand, 0, sizeof(uint32_t) * cipher_size);
+  CHECK_RESULT(PKABigNumModGetResult(Rand, state->PSize, state->rv));
 
+  /* R = R^-1 mod p */
+  CHECK_RESULT(PKABigNumInvModStart(Rand, state->PSize, state->PrimeP, state->PSize, &state->rv, state->process));
+  PT_WAIT_UNTIL(&state->pt, pka_check_status());
+  memset(Rand, 0, sizeof(uint32_t) * cipher_size);
+  CHECK_RESULT(PKABigNumInvModGetResult(Rand, state->PSize, state->rv));
+
+  /* R = p - R */
+  RSize = cipher_size;
+  CHECK_RESULT(PKABigNumSubtractStart(state->PrimeP, state->PSize, Rand, state->PSize, &state->rv, state->process));
+  PT_WAIT_UNTIL(&state->pt, pka_check_status());
+  CHECK_RESULT(PKABigNumSubtractGetResult(Rand, &RSize, state->rv));
+
+  /* CrtP = R * q */
+  state->CrtPLen = plain_size;
+  CHECK_RESULT(PKABigNumMultiplyStart(Rand, RSize, state->PrimeQ, state->QSize, &state->rv, state->process));
+  PT_WAIT_UNTIL(&state->pt, pka_check_status());
+  CHECK_RESULT(PKABigNumMultGetResult(state->CrtP, &state->CrtPLen, state->rv));
+
+  /* R = p^2 mod q */
+  CHECK_RESULT(PKABigNumModStart(state->PSquare, state->PSqLen, state->PrimeQ, state->QSize, &state->rv, state->process));
+  PT_WAIT_UNTIL(&state->pt, pka_check_status());
+  memset(Rand, 0, sizeof(uint32_t) * cipher_size);
+  CHECK_RESULT(PKABigNumModGetResult(Rand, state->QSize, state->rv));
+
+  /* R = R^-1 mod q */
+  CHECK_RESULT(PKABigNumInvModStart(Rand, state->QSize, state->PrimeQ, state->QSize, &state->rv, state->process));
+  PT_WAIT_UNTIL(&state->pt, pka_check_status());
+  memset(Rand, 0, sizeof(uint32_t) * cipher_size);
+  CHECK_RESULT(PKABigNumInvModGetResult(Rand, state->QSize, state->rv));
+
+  /* R = q - R */
+  RSize = cipher_size;
+  CHECK_RESULT(PKABigNumSubtractStart(state->PrimeQ, state->QSize, Rand, state->QSize, &state->rv, state->process));
+  PT_WAIT_UNTIL(&state->pt, pka_check_status());
+  CHECK_RESULT(PKABigNumSubtractGetResult(Rand, &RSize, state->rv));
+
+  /* CrtQ = R * p */
+  state->CrtQLen = plain_size;
+  CHECK_RESULT(PKABigNumMultiplyStart(Rand, RSize, state->PrimeP, state->PSize, &state->rv, state->process));
+  PT_WAIT_UNTIL(&state->pt, pka_check_status());
+  CHECK_RESULT(PKABigNumMultGetResult(state->CrtQ, &state->CrtQLen, state->rv));
+  memset(Rand, 0, sizeof(uint32_t) * cipher_size);
+
+  state->Crt = 1;
+
+#if PAILLIER_POOL_SIZE
+  /* precomputed values of the previous key are useless */
+  if(pool.key == state) {
+    pool_flush();
+  }
+#endif /* PAILLIER_POOL_SIZE */
+
+  PAILLIER_RELEASE();
   PT_END(&state->pt);
 }
 
 PT_THREAD(paillier_enc(paillier_secrete_state_t *state)) {
   PT_BEGIN(&state->pt);
 
-  int i;
+  PAILLIER_ACQUIRE();
+
   /*  m (message) is represented as a padded element of Z_n. */
 
+  /* The random number is drawn before the PKA RAM is locked, other PKA
+   * users are not kept out while the DRBG is busy */
+#if PAILLIER_POOL_SIZE
+  /* R = r^n mod s precomputed by the pool process */
+  RSize = state->NSLen;
+  RPooled = pool_take(state, Rand);
+  if(!RPooled) {
+#endif /* PAILLIER_POOL_SIZE */
+
   /* Generate R in Z_n^*. */
   RSize = state->NLen;
-  for (i = 0; i < RSize; ++i) {
-     Rand[i] = (uint32_t)random_rand() | (uint32_t)random_rand() << 16;
+  CTR_DRBG_WAIT_GENERATE(&state->pt, state->process, state->result, Rand, RSize * sizeof(uint32_t));
+  CHECK_RESULT(state->result ? PKA_STATUS_FAILURE : PKA_STATUS_SUCCESS);
+
+#if PAILLIER_POOL_SIZE
   }
+#endif /* PAILLIER_POOL_SIZE */
+
+  /* n and n^2 stay in the PKA RAM, the intermediate results of c are
+   * chained from one operation into the next */
+  PKA_WAIT_LOCK(&state->pt, state->process);
+  CHECK_RESULT(PKABigNumPin(state->PublicN, (uint8_t) state->NLen, &state->NVector));
+  CHECK_RESULT(PKABigNumPin(state->NSquare, (uint8_t) state->NSLen, &state->NSVector));
+
+#if PAILLIER_POOL_SIZE
+  if(!RPooled) {
+#endif /* PAILLIER_POOL_SIZE */
 
   /* r =  r mod n*/
-  CHECK_RESULT(PKABigNumModStart(Rand, (uint8_t)RSize, state->PublicN, (uint8_t) state->NLen, &state->rv,state->process));
+  CHECK_RESULT(PKABigNumModStart(Rand, (uint8_t)RSize, PKA_VECTOR(state->NVector), (uint8_t) state->NLen, &state->rv,state->process));
   PT_WAIT_UNTIL(&state->pt, pka_check_status());
+  memset(Rand, 0, sizeof(uint32_t) * cipher_size); /* |r| may be < |n|, the upper words must be zero */
   CHECK_RESULT(PKABigNumModGetResult(Rand, RSize, state->rv));
   PRINTF("%d: %lu\n", __LINE__, RSize);
 
-  /* Compute c = (g^m)(r^n) mod n^2. */
-  /* s=1 (tmp use of s) */
-  memset(S, 0, sizeof(uint32_t) * plain_size);
-  S[0] = 1;  /* represent one */
-
-  /* g = n + 1 */
-  CHECK_RESULT(PKABigNumAddStart(state->PublicN, (uint8_t) state->NLen, S, (uint8_t) state->NLen, &state->rv, state->process));
-  PT_WAIT_UNTIL(&state->pt, pka_check_status());
-  CHECK_RESULT(PKABigNumAddGetResult(G, &GSize, state->rv));
-  PRINTF("%d: %lu\n", __LINE__, GSize);
-
-  /* s =  n^2 == n * n*/
-  CHECK_RESULT(PKABigNumMultiplyStart(state->PublicN, (uint8_t) state->NLen, state->PublicN, (uint8_t) state->NLen, &state->rv, state->process));
-  PT_WAIT_UNTIL(&state->pt, pka_check_status());
-  CHECK_RESULT(PKABigNumMultGetResult(S, &SSize, state->rv));
-  PRINTF("%d: %lu\n", __LINE__, SSize);
-
-  GSize = cipher_size;   /* g should be as large as S*/
-  /* c = g^m mod s   */
-  CHECK_RESULT(PKABigNumExpModStart(state->PlainText, (uint8_t) state->PTLen, S, (uint8_t)SSize, G, (uint8_t) GSize, &state->rv, state->process));
-  PT_WAIT_UNTIL(&state->pt, pka_check_status());
-  CHECK_RESULT(PKABigNumExpModGetResult(state->CipherText, state->CTLen, state->rv));
-  PRINTF("%d: %lu\n", __LINE__, state->CTLen);
-
-  RSize=cipher_size; /*increase the size to cipher size, so that |S|==|Rand| */
+  RSize = state->NSLen; /*increase the size to |n^2|, so that |S|==|Rand| */
   /* R = R^n mod s   */
-  CHECK_RESULT(PKABigNumExpModStart(state->PublicN, (uint8_t) state->NLen, S, SSize, Rand, (uint8_t) RSize, &state->rv, state->process));
+  CHECK_RESULT(PKABigNumExpModStart(PKA_VECTOR(state->NVector), (uint8_t) state->NLen, PKA_VECTOR(state->NSVector), (uint8_t) state->NSLen, Rand, (uint8_t) RSize, &state->rv, state->process));
   PT_WAIT_UNTIL(&state->pt, pka_check_status());
   CHECK_RESULT(PKABigNumExpModGetResult(Rand, RSize, state->rv));
   PRINTF("%d: %lu\n", __LINE__, RSize);
 
+#if PAILLIER_POOL_SIZE
+  }
+#endif /* PAILLIER_POOL_SIZE */
+
+  /* Compute c = (g^m)(r^n) mod n^2, c stays in the PKA RAM. */
+  if(state->FastG) {
+    /* g = n+1 => g^m = 1 + m*n mod s, reduced together with c * R below */
+    /* c = m * n */
+    CHECK_RESULT(PKABigNumMultiplyStart(state->PlainText, (uint8_t) state->PTLen, PKA_VECTOR(state->NVector), (uint8_t) state->NLen, &state->rv, state->process));
+    PT_WAIT_UNTIL(&state->pt, pka_check_status());
+    state->CTLen = state->PTLen + state->NLen;
+
+    /* c = c + 1 */
+    CHECK_RESULT(PKABigNumAddStart(PKA_VECTOR(state->rv), (uint8_t) state->CTLen, One, 1, &state->rv, state->process));
+    PT_WAIT_UNTIL(&state->pt, pka_check_status());
+    /* m < n: 1 + m*n < n^2 fits into |n^2| words */
+    state->CTLen = state->CTLen < state->NSLen ? state->CTLen + 1 : state->NSLen;
+  } else {
+    /* c = g^m mod s   */
+    CHECK_RESULT(PKABigNumExpModStart(state->PlainText, (uint8_t) state->PTLen, PKA_VECTOR(state->NSVector), (uint8_t) state->NSLen, state->G, (uint8_t) state->NSLen, &state->rv, state->process));
+    PT_WAIT_UNTIL(&state->pt, pka_check_status());
+    state->CTLen = state->NSLen;
+  }
+  PRINTF("%d: %lu\n", __LINE__, state->CTLen);
+
   /* c = c * R */
-  CHECK_RESULT(PKABigNumMultiplyStart(state->CipherText, (uint8_t) state->CTLen, Rand, (uint8_t)RSize, &state->rv,state->process));
+  CHECK_RESULT(PKABigNumMultiplyStart(PKA_VECTOR(state->rv), (uint8_t) state->CTLen, Rand, (uint8_t)RSize, &state->rv,state->process));
   PT_WAIT_UNTIL(&state->pt, pka_check_status());
-  state->CTLen=cipher_size*2; /* *2: additional space to hold the result */
-  CHECK_RESULT(PKABigNumMultGetResult(state->CipherText, &state->CTLen, state->rv));
-  PRINTF("%d: %lu\n", __LINE__, state->CTLen);
+  state->CTLen += RSize;
 
   /* c = c mod s */
-  CHECK_RESULT(PKABigNumModStart(state->CipherText, (uint8_t) state->CTLen, S, (uint8_t) SSize, &state->rv,state->process));
+  CHECK_RESULT(PKABigNumModStart(PKA_VECTOR(state->rv), (uint8_t) state->CTLen, PKA_VECTOR(state->NSVector), (uint8_t) state->NSLen, &state->rv,state->process));
   PT_WAIT_UNTIL(&state->pt, pka_check_status());
-  CHECK_RESULT(PKABigNumModGetResult(state->CipherText, state->CTLen, state->rv));
+  memset(state->CipherText, 0, sizeof(uint32_t) * cipher_size * 2);
+  CHECK_RESULT(PKABigNumModGetResult(state->CipherText, cipher_size, state->rv));
   state->CTLen = cipher_size;
   PRINTF("%d: %lu\n", __LINE__, state->CTLen);
 
+  PKABigNumUnlock();
+  PAILLIER_RELEASE();
   PT_END(&state->pt);
 }
 
 
 PT_THREAD(paillier_dec(paillier_secrete_state_t *state)) {
   PT_BEGIN(&state->pt);
+  PAILLIER_ACQUIRE();
+
+  if(state->Crt) {
+    /* m = (L_p(c^(p-1) mod p^2) * CrtP + L_q(c^(q-1) mod q^2) * CrtQ) mod n,
+     * where L_p(x) = (x-1)/p and L_q(x) = (x-1)/q, see paillier_gen() */
+
+    /* R = c mod p^2 */
+    CHECK_RESULT(PKABigNumModStart(state->CipherText, cipher_size, state->PSquare, state->PSqLen, &state->rv, state->process));
+    PT_WAIT_UNTIL(&state->pt, pka_check_status());
+    memset(Rand, 0, sizeof(uint32_t) * cipher_size);
+    CHECK_RESULT(PKABigNumModGetResult(Rand, state->PSqLen, state->rv));
+
+    /* R = R^(p-1) mod p^2 */
+    CHECK_RESULT(PKABigNumExpModStart(state->PExp, state->PExpLen, state->PSquare, state->PSqLen, Rand, state->PSqLen, &state->rv, state->process));
+    PT_WAIT_UNTIL(&state->pt, pka_check_status());
+    memset(Rand, 0, sizeof(uint32_t) * cipher_size);
+    CHECK_RESULT(PKABigNumExpModGetResult(Rand, state->PSqLen, state->rv));
+
+    /* R = R - 1 */
+    RSize = cipher_size;
+    CHECK_RESULT(PKABigNumSubtractStart(Rand, state->PSqLen, One, 1, &state->rv, state->process));
+    PT_WAIT_UNTIL(&state->pt, pka_check_status());
+    CHECK_RESULT(PKABigNumSubtractGetResult(Rand, &RSize, state->rv));
+
+    /* R = R / p */
+    CHECK_RESULT(PKABigNumDivideStart(Rand, RSize, state->PrimeP, state->PSize, &state->rv, state->process));
+    PT_WAIT_UNTIL(&state->pt, pka_check_status());
+    RSize = cipher_size;
+    CHECK_RESULT(PKABigNumDivideGetResult(Rand, &RSize, state->rv));
+
+    /* c' = R * CrtP */
+    CHECK_RESULT(PKABigNumMultiplyStart(Rand, RSize, state->CrtP, state->CrtPLen, &state->rv, state->process));
+    PT_WAIT_UNTIL(&state->pt, pka_check_status());
+    CrtSize = cipher_size;
+    CHECK_RESULT(PKABigNumMultGetResult(CrtSum, &CrtSize, state->rv));
+
+    /* R = c mod q^2 */
+    CHECK_RESULT(PKABigNumModStart(state->CipherText, cipher_size, state->QSquare, state->QSqLen, &state->rv, state->process));
+    PT_WAIT_UNTIL(&state->pt, pka_check_status());
+    memset(Rand, 0, sizeof(uint32_t) * cipher_size);
+    CHECK_RESULT(PKABigNumModGetResult(Rand, state->QSqLen, state->rv));
+
+    /* R = R^(q-1) mod q^2 */
+    CHECK_RESULT(PKABigNumExpModStart(state->QExp, state->QExpLen, state->QSquare, state->QSqLen, Rand, state->QSqLen, &state->rv, state->process));
+    PT_WAIT_UNTIL(&state->pt, pka_check_status());
+    memset(Rand, 0, sizeof(uint32_t) * cipher_size);
+    CHECK_RESULT(PKABigNumExpModGetResult(Rand, state->QSqLen, state->rv));
+
+    /* R = R - 1 */
+    RSize = cipher_size;
+    CHECK_RESULT(PKABigNumSubtractStart(Rand, state->QSqLen, One, 1, &state->rv, state->process));
+    PT_WAIT_UNTIL(&state->pt, pka_check_status());
+    CHECK_RESULT(PKABigNumSubtractGetResult(Rand, &RSize, state->rv));
+
+    /* R = R / q */
+    CHECK_RESULT(PKABigNumDivideStart(Rand, RSize, state->PrimeQ, state->QSize, &state->rv, state->process));
+    PT_WAIT_UNTIL(&state->pt, pka_check_status());
+    RSize = cipher_size;
+    CHECK_RESULT(PKABigNumDivideGetResult(Rand, &RSize, state->rv));
+
+    /* R = R * CrtQ */
+    CHECK_RESULT(PKABigNumMultiplyStart(Rand, RSize, state->CrtQ, state->CrtQLen, &state->rv, state->process));
+    PT_WAIT_UNTIL(&state->pt, pka_check_status());
+    RSize = cipher_size;
+    CHECK_RESULT(PKABigNumMultGetResult(Rand, &RSize, state->rv));
+
+    /* c' = c' + R */
+    CHECK_RESULT(PKABigNumAddStart(CrtSum, CrtSize, Rand, RSize, &state->rv, state->process));
+    PT_WAIT_UNTIL(&state->pt, pka_check_status());
+    CrtSize = cipher_size;
+    CHECK_RESULT(PKABigNumAddGetResult(CrtSum, &CrtSize, state->rv));
+
+    /* m = c' mod n */
+    CHECK_RESULT(PKABigNumModStart(CrtSum, CrtSize, state->PublicN, state->NLen, &state->rv, state->process));
+    PT_WAIT_UNTIL(&state->pt, pka_check_status());
+    memset(state->PlainText, 0, sizeof(uint32_t) * plain_size);
+    CHECK_RESULT(PKABigNumModGetResult(state->PlainText, state->PTLen, state->rv));
+    PRINTF("%d: %lu\n", __LINE__, state->PTLen);
+
+    memset(Rand, 0, sizeof(uint32_t) * cipher_size);
+    memset(CrtSum, 0, sizeof(uint32_t) * cipher_size);
+    PAILLIER_RELEASE();
+    PT_EXIT(&state->pt);
+  }
 
   /* Compute L(c^l mod n^2) * u mod n, where L(x) = (x-1)/L, and u = L(g^l mod n^2)^-1 */
-  /* Since we use |q| = |p| => g = n + 1 and u = L^-1 mod n */
-  /* s =  n^2 == n * n*/
-  SSize = cipher_size;
-  CHECK_RESULT(PKABigNumMultiplyStart(state->PublicN,state->NLen,state->PublicN,state->NLen,&state->rv,state->process));
-  PT_WAIT_UNTIL(&state->pt, pka_check_status());
-  CHECK_RESULT(PKABigNumMultGetResult(S, &SSize, state->rv));
-  PRINTF("%d: %lu\n", __LINE__, SSize);
+  /* n^2 and u = L^-1 mod n are part of the key context, see paillier_gen() */
 
   /* c = c^l mod s INFO: state->CipherText has a length of 2*cipher_size, however in ExpMod |Base|=|Mode| */
-  CHECK_RESULT(PKABigNumExpModStart(state->PrviateL, state->LLen, S, SSize, state->CipherText, cipher_size, &state->rv,state->process));
+  CHECK_RESULT(PKABigNumExpModStart(state->PrviateL, state->LLen, state->NSquare, state->NSLen, state->CipherText, cipher_size, &state->rv,state->process));
   PT_WAIT_UNTIL(&state->pt, pka_check_status());
+  memset(state->CipherText, 0, sizeof(uint32_t) * cipher_size * 2);
   CHECK_RESULT(PKABigNumExpModGetResult(state->CipherText, state->CTLen, state->rv));
   PRINTF("%d: %lu\n", __LINE__, state->CTLen);
   //state->CTLen = SSize;
 
-  /* g=1  using G temp for representation of 1 */
-  memset(G, 0, sizeof(uint32_t) * cipher_size);
-  G[0] = 1;
-
   /*c = c - 1 */
-  CHECK_RESULT(PKABigNumSubtractStart(state->CipherText,  cipher_size, G, cipher_size, &state->rv, state->process));
+  CHECK_RESULT(PKABigNumSubtractStart(state->CipherText,  cipher_size, One, 1, &state->rv, state->process));
   PT_WAIT_UNTIL(&state->pt, pka_check_status());
   CHECK_RESULT(PKABigNumSubtractGetResult(state->CipherText, &state->CTLen, state->rv));
   PRINTF("%d: %lu\n", __LINE__, state->CTLen);
@@ -211,15 +579,8 @@ PT_THREAD(paillier_dec(paillier_secrete_state_t *state)) {
   CHECK_RESULT(PKABigNumDivideGetResult(state->CipherText, &state->CTLen, state->rv));
   PRINTF("%d: %lu\n", __LINE__, state->CTLen);
 
-  /* u = l^-1 mod n*/
-  CHECK_RESULT(PKABigNumInvModStart(state->PrviateL, state->LLen, state->PublicN, state->NLen, &state->rv, state->process));
-  PT_WAIT_UNTIL(&state->pt, pka_check_status());
-  /* U will be tmp stored in plaintext, the size will be always <= plain_size; */
-  CHECK_RESULT(PKABigNumInvModGetResult(state->PlainText, state->PTLen, state->rv));
-  PRINTF("%d: %lu\n", __LINE__, state->PTLen);
-
   /* c = c * u */
-  CHECK_RESULT(PKABigNumMultiplyStart(state->CipherText, state->CTLen, state->PlainText, state->PTLen, &state->rv,state->process));
+  CHECK_RESULT(PKABigNumMultiplyStart(state->CipherText, state->CTLen, state->PrivateU, state->ULen, &state->rv,state->process));
   PT_WAIT_UNTIL(&state->pt, pka_check_status());
   state->CTLen=cipher_size*2; /* *2: additional space to hold the result*/
   CHECK_RESULT(PKABigNumMultGetResult(state->CipherText, &state->CTLen, state->rv));
@@ -228,22 +589,20 @@ PT_THREAD(paillier_dec(paillier_secrete_state_t *state)) {
   /* m = c mod n */
   CHECK_RESULT(PKABigNumModStart(state->CipherText, state->CTLen, state->PublicN, state->NLen, &state->rv,state->process));
   PT_WAIT_UNTIL(&state->pt, pka_check_status());
+  memset(state->PlainText, 0, sizeof(uint32_t) * plain_size);
   CHECK_RESULT(PKABigNumModGetResult(state->PlainText, state->PTLen, state->rv));
   PRINTF("%d: %lu\n", __LINE__, state->PTLen);
 
+  PAILLIER_RELEASE();
   PT_END(&state->pt);
 }
 
 
 PT_THREAD(paillier_add(paillier_secrete_state_t *state)) {
   PT_BEGIN(&state->pt);
+  PAILLIER_ACQUIRE();
 
-  /* plain + plain mod n = cipher * cipher mod s */
-  /* s =  n^2 == n * n*/
-  CHECK_RESULT(PKABigNumMultiplyStart(state->PublicN, (uint8_t) state->NLen, state->PublicN, (uint8_t) state->NLen, &state->rv, state->process));
-  PT_WAIT_UNTIL(&state->pt, pka_check_status());
-  CHECK_RESULT(PKABigNumMultGetResult(S, &SSize, state->rv));
-  PRINTF("%d: %lu\n", __LINE__, SSize);
+  /* plain + plain mod n = cipher * cipher mod s, with s = n^2 */
 
   /* cipher * cipher  */
   CHECK_RESULT(PKABigNumMultiplyStart(state->CipherText, cipher_size, state->CipherText, cipher_size, &state->rv, state->process));
@@ -253,11 +612,155 @@ PT_THREAD(paillier_add(paillier_secrete_state_t *state)) {
   PRINTF("%d: %lu\n", __LINE__, state->CTLen);
 
   /* cipher * cipher mod s */
-  CHECK_RESULT(PKABigNumModStart(state->CipherText, (uint8_t) state->CTLen, S, (uint8_t) SSize, &state->rv,state->process));
+  CHECK_RESULT(PKABigNumModStart(state->CipherText, (uint8_t) state->CTLen, state->NSquare, (uint8_t) state->NSLen, &state->rv,state->process));
   PT_WAIT_UNTIL(&state->pt, pka_check_status());
+  memset(state->CipherText, 0, sizeof(uint32_t) * cipher_size * 2);
   CHECK_RESULT(PKABigNumModGetResult(state->CipherText, state->CTLen, state->rv));
   state->CTLen = cipher_size;
   PRINTF("%d: %lu\n", __LINE__, state->CTLen);
 
+  PAILLIER_RELEASE();
+  PT_END(&state->pt);
+}
+
+
+void paillier_agg_init(paillier_agg_t *agg) {
+  memset(agg->Acc, 0, sizeof(uint32_t) * cipher_size * 2);
+  agg->Acc[0] = 1; /* 1 = (1+n)^0 * 1^n mod s */
+  agg->AccLen = 1;
+  agg->Count = 0;
+  agg->Limit = 0;
+}
+
+
+PT_THREAD(paillier_agg_add(paillier_secrete_state_t *state, paillier_agg_t *agg, uint8_t scaled)) {
+  PT_BEGIN(&state->pt);
+
+  /* packed slots must not carry into each other */
+  if(agg->Limit && (scaled || agg->Count >= agg->Limit)) {
+    state->result = PKA_STATUS_INVALID_PARAM;
+    PT_EXIT(&state->pt);
+  }
+
+  PAILLIER_ACQUIRE();
+
+  /* Enc(m) * Enc(m') mod s = Enc(m + m'), Enc(m)^k mod s = Enc(k*m) */
+
+  if(scaled) {
+    /* R = c^k mod s */
+    CHECK_RESULT(PKABigNumExpModStart(state->PlainText, (uint8_t) state->PTLen, state->NSquare, (uint8_t) state->NSLen, state->CipherText, (uint8_t) state->NSLen, &state->rv, state->process));
+    PT_WAIT_UNTIL(&state->pt, pka_check_status());
+    memset(Rand, 0, sizeof(uint32_t) * cipher_size);
+    CHECK_RESULT(PKABigNumExpModGetResult(Rand, state->NSLen, state->rv));
+  }
+
+  /* acc = acc * c, respectively acc * R */
+  CHECK_RESULT(PKABigNumMultiplyStart(agg->Acc, (uint8_t) agg->AccLen, scaled ? Rand : state->CipherText, (uint8_t) state->NSLen, &state->rv, state->process));
+  PT_WAIT_UNTIL(&state->pt, pka_check_status());
+  agg->AccLen = cipher_size * 2;
+  CHECK_RESULT(PKABigNumMultGetResult(agg->Acc, &agg->AccLen, state->rv));
+  PRINTF("%d: %lu\n", __LINE__, agg->AccLen);
+
+  /* acc = acc mod s, the product is too long to be multiplied again */
+  CHECK_RESULT(PKABigNumModStart(agg->Acc, (uint8_t) agg->AccLen, state->NSquare, (uint8_t) state->NSLen, &state->rv, state->process));
+  PT_WAIT_UNTIL(&state->pt, pka_check_status());
+  memset(agg->Acc, 0, sizeof(uint32_t) * cipher_size * 2);
+  CHECK_RESULT(PKABigNumModGetResult(agg->Acc, state->NSLen, state->rv));
+  agg->AccLen = state->NSLen;
+  agg->Count++;
+
+  PAILLIER_RELEASE();
   PT_END(&state->pt);
 }
+
+
+PT_THREAD(paillier_agg_finish(paillier_secrete_state_t *state, paillier_agg_t *agg)) {
+  PT_BEGIN(&state->pt);
+  PAILLIER_ACQUIRE();
+
+  memset(state->CipherText, 0, sizeof(uint32_t) * cipher_size * 2);
+  memcpy(state->CipherText, agg->Acc, sizeof(uint32_t) * agg->AccLen);
+  state->CTLen = cipher_size;
+  state->result = PKA_STATUS_SUCCESS;
+
+  PAILLIER_RELEASE();
+  PT_END(&state->pt);
+}
+
+
+uint8_t paillier_pack_init(paillier_pack_t *pack, const paillier_secrete_state_t *state,
+                           uint8_t value_bits, uint32_t max_sums) {
+  uint32_t bits;
+  uint8_t headroom;
+  int i;
+
+  /* sum of max_sums readings < max_sums * 2^value_bits <= 2^(value_bits + headroom) */
+  for(headroom = 0; headroom < 32 && (1UL << headroom) < max_sums; headroom++);
+  if(value_bits == 0 || value_bits > 32 || value_bits + headroom > 64) {
+    return PKA_STATUS_INVALID_PARAM;
+  }
+
+  /* bits below the top bit of n */
+  for(i = state->NLen - 1; i > 0 && state->PublicN[i] == 0; i--);
+  for(bits = 32 * i; bits < 32 * (i + 1) && (state->PublicN[i] >> (bits - 32 * i)); bits++);
+
+  pack->ValueBits = value_bits;
+  pack->SlotBits = value_bits + headroom;
+  pack->Slots = bits ? (bits - 1) / pack->SlotBits : 0;
+  pack->MaxSums = max_sums ? max_sums : 1;
+  return pack->Slots ? PKA_STATUS_SUCCESS : PKA_STATUS_INVALID_PARAM;
+}
+
+
+uint8_t paillier_pack(const paillier_pack_t *pack, paillier_secrete_state_t *state,
+                      const uint32_t *values, uint32_t count) {
+  uint32_t bit, i;
+
+  if(count > pack->Slots) {
+    return PKA_STATUS_INVALID_PARAM;
+  }
+
+  memset(state->PlainText, 0, sizeof(uint32_t) * plain_size);
+  for(i = 0; i < count; i++) {
+    if(pack->ValueBits < 32 && (values[i] >> pack->ValueBits)) {
+      return PKA_STATUS_INVALID_PARAM;
+    }
+    /* a reading spans at most two words */
+    bit = i * pack->SlotBits;
+    state->PlainText[bit / 32] |= values[i] << (bit % 32);
+    if(bit % 32) {
+      state->PlainText[bit / 32 + 1] |= values[i] >> (32 - bit % 32);
+    }
+  }
+  state->PTLen = count ? (count * pack->SlotBits + 31) / 32 : 1;
+  return PKA_STATUS_SUCCESS;
+}
+
+
+void paillier_unpack(const paillier_pack_t *pack, const paillier_secrete_state_t *state,
+                     uint64_t *sums, uint32_t count) {
+  uint32_t bit, word, i, j;
+  uint32_t w[3];
+
+  for(i = 0; i < count; i++) {
+    /* a slot spans at most three words */
+    bit = i * pack->SlotBits;
+    word = bit / 32;
+    for(j = 0; j < 3; j++) {
+      w[j] = word + j < state->PTLen ? state->PlainText[word + j] : 0;
+    }
+    sums[i] = (w[0] | (uint64_t)w[1] << 32) >> (bit % 32);
+    if(bit % 32) {
+      sums[i] |= (uint64_t)w[2] << (64 - bit % 32);
+    }
+    if(pack->SlotBits < 64) {
+      sums[i] &= (1ULL << pack->SlotBits) - 1;
+    }
+  }
+}
+
+
+void paillier_pack_agg_init(const paillier_pack_t *pack, paillier_agg_t *agg) {
+  paillier_agg_init(agg);
+  agg->Limit = pack->MaxSums;
+}
@@ -42,6 +42,8 @@
 #ifndef PAILLIER_ALGORITHM_H_
 #define PAILLIER_ALGORITHM_H_
 
+#include "pka.h"
+
 /*---------------------------------------------------------------------------*/
 //#define   key_size                   4  /* 4 * 32bit* 2 = 256 bits*/
 //#define   key_size                   8  /* 8 * 32bit* 2 = 512 bits*/
@@ -49,6 +51,13 @@
 #define   plain_size                 2*key_size
 #define   cipher_size                2*plain_size
 
+/* Size of the pool of precomputed r^n mod n^2 values (0 disables the pool) */
+#ifdef PAILLIER_CONF_POOL_SIZE
+#define PAILLIER_POOL_SIZE           PAILLIER_CONF_POOL_SIZE
+#else
+#define PAILLIER_POOL_SIZE           0
+#endif
+
 /* NOTE: Max_Len equals 64 (32-bit) words swrq319c, p504
  * This is equal to 2048 bit or 256 Byte
  * Maximum vector sizes can be optionally extended to 4096 or 8192 bits (with Max_Len equal to 128 respectively 256)
@@ -67,6 +76,8 @@ typedef struct {
   uint32_t    QSize;                 /* size of prime number Q*/
 
   uint32_t    rv;                    /* Address of Next Result in PKA SRAM */
+  uint32_t    NVector;               /* n, resident in PKA SRAM during paillier_enc() */
+  uint32_t    NSVector;              /* n^2, resident in PKA SRAM during paillier_enc() */
 
   /* computed variables */
   uint32_t    PublicN[plain_size];   /* prime n = p*q the public key */
@@ -74,6 +85,29 @@ typedef struct {
   uint32_t    PrviateL[plain_size];  /* private key L=(p-1)*(q-1) */
   uint32_t    LLen;                  /* length of L */
 
+  /* key context, derived once by paillier_gen() and reused by enc/dec/add */
+  uint32_t    NSquare[cipher_size];  /* n^2, modulus of the cipher-text space */
+  uint32_t    NSLen;                 /* length of n^2 */
+  uint32_t    G[cipher_size];        /* generator g = n+1, padded to |n^2| */
+  uint32_t    PrivateU[plain_size];  /* u = L^-1 mod n */
+  uint32_t    ULen;                  /* length of u */
+  uint8_t     FastG;                 /* 1: g = n+1, compute g^m as 1 + m*n (set by paillier_gen) */
+
+  /* CRT decryption context, derived by paillier_gen() */
+  uint8_t     Crt;                   /* 1: decrypt mod p^2 and q^2 (set by paillier_gen) */
+  uint32_t    PExp[key_size];        /* p-1 */
+  uint32_t    PExpLen;               /* length of p-1 */
+  uint32_t    QExp[key_size];        /* q-1 */
+  uint32_t    QExpLen;               /* length of q-1 */
+  uint32_t    PSquare[plain_size];   /* p^2 */
+  uint32_t    PSqLen;                /* length of p^2 */
+  uint32_t    QSquare[plain_size];   /* q^2 */
+  uint32_t    QSqLen;                /* length of q^2 */
+  uint32_t    CrtP[plain_size];      /* hp * (1 mod p, 0 mod q), hp = L_p(g^(p-1) mod p^2)^-1 mod p */
+  uint32_t    CrtPLen;               /* length of CrtP */
+  uint32_t    CrtQ[plain_size];      /* hq * (0 mod p, 1 mod q), hq = L_q(g^(q-1) mod q^2)^-1 mod q */
+  uint32_t    CrtQLen;               /* length of CrtQ */
+
   uint32_t    PlainText[plain_size]; /* plain-text (max input len is 2*keysize)*/
   uint32_t    PTLen;                 /* plain-text length */
 
@@ -83,21 +117,56 @@ typedef struct {
   uint8_t     result;                 /* Result Code */
 } paillier_secrete_state_t;
 
+/* Running product of the homomorphic aggregation */
+typedef struct {
+  uint32_t    Acc[cipher_size*2];     /* product of all ciphertexts, space for the product before modulo */
+  uint32_t    AccLen;                 /* length of the product */
+  uint32_t    Count;                  /* cipher-texts added */
+  uint32_t    Limit;                  /* cipher-texts the slots can take, 0: no limit */
+} paillier_agg_t;
+
+/* Layout of readings packed into one plain-text */
+typedef struct {
+  uint8_t     ValueBits;              /* bits of one reading */
+  uint8_t     SlotBits;               /* bits of a slot, ValueBits plus headroom for the sums */
+  uint32_t    Slots;                  /* readings per plain-text */
+  uint32_t    MaxSums;                /* cipher-texts that can be added without a carry between slots */
+} paillier_pack_t;
+
+/* Counters of the randomness pool */
+typedef struct {
+  uint32_t    filled;                 /* values precomputed by the pool process */
+  uint32_t    drained;                /* values used by paillier_enc() */
+  uint32_t    empty;                  /* encryptions that found the pool empty */
+} paillier_pool_stats_t;
+
 /*---------------------------------------------------------------------------*/
 
 /**
  * \brief Paillier geneate keys
+ *
+ * Computes n and L from the primes p and q and derives the key context
+ * (n^2, g and u) used by all other Paillier operations, as well as the
+ * constants of the CRT decryption. p and q are kept.
  */
 PT_THREAD(paillier_gen(paillier_secrete_state_t *state));
 
 /**
  * \brief Paillier Encrypt
+ *
+ * With the standard generator g = n+1 (FastG set), g^m mod n^2 is computed
+ * as 1 + m*n, i.e. one multiplication and one addition instead of a
+ * modular exponentiation. Clear FastG to force the exponentiation.
  */
 PT_THREAD(paillier_enc(paillier_secrete_state_t *state));
 
 
 /**
  * \brief Paillier decrypt
+ *
+ * With Crt set, m is computed from c^(p-1) mod p^2 and c^(q-1) mod q^2
+ * instead of c^L mod n^2, i.e. two exponentiations with operands of half
+ * the size. Clear Crt to decrypt with c^L mod n^2.
  */
 PT_THREAD(paillier_dec(paillier_secrete_state_t *state));
 
@@ -106,6 +175,101 @@ PT_THREAD(paillier_dec(paillier_secrete_state_t *state));
  */
 PT_THREAD(paillier_add(paillier_secrete_state_t *state));
 
+/**
+ * \brief Starts an aggregation, the aggregate is an encryption of 0
+ */
+void paillier_agg_init(paillier_agg_t *agg);
+
+/**
+ * \brief Adds the cipher-text of \e state to the aggregate
+ *
+ * Multiplies state->CipherText into the running product, i.e. adds its
+ * plain-text. With \e scaled set, state->CipherText is raised to the
+ * plain-text constant k in state->PlainText first (c^k = Enc(k*m)), which
+ * allows weighted sums. The product is reduced mod n^2 after every
+ * cipher-text: the PKA takes operands of at most PKA_MAX_LEN words, which
+ * is one cipher-text, so an unreduced product cannot be multiplied again.
+ */
+PT_THREAD(paillier_agg_add(paillier_secrete_state_t *state, paillier_agg_t *agg, uint8_t scaled));
+
+/**
+ * \brief Stores the aggregate in state->CipherText
+ *
+ * The aggregation may be continued afterwards.
+ */
+PT_THREAD(paillier_agg_finish(paillier_secrete_state_t *state, paillier_agg_t *agg));
+
+/**
+ * \brief Computes the slot layout for readings of \e value_bits bits
+ *
+ * Each slot gets ceil(log2(max_sums)) bits of headroom, so that up to
+ * \e max_sums packed cipher-texts can be added before a slot carries into
+ * the next one. The slots fill the bits below the top bit of n of the key
+ * in \e state, hence every packed plain-text is smaller than n.
+ * \return PKA_STATUS_INVALID_PARAM if a slot exceeds 64 bits or not even one
+ *         slot fits
+ */
+uint8_t paillier_pack_init(paillier_pack_t *pack, const paillier_secrete_state_t *state,
+                           uint8_t value_bits, uint32_t max_sums);
+
+/**
+ * \brief Packs \e count readings into state->PlainText
+ *
+ * Reading i goes into slot i, i.e. bits i*SlotBits and up; the unused
+ * slots are zero.
+ * \return PKA_STATUS_INVALID_PARAM if \e count exceeds the slots or a
+ *         reading exceeds ValueBits
+ */
+uint8_t paillier_pack(const paillier_pack_t *pack, paillier_secrete_state_t *state,
+                      const uint32_t *values, uint32_t count);
+
+/**
+ * \brief Extracts the first \e count slots of state->PlainText
+ *
+ * Applied after paillier_dec(), \e sums receives the per slot sums of all
+ * cipher-texts that were added.
+ */
+void paillier_unpack(const paillier_pack_t *pack, const paillier_secrete_state_t *state,
+                     uint64_t *sums, uint32_t count);
+
+/**
+ * \brief Starts an aggregation of packed cipher-texts
+ *
+ * Like paillier_agg_init(), but paillier_agg_add() fails with
+ * PKA_STATUS_INVALID_PARAM once MaxSums cipher-texts were added, and for
+ * scaled additions, as both would overflow the slots.
+ */
+void paillier_pack_agg_init(const paillier_pack_t *pack, paillier_agg_t *agg);
+
+#if PAILLIER_POOL_SIZE
+/**
+ * \brief Precompute r^n mod n^2 for the key of \e state while the PKA is idle
+ *
+ * Starts the pool process, which keeps up to PAILLIER_POOL_SIZE values
+ * ready. paillier_enc() takes one of them instead of computing r^n mod n^2
+ * and falls back to the full computation if the pool is empty.
+ * \note \e state must stay valid until paillier_pool_stop() is called
+ */
+void paillier_pool_start(paillier_secrete_state_t *state);
+
+/**
+ * \brief Stops the pool process and discards all precomputed values
+ */
+void paillier_pool_stop(void);
+
+/**
+ * \brief Number of precomputed values ready for use
+ */
+uint8_t paillier_pool_count(void);
+
+/**
+ * \brief Fill and drain counters of the pool
+ */
+const paillier_pool_stats_t *paillier_pool_get_stats(void);
+
+PROCESS_NAME(paillier_pool_process);
+#endif /* PAILLIER_POOL_SIZE */
+
 
 #endif /* PAILLIER_ALGORITHM_H_ */
 
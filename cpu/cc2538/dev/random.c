@@ -49,6 +49,7 @@
 #include "dev/soc-adc.h"
 #include "dev/sys-ctrl.h"
 #include "reg.h"
+#include "ctr-drbg.h"
 /*---------------------------------------------------------------------------*/
 /**
  * \brief      Generates a new random number using the cc2538 RNG.
@@ -66,26 +67,10 @@ random_rand(void)
   return ((unsigned short)rv);
 }
 /*---------------------------------------------------------------------------*/
-/**
- * \brief      Seed the cc2538 random number generator.
- * \param seed Ignored. It's here because the function prototype is in core.
- *
- *             We form a seed for the RNG by sampling IF_ADC as
- *             discussed in the user guide.
- *             Seeding with this method should not be done during
- *             normal radio operation. Thus, use this function before
- *             initialising the network.
- *
- * \note       Must not be called after the RF driver has been initialised and is
- *             in normal operation. If it is absolutely necessary to do so, the
- *             radio will need re-initialised.
- */
-void
-random_init(unsigned short seed)
+/* Puts the radio into infinite RX, the IF_ADC then delivers noise */
+static void
+noise_on(void)
 {
-  int i;
-  unsigned short s = 0;
-
   /* Make sure the RNG is on */
   REG(SOC_ADC_ADCCON1) &= ~(SOC_ADC_ADCCON1_RCTRL1 | SOC_ADC_ADCCON1_RCTRL0);
 
@@ -108,6 +93,29 @@ random_init(unsigned short seed)
    * signal to go high."
    */
   while(!(REG(RFCORE_XREG_RSSISTAT) & RFCORE_XREG_RSSISTAT_RSSI_VALID));
+}
+/*---------------------------------------------------------------------------*/
+/**
+ * \brief      Seed the cc2538 random number generator.
+ * \param seed Ignored. It's here because the function prototype is in core.
+ *
+ *             We form a seed for the RNG by sampling IF_ADC as
+ *             discussed in the user guide.
+ *             Seeding with this method should not be done during
+ *             normal radio operation. Thus, use this function before
+ *             initialising the network.
+ *
+ * \note       Must not be called after the RF driver has been initialised and is
+ *             in normal operation. If it is absolutely necessary to do so, the
+ *             radio will need re-initialised.
+ */
+void
+random_init(unsigned short seed)
+{
+  int i;
+  unsigned short s = 0;
+
+  noise_on();
 
   /*
    * Form the seed by concatenating bits from IF_ADC in the RF receive path.
@@ -129,6 +137,36 @@ random_init(unsigned short seed)
   /* RF Off. NETSTACK_RADIO.init() will sort out normal RF operation */
   CC2538_RF_CSP_ISRFOFF();
 }
+/*---------------------------------------------------------------------------*/
+/**
+ * \brief      Entropy source of the CTR-DRBG: IF_ADC noise bits.
+ *
+ *             Pairs of noise bits are debiased (von Neumann), a pair of
+ *             unequal bits yields the first one.
+ *
+ * \note       The same restrictions as for random_init() apply.
+ */
+void
+ctr_drbg_entropy(uint8_t *buf, uint16_t len)
+{
+  uint8_t a, b, bits;
+
+  noise_on();
+
+  while(len--) {
+    for(bits = 0; bits < 8;) {
+      a = !!(REG(RFCORE_XREG_RFRND) & RFCORE_XREG_RFRND_IRND);
+      b = !!(REG(RFCORE_XREG_RFRND) & RFCORE_XREG_RFRND_IRND);
+      if(a != b) {
+        *buf = *buf << 1 | a;
+        bits++;
+      }
+    }
+    buf++;
+  }
+
+  CC2538_RF_CSP_ISRFOFF();
+}
 
 /**
  * @}
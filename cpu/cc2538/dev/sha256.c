@@ -44,6 +44,7 @@
 #include "contiki.h"
 #include "dev/crypto.h"
 #include "dev/sha256.h"
+#include "dev/nvic.h"
 #include "reg.h"
 
 #include <stdbool.h>
@@ -56,63 +57,113 @@
 /*---------------------------------------------------------------------------*/
 #define MIN(a, b)       ((a) < (b) ? (a) : (b))
 /*---------------------------------------------------------------------------*/
-/** \brief Starts a new hash session in hardware
+/** \brief Starts hashing in hardware, a new or a resumed hash session
  * \param state Hash state
- * \param data Pointer to input message
+ * \param data Pointer to the input message
+ * \param len Bytes of input: whole blocks, or the rest of the message for the
+ * final digest
  * \param hash Destination of the hash (32 bytes)
- * \return \c SHA256_SUCCESS if successful, or AES / SHA-256 error code
+ * \param process Process to be polled upon completion, or \c NULL
  */
-static uint8_t
-new_hash(sha256_state_t *state, const void *data, void *hash)
+static void
+hash_start(sha256_state_t *state, const void *data, uint32_t len, void *hash,
+           struct process *process)
 {
   /* Workaround for AES registers not retained after PM2 */
   REG(AES_CTRL_INT_CFG) = AES_CTRL_INT_CFG_LEVEL;
   REG(AES_CTRL_INT_EN) = AES_CTRL_INT_EN_DMA_IN_DONE |
                          AES_CTRL_INT_EN_RESULT_AV;
 
-  /* Configure master control module and enable DMA path to the SHA-256 engine
-   * + Digest readout */
-  REG(AES_CTRL_ALG_SEL) = AES_CTRL_ALG_SEL_TAG | AES_CTRL_ALG_SEL_HASH;
+  if(state->new_digest) {
+    /* Configure master control module and enable DMA path to the SHA-256
+     * engine + Digest readout */
+    REG(AES_CTRL_ALG_SEL) = AES_CTRL_ALG_SEL_TAG | AES_CTRL_ALG_SEL_HASH;
+  } else {
+    /* Configure master control module and enable the DMA path to the
+     * SHA-256 engine */
+    REG(AES_CTRL_ALG_SEL) = AES_CTRL_ALG_SEL_HASH;
+  }
 
   /* Clear any outstanding events */
   REG(AES_CTRL_INT_CLR) = AES_CTRL_INT_CLR_RESULT_AV;
 
   /* Configure hash engine
-   * Indicate start of a new hash session and SHA-256 */
-  REG(AES_HASH_MODE_IN) = AES_HASH_MODE_IN_SHA256_MODE |
-                          AES_HASH_MODE_IN_NEW_HASH;
+   * Indicate SHA-256 and the start of a new or a resumed hash session */
+  if(state->new_digest) {
+    REG(AES_HASH_MODE_IN) = AES_HASH_MODE_IN_SHA256_MODE |
+                            AES_HASH_MODE_IN_NEW_HASH;
+  } else {
+    REG(AES_HASH_MODE_IN) = AES_HASH_MODE_IN_SHA256_MODE;
+  }
 
   /* If the final digest is required (pad the input DMA data), write the
-   * following register */
+   * length of the message */
   if(state->final_digest) {
     /* Write length of the message (lo) */
     REG(AES_HASH_LENGTH_IN_L) = (uint32_t)state->length;
     /* Write length of the message (hi) */
     REG(AES_HASH_LENGTH_IN_H) = (uint32_t)(state->length >> 32);
-    /* Pad the DMA-ed data */
+  }
+
+  /* Write the initial digest of a resumed session */
+  if(!state->new_digest) {
+    REG(AES_HASH_DIGEST_A) = (uint32_t)state->state[0];
+    REG(AES_HASH_DIGEST_B) = (uint32_t)state->state[1];
+    REG(AES_HASH_DIGEST_C) = (uint32_t)state->state[2];
+    REG(AES_HASH_DIGEST_D) = (uint32_t)state->state[3];
+    REG(AES_HASH_DIGEST_E) = (uint32_t)state->state[4];
+    REG(AES_HASH_DIGEST_F) = (uint32_t)state->state[5];
+    REG(AES_HASH_DIGEST_G) = (uint32_t)state->state[6];
+    REG(AES_HASH_DIGEST_H) = (uint32_t)state->state[7];
+  }
+
+  /* If final digest, pad the DMA-ed data */
+  if(state->final_digest) {
     REG(AES_HASH_IO_BUF_CTRL) = AES_HASH_IO_BUF_CTRL_PAD_DMA_MESSAGE;
   }
 
+  if(process != NULL) {
+    crypto_register_process_notification(process);
+    nvic_interrupt_unpend(NVIC_INT_AES);
+    nvic_interrupt_enable(NVIC_INT_AES);
+  }
+
   /* Enable DMA channel 0 for message data */
   REG(AES_DMAC_CH0_CTRL) = AES_DMAC_CH_CTRL_EN;
   /* Base address of the data in ext. memory */
   REG(AES_DMAC_CH0_EXTADDR) = (uint32_t)data;
-  if(state->final_digest) {
-    /* Input data length in bytes, equal to the message */
-    REG(AES_DMAC_CH0_DMALENGTH) = state->curlen;
-  } else {
-    REG(AES_DMAC_CH0_DMALENGTH) = BLOCK_SIZE;
-  }
-
-  /* Enable DMA channel 1 for result digest */
-  REG(AES_DMAC_CH1_CTRL) = AES_DMAC_CH_CTRL_EN;
-  /* Base address of the digest buffer */
-  REG(AES_DMAC_CH1_EXTADDR) = (uint32_t)hash;
-  /* Length of the result digest */
-  REG(AES_DMAC_CH1_DMALENGTH) = OUTPUT_LEN;
+  /* Input data length in bytes, one or more blocks at once */
+  REG(AES_DMAC_CH0_DMALENGTH) = len;
 
-  /* Wait for completion of the operation */
-  while(!(REG(AES_CTRL_INT_STAT) & AES_CTRL_INT_STAT_RESULT_AV));
+  if(state->new_digest) {
+    /* Enable DMA channel 1 for result digest */
+    REG(AES_DMAC_CH1_CTRL) = AES_DMAC_CH_CTRL_EN;
+    /* Base address of the digest buffer */
+    REG(AES_DMAC_CH1_EXTADDR) = (uint32_t)hash;
+    /* Length of the result digest */
+    REG(AES_DMAC_CH1_DMALENGTH) = OUTPUT_LEN;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/** \brief Checks if the hash started by hash_start() is done
+ */
+static uint8_t
+hash_done(void)
+{
+  return !!(REG(AES_CTRL_INT_STAT) &
+            (AES_CTRL_INT_STAT_DMA_BUS_ERR | AES_CTRL_INT_STAT_RESULT_AV));
+}
+/*---------------------------------------------------------------------------*/
+/** \brief Completes the hash started by hash_start()
+ * \param state Hash state
+ * \param hash Destination of the hash (32 bytes)
+ * \return \c SHA256_SUCCESS if successful, or AES / SHA-256 error code
+ */
+static uint8_t
+hash_finish(sha256_state_t *state, void *hash)
+{
+  nvic_interrupt_disable(NVIC_INT_AES);
+  crypto_register_process_notification(NULL);
 
   if(REG(AES_CTRL_INT_STAT) & AES_CTRL_INT_STAT_DMA_BUS_ERR) {
     /* Clear the DMA error */
@@ -122,6 +173,21 @@ new_hash(sha256_state_t *state, const void *data, void *hash)
     return AES_DMA_BUS_ERROR;
   }
 
+  if(!state->new_digest) {
+    /* Read digest */
+    ((uint32_t *)hash)[0] = REG(AES_HASH_DIGEST_A);
+    ((uint32_t *)hash)[1] = REG(AES_HASH_DIGEST_B);
+    ((uint32_t *)hash)[2] = REG(AES_HASH_DIGEST_C);
+    ((uint32_t *)hash)[3] = REG(AES_HASH_DIGEST_D);
+    ((uint32_t *)hash)[4] = REG(AES_HASH_DIGEST_E);
+    ((uint32_t *)hash)[5] = REG(AES_HASH_DIGEST_F);
+    ((uint32_t *)hash)[6] = REG(AES_HASH_DIGEST_G);
+    ((uint32_t *)hash)[7] = REG(AES_HASH_DIGEST_H);
+
+    /* Acknowledge reading of the digest */
+    REG(AES_HASH_IO_BUF_CTRL) = AES_HASH_IO_BUF_CTRL_OUTPUT_FULL;
+  }
+
   /* Clear the interrupt */
   REG(AES_CTRL_INT_CLR) = AES_CTRL_INT_CLR_DMA_IN_DONE |
                           AES_CTRL_INT_CLR_RESULT_AV;
@@ -130,101 +196,69 @@ new_hash(sha256_state_t *state, const void *data, void *hash)
   /* Clear mode */
   REG(AES_AES_CTRL) = 0x00000000;
 
+  state->new_digest = false;
   return SHA256_SUCCESS;
 }
 /*---------------------------------------------------------------------------*/
-/** \brief Resumes an already started hash session in hardware
- * \param state Hash state
- * \param data Pointer to the input message
- * \param hash Pointer to the destination of the hash (32 bytes)
- * \return \c SHA256_SUCCESS if successful, or AES / SHA-256 error code
+/** \brief Hashes in hardware and waits for the result
  */
 static uint8_t
-resume_hash(sha256_state_t *state, const void *data, void *hash)
+hash_sync(sha256_state_t *state, const void *data, uint32_t len, void *hash)
 {
-  /* Workaround for AES registers not retained after PM2 */
-  REG(AES_CTRL_INT_CFG) = AES_CTRL_INT_CFG_LEVEL;
-  REG(AES_CTRL_INT_EN) = AES_CTRL_INT_EN_DMA_IN_DONE |
-                         AES_CTRL_INT_EN_RESULT_AV;
-
-  /* Configure master control module and enable the DMA path to the SHA-256
-   * engine */
-  REG(AES_CTRL_ALG_SEL) = AES_CTRL_ALG_SEL_HASH;
-
-  /* Clear any outstanding events */
-  REG(AES_CTRL_INT_CLR) = AES_CTRL_INT_CLR_RESULT_AV;
-
-  /* Configure hash engine
-   * Indicate the start of a resumed hash session and SHA-256 */
-  REG(AES_HASH_MODE_IN) = AES_HASH_MODE_IN_SHA256_MODE;
+  hash_start(state, data, len, hash, NULL);
+  while(!hash_done());
+  return hash_finish(state, hash);
+}
+/*---------------------------------------------------------------------------*/
+/** \brief Fills the buffered block with the head of the data, and hashes it
+ * if more data follows
+ */
+static uint8_t
+fill(sha256_state_t *state, const uint8_t **data, uint32_t *len)
+{
+  uint32_t n;
+  uint8_t ret;
 
-  /* If the final digest is required (pad the input DMA data) */
-  if(state->final_digest) {
-    /* Write length of the message (lo) */
-    REG(AES_HASH_LENGTH_IN_L) = (uint32_t)state->length;
-    /* Write length of the message (hi) */
-    REG(AES_HASH_LENGTH_IN_H) = (uint32_t)(state->length >> 32);
+  n = MIN(*len, BLOCK_SIZE - state->curlen);
+  memcpy(&state->buf[state->curlen], *data, n);
+  state->curlen += n;
+  *data += n;
+  *len -= n;
+  if(state->curlen == BLOCK_SIZE && *len > 0) {
+    ret = hash_sync(state, state->buf, BLOCK_SIZE, state->state);
+    if(ret != SHA256_SUCCESS) {
+      return ret;
+    }
+    state->length += BLOCK_SIZE << 3;
+    state->curlen = 0;
   }
-
-  /* Write the initial digest */
-  REG(AES_HASH_DIGEST_A) = (uint32_t)state->state[0];
-  REG(AES_HASH_DIGEST_B) = (uint32_t)state->state[1];
-  REG(AES_HASH_DIGEST_C) = (uint32_t)state->state[2];
-  REG(AES_HASH_DIGEST_D) = (uint32_t)state->state[3];
-  REG(AES_HASH_DIGEST_E) = (uint32_t)state->state[4];
-  REG(AES_HASH_DIGEST_F) = (uint32_t)state->state[5];
-  REG(AES_HASH_DIGEST_G) = (uint32_t)state->state[6];
-  REG(AES_HASH_DIGEST_H) = (uint32_t)state->state[7];
-
-  /* If final digest, pad the DMA-ed data */
-  if(state->final_digest) {
-    REG(AES_HASH_IO_BUF_CTRL) = AES_HASH_IO_BUF_CTRL_PAD_DMA_MESSAGE;
+  return SHA256_SUCCESS;
+}
+/*---------------------------------------------------------------------------*/
+/** \brief Bytes of whole blocks that can be DMA-ed from the caller's buffer.
+ * At least one byte is kept back for the final digest.
+ */
+static uint32_t
+run_length(sha256_state_t *state, uint32_t len)
+{
+  return state->curlen == 0 && len > BLOCK_SIZE ?
+         (len - 1) & ~(BLOCK_SIZE - 1) : 0;
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t
+check_state(sha256_state_t *state, const void *data)
+{
+  if(state == NULL || data == NULL) {
+    return SHA256_NULL_ERROR;
   }
 
-  /* Enable DMA channel 0 for message data */
-  REG(AES_DMAC_CH0_CTRL) = AES_DMAC_CH_CTRL_EN;
-  /* Base address of the data in ext. memory */
-  REG(AES_DMAC_CH0_EXTADDR) = (uint32_t)data;
-  /* Input data length in bytes, equal to the message */
-  if(state->final_digest) {
-    REG(AES_DMAC_CH0_DMALENGTH) = state->curlen;
-  } else {
-    REG(AES_DMAC_CH0_DMALENGTH) = BLOCK_SIZE;
+  if(state->curlen > sizeof(state->buf) || state->busy) {
+    return SHA256_INVALID_PARAM;
   }
 
-  /* Wait for completion of the operation */
-  while(!(REG(AES_CTRL_INT_STAT) & AES_CTRL_INT_STAT_RESULT_AV));
-
-  /* Check for any DMA Bus errors */
-  if(REG(AES_CTRL_INT_STAT) & AES_CTRL_INT_STAT_DMA_BUS_ERR) {
-    /* Clear the DMA error */
-    REG(AES_CTRL_INT_CLR) = AES_CTRL_INT_CLR_DMA_BUS_ERR;
-    /* Disable master control / DMA clock */
-    REG(AES_CTRL_ALG_SEL) = 0x00000000;
-    return AES_DMA_BUS_ERROR;
+  if(REG(AES_CTRL_ALG_SEL) != 0x00000000) {
+    return AES_RESOURCE_IN_USE;
   }
-
-  /* Read digest */
-  ((uint32_t *)hash)[0] = REG(AES_HASH_DIGEST_A);
-  ((uint32_t *)hash)[1] = REG(AES_HASH_DIGEST_B);
-  ((uint32_t *)hash)[2] = REG(AES_HASH_DIGEST_C);
-  ((uint32_t *)hash)[3] = REG(AES_HASH_DIGEST_D);
-  ((uint32_t *)hash)[4] = REG(AES_HASH_DIGEST_E);
-  ((uint32_t *)hash)[5] = REG(AES_HASH_DIGEST_F);
-  ((uint32_t *)hash)[6] = REG(AES_HASH_DIGEST_G);
-  ((uint32_t *)hash)[7] = REG(AES_HASH_DIGEST_H);
-
-  /* Acknowledge reading of the digest */
-  REG(AES_HASH_IO_BUF_CTRL) = AES_HASH_IO_BUF_CTRL_OUTPUT_FULL;
-
-  /* Clear the interrupt */
-  REG(AES_CTRL_INT_CLR) = AES_CTRL_INT_CLR_DMA_IN_DONE |
-                          AES_CTRL_INT_CLR_RESULT_AV;
-  /* Disable master control / DMA clock */
-  REG(AES_CTRL_ALG_SEL) = 0x00000000;
-  /* Clear mode */
-  REG(AES_AES_CTRL) = 0x00000000;
-
   return SHA256_SUCCESS;
 }
 /*---------------------------------------------------------------------------*/
@@ -239,87 +273,97 @@ sha256_init(sha256_state_t *state)
   state->length = 0;
   state->new_digest = true;
   state->final_digest = false;
+  state->busy = false;
   return SHA256_SUCCESS;
 }
 /*---------------------------------------------------------------------------*/
 uint8_t
 sha256_process(sha256_state_t *state, const void *data, uint32_t len)
 {
+  const uint8_t *in = data;
   uint32_t n;
   uint8_t ret;
 
-  if(state == NULL || data == NULL) {
-    return SHA256_NULL_ERROR;
+  ret = check_state(state, data);
+  if(ret != SHA256_SUCCESS) {
+    return ret;
   }
 
-  if(state->curlen > sizeof(state->buf)) {
-    return SHA256_INVALID_PARAM;
+  /* Complete a partially buffered block */
+  if(state->curlen > 0) {
+    ret = fill(state, &in, &len);
+    if(ret != SHA256_SUCCESS) {
+      return ret;
+    }
   }
 
-  if(REG(AES_CTRL_ALG_SEL) != 0x00000000) {
-    return AES_RESOURCE_IN_USE;
+  /* Whole blocks straight from the caller's buffer in one DMA run */
+  n = run_length(state, len);
+  if(n > 0) {
+    ret = hash_sync(state, in, n, state->state);
+    if(ret != SHA256_SUCCESS) {
+      return ret;
+    }
+    state->length += (uint64_t)n << 3;
+    in += n;
+    len -= n;
   }
 
-  if(len > 0 && state->new_digest) {
-    if(state->curlen == 0 && len > BLOCK_SIZE) {
-      memcpy(state->buf, data, BLOCK_SIZE);
-      ret = new_hash(state, state->buf, state->state);
-      if(ret != SHA256_SUCCESS) {
-        return ret;
-      }
-      state->new_digest = false;
-      state->length += BLOCK_SIZE << 3;
-      data += BLOCK_SIZE;
-      len -= BLOCK_SIZE;
-    } else {
-      n = MIN(len, BLOCK_SIZE - state->curlen);
-      memcpy(&state->buf[state->curlen], data, n);
-      state->curlen += n;
-      data += n;
-      len -= n;
-      if(state->curlen == BLOCK_SIZE && len > 0) {
-        ret = new_hash(state, state->buf, state->state);
-        if(ret != SHA256_SUCCESS) {
-          return ret;
-        }
-        state->new_digest = false;
-        state->length += BLOCK_SIZE << 3;
-        state->curlen = 0;
-      }
-    }
+  /* The tail stays buffered */
+  return fill(state, &in, &len);
+}
+/*---------------------------------------------------------------------------*/
+uint8_t
+sha256_process_start(sha256_state_t *state, const void *data, uint32_t len,
+                     struct process *process)
+{
+  const uint8_t *in = data;
+  uint32_t n;
+  uint8_t ret;
+
+  ret = check_state(state, data);
+  if(ret != SHA256_SUCCESS) {
+    return ret;
   }
 
-  while(len > 0 && !state->new_digest) {
-    if(state->curlen == 0 && len > BLOCK_SIZE) {
-      memcpy(state->buf, data, BLOCK_SIZE);
-      ret = resume_hash(state, state->buf, state->state);
-      if(ret != SHA256_SUCCESS) {
-        return ret;
-      }
-      state->length += BLOCK_SIZE << 3;
-      data += BLOCK_SIZE;
-      len -= BLOCK_SIZE;
-    } else {
-      n = MIN(len, BLOCK_SIZE - state->curlen);
-      memcpy(&state->buf[state->curlen], data, n);
-      state->curlen += n;
-      data += n;
-      len -= n;
-      if(state->curlen == BLOCK_SIZE && len > 0) {
-        ret = resume_hash(state, state->buf, state->state);
-        if(ret != SHA256_SUCCESS) {
-          return ret;
-        }
-        state->length += BLOCK_SIZE << 3;
-        state->curlen = 0;
-      }
+  /* Complete a partially buffered block */
+  if(state->curlen > 0) {
+    ret = fill(state, &in, &len);
+    if(ret != SHA256_SUCCESS) {
+      return ret;
     }
   }
 
+  /* The tail is buffered right away, the engine reads the run from the
+   * caller's buffer */
+  n = run_length(state, len);
+  memcpy(&state->buf[state->curlen], in + n, len - n);
+  state->curlen += len - n;
+  if(n > 0) {
+    hash_start(state, in, n, state->state, process);
+    state->length += (uint64_t)n << 3;
+    state->busy = true;
+  }
   return SHA256_SUCCESS;
 }
 /*---------------------------------------------------------------------------*/
 uint8_t
+sha256_check_status(sha256_state_t *state)
+{
+  return !state->busy || hash_done();
+}
+/*---------------------------------------------------------------------------*/
+uint8_t
+sha256_get_result(sha256_state_t *state)
+{
+  if(!state->busy) {
+    return SHA256_SUCCESS;
+  }
+  state->busy = false;
+  return hash_finish(state, state->state);
+}
+/*---------------------------------------------------------------------------*/
+uint8_t
 sha256_done(sha256_state_t *state, void *hash)
 {
   uint8_t ret;
@@ -328,7 +372,7 @@ sha256_done(sha256_state_t *state, void *hash)
     return SHA256_NULL_ERROR;
   }
 
-  if(state->curlen > sizeof(state->buf)) {
+  if(state->curlen > sizeof(state->buf) || state->busy) {
     return SHA256_INVALID_PARAM;
   }
 
@@ -339,21 +383,11 @@ sha256_done(sha256_state_t *state, void *hash)
   /* Increase the length of the message */
   state->length += state->curlen << 3;
   state->final_digest = true;
-  if(state->new_digest) {
-    ret = new_hash(state, state->buf, hash);
-    if(ret != SHA256_SUCCESS) {
-      return ret;
-    }
-  } else {
-    ret = resume_hash(state, state->buf, hash);
-    if(ret != SHA256_SUCCESS) {
-      return ret;
-    }
-  }
+  ret = hash_sync(state, state->buf, state->curlen, hash);
   state->new_digest = false;
   state->final_digest = false;
 
-  return SHA256_SUCCESS;
+  return ret;
 }
 
 /** @} */
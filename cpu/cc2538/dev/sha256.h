@@ -64,6 +64,7 @@ typedef struct {
   uint8_t  buf[64];
   uint8_t  new_digest;
   uint8_t  final_digest;
+  uint8_t  busy;          /**< A run of sha256_process_start() is hashed */
 } sha256_state_t;
 /** @} */
 /*---------------------------------------------------------------------------*/
@@ -83,9 +84,39 @@ uint8_t sha256_init(sha256_state_t *state);
  * \param len Length of the data to hash in bytes (octets)
  * \return \c SHA256_SUCCESS if successful, or AES / SHA-256 error code
  * \note This function must be called only after \c sha256_init().
+ *
+ * Whole blocks are DMA-ed from \p data in one run, only a partial block at
+ * the start and the end of \p data is copied into \p state.
  */
 uint8_t sha256_process(sha256_state_t *state, const void *data, uint32_t len);
 
+/** \brief Starts processing a block of memory through the hash, the run of
+ * whole blocks is hashed in the background
+ * \param state Pointer to hash state
+ * \param data Pointer to the data to hash, must stay valid until
+ * \c sha256_get_result()
+ * \param len Length of the data to hash in bytes (octets)
+ * \param process Process to be polled upon completion, or \c NULL
+ * \return \c SHA256_SUCCESS if successful, or AES / SHA-256 error code
+ * \note A partial block at the start of \p data is still hashed before the
+ * function returns.
+ */
+uint8_t sha256_process_start(sha256_state_t *state, const void *data,
+                             uint32_t len, struct process *process);
+
+/** \brief Checks the status of the hash started by sha256_process_start()
+ * \param state Pointer to hash state
+ * \retval false Result not yet available, and no error occurred
+ * \retval true Result available, or error occurred
+ */
+uint8_t sha256_check_status(sha256_state_t *state);
+
+/** \brief Completes the hash started by sha256_process_start()
+ * \param state Pointer to hash state
+ * \return \c SHA256_SUCCESS if successful, or AES / SHA-256 error code
+ */
+uint8_t sha256_get_result(sha256_state_t *state);
+
 /** \brief Terminates hash session to get the digest
  * \param state Pointer to hash state
  * \param hash Pointer to hash
@@ -112,7 +112,7 @@ PROCESS_THREAD(RSA_signature_process, ev, data)
 
 
        memcpy(&public_state.PrimeE,&state.PrimeE,sizeof(uint32_t)*1);//copy one of public key---e
-       memcpy(&public_state.ESize, &state.ESize ,sizeof(uint8_t)*1);//copy one of public key e size
+       memcpy(&public_state.ESize, &state.ESize ,sizeof(state.ESize));//copy one of public key e size
        memcpy(public_state.PublicN, state.PublicN,sizeof(uint32_t)*16);//copy one of another public key--n
        memcpy(&public_state.NLen, &state.NLen,sizeof(uint32_t)*1);//copy one of another public key-n size
 
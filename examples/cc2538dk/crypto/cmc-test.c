@@ -0,0 +1,223 @@
+/*
+ * Copyright (c) 2015, Institute for Pervasive Computing, ETH Zurich.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/**
+ * \addtogroup cc2538-examples
+ * @{
+ *
+ * \defgroup cc2538-cmc-test cc2538dk AES-CMC Test Project
+ *
+ *   AES-CMC access example for CC2538 on SmartRF06EB.
+ *
+ *   This example shows how AES-CMC should be used. The example also verifies
+ *   the AES-CMC functionality against known answers of CMC with a zero tweak
+ *   and by round trips over lengths around the ECB job size.
+ *
+ * @{
+ *
+ * \file
+ *     Example demonstrating AES-CMC on the cc2538dk platform
+ */
+#include "contiki.h"
+#include "sys/rtimer.h"
+#include "lib/random.h"
+#include "dev/crypto.h"
+#include "dev/aes.h"
+#include "dev/cmc.h"
+#include "flash-erase.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+/*---------------------------------------------------------------------------*/
+#define MAX_BLOCKS (3 * (CMC_SAVE_BLOCKS + 1))
+/*---------------------------------------------------------------------------*/
+PROCESS(cmc_test_process, "cmc test process");
+AUTOSTART_PROCESSES(&cmc_test_process, &flash_erase_process);
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(cmc_test_process, ev, data)
+{
+  static const char *const str_res[] = {
+    "success",
+    "resource in use",
+    "keystore read error",
+    "keystore write error",
+    "DMA bus error",
+    "authentication failed",
+    "invalid param",
+    "NULL error"
+  };
+  static const uint8_t key[16] = {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+    0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f
+  };
+  /* AES-128 CMC of the plain-text 00 01 02 ..., tweak 0 */
+  static const uint8_t expected1[] = {
+    0xae, 0xe7, 0x1e, 0xa5, 0x41, 0xd7, 0xae, 0x4b,
+    0xeb, 0x60, 0xbe, 0xcc, 0x59, 0x3f, 0xb6, 0x63
+  };
+  static const uint8_t expected2[] = {
+    0xd1, 0x53, 0xcb, 0x6d, 0xea, 0x79, 0xf3, 0xac,
+    0x41, 0xa8, 0x07, 0x46, 0x75, 0x4e, 0xfb, 0xe2,
+    0x5e, 0x85, 0x47, 0x6d, 0x34, 0xde, 0x26, 0x12,
+    0x4b, 0x1b, 0x2b, 0x31, 0x5b, 0x9c, 0x78, 0xe3
+  };
+  static const uint8_t expected4[] = {
+    0x9b, 0xea, 0xe5, 0x91, 0x03, 0x37, 0xc2, 0x25,
+    0x0b, 0x7a, 0xfd, 0xd6, 0x26, 0xec, 0x0e, 0x25,
+    0x2e, 0x07, 0xc0, 0x4c, 0x47, 0x24, 0x3b, 0x43,
+    0xfc, 0x5c, 0x34, 0xd5, 0x93, 0xbe, 0x76, 0xb2,
+    0xaf, 0xcb, 0x7c, 0xf3, 0xc0, 0x2a, 0x2d, 0x0c,
+    0x17, 0xaa, 0xa9, 0x56, 0x55, 0x73, 0x72, 0x8a,
+    0xc1, 0x70, 0xa5, 0x43, 0x4f, 0xcf, 0xdd, 0x17,
+    0x10, 0x48, 0x34, 0x04, 0xb5, 0x10, 0x42, 0xa4
+  };
+  static const uint8_t expected12[] = {
+    0x43, 0x4e, 0x51, 0x7c, 0xe4, 0xcc, 0xd8, 0x74,
+    0xdc, 0x67, 0x78, 0x98, 0xb4, 0x34, 0x01, 0x51,
+    0x31, 0xaf, 0xc9, 0x45, 0x42, 0x74, 0xcf, 0xc1,
+    0x18, 0x3c, 0x2e, 0xb0, 0x6e, 0x11, 0x5e, 0xd2,
+    0x44, 0xc2, 0xe8, 0xd4, 0x35, 0x63, 0x8d, 0x27,
+    0x09, 0x88, 0xf0, 0xf8, 0x07, 0xbb, 0xae, 0x6e,
+    0x0c, 0x57, 0x5c, 0xf0, 0x38, 0xfe, 0xdc, 0x72,
+    0x69, 0x59, 0xda, 0x1c, 0x91, 0x35, 0x97, 0x4a,
+    0x8a, 0x98, 0xdc, 0xe3, 0x81, 0x48, 0x36, 0x95,
+    0x21, 0x8e, 0x01, 0x1f, 0x9a, 0x6f, 0x65, 0x0e,
+    0x5c, 0x32, 0x0a, 0x74, 0x99, 0xdf, 0xf0, 0xfe,
+    0x0a, 0xe0, 0xd5, 0xbc, 0xf2, 0x3b, 0xe4, 0x1f,
+    0x98, 0x16, 0xdd, 0x26, 0x7e, 0x07, 0x76, 0x45,
+    0xd9, 0x25, 0xbd, 0x46, 0x5e, 0x11, 0x3f, 0x2e,
+    0xdb, 0x8d, 0x70, 0x37, 0xdc, 0x00, 0x31, 0xc5,
+    0x4f, 0x7b, 0xd0, 0x5c, 0x0c, 0x54, 0xb8, 0x82,
+    0x88, 0x1f, 0x08, 0x52, 0xea, 0x4f, 0x1a, 0x15,
+    0x07, 0x46, 0xa0, 0xdd, 0x9f, 0xa5, 0x51, 0x97,
+    0xf1, 0x9a, 0x76, 0xf4, 0x13, 0x98, 0xb2, 0xa3,
+    0x25, 0x68, 0x61, 0x2b, 0xa8, 0xd2, 0xfc, 0x74,
+    0x90, 0x00, 0xf1, 0x1a, 0x5a, 0x2b, 0x33, 0xdc,
+    0x12, 0x24, 0x6b, 0x05, 0xad, 0xa6, 0xc5, 0x98,
+    0x10, 0xd8, 0x8f, 0x2d, 0x00, 0x0b, 0x3c, 0x70,
+    0xa8, 0xcf, 0xc1, 0xcd, 0xe7, 0x84, 0x88, 0xbe
+  };
+  static const struct {
+    const uint8_t *expected;
+    uint32_t len;
+  } vectors[] = {
+    { expected1, sizeof(expected1) },
+    { expected2, sizeof(expected2) },
+    { expected4, sizeof(expected4) },
+    { expected12, sizeof(expected12) }
+  };
+  static uint32_t plain[MAX_BLOCKS * 4], cipher[MAX_BLOCKS * 4];
+  static cmc_state_t state;
+  static uint32_t len;
+  static int i, j;
+  static uint8_t ret;
+  static rtimer_clock_t time;
+
+  PROCESS_BEGIN();
+
+  puts("-----------------------------------------\n"
+       "Initializing cryptoprocessor...");
+  crypto_init();
+
+  ret = aes_load_keys(key, AES_KEY_STORE_SIZE_KEY_SIZE_128, 1, 0);
+  printf("aes_load_keys(): %s\n", str_res[ret]);
+
+  for(i = 0; i < sizeof(vectors) / sizeof(vectors[0]) && ret == AES_SUCCESS; i++) {
+    printf("-----------------------------------------\n"
+           "Test vector #%d: %lu bytes\n", i, vectors[i].len);
+
+    for(j = 0; j < vectors[i].len; j++) {
+      ((uint8_t *)plain)[j] = j;
+    }
+
+    time = RTIMER_NOW();
+    ret = cmc_encrypt((uint8_t *)plain, (uint8_t *)cipher, 0, vectors[i].len);
+    time = RTIMER_NOW() - time;
+    printf("cmc_encrypt(): %s, %lu us\n", str_res[ret],
+           (uint32_t)((uint64_t)time * 1000000 / RTIMER_SECOND));
+    if(ret != AES_SUCCESS) {
+      break;
+    }
+    if(memcmp(cipher, vectors[i].expected, vectors[i].len)) {
+      puts("Encrypted message does not match expected one");
+    } else {
+      puts("Encrypted message OK");
+    }
+
+    time = RTIMER_NOW();
+    ret = cmc_decrypt((uint8_t *)cipher, (uint8_t *)cipher, 0, vectors[i].len);
+    time = RTIMER_NOW() - time;
+    printf("cmc_decrypt(): %s, %lu us\n", str_res[ret],
+           (uint32_t)((uint64_t)time * 1000000 / RTIMER_SECOND));
+    if(ret != AES_SUCCESS) {
+      break;
+    }
+    if(memcmp(cipher, plain, vectors[i].len)) {
+      puts("Decrypted message does not match expected one");
+    } else {
+      puts("Decrypted message OK");
+    }
+    PROCESS_PAUSE();
+  }
+
+  /* Round trips in place through the interrupt driven functions */
+  puts("-----------------------------------------");
+  state.process = &cmc_test_process;
+  state.key_area = 0;
+  for(len = 16; len <= sizeof(plain) && ret == AES_SUCCESS; len += 16) {
+    for(j = 0; j < len / 2; j++) {
+      ((uint16_t *)plain)[j] = random_rand();
+    }
+    memcpy(cipher, plain, len);
+
+    state.in = state.out = (uint8_t *)cipher;
+    state.len = len;
+    PROCESS_PT_SPAWN(&state.pt, cmc_encrypt_async(&state));
+    ret = state.result;
+    if(ret == AES_SUCCESS) {
+      PROCESS_PT_SPAWN(&state.pt, cmc_decrypt_async(&state));
+      ret = state.result;
+    }
+    printf("%lu bytes: %s, %s\n", len, str_res[ret],
+           memcmp(cipher, plain, len) ? "round trip FAILED" : "round trip OK");
+  }
+
+  puts("-----------------------------------------\n"
+       "Disabling cryptoprocessor...");
+  crypto_disable();
+
+  puts("Done!");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
+/**
+ * @}
+ * @}
+ */
@@ -184,6 +184,7 @@ PROCESS_THREAD(sha256_test_process, ev, data)
     }
   };
   static sha256_state_t state;
+  static uint8_t bulk[4096];
   static int i, j;
   static uint8_t ret;
   static rtimer_clock_t total_time;
@@ -251,6 +252,54 @@ PROCESS_THREAD(sha256_test_process, ev, data)
            (uint32_t)((uint64_t)total_time * 1000000 / RTIMER_SECOND));
   }
 
+  /* The same vectors hashed in the background */
+  for(i = 0; i < sizeof(vectors) / sizeof(vectors[0]); i++) {
+    printf("-----------------------------------------\n"
+           "Test vector #%d in the background:\n", i);
+
+    sha256_init(&state);
+    for(j = 0; j < sizeof(vectors[i].data) / sizeof(vectors[i].data[0]) &&
+               vectors[i].data[j] != NULL; j++) {
+      ret = sha256_process_start(&state, vectors[i].data[j],
+                                 strlen(vectors[i].data[j]),
+                                 &sha256_test_process);
+      if(ret != SHA256_SUCCESS) {
+        break;
+      }
+      PROCESS_WAIT_UNTIL(sha256_check_status(&state));
+      ret = sha256_get_result(&state);
+      if(ret != SHA256_SUCCESS) {
+        break;
+      }
+    }
+    printf("sha256_process_start(): %s\n", str_res[ret]);
+    if(ret != SHA256_SUCCESS) {
+      continue;
+    }
+
+    ret = sha256_done(&state, sha256);
+    if(ret != SHA256_SUCCESS || memcmp(sha256, vectors[i].sha256, sizeof(sha256))) {
+      puts("Computed SHA-256 hash does not match expected hash");
+    } else {
+      puts("Computed SHA-256 hash OK");
+    }
+  }
+
+  /* Throughput of long inputs, DMA-ed in one run */
+  puts("-----------------------------------------");
+  memset(bulk, 0xa5, sizeof(bulk));
+  for(i = 1024; i <= sizeof(bulk); i *= 2) {
+    time = RTIMER_NOW();
+    sha256_init(&state);
+    sha256_process(&state, bulk, i);
+    sha256_done(&state, sha256);
+    time = RTIMER_NOW() - time;
+    printf("%d bytes: %lu us, %lu kB/s\n", i,
+           (uint32_t)((uint64_t)time * 1000000 / RTIMER_SECOND),
+           (uint32_t)((uint64_t)i * RTIMER_SECOND / 1024 / (time ? time : 1)));
+    PROCESS_PAUSE();
+  }
+
   puts("-----------------------------------------\n"
        "Disabling cryptoprocessor...");
   crypto_disable();
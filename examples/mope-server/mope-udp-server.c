@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2015, Institute for Pervasive Computing, ETH Zurich.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/**
+ * \file
+ *     mOPE reference server on UDP, for the native platform (tun) or
+ *     Cooja. Clients send their mOPE messages to port MOPE_SERVER_PORT.
+ */
+#include "contiki.h"
+#include "contiki-lib.h"
+#include "contiki-net.h"
+#include "mope-server.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define DEBUG DEBUG_PRINT
+#include "net/ip/uip-debug.h"
+
+#define UIP_IP_BUF   ((struct uip_ip_hdr *)&uip_buf[UIP_LLH_LEN])
+#define UIP_UDP_BUF  ((struct uip_udp_hdr *)&uip_buf[uip_l2_l3_hdr_len])
+
+static struct uip_udp_conn *server_conn;
+static mope_server_t server;
+
+/* client of the insert in progress */
+static uip_ipaddr_t client_addr;
+static uint16_t client_port;
+
+PROCESS(mope_udp_server_process, "mOPE UDP server");
+AUTOSTART_PROCESSES(&mope_udp_server_process);
+/*---------------------------------------------------------------------------*/
+static int
+write_udp(struct mope_server_t *s, uint8_t *buf, uint16_t len)
+{
+  uip_udp_packet_sendto(server_conn, buf, len, &client_addr, client_port);
+  return len;
+}
+/*---------------------------------------------------------------------------*/
+static void
+tcpip_handler(void)
+{
+  if(uip_newdata()) {
+    uip_ipaddr_copy(&client_addr, &UIP_IP_BUF->srcipaddr);
+    client_port = UIP_UDP_BUF->srcport;
+    if(mope_server_handle(&server, uip_appdata, uip_datalen())) {
+      PRINTF("Dropped message from ");
+      PRINT6ADDR(&client_addr);
+      PRINTF("\n");
+    } else if(!server.busy) {
+      PRINTF("Tree: %lu keys, %u levels, %lu requests, %lu re-encodings\n",
+             (unsigned long)mope_server_size(&server), mope_server_depth(&server),
+             (unsigned long)server.stats.requests,
+             (unsigned long)server.stats.reencodings);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(mope_udp_server_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  mope_server_init(&server, write_udp, NULL);
+
+  server_conn = udp_new(NULL, 0, NULL);
+  udp_bind(server_conn, UIP_HTONS(MOPE_SERVER_PORT));
+  PRINTF("mOPE server listening on port %u\n", MOPE_SERVER_PORT);
+
+  while(1) {
+    PROCESS_YIELD();
+    if(ev == tcpip_event) {
+      tcpip_handler();
+    }
+  }
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
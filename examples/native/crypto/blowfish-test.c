@@ -0,0 +1,243 @@
+/*
+ * Copyright (c) 2015, Institute for Pervasive Computing, ETH Zurich.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/**
+ * \addtogroup native-crypto-examples
+ * @{
+ *
+ * \file
+ *     Tests of the Blowfish block modes and the persisted key schedule
+ */
+#include "contiki.h"
+#include "blowfish.h"
+#include "cfs/cfs.h"
+#include "unit-test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(__i386__) || defined(__x86_64__)
+#include <x86intrin.h>
+#endif
+
+#define SCHEDULE_FILE "bf-schedule"
+#define BULK_BYTES    4096
+#define BULK_BLOCKS   (512UL * BULK_BYTES / 8)
+/*---------------------------------------------------------------------------*/
+static blowfish_t bf, other;
+static uint8_t plain[BULK_BYTES], cipher[BULK_BYTES], check[BULK_BYTES];
+static unsigned char key[] = "Talos blowfish key";
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(known_answer, "Blowfish known answers");
+UNIT_TEST_REGISTER(modes, "Blowfish ECB/CTR");
+UNIT_TEST_REGISTER(persistent, "Blowfish persisted schedule");
+/*---------------------------------------------------------------------------*/
+UNIT_TEST(known_answer)
+{
+  static const uint8_t zero_ct[8] = { 0x4e, 0xf9, 0x97, 0x45, 0x61, 0x98, 0xdd, 0x78 };
+  static const uint8_t ones_ct[8] = { 0x51, 0x86, 0x6f, 0xd5, 0xb8, 0x5e, 0xcb, 0x8a };
+  unsigned char k[8];
+  uint8_t block[8];
+  uint32_t l, r;
+
+  UNIT_TEST_BEGIN();
+
+  memset(k, 0, sizeof(k));
+  memset(block, 0, sizeof(block));
+  UNIT_TEST_ASSERT(blowfish_initialize(k, sizeof(k), &bf));
+  UNIT_TEST_ASSERT(blowfish_ecb(&bf, block, block, sizeof(block), BLOWFISH_ENCRYPT));
+  UNIT_TEST_ASSERT(memcmp(block, zero_ct, sizeof(block)) == 0);
+
+  memset(k, 0xff, sizeof(k));
+  memset(block, 0xff, sizeof(block));
+  UNIT_TEST_ASSERT(blowfish_initialize(k, sizeof(k), &bf));
+  UNIT_TEST_ASSERT(blowfish_ecb(&bf, block, block, sizeof(block), BLOWFISH_ENCRYPT));
+  UNIT_TEST_ASSERT(memcmp(block, ones_ct, sizeof(block)) == 0);
+
+  /* the word interface agrees and inverts */
+  l = r = 0xffffffff;
+  blowfish_cipher(&bf, &l, &r, BLOWFISH_ENCRYPT);
+  UNIT_TEST_ASSERT(l == 0x51866fd5 && r == 0xb85ecb8a);
+  blowfish_cipher(&bf, &l, &r, BLOWFISH_DECRYPT);
+  UNIT_TEST_ASSERT(l == 0xffffffff && r == 0xffffffff);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST(modes)
+{
+  uint8_t counter[8], start[8];
+  uint32_t i;
+
+  UNIT_TEST_BEGIN();
+
+  for(i = 0; i < BULK_BYTES; i++) {
+    plain[i] = i * 7 + 3;
+  }
+  blowfish_initialize(key, sizeof(key) - 1, &bf);
+
+  UNIT_TEST_ASSERT(blowfish_ecb(&bf, plain, cipher, 7, BLOWFISH_ENCRYPT) == 0);
+  UNIT_TEST_ASSERT(blowfish_ecb(&bf, plain, cipher, BULK_BYTES, BLOWFISH_ENCRYPT));
+  UNIT_TEST_ASSERT(blowfish_ecb(&bf, cipher, check, BULK_BYTES, BLOWFISH_DECRYPT));
+  UNIT_TEST_ASSERT(memcmp(plain, check, BULK_BYTES) == 0);
+
+  /* ECB over many blocks equals block-by-block encryption */
+  for(i = 0; i < BULK_BYTES; i += 8) {
+    blowfish_ecb(&bf, plain + i, check + i, 8, BLOWFISH_ENCRYPT);
+  }
+  UNIT_TEST_ASSERT(memcmp(cipher, check, BULK_BYTES) == 0);
+
+  /* CTR round trip with a partial block and a carry into the high word */
+  memset(start, 0, sizeof(start));
+  memset(start + 4, 0xff, 4);
+  start[7] = 0xfe;
+  memcpy(counter, start, sizeof(counter));
+  blowfish_ctr(&bf, counter, plain, cipher, 1001);
+  UNIT_TEST_ASSERT(counter[3] == 1 && counter[7] == 124);
+  memcpy(counter, start, sizeof(counter));
+  blowfish_ctr(&bf, counter, cipher, check, 1001);
+  UNIT_TEST_ASSERT(memcmp(plain, check, 1001) == 0);
+
+  /* CTR in pieces of whole blocks gives the same stream */
+  memcpy(counter, start, sizeof(counter));
+  blowfish_ctr(&bf, counter, plain, check, 64);
+  blowfish_ctr(&bf, counter, plain + 64, check + 64, 1001 - 64);
+  UNIT_TEST_ASSERT(memcmp(cipher, check, 1001) == 0);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST(persistent)
+{
+  UNIT_TEST_BEGIN();
+
+  cfs_remove(SCHEDULE_FILE);
+  blowfish_initialize(key, sizeof(key) - 1, &bf);
+
+  /* computed and written on the first call, read back on the second */
+  UNIT_TEST_ASSERT(blowfish_initialize_persistent(key, sizeof(key) - 1, &other, SCHEDULE_FILE));
+  UNIT_TEST_ASSERT(memcmp(&bf, &other, sizeof(bf)) == 0);
+  memset(&other, 0, sizeof(other));
+  UNIT_TEST_ASSERT(blowfish_initialize_persistent(key, sizeof(key) - 1, &other, SCHEDULE_FILE));
+  UNIT_TEST_ASSERT(memcmp(&bf, &other, sizeof(bf)) == 0);
+
+  /* another key replaces the stored schedule */
+  UNIT_TEST_ASSERT(blowfish_initialize_persistent(key, sizeof(key) - 2, &other, SCHEDULE_FILE));
+  UNIT_TEST_ASSERT(memcmp(&bf, &other, sizeof(bf)) != 0);
+  blowfish_initialize(key, sizeof(key) - 2, &bf);
+  UNIT_TEST_ASSERT(memcmp(&bf, &other, sizeof(bf)) == 0);
+
+  UNIT_TEST_ASSERT(blowfish_initialize_persistent(key, 0, &other, SCHEDULE_FILE) == 0);
+  cfs_remove(SCHEDULE_FILE);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+/* Time stamp counter of the host, 0 where there is none */
+static uint64_t
+cycles(void)
+{
+#if defined(__i386__) || defined(__x86_64__)
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+/*---------------------------------------------------------------------------*/
+/* Bulk throughput and the cost of the key expansion against reading it back */
+static void
+benchmark(void)
+{
+  clock_time_t start, elapsed;
+  uint64_t tsc;
+  uint8_t counter[8];
+  int i;
+
+  blowfish_initialize(key, sizeof(key) - 1, &bf);
+  start = clock_time();
+  tsc = cycles();
+  for(i = 0; i < 512; i++) {
+    blowfish_ecb(&bf, plain, cipher, BULK_BYTES, BLOWFISH_ENCRYPT);
+  }
+  tsc = cycles() - tsc;
+  elapsed = clock_time() - start;
+  printf("Blowfish ECB: %lu kB/s, %lu cycles/block, ", (unsigned long)(elapsed ?
+         512UL * BULK_BYTES / 1024 * CLOCK_SECOND / elapsed : 0),
+         (unsigned long)(tsc / BULK_BLOCKS));
+
+  memset(counter, 0, sizeof(counter));
+  start = clock_time();
+  tsc = cycles();
+  for(i = 0; i < 512; i++) {
+    blowfish_ctr(&bf, counter, plain, cipher, BULK_BYTES);
+  }
+  tsc = cycles() - tsc;
+  elapsed = clock_time() - start;
+  printf("CTR: %lu kB/s, %lu cycles/block\n", (unsigned long)(elapsed ?
+         512UL * BULK_BYTES / 1024 * CLOCK_SECOND / elapsed : 0),
+         (unsigned long)(tsc / BULK_BLOCKS));
+
+  start = clock_time();
+  for(i = 0; i < 2000; i++) {
+    blowfish_initialize(key, sizeof(key) - 1, &bf);
+  }
+  printf("Key schedule: %lu us computed, ",
+         (unsigned long)((clock_time() - start) * 500 / CLOCK_SECOND));
+
+  blowfish_initialize_persistent(key, sizeof(key) - 1, &bf, SCHEDULE_FILE);
+  start = clock_time();
+  for(i = 0; i < 2000; i++) {
+    blowfish_initialize_persistent(key, sizeof(key) - 1, &bf, SCHEDULE_FILE);
+  }
+  printf("%lu us read back\n",
+         (unsigned long)((clock_time() - start) * 500 / CLOCK_SECOND));
+  cfs_remove(SCHEDULE_FILE);
+}
+/*---------------------------------------------------------------------------*/
+PROCESS(blowfish_test_process, "Blowfish test");
+AUTOSTART_PROCESSES(&blowfish_test_process);
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(blowfish_test_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  UNIT_TEST_RUN(known_answer);
+  UNIT_TEST_RUN(modes);
+  UNIT_TEST_RUN(persistent);
+
+  benchmark();
+
+  exit(UNIT_TEST_RESULT(known_answer) == unit_test_success
+       && UNIT_TEST_RESULT(modes) == unit_test_success
+       && UNIT_TEST_RESULT(persistent) == unit_test_success ? 0 : 1);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
+
+/** @} */
@@ -0,0 +1,387 @@
+/*
+ * Copyright (c) 2015, Institute for Pervasive Computing, ETH Zurich.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/**
+ * \addtogroup native-crypto-examples
+ * @{
+ *
+ * \file
+ *     Tests of the crypto job queue with timed software engines and pka-sw
+ */
+#include "contiki.h"
+#include "crypto-queue.h"
+#include "crypto-queue-pka.h"
+#include "bignum-driver.h"
+#include "ecc-curve.h"
+#include "pka.h"
+#include "unit-test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*---------------------------------------------------------------------------*/
+/* A software engine that finishes after a delay and polls like an ISR, or
+ * when the test calls timed_done() if the duration is 0 */
+typedef struct {
+  struct ctimer timer;
+  struct process *notify;
+  clock_time_t duration;
+  uint8_t id;
+  uint8_t busy_once;              //Claims the engine is in use once
+  uint8_t done;
+} timed_op_t;
+
+static void
+timed_done(void *ptr)
+{
+  timed_op_t *op = ptr;
+
+  op->done = 1;
+  process_poll(op->notify);
+}
+
+static uint8_t
+timed_start(crypto_job_t *job, struct process *notify)
+{
+  timed_op_t *op = job->arg;
+
+  if(op->busy_once) {
+    op->busy_once = 0;
+    return CRYPTO_QUEUE_RETRY;
+  }
+  op->done = 0;
+  op->notify = notify;
+  if(op->duration) {
+    ctimer_set(&op->timer, op->duration, timed_done, op);
+  }
+  return 0;
+}
+
+static uint8_t
+timed_check(crypto_job_t *job)
+{
+  return ((timed_op_t *)job->arg)->done;
+}
+
+static uint8_t
+timed_finish(crypto_job_t *job)
+{
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+/* A multiplication on the software PKA */
+typedef struct {
+  uint32_t a[4], b[4], product[8];
+  uint32_t len, rv;
+} mult_op_t;
+
+static uint8_t
+mult_start(crypto_job_t *job, struct process *notify)
+{
+  mult_op_t *op = job->arg;
+
+  return PKABigNumMultiplyStart(op->a, 4, op->b, 4, &op->rv, notify);
+}
+
+static uint8_t
+mult_check(crypto_job_t *job)
+{
+  return pka_check_status();
+}
+
+static uint8_t
+mult_finish(crypto_job_t *job)
+{
+  mult_op_t *op = job->arg;
+
+  op->len = 8;
+  return PKABigNumMultGetResult(op->product, &op->len, op->rv);
+}
+/*---------------------------------------------------------------------------*/
+#define JOBS 12
+
+static crypto_job_t jobs[JOBS];
+static timed_op_t ops[JOBS];
+static mult_op_t mult;
+static uint8_t order[JOBS], completed;
+static uint8_t full_result;
+static crypto_queue_stats_t stats;
+
+static crypto_job_t ecc_jobs[3];
+static crypto_queue_ecc_t ecc_ops[3];
+static ec_point_t g, double_g, triple_g, sum;
+static uint32_t two[8], three[8];
+static uint32_t pinned;
+static uint8_t held;
+
+static void
+timed_job(uint8_t i, uint8_t engine, uint8_t priority, clock_time_t duration)
+{
+  memset(&jobs[i], 0, sizeof(crypto_job_t));
+  memset(&ops[i], 0, sizeof(timed_op_t));
+  ops[i].id = i;
+  ops[i].duration = duration;
+  jobs[i].start = timed_start;
+  jobs[i].check = timed_check;
+  jobs[i].finish = timed_finish;
+  jobs[i].arg = &ops[i];
+  jobs[i].process = PROCESS_CURRENT();
+  jobs[i].engine = engine;
+  jobs[i].priority = priority;
+}
+
+static void
+ecc_op(uint8_t i, uint8_t op, uint32_t *scalar, ec_point_t *point_a,
+       ec_point_t *point_out)
+{
+  memset(&ecc_jobs[i], 0, sizeof(crypto_job_t));
+  memset(&ecc_ops[i], 0, sizeof(crypto_queue_ecc_t));
+  ecc_ops[i].op = op;
+  ecc_ops[i].curve_info = &nist_p_256;
+  ecc_ops[i].scalar = scalar;
+  ecc_ops[i].point_a = point_a;
+  ecc_ops[i].point_out = point_out;
+  crypto_queue_ecc_job(&ecc_jobs[i], &ecc_ops[i]);
+  ecc_jobs[i].process = PROCESS_CURRENT();
+  ecc_jobs[i].priority = CRYPTO_QUEUE_PRIO_NORMAL;
+}
+
+static void
+record(crypto_job_t *job)
+{
+  uint8_t i = job - jobs;
+
+  order[completed++] = i;
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(priorities, "Crypto queue priorities");
+UNIT_TEST_REGISTER(overlap, "Crypto queue engine overlap");
+UNIT_TEST_REGISTER(pka, "Crypto queue PKA job and limits");
+UNIT_TEST_REGISTER(ecc, "Crypto queue ECC jobs");
+UNIT_TEST_REGISTER(lock, "Crypto queue PKA lock");
+/*---------------------------------------------------------------------------*/
+UNIT_TEST(priorities)
+{
+  static const uint8_t expected[] = { 0, 3, 2, 4, 1 };
+
+  UNIT_TEST_BEGIN();
+
+  /* job 0 runs first, the others queue behind it by priority */
+  UNIT_TEST_ASSERT(completed == sizeof(expected));
+  UNIT_TEST_ASSERT(memcmp(order, expected, sizeof(expected)) == 0);
+  UNIT_TEST_ASSERT(jobs[3].wait >= 20);
+  UNIT_TEST_ASSERT(jobs[1].wait > jobs[4].wait);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST(overlap)
+{
+  UNIT_TEST_BEGIN();
+
+  /* the PKA job completed while the AES job still held its engine */
+  UNIT_TEST_ASSERT(completed == 2);
+  UNIT_TEST_ASSERT(order[0] == 6 && order[1] == 5);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST(pka)
+{
+  UNIT_TEST_BEGIN();
+
+  /* (2^32 - 1)^2 = 0xfffffffe00000001 */
+  UNIT_TEST_ASSERT(jobs[7].result == PKA_STATUS_SUCCESS);
+  UNIT_TEST_ASSERT(mult.product[0] == 1 && mult.product[1] == 0xfffffffe);
+
+  /* the deferred start was retried */
+  UNIT_TEST_ASSERT(stats.retries == 1);
+  UNIT_TEST_ASSERT(full_result == CRYPTO_QUEUE_FULL);
+  UNIT_TEST_ASSERT(stats.depth == 0);
+  UNIT_TEST_ASSERT(stats.max_depth == CRYPTO_QUEUE_SIZE);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST(ecc)
+{
+  UNIT_TEST_BEGIN();
+
+  UNIT_TEST_ASSERT(ecc_jobs[0].done && ecc_jobs[0].result == PKA_STATUS_SUCCESS);
+  UNIT_TEST_ASSERT(ecc_jobs[1].done && ecc_jobs[1].result == PKA_STATUS_SUCCESS);
+  UNIT_TEST_ASSERT(ecc_jobs[2].done && ecc_jobs[2].result == PKA_STATUS_SUCCESS);
+  UNIT_TEST_ASSERT(memcmp(sum.pui32X, triple_g.pui32X, sizeof(uint32_t) * 8) == 0);
+  UNIT_TEST_ASSERT(memcmp(sum.pui32Y, triple_g.pui32Y, sizeof(uint32_t) * 8) == 0);
+  UNIT_TEST_ASSERT(memcmp(double_g.pui32X, g.pui32X, sizeof(uint32_t) * 8) != 0);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST(lock)
+{
+  UNIT_TEST_BEGIN();
+
+  /* the add job was retried until the test process released the PKA RAM */
+  UNIT_TEST_ASSERT(held);
+  UNIT_TEST_ASSERT(ecc_jobs[2].done && ecc_jobs[2].result == PKA_STATUS_SUCCESS);
+  UNIT_TEST_ASSERT(!PKABigNumLocked());
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS(crypto_queue_test_process, "Crypto queue test");
+AUTOSTART_PROCESSES(&crypto_queue_test_process);
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(crypto_queue_test_process, ev, data)
+{
+  static uint8_t i, pending;
+  static struct etimer timeout;
+
+  PROCESS_BEGIN();
+
+  pka_init();
+  crypto_queue_init();
+
+  /* Priorities: 0 keeps the engine busy while 1 to 4 are queued */
+  timed_job(0, CRYPTO_QUEUE_AES, CRYPTO_QUEUE_PRIO_NORMAL, 20);
+  timed_job(1, CRYPTO_QUEUE_AES, CRYPTO_QUEUE_PRIO_LOW, 5);
+  timed_job(2, CRYPTO_QUEUE_AES, CRYPTO_QUEUE_PRIO_NORMAL, 5);
+  timed_job(3, CRYPTO_QUEUE_AES, CRYPTO_QUEUE_PRIO_HIGH, 5);
+  timed_job(4, CRYPTO_QUEUE_AES, CRYPTO_QUEUE_PRIO_NORMAL, 5);
+  crypto_queue_submit(&jobs[0]);
+  PROCESS_PAUSE();
+  completed = 0;
+  for(i = 1; i <= 4; i++) {
+    crypto_queue_submit(&jobs[i]);
+  }
+  for(pending = 5; pending; pending--) {
+    PROCESS_WAIT_EVENT_UNTIL(ev == crypto_queue_event);
+    record(data);
+  }
+  UNIT_TEST_RUN(priorities);
+
+  /* Overlap of the two engines: 5 holds the AES engine until 6 completed,
+   * or until the timeout if the PKA job does not start */
+  completed = 0;
+  timed_job(5, CRYPTO_QUEUE_AES, CRYPTO_QUEUE_PRIO_NORMAL, 0);
+  timed_job(6, CRYPTO_QUEUE_PKA, CRYPTO_QUEUE_PRIO_NORMAL, 10);
+  crypto_queue_submit(&jobs[5]);
+  crypto_queue_submit(&jobs[6]);
+  etimer_set(&timeout, CLOCK_SECOND);
+  PROCESS_WAIT_EVENT_UNTIL(ev == crypto_queue_event || etimer_expired(&timeout));
+  if(ev == crypto_queue_event) {
+    record(data);
+  }
+  timed_done(&ops[5]);
+  while(completed < 2) {
+    PROCESS_WAIT_EVENT_UNTIL(ev == crypto_queue_event);
+    record(data);
+  }
+  UNIT_TEST_RUN(overlap);
+
+  /* A multiplication on pka-sw behind a deferred start, and a full queue */
+  completed = 0;
+  memset(&jobs[7], 0, sizeof(crypto_job_t));
+  memset(&mult, 0, sizeof(mult));
+  mult.a[0] = mult.b[0] = 0xffffffff;
+  jobs[7].start = mult_start;
+  jobs[7].check = mult_check;
+  jobs[7].finish = mult_finish;
+  jobs[7].arg = &mult;
+  jobs[7].process = PROCESS_CURRENT();
+  jobs[7].engine = CRYPTO_QUEUE_PKA;
+  timed_job(8, CRYPTO_QUEUE_PKA, CRYPTO_QUEUE_PRIO_HIGH, 10);
+  ops[8].busy_once = 1;
+  crypto_queue_submit(&jobs[8]);
+  crypto_queue_submit(&jobs[7]);
+  for(i = 9; i < JOBS; i++) {
+    timed_job(i, CRYPTO_QUEUE_AES, CRYPTO_QUEUE_PRIO_NORMAL, 1);
+    crypto_queue_submit(&jobs[i]);
+  }
+  /* fills the queue, nothing started yet */
+  for(i = 0; i < CRYPTO_QUEUE_SIZE - (JOBS - 7); i++) {
+    crypto_queue_submit(&jobs[i]);
+  }
+  full_result = crypto_queue_submit(&jobs[5]);
+  for(pending = CRYPTO_QUEUE_SIZE; pending; pending--) {
+    PROCESS_WAIT_EVENT_UNTIL(ev == crypto_queue_event);
+    record(data);
+  }
+  crypto_queue_stats(&stats);
+  UNIT_TEST_RUN(pka);
+
+  /* 2G and 3G on the PKA, then 2G + G */
+  memset(&g, 0, sizeof(g));
+  memcpy(g.pui32X, nist_p_256.pui32Gx, sizeof(uint32_t) * 8);
+  memcpy(g.pui32Y, nist_p_256.pui32Gy, sizeof(uint32_t) * 8);
+  two[0] = 2;
+  three[0] = 3;
+  ecc_op(0, CRYPTO_QUEUE_ECC_MULT_GEN, two, NULL, &double_g);
+  ecc_op(1, CRYPTO_QUEUE_ECC_MULTIPLY, three, &g, &triple_g);
+  crypto_queue_submit(&ecc_jobs[0]);
+  crypto_queue_submit(&ecc_jobs[1]);
+  for(pending = 2; pending; pending--) {
+    PROCESS_WAIT_EVENT_UNTIL(ev == crypto_queue_event);
+  }
+  ecc_op(2, CRYPTO_QUEUE_ECC_ADD, NULL, &double_g, &sum);
+  ecc_ops[2].point_b = &g;
+
+  /* The add job waits while this process holds the PKA RAM */
+  held = PKABigNumLock() == PKA_STATUS_SUCCESS
+    && PKABigNumPin(three, 8, &pinned) == PKA_STATUS_SUCCESS;
+  crypto_queue_submit(&ecc_jobs[2]);
+  etimer_set(&timeout, CLOCK_SECOND / 8);
+  PROCESS_WAIT_EVENT_UNTIL(ev == crypto_queue_event || etimer_expired(&timeout));
+  if(ev == crypto_queue_event) {
+    held = 0;
+  } else {
+    PKABigNumUnlock();
+    PROCESS_WAIT_EVENT_UNTIL(ev == crypto_queue_event);
+  }
+  UNIT_TEST_RUN(ecc);
+  UNIT_TEST_RUN(lock);
+
+  printf("Crypto queue: %lu jobs, %lu retries, max depth %u, wait %lu ms total, %lu ms max\n",
+         (unsigned long)stats.jobs, (unsigned long)stats.retries, stats.max_depth,
+         (unsigned long)(stats.wait_total * 1000 / CLOCK_SECOND),
+         (unsigned long)(stats.wait_max * 1000 / CLOCK_SECOND));
+
+  pka_disable();
+
+  exit(UNIT_TEST_RESULT(priorities) == unit_test_success
+       && UNIT_TEST_RESULT(overlap) == unit_test_success
+       && UNIT_TEST_RESULT(pka) == unit_test_success
+       && UNIT_TEST_RESULT(ecc) == unit_test_success
+       && UNIT_TEST_RESULT(lock) == unit_test_success ? 0 : 1);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
+
+/** @} */
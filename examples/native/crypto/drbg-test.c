@@ -0,0 +1,372 @@
+/*
+ * Copyright (c) 2015, Institute for Pervasive Computing, ETH Zurich.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/**
+ * \addtogroup native-crypto-examples
+ * @{
+ *
+ * \file
+ *     Tests of the CTR-DRBG on the software AES backend
+ */
+#include "contiki.h"
+#include "ctr-drbg.h"
+#include "lib/aes-128.h"
+#include "lib/random.h"
+#include "unit-test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BULK_BYTES 4096
+/*---------------------------------------------------------------------------*/
+static uint8_t out[BULK_BYTES + 16], check[BULK_BYTES];
+static uint8_t ref_key[16], ref_v[16];
+
+/* From the OpenSSL 3 CTR-DRBG (AES-128-CTR, derivation function, empty
+ * personalization string): entropy seed[0..47] and nonce seed[48..63],
+ * 64 and 37 bytes, reseed (passed as the parent's entropy), 48 bytes */
+static const uint8_t seed[] = {
+  0x01, 0x08, 0x0f, 0x16, 0x1d, 0x24, 0x2b, 0x32,
+  0x39, 0x40, 0x47, 0x4e, 0x55, 0x5c, 0x63, 0x6a,
+  0x71, 0x78, 0x7f, 0x86, 0x8d, 0x94, 0x9b, 0xa2,
+  0xa9, 0xb0, 0xb7, 0xbe, 0xc5, 0xcc, 0xd3, 0xda,
+  0xe1, 0xe8, 0xef, 0xf6, 0xfd, 0x04, 0x0b, 0x12,
+  0x19, 0x20, 0x27, 0x2e, 0x35, 0x3c, 0x43, 0x4a,
+  0xa0, 0xa1, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7,
+  0xa8, 0xa9, 0xaa, 0xab, 0xac, 0xad, 0xae, 0xaf
+};
+static const uint8_t reseed[] = {
+  0x55, 0x56, 0x53, 0x5c, 0x59, 0x5a, 0x47, 0x40,
+  0x4d, 0x4e, 0x4b, 0x74, 0x71, 0x72, 0x7f, 0x78,
+  0x65, 0x66, 0x63, 0x6c, 0x69, 0x6a, 0x17, 0x10,
+  0x1d, 0x1e, 0x1b, 0x04, 0x01, 0x02, 0x0f, 0x08,
+  0x35, 0x36, 0x33, 0x3c, 0x39, 0x3a, 0x27, 0x20
+};
+static const uint8_t expected1[] = {
+  0x1d, 0x22, 0xe0, 0xf4, 0x5f, 0x96, 0xc6, 0xac,
+  0x90, 0xc2, 0x4b, 0x32, 0x0f, 0x8b, 0x9a, 0xa8,
+  0x70, 0x0c, 0x6d, 0x78, 0x14, 0x81, 0x27, 0xe5,
+  0x0f, 0xf0, 0x4b, 0xa2, 0x47, 0x1c, 0xc8, 0xe0,
+  0x32, 0x57, 0xa0, 0x6f, 0xc7, 0xa5, 0x27, 0xa8,
+  0xac, 0xa7, 0x03, 0xb2, 0x52, 0x39, 0xf9, 0x40,
+  0x4b, 0x21, 0x0d, 0x87, 0x73, 0x12, 0x36, 0xcd,
+  0xf9, 0x70, 0x57, 0x49, 0x24, 0x82, 0x2c, 0x6b
+};
+static const uint8_t expected2[] = {
+  0x38, 0x2f, 0xa0, 0x66, 0xeb, 0x95, 0x0d, 0x2f,
+  0x7d, 0x91, 0xd2, 0x9b, 0x81, 0x11, 0x6a, 0xf7,
+  0x0c, 0xf7, 0xdd, 0x68, 0x20, 0xff, 0xf5, 0x7f,
+  0x7b, 0x5a, 0x39, 0x63, 0xb2, 0xd7, 0x7e, 0x86,
+  0x58, 0xa1, 0x4c, 0xc7, 0xf4
+};
+static const uint8_t expected3[] = {
+  0x21, 0xc5, 0x1b, 0x47, 0xca, 0x3d, 0x4b, 0x61,
+  0xbb, 0xff, 0x1e, 0x79, 0xd8, 0x99, 0x36, 0x2d,
+  0x94, 0x31, 0x69, 0x37, 0x12, 0x11, 0x1c, 0x54,
+  0xfd, 0xad, 0x70, 0x05, 0x0e, 0x47, 0x76, 0xf4,
+  0xe7, 0x0e, 0xab, 0x91, 0xb5, 0x7c, 0x5d, 0xa1,
+  0x2b, 0xac, 0xed, 0xb5, 0x2b, 0xc5, 0x4b, 0x4d
+};
+/*---------------------------------------------------------------------------*/
+/* Reference CTR-DRBG of SP 800-90A (AES-128, derivation function), one
+ * block at a time with a 128 bit counter */
+static void
+ref_block(uint8_t *block)
+{
+  int i;
+
+  for(i = 15; i >= 0 && ++ref_v[i] == 0; i--);
+  memcpy(block, ref_v, 16);
+  AES_128.set_key(ref_key);
+  AES_128.encrypt(block);
+}
+
+static void
+ref_update(const uint8_t *data)
+{
+  uint8_t temp[32];
+  int i;
+
+  ref_block(temp);
+  ref_block(temp + 16);
+  for(i = 0; data != NULL && i < 32; i++) {
+    temp[i] ^= data[i];
+  }
+  memcpy(ref_key, temp, 16);
+  memcpy(ref_v, temp + 16, 16);
+}
+
+/* Block_Cipher_df from a buffer holding S = L || N || input || 0x80 || 0... */
+static void
+ref_df(const uint8_t *input, uint16_t len, uint8_t *material)
+{
+  static uint8_t s[16 + 8 + sizeof(seed) + 16];
+  uint8_t temp[32], k[16];
+  uint16_t n, i, j;
+
+  memset(s, 0, sizeof(s));
+  s[16 + 2] = len >> 8;
+  s[16 + 3] = len;
+  s[16 + 7] = 32;
+  memcpy(s + 16 + 8, input, len);
+  s[16 + 8 + len] = 0x80;
+  n = (16 + 8 + len + 1 + 15) & ~15;
+
+  for(i = 0; i < 16; i++) {
+    k[i] = i;
+  }
+  AES_128.set_key(k);
+  for(i = 0; i < 2; i++) {
+    s[3] = i;
+    memset(temp + 16 * i, 0, 16);
+    for(j = 0; j < n; j++) {
+      temp[16 * i + j % 16] ^= s[j];
+      if(j % 16 == 15) {
+        AES_128.encrypt(temp + 16 * i);
+      }
+    }
+  }
+  AES_128.set_key(temp);
+  memcpy(material, temp + 16, 16);
+  AES_128.encrypt(material);
+  memcpy(material + 16, material, 16);
+  AES_128.encrypt(material + 16);
+}
+
+static void
+ref_instantiate(const uint8_t *data, uint16_t len)
+{
+  uint8_t material[32];
+
+  ref_df(data, len, material);
+  memset(ref_key, 0, sizeof(ref_key));
+  memset(ref_v, 0, sizeof(ref_v));
+  ref_update(material);
+}
+
+static void
+ref_reseed(const uint8_t *data, uint16_t len)
+{
+  uint8_t material[32];
+
+  ref_df(data, len, material);
+  ref_update(material);
+}
+
+static void
+ref_generate(uint8_t *buf, uint16_t len)
+{
+  uint8_t block[16];
+  uint16_t n;
+
+  while(len) {
+    ref_block(block);
+    n = len < 16 ? len : 16;
+    memcpy(buf, block, n);
+    buf += n;
+    len -= n;
+  }
+  ref_update(NULL);
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(known_answer, "CTR-DRBG known answers");
+UNIT_TEST_REGISTER(reference, "CTR-DRBG against the reference");
+UNIT_TEST_REGISTER(lengths, "CTR-DRBG request lengths");
+UNIT_TEST_REGISTER(seeding, "CTR-DRBG seeding");
+UNIT_TEST_REGISTER(interval, "CTR-DRBG reseed interval");
+/*---------------------------------------------------------------------------*/
+UNIT_TEST(known_answer)
+{
+  UNIT_TEST_BEGIN();
+
+  UNIT_TEST_ASSERT(ctr_drbg_instantiate(seed, sizeof(seed)) == CTR_DRBG_SUCCESS);
+  UNIT_TEST_ASSERT(ctr_drbg_generate(out, sizeof(expected1)) == CTR_DRBG_SUCCESS);
+  UNIT_TEST_ASSERT(memcmp(out, expected1, sizeof(expected1)) == 0);
+  UNIT_TEST_ASSERT(ctr_drbg_generate(out, sizeof(expected2)) == CTR_DRBG_SUCCESS);
+  UNIT_TEST_ASSERT(memcmp(out, expected2, sizeof(expected2)) == 0);
+  UNIT_TEST_ASSERT(ctr_drbg_reseed(reseed, sizeof(reseed)) == CTR_DRBG_SUCCESS);
+  UNIT_TEST_ASSERT(ctr_drbg_generate(out, sizeof(expected3)) == CTR_DRBG_SUCCESS);
+  UNIT_TEST_ASSERT(memcmp(out, expected3, sizeof(expected3)) == 0);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST(reference)
+{
+  static const uint16_t lens[] = { 64, 37, 16, 1, 0, BULK_BYTES };
+  int i;
+
+  UNIT_TEST_BEGIN();
+
+  UNIT_TEST_ASSERT(ctr_drbg_instantiate(seed, 40) == CTR_DRBG_SUCCESS);
+  ref_instantiate(seed, 40);
+  for(i = 0; i < sizeof(lens) / sizeof(lens[0]); i++) {
+    UNIT_TEST_ASSERT(ctr_drbg_generate(out, lens[i]) == CTR_DRBG_SUCCESS);
+    ref_generate(check, lens[i]);
+    UNIT_TEST_ASSERT(memcmp(out, check, lens[i]) == 0);
+  }
+
+  UNIT_TEST_ASSERT(ctr_drbg_reseed(reseed, 17) == CTR_DRBG_SUCCESS);
+  ref_reseed(reseed, 17);
+  UNIT_TEST_ASSERT(ctr_drbg_generate(out, 100) == CTR_DRBG_SUCCESS);
+  ref_generate(check, 100);
+  UNIT_TEST_ASSERT(memcmp(out, check, 100) == 0);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST(lengths)
+{
+  uint16_t len;
+
+  UNIT_TEST_BEGIN();
+
+  /* nothing is written past the requested length */
+  for(len = 1; len <= 48; len++) {
+    memset(out, 0xa5, sizeof(out));
+    UNIT_TEST_ASSERT(ctr_drbg_generate(out, len) == CTR_DRBG_SUCCESS);
+    UNIT_TEST_ASSERT(out[len] == 0xa5 && out[len + 15] == 0xa5);
+  }
+
+  /* consecutive requests never repeat */
+  UNIT_TEST_ASSERT(ctr_drbg_generate(out, 32) == CTR_DRBG_SUCCESS);
+  UNIT_TEST_ASSERT(ctr_drbg_generate(check, 32) == CTR_DRBG_SUCCESS);
+  UNIT_TEST_ASSERT(memcmp(out, check, 32) != 0);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST(seeding)
+{
+  UNIT_TEST_BEGIN();
+
+  /* the same seed gives the same stream, a reseed changes it */
+  ctr_drbg_instantiate(seed, sizeof(seed));
+  UNIT_TEST_ASSERT(ctr_drbg_generate(out, 64) == CTR_DRBG_SUCCESS);
+  ctr_drbg_instantiate(seed, sizeof(seed));
+  UNIT_TEST_ASSERT(ctr_drbg_generate(check, 64) == CTR_DRBG_SUCCESS);
+  UNIT_TEST_ASSERT(memcmp(out, check, 64) == 0);
+  ctr_drbg_instantiate(seed, sizeof(seed));
+  UNIT_TEST_ASSERT(ctr_drbg_reseed(reseed, sizeof(reseed)) == CTR_DRBG_SUCCESS);
+  UNIT_TEST_ASSERT(ctr_drbg_generate(check, 64) == CTR_DRBG_SUCCESS);
+  UNIT_TEST_ASSERT(memcmp(out, check, 64) != 0);
+
+  /* a freshly collected seed differs from the fixed one */
+  ctr_drbg_init();
+  UNIT_TEST_ASSERT(ctr_drbg_generate(check, 64) == CTR_DRBG_SUCCESS);
+  UNIT_TEST_ASSERT(memcmp(out, check, 64) != 0);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST(interval)
+{
+  uint32_t i;
+
+  UNIT_TEST_BEGIN();
+
+  /* CTR_DRBG_RESEED_INTERVAL requests, then a reseed is required */
+  ctr_drbg_instantiate(seed, sizeof(seed));
+  for(i = 0; i < CTR_DRBG_RESEED_INTERVAL; i++) {
+    if(ctr_drbg_generate(out, 1) != CTR_DRBG_SUCCESS) {
+      break;
+    }
+  }
+  UNIT_TEST_ASSERT(i == CTR_DRBG_RESEED_INTERVAL);
+  memset(out, 0xa5, 16);
+  UNIT_TEST_ASSERT(ctr_drbg_generate(out, 16) == CTR_DRBG_RESEED);
+  UNIT_TEST_ASSERT(out[0] == 0xa5);
+  UNIT_TEST_ASSERT(ctr_drbg_reseed(reseed, sizeof(reseed)) == CTR_DRBG_SUCCESS);
+  UNIT_TEST_ASSERT(ctr_drbg_generate(out, 16) == CTR_DRBG_SUCCESS);
+
+  /* a new seed from the platform restarts the interval as well */
+  for(i = 0; i < CTR_DRBG_RESEED_INTERVAL; i++) {
+    ctr_drbg_generate(out, 1);
+  }
+  UNIT_TEST_ASSERT(ctr_drbg_generate(out, 16) == CTR_DRBG_RESEED);
+  ctr_drbg_init();
+  UNIT_TEST_ASSERT(ctr_drbg_generate(out, 16) == CTR_DRBG_SUCCESS);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+/* Bulk throughput against the 16 bit random_rand() loop it replaces */
+static void
+benchmark(void)
+{
+  clock_time_t start, elapsed;
+  unsigned short r;
+  int i, j;
+
+  start = clock_time();
+  for(i = 0; i < 256; i++) {
+    ctr_drbg_generate(out, BULK_BYTES);
+  }
+  elapsed = clock_time() - start;
+  printf("CTR-DRBG: %lu bytes/s, ", (unsigned long)(elapsed ?
+         256UL * BULK_BYTES * CLOCK_SECOND / elapsed : 0));
+
+  start = clock_time();
+  for(i = 0; i < 256; i++) {
+    for(j = 0; j < BULK_BYTES; j += 2) {
+      r = random_rand();
+      memcpy(out + j, &r, 2);
+    }
+  }
+  elapsed = clock_time() - start;
+  printf("random_rand: %lu bytes/s\n", (unsigned long)(elapsed ?
+         256UL * BULK_BYTES * CLOCK_SECOND / elapsed : 0));
+}
+/*---------------------------------------------------------------------------*/
+PROCESS(drbg_test_process, "CTR-DRBG test");
+AUTOSTART_PROCESSES(&drbg_test_process);
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(drbg_test_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  UNIT_TEST_RUN(known_answer);
+  UNIT_TEST_RUN(reference);
+  UNIT_TEST_RUN(lengths);
+  UNIT_TEST_RUN(seeding);
+  UNIT_TEST_RUN(interval);
+
+  benchmark();
+
+  exit(UNIT_TEST_RESULT(known_answer) == unit_test_success
+       && UNIT_TEST_RESULT(reference) == unit_test_success
+       && UNIT_TEST_RESULT(lengths) == unit_test_success
+       && UNIT_TEST_RESULT(seeding) == unit_test_success
+       && UNIT_TEST_RESULT(interval) == unit_test_success ? 0 : 1);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
+
+/** @} */
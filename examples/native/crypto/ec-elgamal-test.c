@@ -0,0 +1,537 @@
+/*
+ * Copyright (c) 2015, Institute for Pervasive Computing, ETH Zurich.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/**
+ * \addtogroup native-crypto-examples
+ * @{
+ *
+ * \file
+ *     Tests of EC-ElGamal and its discrete log decoder on the software PKA
+ */
+#include "contiki.h"
+#include "ec-elgamal-algorithm.h"
+#include "ecc-curve.h"
+#include "pka.h"
+#include "pt.h"
+#include "unit-test.h"
+#include "cfs/cfs.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*---------------------------------------------------------------------------*/
+#define TABLE_SIZE               64
+
+static uint32_t table_x[TABLE_SIZE];
+static uint16_t table_j[TABLE_SIZE];
+static ec_elgamal_bsgs_table_t table;
+
+static ec_elgmal_enc_state_t enc;
+static ec_elgamal_dlog_state_t dlog;
+
+/* The software PKA completes every operation inside the start function */
+#define RUN(state, thread) do {                                               \
+    PT_INIT(&(state)->pt);                                                    \
+    while(PT_SCHEDULE(thread));                                               \
+  } while(0)
+/*---------------------------------------------------------------------------*/
+static void
+generate_table(uint32_t *x, uint16_t *j, uint32_t size)
+{
+  memset(&dlog, 0, sizeof(dlog));
+  dlog.curve_info = &nist_p_192;
+  dlog.table_x = x;
+  dlog.table_j = j;
+  dlog.table_size = size;
+  RUN(&dlog, ec_elgamal_bsgs_generate(&dlog));
+
+  table.size = size;
+  table.x = x;
+  table.j = j;
+  dlog.table = &table;
+}
+/*---------------------------------------------------------------------------*/
+/* plain = m * G */
+static uint8_t
+map(ec_point_t *plain, uint32_t m)
+{
+  uint32_t scalar[12] = { m };
+  uint32_t rv;
+
+  memset(plain, 0, sizeof(*plain));
+  if(PKAECCMultGenPtStart(scalar, &nist_p_192, &rv, NULL) != PKA_STATUS_SUCCESS) {
+    return PKA_STATUS_FAILURE;
+  }
+  return PKAECCMultGenPtGetResult(plain, rv);
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t
+decode(uint32_t m, uint32_t bound)
+{
+  dlog.bound = bound;
+  dlog.plain_int = 0;
+  map(&dlog.plain, m);
+  RUN(&dlog, ec_elgamal_dlog(&dlog));
+  return dlog.result;
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(enc_dec, "EC-ElGamal encrypt/decrypt");
+UNIT_TEST_REGISTER(bsgs_table, "BSGS table");
+UNIT_TEST_REGISTER(bsgs_decode, "BSGS decode");
+UNIT_TEST_REGISTER(bsgs_sum, "BSGS decode of a homomorphic sum");
+UNIT_TEST_REGISTER(comb, "Encryption with fixed-base tables");
+UNIT_TEST_REGISTER(ring, "Encryption with pre-generated ephemeral pairs");
+UNIT_TEST_REGISTER(wire, "Compressed cipher-texts");
+UNIT_TEST_REGISTER(koblitz, "Koblitz encoding");
+/*---------------------------------------------------------------------------*/
+UNIT_TEST(enc_dec)
+{
+  ec_point_t expected;
+
+  UNIT_TEST_BEGIN();
+
+  memset(&enc, 0, sizeof(enc));
+  enc.curve_info = &nist_p_192;
+  RUN(&enc, ec_elgamal_generate(&enc));
+  UNIT_TEST_ASSERT(enc.result == PKA_STATUS_SUCCESS);
+
+  UNIT_TEST_ASSERT(map(&enc.plain, 4711) == PKA_STATUS_SUCCESS);
+  memcpy(&expected, &enc.plain, sizeof(expected));
+  RUN(&enc, ec_elgamal_enc(&enc));
+  UNIT_TEST_ASSERT(enc.result == PKA_STATUS_SUCCESS);
+  memset(&enc.plain, 0, sizeof(enc.plain));
+  RUN(&enc, ec_elgamal_dec(&enc));
+  UNIT_TEST_ASSERT(enc.result == PKA_STATUS_SUCCESS);
+  UNIT_TEST_ASSERT(memcmp(&enc.plain, &expected, sizeof(expected)) == 0);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST(bsgs_table)
+{
+  ec_point_t point;
+  uint32_t i;
+
+  UNIT_TEST_BEGIN();
+
+  generate_table(table_x, table_j, TABLE_SIZE);
+  UNIT_TEST_ASSERT(dlog.result == PKA_STATUS_SUCCESS);
+
+  for(i = 0; i < TABLE_SIZE; i++) {
+    UNIT_TEST_ASSERT(i == 0 || table_x[i - 1] <= table_x[i]);
+    UNIT_TEST_ASSERT(map(&point, table_j[i]) == PKA_STATUS_SUCCESS);
+    UNIT_TEST_ASSERT(point.pui32X[0] == table_x[i]);
+  }
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST(bsgs_decode)
+{
+  /* Around the window borders of 2M+1 = 129 */
+  static const uint32_t values[] = { 1, 2, 63, 64, 65, 128, 129, 130, 192,
+                                     193, 194, 1000, 4096, 20000 };
+  uint32_t i;
+
+  UNIT_TEST_BEGIN();
+
+  for(i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+    UNIT_TEST_ASSERT(decode(values[i], 20000) == PKA_STATUS_SUCCESS);
+    UNIT_TEST_ASSERT(dlog.plain_int == values[i]);
+  }
+  UNIT_TEST_ASSERT(dlog.giant_steps == 20000 / (2 * TABLE_SIZE + 1));
+
+  /* Out of range */
+  UNIT_TEST_ASSERT(decode(20001, 20000) == PKA_STATUS_FAILURE);
+  UNIT_TEST_ASSERT(decode(100, 99) == PKA_STATUS_FAILURE);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST(bsgs_sum)
+{
+  static ec_point_t p1, p2;
+  uint32_t rv;
+
+  UNIT_TEST_BEGIN();
+
+  /* Enc(1234) + Enc(5678) */
+  UNIT_TEST_ASSERT(map(&enc.plain, 1234) == PKA_STATUS_SUCCESS);
+  RUN(&enc, ec_elgamal_enc(&enc));
+  UNIT_TEST_ASSERT(enc.result == PKA_STATUS_SUCCESS);
+  memcpy(&p1, &enc.cipher_p1, sizeof(p1));
+  memcpy(&p2, &enc.cipher_p2, sizeof(p2));
+
+  /* another ephemeral key, rG + rG would be a point doubling */
+  enc.random[0]++;
+  UNIT_TEST_ASSERT(map(&enc.plain, 5678) == PKA_STATUS_SUCCESS);
+  RUN(&enc, ec_elgamal_enc(&enc));
+  UNIT_TEST_ASSERT(enc.result == PKA_STATUS_SUCCESS);
+
+  UNIT_TEST_ASSERT(PKAECCAddStart(&enc.cipher_p1, &p1, &nist_p_192, &rv, NULL) == PKA_STATUS_SUCCESS);
+  UNIT_TEST_ASSERT(PKAECCAddGetResult(&enc.cipher_p1, rv) == PKA_STATUS_SUCCESS);
+  UNIT_TEST_ASSERT(PKAECCAddStart(&enc.cipher_p2, &p2, &nist_p_192, &rv, NULL) == PKA_STATUS_SUCCESS);
+  UNIT_TEST_ASSERT(PKAECCAddGetResult(&enc.cipher_p2, rv) == PKA_STATUS_SUCCESS);
+
+  RUN(&enc, ec_elgamal_dec(&enc));
+  UNIT_TEST_ASSERT(enc.result == PKA_STATUS_SUCCESS);
+
+  memcpy(&dlog.plain, &enc.plain, sizeof(dlog.plain));
+  dlog.bound = 10000;
+  RUN(&dlog, ec_elgamal_dlog(&dlog));
+  UNIT_TEST_ASSERT(dlog.result == PKA_STATUS_SUCCESS);
+  UNIT_TEST_ASSERT(dlog.plain_int == 1234 + 5678);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+/* Encrypts with and without the tables, both ciphers have to be equal */
+static int
+comb_encrypt(uint32_t m)
+{
+  ec_point_t p1, p2;
+  uint32_t len = nist_p_192.ui8Size * sizeof(uint32_t);
+
+  map(&enc.plain, m);
+  enc.comb = 0;
+  RUN(&enc, ec_elgamal_enc(&enc));
+  memcpy(&p1, &enc.cipher_p1, sizeof(p1));
+  memcpy(&p2, &enc.cipher_p2, sizeof(p2));
+
+  enc.comb = 1;
+  RUN(&enc, ec_elgamal_enc(&enc));
+  return enc.result == PKA_STATUS_SUCCESS
+         && memcmp(p1.pui32X, enc.cipher_p1.pui32X, len) == 0
+         && memcmp(p1.pui32Y, enc.cipher_p1.pui32Y, len) == 0
+         && memcmp(p2.pui32X, enc.cipher_p2.pui32X, len) == 0
+         && memcmp(p2.pui32Y, enc.cipher_p2.pui32Y, len) == 0;
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST(comb)
+{
+  ec_point_t expected;
+  uint32_t i;
+
+  UNIT_TEST_BEGIN();
+
+  cfs_remove(EC_ELGAMAL_COMB_FILE_G);
+  cfs_remove(EC_ELGAMAL_COMB_FILE_Q);
+
+  /* Build */
+  RUN(&enc, ec_elgamal_generate(&enc));
+  RUN(&enc, ec_elgamal_precompute(&enc));
+  UNIT_TEST_ASSERT(enc.result == PKA_STATUS_SUCCESS);
+  UNIT_TEST_ASSERT(enc.comb == 1);
+
+  /* Small, large and all-ones windows of r */
+  UNIT_TEST_ASSERT(comb_encrypt(4711));
+  enc.random[0] = 1;
+  memset(&enc.random[1], 0, sizeof(enc.random) - sizeof(uint32_t));
+  UNIT_TEST_ASSERT(comb_encrypt(4711));
+  for(i = 0; i < nist_p_192.ui8Size; i++) {
+    enc.random[i] = nist_p_192.pui32N[i] - (i == 0 ? 1 : 0);
+  }
+  UNIT_TEST_ASSERT(comb_encrypt(4711));
+  memset(enc.random, 0xff, sizeof(enc.random));
+  enc.random[nist_p_192.ui8Size - 1] = 0x0fffffff;
+  UNIT_TEST_ASSERT(comb_encrypt(4711));
+
+  /* Decrypts */
+  memcpy(&expected, &enc.plain, sizeof(expected));
+  memset(&enc.plain, 0, sizeof(enc.plain));
+  RUN(&enc, ec_elgamal_dec(&enc));
+  UNIT_TEST_ASSERT(memcmp(&enc.plain, &expected, sizeof(expected)) == 0);
+
+  /* Reload after a "reboot" */
+  RUN(&enc, ec_elgamal_precompute(&enc));
+  UNIT_TEST_ASSERT(enc.result == PKA_STATUS_SUCCESS);
+  UNIT_TEST_ASSERT(comb_encrypt(42));
+
+  /* A new key disables the tables, the Q table is rebuilt */
+  RUN(&enc, ec_elgamal_generate(&enc));
+  UNIT_TEST_ASSERT(enc.comb == 0);
+  RUN(&enc, ec_elgamal_precompute(&enc));
+  UNIT_TEST_ASSERT(enc.result == PKA_STATUS_SUCCESS);
+  UNIT_TEST_ASSERT(comb_encrypt(42));
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+/* Runs after the ring process filled the ring for the current key */
+UNIT_TEST(ring)
+{
+  const ec_elgamal_ring_stats_t *stats = ec_elgamal_ring_get_stats();
+  ec_point_t expected;
+  int i;
+
+  UNIT_TEST_BEGIN();
+
+  UNIT_TEST_ASSERT(ec_elgamal_ring_count() == EC_ELGAMAL_RING_SIZE);
+  UNIT_TEST_ASSERT(stats->filled == EC_ELGAMAL_RING_SIZE);
+  UNIT_TEST_ASSERT(stats->drained == 0);
+
+  /* The last encryption finds the ring empty and computes the pair itself */
+  for(i = 0; i <= EC_ELGAMAL_RING_SIZE; i++) {
+    map(&enc.plain, 1000 + i);
+    memcpy(&expected, &enc.plain, sizeof(expected));
+    RUN(&enc, ec_elgamal_enc(&enc));
+    UNIT_TEST_ASSERT(enc.result == PKA_STATUS_SUCCESS);
+    memset(&enc.plain, 0, sizeof(enc.plain));
+    RUN(&enc, ec_elgamal_dec(&enc));
+    UNIT_TEST_ASSERT(enc.result == PKA_STATUS_SUCCESS);
+    UNIT_TEST_ASSERT(memcmp(&enc.plain, &expected, sizeof(expected)) == 0);
+  }
+  UNIT_TEST_ASSERT(ec_elgamal_ring_count() == 0);
+  UNIT_TEST_ASSERT(stats->drained == EC_ELGAMAL_RING_SIZE);
+  UNIT_TEST_ASSERT(stats->empty == 1);
+
+  /* A new key discards the pairs */
+  RUN(&enc, ec_elgamal_generate(&enc));
+  UNIT_TEST_ASSERT(ec_elgamal_ring_count() == 0);
+
+  ec_elgamal_ring_stop();
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST(wire)
+{
+  static ec_elgmal_enc_state_t key;
+  static ec_elgamal_wire_state_t wire;
+  static ec_point_t sent[6];
+  static ec_point_t received[6];
+  static uint8_t frame[3 * EC_ELGAMAL_WIRE_LEN(8)];
+  ecc_curve_info_t *curves[2] = { &nist_p_192, &nist_p_256 };
+  uint32_t scalar[12] = { 0 };
+  uint32_t len, rv;
+  int c, i;
+
+  UNIT_TEST_BEGIN();
+
+  for(c = 0; c < 2; c++) {
+    memset(&key, 0, sizeof(key));
+    key.curve_info = curves[c];
+    RUN(&key, ec_elgamal_generate(&key));
+    UNIT_TEST_ASSERT(key.result == PKA_STATUS_SUCCESS);
+
+    /* A batch of three cipher-texts, back to back as in one frame */
+    len = 0;
+    for(i = 0; i < 3; i++) {
+      scalar[0] = 1000 + i;
+      UNIT_TEST_ASSERT(PKAECCMultGenPtStart(scalar, curves[c], &rv, NULL) == PKA_STATUS_SUCCESS);
+      UNIT_TEST_ASSERT(PKAECCMultGenPtGetResult(&key.plain, rv) == PKA_STATUS_SUCCESS);
+      RUN(&key, ec_elgamal_enc(&key));
+      UNIT_TEST_ASSERT(key.result == PKA_STATUS_SUCCESS);
+      memcpy(&sent[2 * i], &key.cipher_p1, sizeof(ec_point_t));
+      memcpy(&sent[2 * i + 1], &key.cipher_p2, sizeof(ec_point_t));
+      len += ec_elgamal_encode(&key, frame + len);
+    }
+    UNIT_TEST_ASSERT(len == 3 * EC_ELGAMAL_WIRE_LEN(curves[c]->ui8Size));
+    printf("%s: %lu bytes per cipher-text instead of %lu\n", curves[c]->name,
+           (unsigned long)(len / 3), (unsigned long)(16 * curves[c]->ui8Size));
+
+    memset(&wire, 0, sizeof(wire));
+    memset(received, 0, sizeof(received));
+    wire.curve_info = curves[c];
+    wire.wire = frame;
+    wire.count = 3;
+    wire.cipher = received;
+    RUN(&wire, ec_elgamal_decode(&wire));
+    UNIT_TEST_ASSERT(wire.result == PKA_STATUS_SUCCESS);
+    UNIT_TEST_ASSERT(memcmp(received, sent, sizeof(sent)) == 0);
+
+    /* x = p is rejected, as is an unknown prefix */
+    memset(frame + 1, 0, 4 * curves[c]->ui8Size);
+    for(i = 0; i < curves[c]->ui8Size; i++) {
+      frame[1 + 4 * i] = curves[c]->pui32Prime[curves[c]->ui8Size - 1 - i] >> 24;
+      frame[2 + 4 * i] = curves[c]->pui32Prime[curves[c]->ui8Size - 1 - i] >> 16;
+      frame[3 + 4 * i] = curves[c]->pui32Prime[curves[c]->ui8Size - 1 - i] >> 8;
+      frame[4 + 4 * i] = curves[c]->pui32Prime[curves[c]->ui8Size - 1 - i];
+    }
+    RUN(&wire, ec_elgamal_decode(&wire));
+    UNIT_TEST_ASSERT(wire.result == PKA_STATUS_FAILURE);
+    frame[0] = 0x04;
+    RUN(&wire, ec_elgamal_decode(&wire));
+    UNIT_TEST_ASSERT(wire.result == PKA_STATUS_FAILURE);
+  }
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+static ec_elgmal_map_state_t koblitz_map;
+/*---------------------------------------------------------------------------*/
+static uint8_t
+koblitz(uint32_t m, uint8_t int_to_ecpoint)
+{
+  koblitz_map.curve_info = &nist_p_192;
+  koblitz_map.K = 32;
+  koblitz_map.int_to_ecpoint = int_to_ecpoint;
+  if(int_to_ecpoint) {
+    memset(koblitz_map.plain_int, 0, sizeof(koblitz_map.plain_int));
+    koblitz_map.plain_int[0] = m;
+    koblitz_map.plain_len = 1;
+  } else {
+    koblitz_map.plain_len = sizeof(koblitz_map.plain_int) / sizeof(uint32_t);
+  }
+  RUN(&koblitz_map, ec_elgamal_map_koblitz(&koblitz_map));
+  return koblitz_map.result;
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST(koblitz)
+{
+  static ec_elgmal_enc_state_t point;
+  static ec_elgamal_wire_state_t wire;
+  static ec_point_t decoded[2];
+  static uint8_t frame[EC_ELGAMAL_WIRE_LEN(6)];
+  uint32_t m;
+
+  UNIT_TEST_BEGIN();
+
+  for(m = 1; m <= 8; m++) {
+    UNIT_TEST_ASSERT(koblitz(m, 1) == PKA_STATUS_SUCCESS);
+    UNIT_TEST_ASSERT(koblitz_map.j_rounds >= 1 && koblitz_map.j_rounds <= koblitz_map.K);
+
+    /* The decompression recomputes y and rejects points off the curve */
+    point.curve_info = &nist_p_192;
+    memcpy(&point.cipher_p1, &koblitz_map.plain_ec, sizeof(ec_point_t));
+    memcpy(&point.cipher_p2, &koblitz_map.plain_ec, sizeof(ec_point_t));
+    ec_elgamal_encode(&point, frame);
+    memset(&wire, 0, sizeof(wire));
+    wire.curve_info = &nist_p_192;
+    wire.wire = frame;
+    wire.count = 1;
+    wire.cipher = decoded;
+    RUN(&wire, ec_elgamal_decode(&wire));
+    UNIT_TEST_ASSERT(wire.result == PKA_STATUS_SUCCESS);
+    UNIT_TEST_ASSERT(memcmp(&decoded[0], &koblitz_map.plain_ec, sizeof(ec_point_t)) == 0);
+
+    UNIT_TEST_ASSERT(koblitz(0, 0) == PKA_STATUS_SUCCESS);
+    UNIT_TEST_ASSERT(koblitz_map.plain_int[0] == m);
+  }
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+/* Worst case decoding time of m <= 2^20 for several table sizes */
+static void
+benchmark(void)
+{
+  static uint32_t x[4096];
+  static uint16_t j[4096];
+  clock_time_t start, gen;
+  uint32_t size, attempts;
+
+  /* Koblitz encoding of m = 1..100, K = 32 */
+  attempts = 0;
+  start = clock_time();
+  for(size = 1; size <= 100; size++) {
+    koblitz(size, 1);
+    attempts += koblitz_map.j_rounds;
+  }
+  printf("Koblitz encoding: %lu.%02lu attempts per value, %lu us per value\n",
+         (unsigned long)(attempts / 100), (unsigned long)(attempts % 100),
+         (unsigned long)((clock_time() - start) * 10000 / CLOCK_SECOND));
+
+  printf("Fixed-base tables (window %u): ", EC_ELGAMAL_COMB_WINDOW);
+  start = clock_time();
+  RUN(&enc, ec_elgamal_generate(&enc));
+  RUN(&enc, ec_elgamal_precompute(&enc));
+  printf("build %lu ms, ", (unsigned long)((clock_time() - start) * 1000 / CLOCK_SECOND));
+  start = clock_time();
+  RUN(&enc, ec_elgamal_precompute(&enc));
+  printf("load %lu ms, ", (unsigned long)((clock_time() - start) * 1000 / CLOCK_SECOND));
+  for(enc.comb = 0; enc.comb < 2; enc.comb++) {
+    start = clock_time();
+    for(size = 0; size < 100; size++) {
+      RUN(&enc, ec_elgamal_enc(&enc));
+    }
+    printf("%s %lu ms per encryption%s", enc.comb ? "with tables" : "without tables",
+           (unsigned long)((clock_time() - start) * 10 / CLOCK_SECOND), enc.comb ? "\n" : ", ");
+  }
+  cfs_remove(EC_ELGAMAL_COMB_FILE_G);
+  cfs_remove(EC_ELGAMAL_COMB_FILE_Q);
+
+  printf("BSGS table size, generation [ms], worst case decoding of 2^20 [ms], giant steps\n");
+  for(size = 256; size <= 4096; size *= 2) {
+    start = clock_time();
+    generate_table(x, j, size);
+    gen = clock_time() - start;
+
+    start = clock_time();
+    decode(1UL << 20, 1UL << 20);
+    printf("%lu, %lu, %lu, %lu\n", (unsigned long)size,
+           (unsigned long)(gen * 1000 / CLOCK_SECOND),
+           (unsigned long)((clock_time() - start) * 1000 / CLOCK_SECOND),
+           (unsigned long)dlog.giant_steps);
+  }
+}
+/*---------------------------------------------------------------------------*/
+PROCESS(ec_elgamal_test_process, "EC-ElGamal test");
+AUTOSTART_PROCESSES(&ec_elgamal_test_process);
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(ec_elgamal_test_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  pka_init();
+
+  UNIT_TEST_RUN(enc_dec);
+  UNIT_TEST_RUN(bsgs_table);
+  UNIT_TEST_RUN(bsgs_decode);
+  UNIT_TEST_RUN(bsgs_sum);
+  UNIT_TEST_RUN(comb);
+  UNIT_TEST_RUN(wire);
+  UNIT_TEST_RUN(koblitz);
+
+  /* Fill the ring in the background */
+  RUN(&enc, ec_elgamal_generate(&enc));
+  ec_elgamal_ring_start(&enc);
+  while(ec_elgamal_ring_count() < EC_ELGAMAL_RING_SIZE) {
+    PROCESS_PAUSE();
+  }
+  UNIT_TEST_RUN(ring);
+
+  benchmark();
+
+  pka_disable();
+
+  exit(UNIT_TEST_RESULT(enc_dec) == unit_test_success
+       && UNIT_TEST_RESULT(bsgs_table) == unit_test_success
+       && UNIT_TEST_RESULT(bsgs_decode) == unit_test_success
+       && UNIT_TEST_RESULT(bsgs_sum) == unit_test_success
+       && UNIT_TEST_RESULT(comb) == unit_test_success
+       && UNIT_TEST_RESULT(ring) == unit_test_success
+       && UNIT_TEST_RESULT(wire) == unit_test_success
+       && UNIT_TEST_RESULT(koblitz) == unit_test_success ? 0 : 1);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
+
+/** @} */
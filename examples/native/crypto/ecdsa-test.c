@@ -0,0 +1,279 @@
+/*
+ * Copyright (c) 2015, Institute for Pervasive Computing, ETH Zurich.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/**
+ * \addtogroup native-crypto-examples
+ * @{
+ *
+ * \file
+ *     Tests of ECDSA and the joint multiplication on the software PKA
+ */
+#include "contiki.h"
+#include "bignum-driver.h"
+#include "ecc-algorithm.h"
+#include "ecc-curve.h"
+#include "pka.h"
+#include "pt.h"
+#include "random.h"
+#include "unit-test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*---------------------------------------------------------------------------*/
+static ecc_generate_state_t key;
+static ecc_dsa_sign_state_t sign;
+static ecc_dsa_verify_state_t verify;
+static ecc_dual_multiply_state_t dual;
+
+/* The software PKA completes every operation inside the start function */
+#define RUN(state, thread) do {                                               \
+    PT_INIT(&(state)->pt);                                                    \
+    while(PT_SCHEDULE(thread));                                               \
+  } while(0)
+/*---------------------------------------------------------------------------*/
+/* out = a * A + b * B by two multiplications and an addition */
+static uint8_t
+reference(const uint32_t *a, const ec_point_t *pa, const uint32_t *b,
+          const ec_point_t *pb, ec_point_t *out)
+{
+  ec_point_t p1, p2;
+  uint32_t rv;
+
+  if(PKAECCMultiplyStart((uint32_t *)a, (ec_point_t *)pa, &nist_p_256, &rv, NULL)
+     || PKAECCMultiplyGetResult(&p1, rv)
+     || PKAECCMultiplyStart((uint32_t *)b, (ec_point_t *)pb, &nist_p_256, &rv, NULL)
+     || PKAECCMultiplyGetResult(&p2, rv)
+     || PKAECCAddStart(&p1, &p2, &nist_p_256, &rv, NULL)) {
+    return PKA_STATUS_FAILURE;
+  }
+  return PKAECCAddGetResult(out, rv);
+}
+/*---------------------------------------------------------------------------*/
+static void
+random_scalar(uint32_t *scalar)
+{
+  int i;
+
+  memset(scalar, 0, sizeof(uint32_t) * 12);
+  for(i = 0; i < 8; i++) {
+    scalar[i] = (uint32_t)random_rand() | (uint32_t)random_rand() << 16;
+  }
+  scalar[7] &= 0x7fffffff;
+}
+/*---------------------------------------------------------------------------*/
+static void
+dual_setup(const ec_point_t *a, const ec_point_t *b)
+{
+  memset(&dual, 0, sizeof(dual));
+  dual.curve_info = &nist_p_256;
+  memcpy(&dual.point_a, a, sizeof(ec_point_t));
+  memcpy(&dual.point_b, b, sizeof(ec_point_t));
+}
+/*---------------------------------------------------------------------------*/
+static void
+sign_hash(uint32_t h)
+{
+  memset(&sign, 0, sizeof(sign));
+  sign.curve_info = &nist_p_256;
+  memcpy(sign.secret, key.secret, sizeof(sign.secret));
+  sign.hash[0] = h;
+  random_scalar(sign.k_e);
+  RUN(&sign, ecc_dsa_sign(&sign));
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t
+verify_hash(uint32_t h)
+{
+  memset(&verify, 0, sizeof(verify));
+  verify.curve_info = &nist_p_256;
+  memcpy(&verify.public, &key.public, sizeof(ec_point_t));
+  memcpy(verify.signature_r, sign.point_r.pui32X, sizeof(verify.signature_r));
+  memcpy(verify.signature_s, sign.signature_s, sizeof(verify.signature_s));
+  verify.hash[0] = h;
+  RUN(&verify, ecc_dsa_verify(&verify));
+  return verify.result;
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(dual_multiply, "Joint multiplication");
+UNIT_TEST_REGISTER(dual_corner, "Joint multiplication corner cases");
+UNIT_TEST_REGISTER(dsa, "ECDSA sign/verify");
+/*---------------------------------------------------------------------------*/
+UNIT_TEST(dual_multiply)
+{
+  ec_point_t g, expected;
+  int i;
+
+  UNIT_TEST_BEGIN();
+
+  memset(&key, 0, sizeof(key));
+  key.curve_info = &nist_p_256;
+  RUN(&key, ecc_generate(&key));
+  UNIT_TEST_ASSERT(key.result == PKA_STATUS_SUCCESS);
+
+  memset(&g, 0, sizeof(g));
+  memcpy(g.pui32X, nist_p_256.pui32Gx, sizeof(uint32_t) * 8);
+  memcpy(g.pui32Y, nist_p_256.pui32Gy, sizeof(uint32_t) * 8);
+
+  for(i = 0; i < 4; i++) {
+    dual_setup(&g, &key.public);
+    random_scalar(dual.scalar_a);
+    random_scalar(dual.scalar_b);
+    if(i == 1) {
+      /* a single nonzero scalar */
+      memset(dual.scalar_b, 0, sizeof(dual.scalar_b));
+      dual.scalar_b[0] = 1;
+    }
+    UNIT_TEST_ASSERT(reference(dual.scalar_a, &dual.point_a, dual.scalar_b, &dual.point_b, &expected) == PKA_STATUS_SUCCESS);
+    RUN(&dual, ecc_dual_multiply(&dual));
+    UNIT_TEST_ASSERT(dual.result == PKA_STATUS_SUCCESS);
+    UNIT_TEST_ASSERT(memcmp(dual.point_out.pui32X, expected.pui32X, sizeof(uint32_t) * 8) == 0);
+    UNIT_TEST_ASSERT(memcmp(dual.point_out.pui32Y, expected.pui32Y, sizeof(uint32_t) * 8) == 0);
+  }
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST(dual_corner)
+{
+  ec_point_t g, neg;
+  uint32_t rv, len;
+
+  UNIT_TEST_BEGIN();
+
+  memset(&g, 0, sizeof(g));
+  memcpy(g.pui32X, nist_p_256.pui32Gx, sizeof(uint32_t) * 8);
+  memcpy(g.pui32Y, nist_p_256.pui32Gy, sizeof(uint32_t) * 8);
+
+  /* A = B: 3G + 5G = 8G */
+  dual_setup(&g, &g);
+  dual.scalar_a[0] = 3;
+  dual.scalar_b[0] = 5;
+  RUN(&dual, ecc_dual_multiply(&dual));
+  UNIT_TEST_ASSERT(dual.result == PKA_STATUS_SUCCESS);
+  memset(&neg, 0, sizeof(neg));
+  dual.scalar_a[0] = 8;
+  PKAECCMultiplyStart(dual.scalar_a, &g, &nist_p_256, &rv, NULL);
+  PKAECCMultiplyGetResult(&neg, rv);
+  UNIT_TEST_ASSERT(memcmp(dual.point_out.pui32X, neg.pui32X, sizeof(uint32_t) * 8) == 0);
+
+  /* B = -A: 5G + 5(-G) = O */
+  memcpy(&neg, &g, sizeof(neg));
+  PKABigNumSubtractStart(nist_p_256.pui32Prime, 8, g.pui32Y, 8, &rv, NULL);
+  len = 8;
+  PKABigNumSubtractGetResult(neg.pui32Y, &len, rv);
+  dual_setup(&g, &neg);
+  dual.scalar_a[0] = 5;
+  dual.scalar_b[0] = 5;
+  RUN(&dual, ecc_dual_multiply(&dual));
+  UNIT_TEST_ASSERT(dual.result == PKA_STATUS_RESULT_0);
+
+  /* 7G + 5(-G) = 2G, passes through R = -B */
+  dual.scalar_a[0] = 7;
+  RUN(&dual, ecc_dual_multiply(&dual));
+  UNIT_TEST_ASSERT(dual.result == PKA_STATUS_SUCCESS);
+  dual.scalar_a[0] = 2;
+  PKAECCMultiplyStart(dual.scalar_a, &g, &nist_p_256, &rv, NULL);
+  PKAECCMultiplyGetResult(&neg, rv);
+  UNIT_TEST_ASSERT(memcmp(dual.point_out.pui32X, neg.pui32X, sizeof(uint32_t) * 8) == 0);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST(dsa)
+{
+  uint32_t bytes;
+
+  UNIT_TEST_BEGIN();
+
+  bytes = PKABigNumBusBytes();
+  sign_hash(0x12345678);
+  printf("Bus bytes per signature: %lu\n",
+         (unsigned long)(PKABigNumBusBytes() - bytes));
+  UNIT_TEST_ASSERT(sign.result == PKA_STATUS_SUCCESS);
+  UNIT_TEST_ASSERT(verify_hash(0x12345678) == PKA_STATUS_SUCCESS);
+  UNIT_TEST_ASSERT(verify_hash(0x12345679) == PKA_STATUS_SIGNATURE_INVALID);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+/* Verification time against u1 * G and u2 * Q by two multiplications */
+static void
+benchmark(void)
+{
+  clock_time_t start;
+  ec_point_t g, out;
+  int i;
+
+  memset(&g, 0, sizeof(g));
+  memcpy(g.pui32X, nist_p_256.pui32Gx, sizeof(uint32_t) * 8);
+  memcpy(g.pui32Y, nist_p_256.pui32Gy, sizeof(uint32_t) * 8);
+
+  start = clock_time();
+  for(i = 0; i < 20; i++) {
+    verify_hash(0x12345678);
+  }
+  printf("ECDSA verify (P-256): %lu ms per verification%s, ",
+         (unsigned long)((clock_time() - start) * 50 / CLOCK_SECOND),
+         ECC_VERIFY_SHAMIR ? " with Shamir's trick" : "");
+
+  start = clock_time();
+  for(i = 0; i < 20; i++) {
+    reference(verify.u1, &g, verify.u2, &verify.public, &out);
+  }
+  printf("%lu ms for the two multiplications alone\n",
+         (unsigned long)((clock_time() - start) * 50 / CLOCK_SECOND));
+}
+/*---------------------------------------------------------------------------*/
+PROCESS(ecdsa_test_process, "ECDSA test");
+AUTOSTART_PROCESSES(&ecdsa_test_process);
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(ecdsa_test_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  pka_init();
+
+  UNIT_TEST_RUN(dual_multiply);
+  UNIT_TEST_RUN(dual_corner);
+  UNIT_TEST_RUN(dsa);
+
+  benchmark();
+
+  pka_disable();
+
+  exit(UNIT_TEST_RESULT(dual_multiply) == unit_test_success
+       && UNIT_TEST_RESULT(dual_corner) == unit_test_success
+       && UNIT_TEST_RESULT(dsa) == unit_test_success ? 0 : 1);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
+
+/** @} */
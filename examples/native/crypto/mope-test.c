@@ -0,0 +1,325 @@
+/*
+ * Copyright (c) 2015, Institute for Pervasive Computing, ETH Zurich.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/**
+ * \addtogroup native-crypto-examples
+ * @{
+ *
+ * \file
+ *     End-to-end tests of the mOPE client against the reference server.
+ *     A sensor trace, one reading per line in the file given as first
+ *     argument or a synthetic random walk, is inserted value by value and
+ *     in batches, and the protocol cost per insert is reported.
+ */
+#include "contiki.h"
+#include "mope.h"
+#include "mope-server.h"
+#include "blowfish.h"
+#include "random.h"
+#include "unit-test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TRACE_MAX           1024
+#define TRACE_SYNTHETIC     400
+#define QUEUE_SIZE          (MOPE_SERVER_BATCH + 2)
+
+extern int contiki_argc;
+extern char **contiki_argv;
+
+static uint32_t trace[TRACE_MAX];
+static int trace_len;
+
+static blowfish_t container;
+static mope_handler_t handler;
+static mope_context_t client;
+static mope_server_t server;
+
+/* In-flight messages, delivered one at a time so that neither side is
+ * reentered from its own write callback */
+static struct {
+  uint8_t to_server;
+  uint16_t len;
+  uint8_t buf[UIP_CONF_BUFFER_SIZE];
+} queue[QUEUE_SIZE];
+static int queue_head, queue_len;
+static uint32_t client_messages;
+/*---------------------------------------------------------------------------*/
+static int
+push(uint8_t to_server, uint8_t *buf, uint16_t len)
+{
+  int i = (queue_head + queue_len) % QUEUE_SIZE;
+
+  if(queue_len == QUEUE_SIZE) {
+    return -1;
+  }
+  queue[i].to_server = to_server;
+  queue[i].len = len;
+  memcpy(queue[i].buf, buf, len);
+  queue_len++;
+  return len;
+}
+/*---------------------------------------------------------------------------*/
+static int
+client_write(struct mope_context_t *ctx, session_t *session, uint8_t *buf, uint16_t len)
+{
+  client_messages++;
+  return push(1, buf, len);
+}
+/*---------------------------------------------------------------------------*/
+static int
+server_write(struct mope_server_t *s, uint8_t *buf, uint16_t len)
+{
+  return push(0, buf, len);
+}
+/*---------------------------------------------------------------------------*/
+/* Delivers messages until both sides are idle */
+static int
+pump(void)
+{
+  int i;
+
+  while(queue_len) {
+    i = queue_head;
+    queue_head = (queue_head + 1) % QUEUE_SIZE;
+    queue_len--;
+    if(queue[i].to_server) {
+      if(mope_server_handle(&server, queue[i].buf, queue[i].len)) {
+        return -1;
+      }
+    } else {
+      mope_handle_interaction(&client, queue[i].buf, queue[i].len);
+    }
+  }
+  return server.busy ? -1 : 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+det_encrypt(uint32_t value, uint8_t *cipher)
+{
+  uint32_t low  = UIP_HTONL(0);
+  uint32_t high = UIP_HTONL(value);
+
+  blowfish_cipher(&container, &high, &low, BLOWFISH_ENCRYPT);
+  memcpy(cipher, &low, 4);
+  memcpy(cipher + 4, &high, 4);
+}
+/*---------------------------------------------------------------------------*/
+static void
+load_trace(void)
+{
+  FILE *f;
+  unsigned long value;
+  uint32_t walk = 2000;
+
+  trace_len = 0;
+  if(contiki_argc > 1 && (f = fopen(contiki_argv[1], "r")) != NULL) {
+    while(trace_len < TRACE_MAX && fscanf(f, "%lu", &value) == 1) {
+      trace[trace_len++] = value;
+    }
+    fclose(f);
+    printf("Trace %s: %d readings\n", contiki_argv[1], trace_len);
+    return;
+  }
+  /* temperature like readings: small steps, frequent repeats */
+  for(; trace_len < TRACE_SYNTHETIC; trace_len++) {
+    walk += random_rand() % 7;
+    walk -= 3;
+    trace[trace_len] = walk;
+  }
+  printf("Synthetic trace: %d readings\n", trace_len);
+}
+/*---------------------------------------------------------------------------*/
+static void
+reset(void)
+{
+  mope_server_init(&server, server_write, NULL);
+  memset(&client, 0, sizeof(client));
+  client.container = &container;
+  client.h = &handler;
+  queue_head = queue_len = 0;
+  client_messages = 0;
+}
+/*---------------------------------------------------------------------------*/
+/* Checks that the encodings of the tree follow the order of the trace */
+static int
+check_order(void)
+{
+  uint8_t cipher[CIPHER_LEN_BYTE];
+  uint8_t encoding[ENCODING_LEN], last[ENCODING_LEN];
+  uint32_t value, bound = 0;
+  int i, found = 0;
+
+  /* smallest value above bound, repeatedly */
+  for(;;) {
+    value = UINT32_MAX;
+    for(i = 0; i < trace_len; i++) {
+      if(trace[i] < value && (found == 0 || trace[i] > bound)) {
+        value = trace[i];
+      }
+    }
+    if(value == UINT32_MAX || (found && value <= bound)) {
+      break;
+    }
+    det_encrypt(value, cipher);
+    if(!mope_server_lookup(&server, cipher, encoding)) {
+      return 0;
+    }
+    if(found && memcmp(last, encoding, ENCODING_LEN) >= 0) {
+      return 0;
+    }
+    memcpy(last, encoding, ENCODING_LEN);
+    bound = value;
+    found++;
+  }
+  return found == mope_server_size(&server);
+}
+/*---------------------------------------------------------------------------*/
+static void
+report(const char *mode)
+{
+  const mope_server_stats_t *s = &server.stats;
+  const mope_cache_stats_t *c = mope_client_cache_stats(&client);
+
+  printf("%s: %d inserts, %lu keys, %u levels\n", mode, trace_len,
+         (unsigned long)mope_server_size(&server), mope_server_depth(&server));
+  printf("  per insert: %lu.%02lu round-trips, %lu.%02lu sequential rounds, "
+         "%lu bytes on air, %lu.%02lu re-encodings\n",
+         (unsigned long)(s->requests / trace_len),
+         (unsigned long)(s->requests * 100 / trace_len % 100),
+         (unsigned long)(s->rounds / trace_len),
+         (unsigned long)(s->rounds * 100 / trace_len % 100),
+         (unsigned long)((s->bytes_in + s->bytes_out) / trace_len),
+         (unsigned long)(s->reencodings / trace_len),
+         (unsigned long)(s->reencodings * 100 / trace_len % 100));
+  printf("  client: %lu messages, cache %lu hits %lu misses %lu evictions\n",
+         (unsigned long)client_messages, (unsigned long)c->hits,
+         (unsigned long)c->misses, (unsigned long)c->evictions);
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(single, "mOPE insert value by value");
+UNIT_TEST_REGISTER(batch, "mOPE insert in batches");
+/*---------------------------------------------------------------------------*/
+UNIT_TEST(single)
+{
+  uint8_t cipher[CIPHER_LEN_BYTE];
+  uint8_t encoding[ENCODING_LEN];
+  packet_insert_t request;
+  int i;
+
+  UNIT_TEST_BEGIN();
+
+  reset();
+  for(i = 0; i < trace_len; i++) {
+    UNIT_TEST_ASSERT(mope_client_encrypt(&client, trace[i]) != 0);
+    UNIT_TEST_ASSERT(pump() == 0);
+    det_encrypt(trace[i], cipher);
+    UNIT_TEST_ASSERT(mope_server_lookup(&server, cipher, encoding));
+    UNIT_TEST_ASSERT(memcmp(client.mope_encoding, encoding, ENCODING_LEN) == 0);
+  }
+  UNIT_TEST_ASSERT(server.stats.failures == 0);
+  UNIT_TEST_ASSERT(check_order());
+
+  /* Node requests without elements, or longer than received, are dropped */
+  request.len = UIP_HTONS(sizeof(request));
+  request.type = INTERACT_FOR_LOOKUP_S;
+  i = client_messages;
+  UNIT_TEST_ASSERT(mope_handle_interaction(&client, (uint8_t *)&request, sizeof(request)) == 0);
+  request.len = UIP_HTONS(sizeof(request) + CIPHER_LEN_BYTE);
+  UNIT_TEST_ASSERT(mope_handle_interaction(&client, (uint8_t *)&request, sizeof(request)) == 0);
+  UNIT_TEST_ASSERT(client_messages == i);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST(batch)
+{
+  uint8_t cipher[CIPHER_LEN_BYTE];
+  uint8_t encoding[ENCODING_LEN];
+  const uint8_t *received;
+  packet_batch_t request;
+  int i, j;
+
+  UNIT_TEST_BEGIN();
+
+  reset();
+  for(i = 0; i < trace_len; i += MOPE_BATCH_SIZE) {
+    for(j = i; j < trace_len && j < i + MOPE_BATCH_SIZE; j++) {
+      UNIT_TEST_ASSERT(mope_client_batch_add(&client, trace[j]) != 0);
+    }
+    UNIT_TEST_ASSERT(mope_client_encrypt_batch(&client) != 0);
+    UNIT_TEST_ASSERT(pump() == 0);
+    for(j = i; j < trace_len && j < i + MOPE_BATCH_SIZE; j++) {
+      received = mope_client_batch_encoding(&client, trace[j]);
+      det_encrypt(trace[j], cipher);
+      UNIT_TEST_ASSERT(received != NULL);
+      UNIT_TEST_ASSERT(mope_server_lookup(&server, cipher, encoding));
+      UNIT_TEST_ASSERT(memcmp(received, encoding, ENCODING_LEN) == 0);
+    }
+  }
+  UNIT_TEST_ASSERT(server.stats.failures == 0);
+  UNIT_TEST_ASSERT(check_order());
+
+  /* A range past the batch must not be answered, first + count wraps in 8 bits */
+  request.len = UIP_HTONS(sizeof(request));
+  request.type = INTERACT_FOR_LOOKUP_BATCH_S;
+  request.first = 250;
+  request.count = 10;
+  j = client_messages;
+  UNIT_TEST_ASSERT(mope_handle_interaction(&client, (uint8_t *)&request, sizeof(request)) == 0);
+  UNIT_TEST_ASSERT(client_messages == j);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS(mope_test_process, "mOPE test");
+AUTOSTART_PROCESSES(&mope_test_process);
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(mope_test_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  blowfish_initialize((unsigned char *)"mope-test-key", 13, &container);
+  handler.write = client_write;
+  load_trace();
+
+  UNIT_TEST_RUN(single);
+  report("Single");
+  UNIT_TEST_RUN(batch);
+  report("Batch");
+
+  exit(UNIT_TEST_RESULT(single) == unit_test_success
+       && UNIT_TEST_RESULT(batch) == unit_test_success ? 0 : 1);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
+
+/** @} */
@@ -0,0 +1,424 @@
+/*
+ * Copyright (c) 2015, Institute for Pervasive Computing, ETH Zurich.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/**
+ * \addtogroup native-crypto-examples
+ * @{
+ *
+ * \file
+ *     Tests of the Paillier crypto system on the software PKA
+ */
+#include "contiki.h"
+#include "bignum-driver.h"
+#include "paillier-algorithm.h"
+#include "pka.h"
+#include "pt.h"
+#include "unit-test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*---------------------------------------------------------------------------*/
+/* big prime numbers for 2*key_size bit key*, Stored in 'little endian' words */
+static uint32_t Prime_P[key_size] = {
+0x33760457, 0xE3935094, 0xC0D70FED, 0x86FB3614, 0xCFDDD6FA, 0x7F1E6876, 0x6071DF95, 0x2EAD7E25, 0xF7FAEC70, 0x51219209, 0xBC72BC90, 0xD066BAB6, 0xBFFDD413, 0xE9965B14, 0xC3D790EA, 0xED7B34A9};
+static uint32_t Prime_Q[key_size] = {
+0x9E027D79, 0x89D2FD82, 0x1B6D3B4A, 0x7643BCDE, 0x65AB5B2A, 0xE8035C5B, 0xC981A978, 0x19118E35, 0x324341DD, 0x2D940629, 0x80F98215, 0xB6EBD2A2, 0x64126437, 0x7A616471, 0x62EA0DE6, 0xF404BC3F};
+
+#define input_size               plain_size/2
+
+static uint32_t plain_txt[input_size] = { 0x11111111, 0x0000000, 0x22222222, 0x0000000, 0x33333333, 0x0000000, 0xf0000000, 0x0000000,
+                                          0x55555555, 0x0000000, 0x66666666, 0x0000000, 0x77777777, 0x0000000, 0xf0000000, 0x0000000};
+
+static paillier_secrete_state_t state;
+
+/* The software PKA completes every operation inside the start function */
+#define RUN(thread) do {                                                      \
+    PT_INIT(&state.pt);                                                       \
+    while(PT_SCHEDULE(thread));                                               \
+  } while(0)
+/*---------------------------------------------------------------------------*/
+static void
+generate(void)
+{
+  memset(&state, 0, sizeof(state));
+  state.PSize = key_size;
+  state.QSize = key_size;
+  state.NLen  = plain_size;
+  state.LLen  = plain_size;
+  state.CTLen = cipher_size;
+  memcpy(state.PrimeP, Prime_P, sizeof(uint32_t) * key_size);
+  memcpy(state.PrimeQ, Prime_Q, sizeof(uint32_t) * key_size);
+  RUN(paillier_gen(&state));
+}
+/*---------------------------------------------------------------------------*/
+static void
+encrypt(const uint32_t *plain, uint32_t len)
+{
+  memset(state.PlainText, 0, sizeof(uint32_t) * plain_size);
+  memcpy(state.PlainText, plain, sizeof(uint32_t) * len);
+  state.PTLen = len;
+  memset(state.CipherText, 0, sizeof(uint32_t) * cipher_size);
+  state.CTLen = cipher_size;
+  RUN(paillier_enc(&state));
+}
+/*---------------------------------------------------------------------------*/
+static void
+decrypt(void)
+{
+  memset(state.PlainText, 0, sizeof(uint32_t) * plain_size);
+  state.PTLen = plain_size;
+  RUN(paillier_dec(&state));
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(key_context, "Paillier key context");
+UNIT_TEST_REGISTER(enc_dec, "Paillier encrypt/decrypt");
+UNIT_TEST_REGISTER(add, "Paillier homomorphic addition");
+UNIT_TEST_REGISTER(fast_g, "Paillier g = n+1 encryption");
+UNIT_TEST_REGISTER(crt, "Paillier CRT decryption");
+UNIT_TEST_REGISTER(aggregate, "Paillier aggregation");
+UNIT_TEST_REGISTER(pack, "Paillier plain-text packing");
+UNIT_TEST_REGISTER(pool, "Paillier randomness pool");
+/*---------------------------------------------------------------------------*/
+UNIT_TEST(key_context)
+{
+  uint32_t one[1] = { 1 };
+  uint32_t tmp[cipher_size];
+  uint32_t len;
+  uint32_t rv;
+
+  UNIT_TEST_BEGIN();
+
+  generate();
+  UNIT_TEST_ASSERT(state.result == PKA_STATUS_SUCCESS);
+  UNIT_TEST_ASSERT(state.NLen == plain_size);
+  UNIT_TEST_ASSERT(state.NSLen == cipher_size);
+
+  /* g = n + 1 */
+  len = cipher_size;
+  memset(tmp, 0, sizeof(tmp));
+  UNIT_TEST_ASSERT(PKABigNumAddStart(state.PublicN, state.NLen, one, 1, &rv, NULL) == PKA_STATUS_SUCCESS);
+  UNIT_TEST_ASSERT(PKABigNumAddGetResult(tmp, &len, rv) == PKA_STATUS_SUCCESS);
+  UNIT_TEST_ASSERT(memcmp(tmp, state.G, sizeof(tmp)) == 0);
+
+  /* u * L == 1 mod n */
+  len = cipher_size;
+  UNIT_TEST_ASSERT(PKABigNumMultiplyStart(state.PrivateU, state.ULen, state.PrviateL, state.LLen, &rv, NULL) == PKA_STATUS_SUCCESS);
+  UNIT_TEST_ASSERT(PKABigNumMultGetResult(tmp, &len, rv) == PKA_STATUS_SUCCESS);
+  UNIT_TEST_ASSERT(PKABigNumModStart(tmp, len, state.PublicN, state.NLen, &rv, NULL) == PKA_STATUS_SUCCESS);
+  memset(tmp, 0, sizeof(tmp));
+  UNIT_TEST_ASSERT(PKABigNumModGetResult(tmp, cipher_size, rv) == PKA_STATUS_SUCCESS);
+  UNIT_TEST_ASSERT(tmp[0] == 1);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST(enc_dec)
+{
+  int i;
+
+  UNIT_TEST_BEGIN();
+
+  generate();
+  for(i = 0; i < 3; i++) {
+    encrypt(plain_txt, input_size);
+    UNIT_TEST_ASSERT(state.result == PKA_STATUS_SUCCESS);
+    decrypt();
+    UNIT_TEST_ASSERT(state.result == PKA_STATUS_SUCCESS);
+    UNIT_TEST_ASSERT(memcmp(state.PlainText, plain_txt, sizeof(plain_txt)) == 0);
+  }
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST(add)
+{
+  uint32_t expected[input_size];
+  uint64_t sum;
+  int i;
+
+  UNIT_TEST_BEGIN();
+
+  /* m + m */
+  sum = 0;
+  for(i = 0; i < input_size; i++) {
+    sum += (uint64_t)plain_txt[i] * 2;
+    expected[i] = (uint32_t)sum;
+    sum >>= 32;
+  }
+
+  generate();
+  encrypt(plain_txt, input_size);
+  RUN(paillier_add(&state));
+  UNIT_TEST_ASSERT(state.result == PKA_STATUS_SUCCESS);
+  decrypt();
+  UNIT_TEST_ASSERT(state.result == PKA_STATUS_SUCCESS);
+  UNIT_TEST_ASSERT(memcmp(state.PlainText, expected, sizeof(expected)) == 0);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST(fast_g)
+{
+  uint32_t bytes;
+  int i;
+
+  UNIT_TEST_BEGIN();
+
+  generate();
+  UNIT_TEST_ASSERT(state.FastG == 1);
+
+  /* g^m by exponentiation and as 1 + m*n must both decrypt to m */
+  for(i = 0; i < 2; i++) {
+    state.FastG = i;
+    bytes = PKABigNumBusBytes();
+    encrypt(plain_txt, input_size);
+    printf("Bus bytes per encryption (g%s): %lu\n", i ? " = n+1" : "^m",
+           (unsigned long)(PKABigNumBusBytes() - bytes));
+    UNIT_TEST_ASSERT(state.result == PKA_STATUS_SUCCESS);
+    decrypt();
+    UNIT_TEST_ASSERT(state.result == PKA_STATUS_SUCCESS);
+    UNIT_TEST_ASSERT(memcmp(state.PlainText, plain_txt, sizeof(plain_txt)) == 0);
+  }
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST(crt)
+{
+  static uint32_t cipher[cipher_size];
+  static uint32_t plain[2][plain_size];
+  int i, j;
+
+  UNIT_TEST_BEGIN();
+
+  generate();
+  UNIT_TEST_ASSERT(state.Crt == 1);
+  UNIT_TEST_ASSERT(memcmp(state.PrimeP, Prime_P, sizeof(Prime_P)) == 0);
+  UNIT_TEST_ASSERT(memcmp(state.PrimeQ, Prime_Q, sizeof(Prime_Q)) == 0);
+
+  /* Both paths must agree on fresh ciphertexts and on sums of them */
+  for(j = 0; j < 2; j++) {
+    encrypt(plain_txt, input_size);
+    UNIT_TEST_ASSERT(state.result == PKA_STATUS_SUCCESS);
+    if(j) {
+      RUN(paillier_add(&state));
+      UNIT_TEST_ASSERT(state.result == PKA_STATUS_SUCCESS);
+    }
+    memcpy(cipher, state.CipherText, sizeof(cipher));
+
+    for(i = 0; i < 2; i++) {
+      memcpy(state.CipherText, cipher, sizeof(cipher));
+      state.Crt = i;
+      decrypt();
+      UNIT_TEST_ASSERT(state.result == PKA_STATUS_SUCCESS);
+      memcpy(plain[i], state.PlainText, sizeof(plain[i]));
+    }
+    state.Crt = 1;
+    UNIT_TEST_ASSERT(memcmp(plain[0], plain[1], sizeof(plain[0])) == 0);
+    UNIT_TEST_ASSERT(j || memcmp(plain[1], plain_txt, sizeof(plain_txt)) == 0);
+  }
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST(aggregate)
+{
+  static paillier_agg_t agg;
+  uint32_t values[5] = { 0x12345678, 0xffffffff, 1, 0x80000000, 42 };
+  uint32_t weights[5] = { 0, 3, 0, 0x10001, 7 }; /* 0: plain addition */
+  uint64_t expected;
+  int i;
+
+  UNIT_TEST_BEGIN();
+
+  generate();
+  paillier_agg_init(&agg);
+  expected = 0;
+  for(i = 0; i < 5; i++) {
+    encrypt(&values[i], 1);
+    UNIT_TEST_ASSERT(state.result == PKA_STATUS_SUCCESS);
+    if(weights[i]) {
+      state.PlainText[0] = weights[i];
+      state.PTLen = 1;
+      expected += (uint64_t)values[i] * weights[i];
+    } else {
+      expected += values[i];
+    }
+    RUN(paillier_agg_add(&state, &agg, weights[i] != 0));
+    UNIT_TEST_ASSERT(state.result == PKA_STATUS_SUCCESS);
+    UNIT_TEST_ASSERT(agg.AccLen <= cipher_size);
+  }
+  RUN(paillier_agg_finish(&state, &agg));
+  UNIT_TEST_ASSERT(state.result == PKA_STATUS_SUCCESS);
+
+  decrypt();
+  UNIT_TEST_ASSERT(state.result == PKA_STATUS_SUCCESS);
+  UNIT_TEST_ASSERT(state.PlainText[0] == (uint32_t)expected);
+  UNIT_TEST_ASSERT(state.PlainText[1] == (uint32_t)(expected >> 32));
+  for(i = 2; i < plain_size; i++) {
+    UNIT_TEST_ASSERT(state.PlainText[i] == 0);
+  }
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST(pack)
+{
+  static paillier_agg_t agg;
+  static paillier_pack_t layout;
+  static uint32_t readings[4][plain_size * 2];
+  static uint64_t sums[plain_size * 2];
+  uint32_t packed[plain_size];
+  uint32_t len;
+  uint64_t expected;
+  uint32_t i, j;
+
+  UNIT_TEST_BEGIN();
+
+  generate();
+
+  /* 16 bit readings, four cipher-texts per sum: 18 bit slots */
+  UNIT_TEST_ASSERT(paillier_pack_init(&layout, &state, 16, 4) == PKA_STATUS_SUCCESS);
+  UNIT_TEST_ASSERT(layout.SlotBits == 18);
+  UNIT_TEST_ASSERT(layout.Slots == (32 * plain_size - 1) / 18);
+  printf("Readings per cipher-text: %lu\n", (unsigned long)layout.Slots);
+
+  readings[0][0] = 0x10000;
+  UNIT_TEST_ASSERT(paillier_pack(&layout, &state, readings[0], 1) == PKA_STATUS_INVALID_PARAM);
+  UNIT_TEST_ASSERT(paillier_pack(&layout, &state, readings[0], layout.Slots + 1) == PKA_STATUS_INVALID_PARAM);
+
+  /* The maximum reading in every slot of every cipher-text fills the headroom */
+  paillier_pack_agg_init(&layout, &agg);
+  for(i = 0; i < 4; i++) {
+    for(j = 0; j < layout.Slots; j++) {
+      readings[i][j] = i == 3 ? 0xffff : (i * 7919 + j * 104729) & 0xffff;
+    }
+    UNIT_TEST_ASSERT(paillier_pack(&layout, &state, readings[i], layout.Slots) == PKA_STATUS_SUCCESS);
+    /* encrypt() overwrites the plain-text */
+    memcpy(packed, state.PlainText, sizeof(packed));
+    len = state.PTLen;
+    encrypt(packed, len);
+    UNIT_TEST_ASSERT(state.result == PKA_STATUS_SUCCESS);
+    RUN(paillier_agg_add(&state, &agg, 0));
+    UNIT_TEST_ASSERT(state.result == PKA_STATUS_SUCCESS);
+  }
+
+  /* A fifth cipher-text could carry into the next slot */
+  RUN(paillier_agg_add(&state, &agg, 0));
+  UNIT_TEST_ASSERT(state.result == PKA_STATUS_INVALID_PARAM);
+  UNIT_TEST_ASSERT(agg.Count == 4);
+
+  RUN(paillier_agg_finish(&state, &agg));
+  UNIT_TEST_ASSERT(state.result == PKA_STATUS_SUCCESS);
+  decrypt();
+  UNIT_TEST_ASSERT(state.result == PKA_STATUS_SUCCESS);
+
+  paillier_unpack(&layout, &state, sums, layout.Slots);
+  for(j = 0; j < layout.Slots; j++) {
+    expected = 0;
+    for(i = 0; i < 4; i++) {
+      expected += readings[i][j];
+    }
+    UNIT_TEST_ASSERT(sums[j] == expected);
+  }
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+/* Runs after the pool process filled the pool for the current key */
+UNIT_TEST(pool)
+{
+  const paillier_pool_stats_t *stats = paillier_pool_get_stats();
+  int i;
+
+  UNIT_TEST_BEGIN();
+
+  UNIT_TEST_ASSERT(paillier_pool_count() == PAILLIER_POOL_SIZE);
+  UNIT_TEST_ASSERT(stats->filled == PAILLIER_POOL_SIZE);
+  UNIT_TEST_ASSERT(stats->drained == 0);
+
+  /* The last encryption finds the pool empty and computes r^n itself */
+  for(i = 0; i <= PAILLIER_POOL_SIZE; i++) {
+    encrypt(plain_txt, input_size);
+    UNIT_TEST_ASSERT(state.result == PKA_STATUS_SUCCESS);
+    decrypt();
+    UNIT_TEST_ASSERT(state.result == PKA_STATUS_SUCCESS);
+    UNIT_TEST_ASSERT(memcmp(state.PlainText, plain_txt, sizeof(plain_txt)) == 0);
+  }
+  UNIT_TEST_ASSERT(paillier_pool_count() == 0);
+  UNIT_TEST_ASSERT(stats->drained == PAILLIER_POOL_SIZE);
+  UNIT_TEST_ASSERT(stats->empty == 1);
+
+  paillier_pool_stop();
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS(paillier_test_process, "Paillier test");
+AUTOSTART_PROCESSES(&paillier_test_process);
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(paillier_test_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  pka_init();
+
+  UNIT_TEST_RUN(key_context);
+  UNIT_TEST_RUN(enc_dec);
+  UNIT_TEST_RUN(add);
+  UNIT_TEST_RUN(fast_g);
+  UNIT_TEST_RUN(crt);
+  UNIT_TEST_RUN(aggregate);
+  UNIT_TEST_RUN(pack);
+
+  /* Fill the pool in the background */
+  generate();
+  paillier_pool_start(&state);
+  while(paillier_pool_count() < PAILLIER_POOL_SIZE) {
+    PROCESS_PAUSE();
+  }
+  UNIT_TEST_RUN(pool);
+
+  pka_disable();
+
+  exit(UNIT_TEST_RESULT(key_context) == unit_test_success
+       && UNIT_TEST_RESULT(enc_dec) == unit_test_success
+       && UNIT_TEST_RESULT(add) == unit_test_success
+       && UNIT_TEST_RESULT(fast_g) == unit_test_success
+       && UNIT_TEST_RESULT(crt) == unit_test_success
+       && UNIT_TEST_RESULT(aggregate) == unit_test_success
+       && UNIT_TEST_RESULT(pack) == unit_test_success
+       && UNIT_TEST_RESULT(pool) == unit_test_success ? 0 : 1);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
+
+/** @} */
@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) 2015, Institute for Pervasive Computing, ETH Zurich.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/**
+ * \addtogroup native-crypto-examples
+ * @{
+ *
+ * \file
+ *     Tests of RSA on the software PKA
+ */
+#include "contiki.h"
+#include "RSA-algorithm.h"
+#include "bignum-driver.h"
+#include "pka.h"
+#include "pt.h"
+#include "unit-test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*---------------------------------------------------------------------------*/
+/* 256 bit primes, little endian words, p - 1 and q - 1 prime to e */
+static const uint32_t prime_p[8] = {
+0xD031B625, 0xB45AEEBE, 0x1692329B, 0x7635BFEA, 0xE7D2B63E, 0x6D24C6A2, 0xE44C6811, 0xCFB876F7};
+static const uint32_t prime_q[8] = {
+0x8B40816F, 0x55376CF6, 0x4FFA6A3C, 0xC3F62CBA, 0xBD0233A0, 0x1F2EBC94, 0x3AFC31EF, 0xDC0DC573};
+
+static const uint32_t message[16] = {
+0x11111111, 0x22222222, 0x33333333, 0x44444444, 0x55555555, 0x66666666, 0x77777777, 0x88888888,
+0x99999999, 0xaaaaaaaa, 0xbbbbbbbb, 0xcccccccc, 0xdddddddd, 0xeeeeeeee, 0x0fffffff, 0x00000000};
+
+static RSA_secrete_state_t state;
+
+/* The software PKA completes every operation inside the start function */
+#define RUN(thread) do {                                                      \
+    PT_INIT(&state.pt);                                                       \
+    while(PT_SCHEDULE(thread));                                               \
+  } while(0)
+/*---------------------------------------------------------------------------*/
+static void
+generate(void)
+{
+  memset(&state, 0, sizeof(state));
+  memcpy(state.PrimeP, prime_p, sizeof(prime_p));
+  memcpy(state.PrimeQ, prime_q, sizeof(prime_q));
+  state.PSize = 8;
+  state.QSize = 8;
+  state.PrimeE = 0x10001;
+  state.ESize = 1;
+  state.ONEDATA[0] = 1;
+  state.NLen = 16;
+  state.FLen = 16;
+  state.DLen = 16;
+  RUN(RSA_create_public(&state));
+  if(state.result == PKA_STATUS_SUCCESS) {
+    RUN(RSA_create_private(&state));
+  }
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(keys, "RSA key generation");
+UNIT_TEST_REGISTER(enc_dec, "RSA encrypt/decrypt");
+UNIT_TEST_REGISTER(sign_verify, "RSA sign/verify");
+
+UNIT_TEST(keys)
+{
+  uint32_t tmp[18];
+  uint32_t len = sizeof(tmp) / sizeof(uint32_t);
+  uint32_t rv;
+
+  UNIT_TEST_BEGIN();
+
+  generate();
+  UNIT_TEST_ASSERT(state.result == PKA_STATUS_SUCCESS);
+  UNIT_TEST_ASSERT(state.NLen == 16);
+
+  /* d * e = 1 mod (p - 1)(q - 1) */
+  UNIT_TEST_ASSERT(PKABigNumMultiplyStart(state.PrviateD, state.DLen, &state.PrimeE, 1, &rv, NULL) == PKA_STATUS_SUCCESS);
+  UNIT_TEST_ASSERT(PKABigNumMultGetResult(tmp, &len, rv) == PKA_STATUS_SUCCESS);
+  UNIT_TEST_ASSERT(PKABigNumModStart(tmp, len, state.PrimeF, state.FLen, &rv, NULL) == PKA_STATUS_SUCCESS);
+  memset(tmp, 0, sizeof(tmp));
+  UNIT_TEST_ASSERT(PKABigNumModGetResult(tmp, 16, rv) == PKA_STATUS_SUCCESS);
+  UNIT_TEST_ASSERT(tmp[0] == 1 && tmp[1] == 0);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST(enc_dec)
+{
+  UNIT_TEST_BEGIN();
+
+  memcpy(state.Messagetoencrypt, message, sizeof(message));
+  state.MLen = 16;
+  state.SMLen = 16;
+  RUN(RSA_encrypt_message(&state));
+  UNIT_TEST_ASSERT(state.result == PKA_STATUS_SUCCESS);
+  UNIT_TEST_ASSERT(memcmp(state.secretMessage, message, sizeof(message)) != 0);
+
+  memset(state.Messagetoencrypt, 0, sizeof(state.Messagetoencrypt));
+  RUN(RSA_decrypt_message(&state));
+  UNIT_TEST_ASSERT(state.result == PKA_STATUS_SUCCESS);
+  UNIT_TEST_ASSERT(memcmp(state.Messagetoencrypt, message, sizeof(message)) == 0);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST(sign_verify)
+{
+  UNIT_TEST_BEGIN();
+
+  memcpy(state.Messagetoencrypt, message, sizeof(message));
+  memset(state.secretMessage, 0, sizeof(state.secretMessage));
+  RUN(RSA_signature_message(&state));
+  UNIT_TEST_ASSERT(state.result == PKA_STATUS_SUCCESS);
+
+  memset(state.Messagetoencrypt, 0, sizeof(state.Messagetoencrypt));
+  RUN(RSA_signature_verification(&state));
+  UNIT_TEST_ASSERT(state.result == PKA_STATUS_SUCCESS);
+  UNIT_TEST_ASSERT(memcmp(state.Messagetoencrypt, message, sizeof(message)) == 0);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+/* Time of the private key operation, a 512 bit exponentiation */
+static void
+benchmark(void)
+{
+  clock_time_t start;
+  int i;
+
+  start = clock_time();
+  for(i = 0; i < 100; i++) {
+    RUN(RSA_decrypt_message(&state));
+  }
+  printf("RSA-512 decryption: %lu us per operation\n",
+         (unsigned long)((clock_time() - start) * 10000 / CLOCK_SECOND));
+}
+/*---------------------------------------------------------------------------*/
+PROCESS(rsa_test_process, "RSA test");
+AUTOSTART_PROCESSES(&rsa_test_process);
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(rsa_test_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  pka_init();
+
+  UNIT_TEST_RUN(keys);
+  UNIT_TEST_RUN(enc_dec);
+  UNIT_TEST_RUN(sign_verify);
+
+  benchmark();
+
+  pka_disable();
+
+  exit(UNIT_TEST_RESULT(keys) == unit_test_success
+       && UNIT_TEST_RESULT(enc_dec) == unit_test_success
+       && UNIT_TEST_RESULT(sign_verify) == unit_test_success ? 0 : 1);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
+
+/** @} */
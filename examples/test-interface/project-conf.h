@@ -44,10 +44,16 @@
 #define USE_PREEMPTION                                0
 #define MTARCH_CONF_STACKSIZE                       512
 
+/* Coffee holds the fixed-base tables of EC-ElGamal */
+#define COFFEE_CONF_SIZE                   (160 * 1024)
+#define EC_ELGAMAL_CONF_RING_SIZE                     4
+
 #define USE_APP_SHA256                                1
 #define USE_APP_CCM                                   1
 #define USE_APP_AES                                   1
 #define USE_APP_ECC                                   1
+/* HMAC and PRF of tinydtls, needs APPS += tinydtls */
+#define USE_APP_HMAC                                  0
 #define HAVE_RELIC                                    0
 #define HAVE_FLOCKLAB                                 0
 
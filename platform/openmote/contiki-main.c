@@ -55,6 +55,7 @@
 #include "dev/slip.h"
 #include "dev/cc2538-rf.h"
 #include "dev/udma.h"
+#include "dev/ctr-drbg.h"
 #include "usb/usb-serial.h"
 #include "lib/random.h"
 #include "net/netstack.h"
@@ -203,6 +204,7 @@ main(void)
 
   /* Initialise the H/W RNG engine. */
   random_init(0);
+  ctr_drbg_init();
 
   udma_init();
 
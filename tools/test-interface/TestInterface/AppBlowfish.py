@@ -40,10 +40,21 @@ class AppBlowfish(AppTimer):
   BLOWFISH_INIT           =  1
   BLOWFISH_ENC            =  2
   BLOWFISH_DEC            =  3
+  BLOWFISH_DEC_NODE       =  4
+  BLOWFISH_ECB            =  5
+  BLOWFISH_CTR            =  6
+  BLOWFISH_INIT_PERSISTENT =  7
+
+  #Modes copied from blowfish.h
+  BLOWFISH_ENCRYPT        =  1
+  BLOWFISH_DECRYPT        =  2
     
   def init(self, key):
     self.executeCommand(self.APP_BLOWFISH, self.BLOWFISH_INIT, len(key), key);
 
+  def initPersistent(self, key):
+    self.executeCommand(self.APP_BLOWFISH, self.BLOWFISH_INIT_PERSISTENT, len(key), key);
+
   def encrypt(self, plaintext):
     self.executeCommand(self.APP_BLOWFISH, self.BLOWFISH_ENC, len(plaintext), plaintext);
     return self.payload;
@@ -51,3 +62,20 @@ class AppBlowfish(AppTimer):
   def decrypt(self, cipertext):
     self.executeCommand(self.APP_BLOWFISH, self.BLOWFISH_DEC, len(cipertext), cipertext);
     return self.payload;
+
+  def decryptNode(self, elements):
+    payload = [0]*4;
+    self.setLong(payload, 0, elements);
+    self.executeCommand(self.APP_BLOWFISH, self.BLOWFISH_DEC_NODE, len(payload), payload);
+
+  def ecb(self, length, mode):
+    payload = [0]*8;
+    self.setLong(payload, 0, mode);
+    self.setLong(payload, 4, length);
+    self.executeCommand(self.APP_BLOWFISH, self.BLOWFISH_ECB, len(payload), payload);
+
+  def ctr(self, length, counter):
+    payload = [0]*4 + list(counter);
+    self.setLong(payload, 0, length);
+    self.executeCommand(self.APP_BLOWFISH, self.BLOWFISH_CTR, len(payload), payload);
+    return self.payload;
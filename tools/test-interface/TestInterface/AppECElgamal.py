@@ -48,6 +48,11 @@ class AppECElgamal(ECurve):
   EG_DEC                  =  9
   EG_ADD                  = 10
   EG_MAP_TO_EC_ALT        = 11
+  EG_BSGS_TABLE           = 12
+  EG_BSGS_DECODE          = 13
+  EG_PRECOMPUTE           = 14
+  EG_RING                 = 15
+  EG_RING_STATS           = 16
     
   def switchToHardwareCrypto(self):
     self.executeCommand(self.APP_MANAGEMENT, self.SWITCH_PKA, 1, [0x01]);
@@ -91,4 +96,32 @@ class AppECElgamal(ECurve):
 
   def add(self):
     self.executeCommand(self.APP_ELGAMAL, self.EG_ADD, 0, []);
-    
\ No newline at end of file
+    
+
+  def precompute(self):
+    self.executeCommand(self.APP_ELGAMAL, self.EG_PRECOMPUTE, 1, [0x01]);
+
+  def disablePrecompute(self):
+    self.executeCommand(self.APP_ELGAMAL, self.EG_PRECOMPUTE, 1, [0x00]);
+
+  def startRing(self):
+    self.executeCommand(self.APP_ELGAMAL, self.EG_RING, 1, [0x01]);
+
+  def stopRing(self):
+    self.executeCommand(self.APP_ELGAMAL, self.EG_RING, 1, [0x00]);
+
+  def getRingStats(self):
+    """Returns (pairs ready, filled, drained, empty)"""
+    self.executeCommand(self.APP_ELGAMAL, self.EG_RING_STATS);
+    return tuple(self.getLong(self.payload, i) for i in range(0, 16, 4));
+
+  def generateBsgsTable(self, size):
+    payload = [0]*4;
+    self.setLong(payload, 0, size);
+    self.executeCommand(self.APP_ELGAMAL, self.EG_BSGS_TABLE, len(payload), payload);
+
+  def decodeBsgs(self, bound):
+    payload = [0]*4;
+    self.setLong(payload, 0, bound);
+    self.executeCommand(self.APP_ELGAMAL, self.EG_BSGS_DECODE, len(payload), payload);
+    return (self.getLong(self.payload, 0), self.getLong(self.payload, 4));
@@ -47,6 +47,12 @@ class AppPailler(AppTimer):
   PAILLER_ENC             =  8
   PAILLER_DEC             =  9
   PAILLER_ADD             = 10
+  PAILLER_SET_FAST_G      = 11
+  PAILLER_SET_CRT         = 12
+  PAILLER_AGG_INIT        = 13
+  PAILLER_AGG_ADD         = 14
+  PAILLER_AGG_ADD_SCALED  = 15
+  PAILLER_AGG_FINISH      = 16
     
   def switchToHardwareCrypto(self):
     self.executeCommand(self.APP_MANAGEMENT, self.SWITCH_PKA, 1, [0x01]);
@@ -69,6 +75,18 @@ class AppPailler(AppTimer):
     self.executeCommand(self.APP_PAILLER, self.PAILLER_GET_CIPHERT, 0, []);
     return self.payload
 
+  def enableFastG(self):
+    self.executeCommand(self.APP_PAILLER, self.PAILLER_SET_FAST_G, 1, [0x01]);
+
+  def disableFastG(self):
+    self.executeCommand(self.APP_PAILLER, self.PAILLER_SET_FAST_G, 1, [0x00]);
+
+  def enableCrt(self):
+    self.executeCommand(self.APP_PAILLER, self.PAILLER_SET_CRT, 1, [0x01]);
+
+  def disableCrt(self):
+    self.executeCommand(self.APP_PAILLER, self.PAILLER_SET_CRT, 1, [0x00]);
+
   def generate(self):
     self.executeCommand(self.APP_PAILLER, self.PAILLER_GEN, 0, []);
   
@@ -80,4 +98,16 @@ class AppPailler(AppTimer):
 
   def add(self):
     self.executeCommand(self.APP_PAILLER, self.PAILLER_ADD, 0, []);
-    
\ No newline at end of file
+    
+
+  def aggregateInit(self):
+    self.executeCommand(self.APP_PAILLER, self.PAILLER_AGG_INIT, 0, []);
+
+  def aggregateAdd(self):
+    self.executeCommand(self.APP_PAILLER, self.PAILLER_AGG_ADD, 0, []);
+
+  def aggregateAddScaled(self):
+    self.executeCommand(self.APP_PAILLER, self.PAILLER_AGG_ADD_SCALED, 0, []);
+
+  def aggregateFinish(self):
+    self.executeCommand(self.APP_PAILLER, self.PAILLER_AGG_FINISH, 0, []);
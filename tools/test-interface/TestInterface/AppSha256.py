@@ -39,6 +39,8 @@ class AppSha256(AppTimer):
   #Enums copied from test-interface.h
   SELECT_SHA256_ENGINE    =  1
   CALC_HASH               =  2
+  CALC_HMAC               =  3
+  CALC_PRF                =  4
   
   def switchToHardwareCrypto(self):
     self.executeCommand(self.APP_MANAGEMENT, self.SWITCH_CRYPTO, 1, [0x01]);
@@ -53,3 +55,21 @@ class AppSha256(AppTimer):
     payload = [0]*2;
     self.setShort(payload, 0, byte_count);
     self.executeCommand(self.APP_SHA256, self.CALC_HASH, 2, payload);
+
+  def calculateHmac(self, key, byte_count):
+    """Calculates the HMAC-SHA256 of pre uploaded data"""
+    payload = [0]*4 + list(key);
+    self.setShort(payload, 0, len(key));
+    self.setShort(payload, 2, byte_count);
+    self.executeCommand(self.APP_SHA256, self.CALC_HMAC, len(payload), payload);
+    return self.payload;
+
+  def calculatePrf(self, key, label, seed_count, output_count):
+    """Expands the key with the DTLS PRF, the seed is pre uploaded"""
+    payload = [0]*8 + list(key) + list(label);
+    self.setShort(payload, 0, output_count);
+    self.setShort(payload, 2, len(key));
+    self.setShort(payload, 4, len(label));
+    self.setShort(payload, 6, seed_count);
+    self.executeCommand(self.APP_SHA256, self.CALC_PRF, len(payload), payload);
+    return self.payload;
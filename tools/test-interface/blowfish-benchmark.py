@@ -0,0 +1,99 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+#
+# Copyright (c) 2014, Institute for Pervasive Computing, ETH Zurich.
+# All rights reserved.
+#
+# Author: Andreas Dröscher <contiki@anticat.ch>
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+# 1. Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+# 2. Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+# 3. Neither the name of the Institute nor the names of its contributors
+#    may be used to endorse or promote products derived from this software
+#    without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS "AS IS" AND
+# ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+# ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+# FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+# OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+# HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+# LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+# OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+# SUCH DAMAGE.
+#
+
+import sys, os, random
+
+from TerminalApplication import TerminalApplication
+from TestInterface.MeasurementWriter import MeasurementWriter
+from TestInterface.AppBlowfish import AppBlowfish
+
+#The cc2538 runs at 32 MHz, the timer counts microseconds
+CYCLES_PER_US = 32
+
+class BlowfishApplication(TerminalApplication):
+  def define_arguments(self, parser):
+    parser.add_argument("-n", "--cycles",   dest="cycles",   metavar="n", help="run benchmark n times (default: 1)", default=1);
+    parser.add_argument("-s", "--sizes",    dest="sizes",    metavar="s", help="comma separated message sizes in bytes (default: 8,64,512,4096)", default="8,64,512,4096");
+    parser.add_argument("-o", "--output",   dest="output",   metavar="o", help="save measurements (JSON) into o");
+
+  def instantiate_interface(self, args):
+    return AppBlowfish();
+
+  def report(self, name, length, us):
+    blocks = (length + 7) / 8;
+    sys.stdout.write(" %s: %d B/s, %d cycles/block" % (name, length * 1000000 / max(us, 1), us * CYCLES_PER_US / blocks));
+
+  def execute_test(self, client, args):
+    #Prepare Measurement Write
+    measurements = MeasurementWriter(args.output)
+    key = os.urandom(16);
+
+    #Key expansion against reading back the persisted schedule
+    client.clearTimer();
+    client.init(key);
+    measurements.add("init", client.readMeasurements());
+    client.initPersistent(key);
+    client.clearTimer();
+    client.initPersistent(key);
+    measurements.add("init-persistent", client.readMeasurements());
+
+    for length in [int(s) for s in args.sizes.split(",")]:
+      sys.stdout.write("%d bytes: " % length);
+
+      for i in range(0, int(args.cycles)):
+        if(i % 50 == 0):
+          sys.stdout.write(".");
+          sys.stdout.flush();
+
+        client.uploadData(length, [random.randint(0, 255) for j in range(0, length)]);
+
+        client.clearTimer();
+        client.ecb(length, client.BLOWFISH_ENCRYPT);
+        ecb = client.readMeasurements();
+        measurements.add("%d-ecb" % length, ecb);
+
+        client.clearTimer();
+        client.ctr(length, [random.randint(0, 255) for j in range(0, 8)]);
+        ctr = client.readMeasurements();
+        measurements.add("%d-ctr" % length, ctr);
+
+      self.report("ECB", length, ecb[1]);
+      self.report("CTR", length, ctr[1]);
+      sys.stdout.write("\n");
+
+    measurements.save();
+    return 0;
+
+if __name__ == "__main__":
+  app = BlowfishApplication();
+  sys.exit(app.main());
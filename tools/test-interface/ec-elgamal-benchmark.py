@@ -31,7 +31,7 @@
 # SUCH DAMAGE.
 #
 
-import sys, os, binascii, random
+import sys, os, binascii, random, time
 
 from TerminalApplication import TerminalApplication
 from TestInterface.MeasurementWriter import MeasurementWriter
@@ -43,6 +43,9 @@ class EccApplication(TerminalApplication):
   def define_arguments(self, parser):
     parser.add_argument("-o", "--output", dest="output", metavar="o", help="save measurements (JSON) into o");
     parser.add_argument("-n", "--cycles", dest="cycles", metavar="n", help="run benchmark n times (default: 1)", default=1);
+    parser.add_argument("-p", "--precompute", dest="precompute", action="store_true", help="encrypt with the fixed-base tables");
+    parser.add_argument("-r", "--ring",   dest="ring",   metavar="s", type=float, help="encrypt with pre-generated pairs, idle s seconds before every encryption");
+    parser.add_argument("-b", "--bsgs",   dest="bsgs",   metavar="b", help="decode plain texts up to 4 bytes with baby-step tables of comma separated sizes b");
     parser.add_argument(                  dest="min",                 help="min in bytes",);
     parser.add_argument(                  dest="max",                 help="max in bytes",);
     parser.add_argument(                  dest="step",                help="step in bytes",);
@@ -59,6 +62,22 @@ class EccApplication(TerminalApplication):
     client.setExponent(exponent);
     client.generate();
 
+    #Load or build the fixed-base tables
+    if args.precompute:
+      client.clearTimer();
+      client.precompute();
+      measurement = client.readMultiValueMeasurements();
+      measurements.add("precompute", {1: measurement[1][0]});
+
+    #Fill the ring of ephemeral pairs while idle
+    if args.ring is not None:
+      client.startRing();
+
+    #Baby-step table sizes
+    tables = [];
+    if args.bsgs:
+      tables = [int(t) for t in args.bsgs.split(",")];
+
     #Run Tests
     nb = 1;
     for size in range(int(args.min), int(args.max)+1, int(args.step)):
@@ -79,18 +98,42 @@ class EccApplication(TerminalApplication):
         measurement = client.readMultiValueMeasurements();
         measurements.add("%d-map" % size, {1: measurement[1][0]});
 
+        if args.ring is not None:
+          time.sleep(args.ring);
+
         client.clearTimer();
         client.encrypt();
         measurement = client.readMultiValueMeasurements();
-        measurements.add("%d-enc" % size, {1: measurement[1][0]});
+        measurements.add("%d-enc%s" % (size, "-ring" if args.ring is not None else ""), {1: measurement[1][0]});
 
         client.clearTimer();
         client.decrypt();
         measurement = client.readMultiValueMeasurements();
         measurements.add("%d-dec" % size, {1: measurement[1][0]});
 
+        #Recover the integer from the decrypted point
+        if size <= 4:
+          for table in tables:
+            client.clearTimer();
+            client.generateBsgsTable(table);
+            measurement = client.readMultiValueMeasurements();
+            measurements.add("%d-bsgs-table" % table, {1: measurement[1][0]});
+
+            client.clearTimer();
+            (value, steps) = client.decodeBsgs((1 << (size*8)) - 1);
+            measurement = client.readMultiValueMeasurements();
+            measurements.add("%d-%d-dlog" % (table, size), {1: measurement[1][0], 2: steps});
+            if value != int(input, 16):
+              raise RuntimeError("BSGS decoded %d instead of %s" % (value, input));
+
       sys.stdout.write(" success.\n");
 
+    #Ring occupancy
+    if args.ring is not None:
+      (ready, filled, drained, empty) = client.getRingStats();
+      measurements.add("ring", {1: ready, 2: filled, 3: drained, 4: empty});
+      client.stopRing();
+
     measurements.save();
     return 0;
 
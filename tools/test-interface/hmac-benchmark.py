@@ -0,0 +1,117 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+#
+# Copyright (c) 2014, Institute for Pervasive Computing, ETH Zurich.
+# All rights reserved.
+#
+# Author: Andreas Dröscher <contiki@anticat.ch>
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+# 1. Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+# 2. Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+# 3. Neither the name of the Institute nor the names of its contributors
+#    may be used to endorse or promote products derived from this software
+#    without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS "AS IS" AND
+# ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+# ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+# FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+# OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+# HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+# LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+# OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+# SUCH DAMAGE.
+#
+
+
+import sys, random, binascii, hmac, hashlib
+
+from TerminalApplication import TerminalApplication
+from TestInterface.MeasurementWriter import MeasurementWriter
+from TestInterface.AppSha256 import AppSha256
+
+#PRF expansions of a handshake with TLS_PSK_WITH_AES_128_CCM_8
+PRF_EXPANSIONS = [("master secret",   48, 64),
+                  ("key expansion",   40, 64),
+                  ("client finished", 12, 32)];
+
+def prf(key, label, seed, length):
+  """P_SHA256 of RFC 5246"""
+  seed = label + seed;
+  a = seed;
+  out = "";
+  while len(out) < length:
+    a = hmac.new(key, a, hashlib.sha256).digest();
+    out += hmac.new(key, a + seed, hashlib.sha256).digest();
+  return out[:length];
+
+def random_bytes(length):
+  return [random.randint(0, 255) for i in range(0, length)];
+
+class HmacApplication(TerminalApplication):
+  def define_arguments(self, parser):
+    parser.add_argument("-n", "--cycles", dest="cycles", metavar="n", help="run benchmark n times (default: 1)", default=1);
+    parser.add_argument("-s", "--sizes",  dest="sizes",  metavar="s", help="comma separated message sizes in bytes (default: 13,64,256)", default="13,64,256");
+    parser.add_argument("-o", "--output", dest="output", metavar="o", help="save measurements (JSON) into o");
+
+  def instantiate_interface(self, args):
+    return AppSha256();
+
+  def execute_test(self, client, args):
+    #Prepare Measurement Writer
+    measurements = MeasurementWriter(args.output)
+
+    #HMAC: 1 key pads, 2 MAC, 3 MAC with the cached key pads
+    for length in [int(s) for s in args.sizes.split(",")]:
+      sys.stdout.write("HMAC %d bytes: " % length);
+      for i in range(0, int(args.cycles)):
+        if(i % 50 == 0):
+          sys.stdout.write(".");
+          sys.stdout.flush();
+
+        key = random_bytes(32);
+        msg = random_bytes(length);
+        client.uploadData(length, msg);
+        client.clearTimer();
+        mac = client.calculateHmac(key, length);
+        expected = hmac.new(str(bytearray(key)), str(bytearray(msg)), hashlib.sha256).digest();
+        if binascii.b2a_hex(mac) != binascii.b2a_hex(expected):
+          raise RuntimeError("HMAC of %d bytes failed." % length);
+        result = client.readMeasurements();
+        measurements.add("hmac-%d" % length, result);
+      sys.stdout.write(" key %d us, MAC %d us, cached %d us\n" % (result[1], result[2], result[3]));
+
+    #PRF expansions of the handshake
+    for (label, length, seed_length) in PRF_EXPANSIONS:
+      sys.stdout.write("PRF %s (%d bytes): " % (label, length));
+      for i in range(0, int(args.cycles)):
+        if(i % 50 == 0):
+          sys.stdout.write(".");
+          sys.stdout.flush();
+
+        key = random_bytes(48);
+        seed = random_bytes(seed_length);
+        client.uploadData(seed_length, seed);
+        client.clearTimer();
+        out = client.calculatePrf(key, [ord(c) for c in label], seed_length, length);
+        expected = prf(str(bytearray(key)), label, str(bytearray(seed)), length);
+        if binascii.b2a_hex(out) != binascii.b2a_hex(expected):
+          raise RuntimeError("PRF '%s' failed." % label);
+        result = client.readMeasurements();
+        measurements.add("prf-%s" % label.replace(" ", "-"), result);
+      sys.stdout.write(" %d us\n" % result[1]);
+
+    measurements.save();
+    return 0;
+
+if __name__ == "__main__":
+  app = HmacApplication();
+  sys.exit(app.main());
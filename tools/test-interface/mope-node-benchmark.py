@@ -0,0 +1,91 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+#
+# Copyright (c) 2014, Institute for Pervasive Computing, ETH Zurich.
+# All rights reserved.
+#
+# Author: Andreas Dröscher <contiki@anticat.ch>
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+# 1. Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+# 2. Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+# 3. Neither the name of the Institute nor the names of its contributors
+#    may be used to endorse or promote products derived from this software
+#    without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS "AS IS" AND
+# ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+# ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+# FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+# OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+# HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+# LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+# OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+# SUCH DAMAGE.
+#
+
+import sys, os, random
+
+from TerminalApplication import TerminalApplication
+from TestInterface.MeasurementWriter import MeasurementWriter
+from TestInterface.AppAES import AppAES
+from TestInterface.AppBlowfish import AppBlowfish
+
+class AppMopeNode(AppAES, AppBlowfish):
+  """AES and Blowfish Application, for the two DET modes of mOPE"""
+
+class MopeNodeApplication(TerminalApplication):
+  def define_arguments(self, parser):
+    parser.add_argument("-n", "--cycles",   dest="cycles",   metavar="n", help="run benchmark n times (default: 1)", default=1);
+    parser.add_argument("-s", "--sizes",    dest="sizes",    metavar="s", help="comma separated node sizes (default: 4,8,16,32)", default="4,8,16,32");
+    parser.add_argument("-o", "--output",   dest="output",   metavar="o", help="save measurements (JSON) into o");
+
+  def instantiate_interface(self, args):
+    return AppMopeNode();
+
+  def execute_test(self, client, args):
+    #Prepare Measurement Write
+    measurements = MeasurementWriter(args.output)
+
+    #mOPE with AES decrypts a node as one ECB DMA job
+    client.setKey(os.urandom(16));
+    client.switchToECBMode();
+    client.switchToDMA();
+    client.disableUpload();
+
+    #mOPE with Blowfish decrypts element by element
+    client.init(os.urandom(16));
+
+    for elements in [int(s) for s in args.sizes.split(",")]:
+      sys.stdout.write("Node of %d elements: " % elements);
+
+      for i in range(0, int(args.cycles)):
+        if(i % 50 == 0):
+          sys.stdout.write(".");
+          sys.stdout.flush();
+
+        client.uploadData(elements*16, [random.randint(0, 255) for j in range(0, elements*16)]);
+
+        client.clearTimer();
+        client.decrypt(elements*16);
+        measurements.add("%d-aes" % elements, client.readMeasurements());
+
+        client.clearTimer();
+        client.decryptNode(elements);
+        measurements.add("%d-blowfish" % elements, client.readMeasurements());
+
+      sys.stdout.write(" done.\n");
+
+    measurements.save();
+    return 0;
+
+if __name__ == "__main__":
+  app = MopeNodeApplication();
+  sys.exit(app.main());
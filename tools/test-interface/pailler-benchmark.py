@@ -40,9 +40,25 @@ from TestInterface.AppPailler import AppPailler
 KEY_P = "33760457E3935094C0D70FED86FB3614CFDDD6FA7F1E68766071DF952EAD7E25F7FAEC7051219209BC72BC90D066BAB6BFFDD413E9965B14C3D790EAED7B34A9"
 KEY_Q = "9E027D7989D2FD821B6D3B4A7643BCDE65AB5B2AE8035C5BC981A97819118E35324341DD2D94062980F98215B6EBD2A2641264377A61647162EA0DE6F404BC3F"
 
+#Numbers are exchanged as little endian sequences of big endian 32bit words
+def words_to_int(data):
+  value = 0;
+  for i in range(0, len(data) // 4):
+    value = value | (int(binascii.b2a_hex(data[4*i:4*i+4]), 16) << (32 * i));
+  return value;
+
+def int_to_words(value, size):
+  data = b"";
+  for i in range(0, size // 4):
+    data = data + binascii.a2b_hex("%08x" % ((value >> (32 * i)) & 0xFFFFFFFF));
+  return data;
+
 class PaillerApplication(TerminalApplication):
   def define_arguments(self, parser):
     parser.add_argument("-n", "--cycles", dest="cycles", metavar="n", help="run benchmark n times (default: 1)", default=1);
+    parser.add_argument("-g", "--compare-g", dest="compare_g", action="store_true", help="compare g^m by exponentiation with the g=n+1 shortcut", default=False);
+    parser.add_argument("-c", "--compare-crt", dest="compare_crt", action="store_true", help="compare decryption mod n^2 with the CRT decryption", default=False);
+    parser.add_argument("-a", "--aggregate", dest="aggregate", action="store_true", help="aggregate n cipher-texts per size instead of encrypt/decrypt", default=False);
     parser.add_argument("-o", "--output", dest="output", metavar="o", help="save measurements (JSON) into o");
     parser.add_argument(                  dest="min",                 help="min in bytes",);
     parser.add_argument(                  dest="max",                 help="max in bytes",);
@@ -59,6 +75,9 @@ class PaillerApplication(TerminalApplication):
     client.setKey(binascii.a2b_hex(KEY_P), binascii.a2b_hex(KEY_Q));
     client.generate();
 
+    if args.aggregate:
+      return self.execute_aggregation(client, args, measurements);
+
     #Run Tests
     nb = 1;
     for size in range(int(args.min), int(args.max)+1, int(args.step)):
@@ -75,11 +94,47 @@ class PaillerApplication(TerminalApplication):
         input = binascii.a2b_hex(input);
         client.setPlainText(input);
 
+        if args.compare_g:
+          #g^m by modular exponentiation
+          client.disableFastG();
+          client.clearTimer();
+          client.encrypt();
+          measurement = client.readMultiValueMeasurements();
+          measurements.add("%d-enc-exp"  % size, {1: measurement[1][0]});
+
+          client.decrypt();
+          if args.output is None:
+            payload = client.getPlainText()[0:len(input)];
+            if payload != input:
+              raise RuntimeError("Test Vector failed (g^m by exponentiation).");
+
+          #g^m = 1 + m*n mod n^2
+          client.enableFastG();
+          client.setPlainText(input);
+
         client.clearTimer();
         client.encrypt();
         measurement = client.readMultiValueMeasurements();
         measurements.add("%d-enc"      % size, {1: measurement[1][0]});
 
+        if args.compare_crt:
+          #c^L mod n^2
+          ciphertext = client.getCipherText();
+          client.disableCrt();
+          client.clearTimer();
+          client.decrypt();
+          measurement = client.readMultiValueMeasurements();
+          measurements.add("%d-dec-std"  % size, {1: measurement[1][0]});
+
+          if args.output is None:
+            payload = client.getPlainText()[0:len(input)];
+            if payload != input:
+              raise RuntimeError("Test Vector failed (decryption mod n^2).");
+
+          #c^(p-1) mod p^2 and c^(q-1) mod q^2
+          client.enableCrt();
+          client.setCipherText(ciphertext);
+
         client.clearTimer();
         client.decrypt();
         measurement = client.readMultiValueMeasurements();
@@ -96,6 +151,56 @@ class PaillerApplication(TerminalApplication):
     measurements.save();
     return 0;
 
+  def execute_aggregation(self, client, args, measurements):
+    n = words_to_int(binascii.a2b_hex(KEY_P)) * words_to_int(binascii.a2b_hex(KEY_Q));
+
+    nb = 1;
+    for size in range(int(args.min), int(args.max)+1, int(args.step)):
+      sys.stdout.write("Running Aggregation (Index: %d): " % nb);
+      nb = nb+1;
+
+      client.aggregateInit();
+      expected = 0;
+      for i in range(0, int(args.cycles)):
+        if(i % 50 == 0):
+          sys.stdout.write(".");
+          sys.stdout.flush();
+
+        #Encrypt random PlainText
+        value = random.getrandbits(size*8);
+        client.setPlainText(int_to_words(value, size));
+        client.encrypt();
+
+        #Every second cipher-text is weighted with a random constant
+        if i % 2:
+          weight = random.getrandbits(16) | 1;
+          client.setPlainText(int_to_words(weight, 4));
+          client.clearTimer();
+          client.aggregateAddScaled();
+          measurement = client.readMultiValueMeasurements();
+          measurements.add("%d-agg-scaled" % size, {1: measurement[1][0]});
+          expected = expected + weight * value;
+        else:
+          client.clearTimer();
+          client.aggregateAdd();
+          measurement = client.readMultiValueMeasurements();
+          measurements.add("%d-agg-add"    % size, {1: measurement[1][0]});
+          expected = expected + value;
+
+      client.clearTimer();
+      client.aggregateFinish();
+      measurement = client.readMultiValueMeasurements();
+      measurements.add("%d-agg-finish"     % size, {1: measurement[1][0]});
+
+      client.decrypt();
+      if words_to_int(client.getPlainText()) != expected % n:
+        raise RuntimeError("Aggregation failed.");
+
+      sys.stdout.write(" success.\n");
+
+    measurements.save();
+    return 0;
+
 if __name__ == "__main__":
   app = PaillerApplication();
   sys.exit(app.main());